@@ -420,6 +420,13 @@ void DynamicBVH::get_elements(List<ID> *r_elements) {
 	}
 }
 
+AABB DynamicBVH::get_aabb() const {
+	if (!bvh_root) {
+		return AABB();
+	}
+	return AABB(bvh_root->volume.min, bvh_root->volume.get_length());
+}
+
 int DynamicBVH::get_leaf_count() const {
 	return total_leaves;
 }
@@ -295,6 +295,7 @@ public:
 	bool update(const ID &p_id, const AABB &p_box);
 	void remove(const ID &p_id);
 	void get_elements(List<ID> *r_elements);
+	AABB get_aabb() const;
 
 	int get_leaf_count() const;
 	int get_max_depth() const;
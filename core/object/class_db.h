@@ -126,7 +126,8 @@ public:
 
 	template <class T>
 	static Object *creator() {
-		return memnew(T);
+		// Attributed to the class rather than to this line.
+		return _post_initialize(new (memory_type_site<T>()) T);
 	}
 
 	static RWLock lock;
@@ -34,68 +34,139 @@
 #include "core/core_string_names.h"
 #include "core/object/class_db.h"
 #include "core/object/script_language.h"
+#include "core/os/thread.h"
 
 MessageQueue *MessageQueue::singleton = nullptr;
 
+// Guards the singleton against threads giving their arena back while the queue is destroyed.
+static BinaryMutex singleton_mutex;
+static SafeNumeric<uint64_t> last_queue_id;
+
+thread_local MessageQueue::ArenaCache MessageQueue::arena_cache;
+
+MessageQueue::ArenaCache::~ArenaCache() {
+	MutexLock lock(singleton_mutex);
+	if (arena && singleton && singleton->id == queue_id) {
+		arena->claimed.clear();
+	}
+}
+
 MessageQueue *MessageQueue::get_singleton() {
 	return singleton;
 }
 
-Error MessageQueue::push_callp(ObjectID p_id, const StringName &p_method, const Variant **p_args, int p_argcount, bool p_show_error) {
-	return push_callablep(Callable(p_id, p_method), p_args, p_argcount, p_show_error);
+MessageQueue::Arena *MessageQueue::_claim_arena() {
+	MutexLock lock(arenas_mutex);
+
+	// Reuse the arena of a thread that has exited, if any.
+	Arena *arena = nullptr;
+	for (uint32_t i = 0; i < arenas.size(); i++) {
+		if (!arenas[i]->claimed.is_set()) {
+			arena = arenas[i];
+			break;
+		}
+	}
+
+	if (!arena) {
+		arena = memnew(Arena);
+		if (Thread::get_caller_id() == Thread::get_main_id() && initial_size > PAGE_SIZE) {
+			// Most deferred calls come from the main thread, start it with a large page.
+			Page page;
+			page.size = initial_size;
+			page.data = memnew_arr(uint8_t, page.size);
+			arena->free_pages.push_back(page);
+		}
+		arenas.push_back(arena);
+	}
+	arena->claimed.set();
+
+	arena_cache.queue_id = id;
+	arena_cache.arena = arena;
+	return arena;
 }
 
-Error MessageQueue::push_set(ObjectID p_id, const StringName &p_prop, const Variant &p_value) {
-	_THREAD_SAFE_METHOD_
+MessageQueue::Message *MessageQueue::_allocate_message(Arena *p_arena, int p_argcount) {
+	uint32_t room_needed = sizeof(Message) + sizeof(Variant) * p_argcount;
+
+	Page *page = p_arena->pages.is_empty() ? nullptr : &p_arena->pages[p_arena->pages.size() - 1];
+	if (!page || page->used + room_needed > page->size) {
+		Page new_page;
+		for (uint32_t i = 0; i < p_arena->free_pages.size(); i++) {
+			if (p_arena->free_pages[i].size >= room_needed) {
+				new_page = p_arena->free_pages[i];
+				p_arena->free_pages.remove_at_unordered(i);
+				break;
+			}
+		}
+		if (!new_page.data) {
+			new_page.size = MAX((uint32_t)PAGE_SIZE, room_needed);
+			new_page.data = memnew_arr(uint8_t, new_page.size);
+		}
+		new_page.used = 0;
+		p_arena->pages.push_back(new_page);
+		page = &p_arena->pages[p_arena->pages.size() - 1];
+	}
 
-	uint8_t room_needed = sizeof(Message) + sizeof(Variant);
+	Message *msg = memnew_placement(&page->data[page->used], Message);
+	msg->ticket = next_ticket.postincrement();
+	page->used += room_needed;
+	return msg;
+}
 
-	if ((buffer_end + room_needed) >= buffer_size) {
-		String type;
-		if (ObjectDB::get_instance(p_id)) {
-			type = ObjectDB::get_instance(p_id)->get_class();
+void MessageQueue::_destroy_messages(const Page &p_page) {
+	uint32_t read_pos = 0;
+
+	while (read_pos < p_page.used) {
+		Message *message = (Message *)&p_page.data[read_pos];
+		Variant *args = (Variant *)(message + 1);
+		int argc = message->args;
+		if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
+			for (int i = 0; i < argc; i++) {
+				args[i].~Variant();
+			}
+		}
+
+		read_pos += sizeof(Message);
+		if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
+			read_pos += sizeof(Variant) * message->args;
 		}
-		print_line("Failed set: " + type + ":" + p_prop + " target ID: " + itos(p_id));
-		statistics();
-		ERR_FAIL_V_MSG(ERR_OUT_OF_MEMORY, "Message queue out of memory. Try increasing 'memory/limits/message_queue/max_size_kb' in project settings.");
+
+		message->~Message();
 	}
+}
 
-	Message *msg = memnew_placement(&buffer[buffer_end], Message);
+Error MessageQueue::push_callp(ObjectID p_id, const StringName &p_method, const Variant **p_args, int p_argcount, bool p_show_error) {
+	return push_callablep(Callable(p_id, p_method), p_args, p_argcount, p_show_error);
+}
+
+Error MessageQueue::push_set(ObjectID p_id, const StringName &p_prop, const Variant &p_value) {
+	Arena *arena = _get_arena();
+	MutexLock lock(arena->mutex);
+
+	Message *msg = _allocate_message(arena, 1);
 	msg->args = 1;
 	msg->callable = Callable(p_id, p_prop);
 	msg->type = TYPE_SET;
 
-	buffer_end += sizeof(Message);
-
-	Variant *v = memnew_placement(&buffer[buffer_end], Variant);
-	buffer_end += sizeof(Variant);
+	Variant *v = memnew_placement(msg + 1, Variant);
 	*v = p_value;
 
 	return OK;
 }
 
 Error MessageQueue::push_notification(ObjectID p_id, int p_notification) {
-	_THREAD_SAFE_METHOD_
-
 	ERR_FAIL_COND_V(p_notification < 0, ERR_INVALID_PARAMETER);
 
-	uint8_t room_needed = sizeof(Message);
-
-	if ((buffer_end + room_needed) >= buffer_size) {
-		print_line("Failed notification: " + itos(p_notification) + " target ID: " + itos(p_id));
-		statistics();
-		ERR_FAIL_V_MSG(ERR_OUT_OF_MEMORY, "Message queue out of memory. Try increasing 'memory/limits/message_queue/max_size_kb' in project settings.");
-	}
+	Arena *arena = _get_arena();
+	MutexLock lock(arena->mutex);
 
-	Message *msg = memnew_placement(&buffer[buffer_end], Message);
+	Message *msg = _allocate_message(arena, 0);
 
 	msg->type = TYPE_NOTIFICATION;
 	msg->callable = Callable(p_id, CoreStringNames::get_singleton()->notification); //name is meaningless but callable needs it
 	//msg->target;
 	msg->notification = p_notification;
 
-	buffer_end += sizeof(Message);
-
 	return OK;
 }
 
@@ -112,17 +183,12 @@ Error MessageQueue::push_set(Object *p_object, const StringName &p_prop, const V
 }
 
 Error MessageQueue::push_callablep(const Callable &p_callable, const Variant **p_args, int p_argcount, bool p_show_error) {
-	_THREAD_SAFE_METHOD_
-
-	int room_needed = sizeof(Message) + sizeof(Variant) * p_argcount;
+	ERR_FAIL_COND_V(p_argcount < 0, ERR_INVALID_PARAMETER);
 
-	if ((buffer_end + room_needed) >= buffer_size) {
-		print_line("Failed method: " + p_callable);
-		statistics();
-		ERR_FAIL_V_MSG(ERR_OUT_OF_MEMORY, "Message queue out of memory. Try increasing 'memory/limits/message_queue/max_size_kb' in project settings.");
-	}
+	Arena *arena = _get_arena();
+	MutexLock lock(arena->mutex);
 
-	Message *msg = memnew_placement(&buffer[buffer_end], Message);
+	Message *msg = _allocate_message(arena, p_argcount);
 	msg->args = p_argcount;
 	msg->callable = p_callable;
 	msg->type = TYPE_CALL;
@@ -130,11 +196,9 @@ Error MessageQueue::push_callablep(const Callable &p_callable, const Variant **p
 		msg->type |= FLAG_SHOW_ERROR;
 	}
 
-	buffer_end += sizeof(Message);
-
+	Variant *args = (Variant *)(msg + 1);
 	for (int i = 0; i < p_argcount; i++) {
-		Variant *v = memnew_placement(&buffer[buffer_end], Variant);
-		buffer_end += sizeof(Variant);
+		Variant *v = memnew_placement(&args[i], Variant);
 		*v = *p_args[i];
 	}
 
@@ -146,56 +210,66 @@ void MessageQueue::statistics() {
 	Map<int, int> notify_count;
 	Map<Callable, int> call_count;
 	int null_count = 0;
+	uint32_t total_bytes = 0;
 
-	uint32_t read_pos = 0;
-	while (read_pos < buffer_end) {
-		Message *message = (Message *)&buffer[read_pos];
+	MutexLock lock(arenas_mutex);
+	for (uint32_t i = 0; i < arenas.size(); i++) {
+		MutexLock arena_lock(arenas[i]->mutex);
+		for (uint32_t j = 0; j < arenas[i]->pages.size(); j++) {
+			const Page &page = arenas[i]->pages[j];
+			total_bytes += page.used;
 
-		Object *target = message->callable.get_object();
+			uint32_t read_pos = 0;
+			while (read_pos < page.used) {
+				Message *message = (Message *)&page.data[read_pos];
 
-		if (target != nullptr) {
-			switch (message->type & FLAG_MASK) {
-				case TYPE_CALL: {
-					if (!call_count.has(message->callable)) {
-						call_count[message->callable] = 0;
-					}
+				Object *target = message->callable.get_object();
 
-					call_count[message->callable]++;
+				if (target != nullptr) {
+					switch (message->type & FLAG_MASK) {
+						case TYPE_CALL: {
+							if (!call_count.has(message->callable)) {
+								call_count[message->callable] = 0;
+							}
 
-				} break;
-				case TYPE_NOTIFICATION: {
-					if (!notify_count.has(message->notification)) {
-						notify_count[message->notification] = 0;
-					}
+							call_count[message->callable]++;
 
-					notify_count[message->notification]++;
+						} break;
+						case TYPE_NOTIFICATION: {
+							if (!notify_count.has(message->notification)) {
+								notify_count[message->notification] = 0;
+							}
 
-				} break;
-				case TYPE_SET: {
-					StringName t = message->callable.get_method();
-					if (!set_count.has(t)) {
-						set_count[t] = 0;
-					}
+							notify_count[message->notification]++;
 
-					set_count[t]++;
+						} break;
+						case TYPE_SET: {
+							StringName t = message->callable.get_method();
+							if (!set_count.has(t)) {
+								set_count[t] = 0;
+							}
 
-				} break;
-			}
+							set_count[t]++;
 
-		} else {
-			//object was deleted
-			print_line("Object was deleted while awaiting a callback");
+						} break;
+					}
 
-			null_count++;
-		}
+				} else {
+					//object was deleted
+					print_line("Object was deleted while awaiting a callback");
 
-		read_pos += sizeof(Message);
-		if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
-			read_pos += sizeof(Variant) * message->args;
+					null_count++;
+				}
+
+				read_pos += sizeof(Message);
+				if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
+					read_pos += sizeof(Variant) * message->args;
+				}
+			}
 		}
 	}
 
-	print_line("TOTAL BYTES: " + itos(buffer_end));
+	print_line("TOTAL BYTES: " + itos(total_bytes));
 	print_line("NULL count: " + itos(null_count));
 
 	for (const KeyValue<StringName, int> &E : set_count) {
@@ -233,113 +307,158 @@ void MessageQueue::_call_function(const Callable &p_callable, const Variant *p_a
 }
 
 void MessageQueue::flush() {
-	if (buffer_end > buffer_max_used) {
-		buffer_max_used = buffer_end;
-	}
-
-	uint32_t read_pos = 0;
-
-	//using reverse locking strategy
-	_THREAD_SAFE_LOCK_
-
-	if (flushing) {
-		_THREAD_SAFE_UNLOCK_
-		ERR_FAIL_COND(flushing); //already flushing, you did something odd
-	}
-	flushing = true;
-
-	while (read_pos < buffer_end) {
-		//lock on each iteration, so a call can re-add itself to the message queue
-
-		Message *message = (Message *)&buffer[read_pos];
+	ERR_FAIL_COND(flushing.is_set()); //already flushing, you did something odd
+	flushing.set();
+
+	while (true) {
+		// Take the pages of every arena, calls pushed from now on go to fresh pages
+		// and are picked up by the next round, so a call can re-add itself.
+		flush_pages.clear();
+		flush_cursors.clear();
+		uint32_t used = 0;
+		{
+			MutexLock lock(arenas_mutex);
+			for (uint32_t i = 0; i < arenas.size(); i++) {
+				Arena *arena = arenas[i];
+				MutexLock arena_lock(arena->mutex);
+				if (arena->pages.is_empty()) {
+					continue;
+				}
+
+				FlushCursor cursor;
+				cursor.arena = arena;
+				cursor.page = flush_pages.size();
+				for (uint32_t j = 0; j < arena->pages.size(); j++) {
+					flush_pages.push_back(arena->pages[j]);
+					used += arena->pages[j].used;
+				}
+				cursor.page_end = flush_pages.size();
+				arena->pages.clear();
+				flush_cursors.push_back(cursor);
+			}
+		}
 
-		uint32_t advance = sizeof(Message);
-		if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
-			advance += sizeof(Variant) * message->args;
+		if (flush_cursors.is_empty()) {
+			break;
 		}
+		if (used > buffer_max_used) {
+			buffer_max_used = used;
+		}
+
+		while (true) {
+			// Merge the arenas back, in the order the messages were pushed.
+			FlushCursor *cursor = nullptr;
+			Message *message = nullptr;
+			for (uint32_t i = 0; i < flush_cursors.size(); i++) {
+				FlushCursor &candidate = flush_cursors[i];
+				if (candidate.page == candidate.page_end) {
+					continue;
+				}
+				Message *candidate_message = (Message *)&flush_pages[candidate.page].data[candidate.offset];
+				if (!message || candidate_message->ticket < message->ticket) {
+					cursor = &candidate;
+					message = candidate_message;
+				}
+			}
+			if (!message) {
+				break;
+			}
 
-		//pre-advance so this function is reentrant
-		read_pos += advance;
+			uint32_t advance = sizeof(Message);
+			if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
+				advance += sizeof(Variant) * message->args;
+			}
+			cursor->offset += advance;
+			if (cursor->offset >= flush_pages[cursor->page].used) {
+				cursor->page++;
+				cursor->offset = 0;
+			}
 
-		_THREAD_SAFE_UNLOCK_
+			Object *target = message->callable.get_object();
 
-		Object *target = message->callable.get_object();
+			if (target != nullptr) {
+				switch (message->type & FLAG_MASK) {
+					case TYPE_CALL: {
+						Variant *args = (Variant *)(message + 1);
 
-		if (target != nullptr) {
-			switch (message->type & FLAG_MASK) {
-				case TYPE_CALL: {
-					Variant *args = (Variant *)(message + 1);
+						// messages don't expect a return value
 
-					// messages don't expect a return value
+						_call_function(message->callable, args, message->args, message->type & FLAG_SHOW_ERROR);
 
-					_call_function(message->callable, args, message->args, message->type & FLAG_SHOW_ERROR);
+					} break;
+					case TYPE_NOTIFICATION: {
+						// messages don't expect a return value
+						target->notification(message->notification);
 
-				} break;
-				case TYPE_NOTIFICATION: {
-					// messages don't expect a return value
-					target->notification(message->notification);
+					} break;
+					case TYPE_SET: {
+						Variant *arg = (Variant *)(message + 1);
+						// messages don't expect a return value
+						target->set(message->callable.get_method(), *arg);
 
-				} break;
-				case TYPE_SET: {
-					Variant *arg = (Variant *)(message + 1);
-					// messages don't expect a return value
-					target->set(message->callable.get_method(), *arg);
+					} break;
+				}
+			}
 
-				} break;
+			if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
+				Variant *args = (Variant *)(message + 1);
+				for (int i = 0; i < message->args; i++) {
+					args[i].~Variant();
+				}
 			}
+
+			message->~Message();
 		}
 
-		if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
-			Variant *args = (Variant *)(message + 1);
-			for (int i = 0; i < message->args; i++) {
-				args[i].~Variant();
+		// Give the pages back to their arenas, keeping a few around for the next frame.
+		for (uint32_t i = 0; i < flush_cursors.size(); i++) {
+			Arena *arena = flush_cursors[i].arena;
+			MutexLock arena_lock(arena->mutex);
+			for (uint32_t j = i == 0 ? 0 : flush_cursors[i - 1].page_end; j < flush_cursors[i].page_end; j++) {
+				if (arena->free_pages.size() < MAX_FREE_PAGES) {
+					arena->free_pages.push_back(flush_pages[j]);
+				} else {
+					memdelete_arr(flush_pages[j].data);
+				}
 			}
 		}
-
-		message->~Message();
-
-		_THREAD_SAFE_LOCK_
 	}
 
-	buffer_end = 0; // reset buffer
-	flushing = false;
-	_THREAD_SAFE_UNLOCK_
+	flushing.clear();
 }
 
 bool MessageQueue::is_flushing() const {
-	return flushing;
+	return flushing.is_set();
 }
 
 MessageQueue::MessageQueue() {
 	ERR_FAIL_COND_MSG(singleton != nullptr, "A MessageQueue singleton already exists.");
-	singleton = this;
+	{
+		MutexLock lock(singleton_mutex);
+		singleton = this;
+		id = last_queue_id.increment();
+	}
 
-	buffer_size = GLOBAL_DEF_RST("memory/limits/message_queue/max_size_kb", DEFAULT_QUEUE_SIZE_KB);
+	initial_size = GLOBAL_DEF_RST("memory/limits/message_queue/max_size_kb", DEFAULT_QUEUE_SIZE_KB);
 	ProjectSettings::get_singleton()->set_custom_property_info("memory/limits/message_queue/max_size_kb", PropertyInfo(Variant::INT, "memory/limits/message_queue/max_size_kb", PROPERTY_HINT_RANGE, "1024,4096,1,or_greater"));
-	buffer_size *= 1024;
-	buffer = memnew_arr(uint8_t, buffer_size);
+	initial_size *= 1024;
 }
 
 MessageQueue::~MessageQueue() {
-	uint32_t read_pos = 0;
+	{
+		MutexLock lock(singleton_mutex);
+		singleton = nullptr;
+	}
 
-	while (read_pos < buffer_end) {
-		Message *message = (Message *)&buffer[read_pos];
-		Variant *args = (Variant *)(message + 1);
-		int argc = message->args;
-		if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
-			for (int i = 0; i < argc; i++) {
-				args[i].~Variant();
-			}
+	for (uint32_t i = 0; i < arenas.size(); i++) {
+		Arena *arena = arenas[i];
+		for (uint32_t j = 0; j < arena->pages.size(); j++) {
+			_destroy_messages(arena->pages[j]);
+			memdelete_arr(arena->pages[j].data);
 		}
-		message->~Message();
-
-		read_pos += sizeof(Message);
-		if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
-			read_pos += sizeof(Variant) * message->args;
+		for (uint32_t j = 0; j < arena->free_pages.size(); j++) {
+			memdelete_arr(arena->free_pages[j].data);
 		}
+		memdelete(arena);
 	}
-
-	singleton = nullptr;
-	memdelete_arr(buffer);
 }
@@ -32,16 +32,18 @@
 #define MESSAGE_QUEUE_H
 
 #include "core/object/object_id.h"
-#include "core/os/thread_safe.h"
+#include "core/os/mutex.h"
+#include "core/templates/local_vector.h"
+#include "core/templates/safe_refcount.h"
 #include "core/variant/variant.h"
 
 class Object;
 
 class MessageQueue {
-	_THREAD_SAFE_CLASS_
-
 	enum {
-		DEFAULT_QUEUE_SIZE_KB = 4096
+		DEFAULT_QUEUE_SIZE_KB = 4096,
+		PAGE_SIZE = 16 * 1024,
+		MAX_FREE_PAGES = 8
 	};
 
 	enum {
@@ -55,6 +57,7 @@ class MessageQueue {
 
 	struct Message {
 		Callable callable;
+		uint64_t ticket; // Order the message was pushed in, across all threads.
 		int16_t type;
 		union {
 			int16_t notification;
@@ -62,16 +65,65 @@ class MessageQueue {
 		};
 	};
 
-	uint8_t *buffer = nullptr;
-	uint32_t buffer_end = 0;
+	struct Page {
+		uint8_t *data = nullptr;
+		uint32_t size = 0;
+		uint32_t used = 0;
+	};
+
+	// Every thread pushes into its own arena, so threads only contend with the
+	// flush, never with each other. Pages are added as needed and recycled.
+	struct Arena {
+		BinaryMutex mutex;
+		LocalVector<Page> pages;
+		LocalVector<Page> free_pages;
+		SafeFlag claimed;
+	};
+
+	struct FlushCursor {
+		Arena *arena = nullptr;
+		uint32_t page = 0;
+		uint32_t page_end = 0;
+		uint32_t offset = 0;
+	};
+
+	// Gives the arena back for other threads to claim when the thread exits.
+	struct ArenaCache {
+		uint64_t queue_id = 0;
+		Arena *arena = nullptr;
+
+		~ArenaCache();
+	};
+
+	static thread_local ArenaCache arena_cache;
+
+	uint64_t id = 0;
+	BinaryMutex arenas_mutex;
+	LocalVector<Arena *> arenas;
+	SafeNumeric<uint64_t> next_ticket;
+	uint32_t initial_size = 0;
+
+	// Only used while flushing.
+	LocalVector<Page> flush_pages;
+	LocalVector<FlushCursor> flush_cursors;
 	uint32_t buffer_max_used = 0;
-	uint32_t buffer_size = 0;
+
+	_FORCE_INLINE_ Arena *_get_arena() {
+		if (likely(arena_cache.queue_id == id)) {
+			return arena_cache.arena;
+		}
+		return _claim_arena();
+	}
+
+	Arena *_claim_arena();
+	Message *_allocate_message(Arena *p_arena, int p_argcount);
+	static void _destroy_messages(const Page &p_page);
 
 	void _call_function(const Callable &p_callable, const Variant *p_args, int p_argcount, bool p_show_error);
 
 	static MessageQueue *singleton;
 
-	bool flushing = false;
+	SafeFlag flushing;
 
 public:
 	static MessageQueue *get_singleton();
@@ -38,6 +38,7 @@
 #include "core/os/os.h"
 #include "core/string/print_string.h"
 #include "core/string/translation.h"
+#include "core/variant/variant_internal.h"
 
 #ifdef DEBUG_ENABLED
 
@@ -1053,6 +1054,33 @@ Error Object::_emit_signal(const Variant **p_args, int p_argcount, Callable::Cal
 	return emit_signalp(signal, args, argc);
 }
 
+// Calls a connected method straight through its MethodBind, skipping the method lookup and argument conversion of Object::callp().
+// Only possible when no script can override the method and the arguments already have the exact bound types.
+static bool _signal_ptrcall(MethodBind *p_method, Object *p_target, const Variant **p_args, int p_argcount) {
+	if (p_argcount != p_method->get_argument_count() || p_target->get_script_instance()) {
+		return false;
+	}
+
+	const void **argptrs = (const void **)alloca(sizeof(const void *) * MAX(p_argcount, 1));
+	for (int i = 0; i < p_argcount; i++) {
+		const Variant::Type type = p_method->get_argument_type(i);
+		if (type == Variant::NIL) {
+			argptrs[i] = p_args[i]; // Variant argument.
+		} else if (type != Variant::OBJECT && p_args[i]->get_type() == type) {
+			// Objects are left to call(), which checks their class.
+			argptrs[i] = VariantInternal::get_opaque_pointer(p_args[i]);
+		} else {
+			return false;
+		}
+	}
+
+#ifdef DEBUG_ENABLED
+	_ObjectDebugLock target_lock(p_target);
+#endif
+	p_method->ptrcall(p_target, argptrs, nullptr);
+	return true;
+}
+
 Error Object::emit_signalp(const StringName &p_name, const Variant **p_args, int p_argcount) {
 	if (_block_signals) {
 		return ERR_CANT_ACQUIRE_RESOURCE; //no emit, signals blocked
@@ -1080,12 +1108,18 @@ Error Object::emit_signalp(const StringName &p_name, const Variant **p_args, int
 
 	OBJ_DEBUG_LOCK
 
-	Vector<const Variant *> bind_mem;
+	// Arguments followed by the binds of a connection, sized for the connection with the most binds.
+	int max_binds = 0;
+	for (int i = 0; i < ssize; i++) {
+		max_binds = MAX(max_binds, slot_map.getv(i).conn.binds.size());
+	}
+	const Variant **bind_args = max_binds ? (const Variant **)alloca(sizeof(const Variant *) * (p_argcount + max_binds)) : nullptr;
 
 	Error err = OK;
 
 	for (int i = 0; i < ssize; i++) {
-		const Connection &c = slot_map.getv(i).conn;
+		const SignalData::Slot &slot = slot_map.getv(i);
+		const Connection &c = slot.conn;
 
 		Object *target = c.callable.get_object();
 		if (!target) {
@@ -1098,17 +1132,15 @@ Error Object::emit_signalp(const StringName &p_name, const Variant **p_args, int
 
 		if (c.binds.size()) {
 			//handle binds
-			bind_mem.resize(p_argcount + c.binds.size());
-
 			for (int j = 0; j < p_argcount; j++) {
-				bind_mem.write[j] = p_args[j];
+				bind_args[j] = p_args[j];
 			}
 			for (int j = 0; j < c.binds.size(); j++) {
-				bind_mem.write[p_argcount + j] = &c.binds[j];
+				bind_args[p_argcount + j] = &c.binds[j];
 			}
 
-			args = (const Variant **)bind_mem.ptr();
-			argc = bind_mem.size();
+			args = bind_args;
+			argc = p_argcount + c.binds.size();
 		}
 
 		if (c.flags & CONNECT_DEFERRED) {
@@ -1116,8 +1148,10 @@ Error Object::emit_signalp(const StringName &p_name, const Variant **p_args, int
 		} else {
 			Callable::CallError ce;
 			_emitting = true;
-			Variant ret;
-			c.callable.call(args, argc, ret, ce);
+			if (!slot.method_bind || !_signal_ptrcall(slot.method_bind, target, args, argc)) {
+				Variant ret;
+				c.callable.call(args, argc, ret, ce);
+			}
 			_emitting = false;
 
 			if (ce.error != Callable::CallError::CALL_OK) {
@@ -1358,6 +1392,12 @@ Error Object::connect(const StringName &p_signal, const Callable &p_callable, co
 	conn.binds = p_binds;
 	slot.conn = conn;
 	slot.cE = target_object->connections.push_back(conn);
+	if (target.is_standard()) {
+		MethodBind *method = ClassDB::get_method(target_object->get_class_name(), target.get_method());
+		if (method && !method->is_vararg() && !method->has_return()) {
+			slot.method_bind = method;
+		}
+	}
 	if (p_flags & CONNECT_REFERENCE_COUNTED) {
 		slot.reference_count = 1;
 	}
@@ -490,6 +490,8 @@ private:
 			int reference_count = 0;
 			Connection conn;
 			List<Connection>::Element *cE = nullptr;
+			// Resolved on connection when the target method can be ptrcalled, see _signal_ptrcall().
+			MethodBind *method_bind = nullptr;
 		};
 
 		MethodInfo user;
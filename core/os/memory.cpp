@@ -33,11 +33,16 @@
 #include "core/error/error_macros.h"
 #include "core/templates/safe_refcount.h"
 
+#ifdef SMALL_ALLOCATOR_ENABLED
+#include "core/os/small_allocator.h"
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 void *operator new(size_t p_size, const char *p_description) {
-	return Memory::alloc_static(p_size, false);
+	return Memory::alloc_static(p_size, false, p_description);
 }
 
 void *operator new(size_t p_size, void *(*p_allocfunc)(size_t p_size)) {
@@ -65,18 +70,134 @@ SafeNumeric<uint64_t> Memory::max_usage;
 
 SafeNumeric<uint64_t> Memory::alloc_count;
 
-void *Memory::alloc_static(size_t p_bytes, bool p_pad_align) {
+#ifdef SMALL_ALLOCATOR_ENABLED
+static _FORCE_INLINE_ void *_alloc_block(size_t p_bytes) {
+	void *mem = SmallAllocator::alloc(p_bytes);
+	return mem ? mem : malloc(p_bytes);
+}
+
+static void *_realloc_block(void *p_memory, size_t p_bytes) {
+	if (!SmallAllocator::owns(p_memory)) {
+		return realloc(p_memory, p_bytes);
+	}
+	if (p_bytes == 0) {
+		SmallAllocator::free(p_memory);
+		return nullptr;
+	}
+	const size_t size = SmallAllocator::get_size(p_memory);
+	if (p_bytes <= size && size - p_bytes < SmallAllocator::SIZE_CLASS_GRANULARITY) {
+		return p_memory;
+	}
+	void *mem = _alloc_block(p_bytes);
+	if (mem) {
+		memcpy(mem, p_memory, MIN(size, p_bytes));
+		SmallAllocator::free(p_memory);
+	}
+	return mem;
+}
+
+static _FORCE_INLINE_ void _free_block(void *p_memory) {
+	if (SmallAllocator::owns(p_memory)) {
+		SmallAllocator::free(p_memory);
+	} else {
+		free(p_memory);
+	}
+}
+
+// Usage is counted per thread to avoid contention on a shared counter, so the
+// maximum can only be sampled whenever the usage is queried.
+#define MEM_USAGE_ADD(m_bytes) SmallAllocator::add_usage(m_bytes)
+#define MEM_USAGE_SUB(m_bytes) SmallAllocator::add_usage(-(int64_t)(m_bytes))
+#else
+#define _alloc_block(m_bytes) malloc(m_bytes)
+#define _realloc_block(m_memory, m_bytes) realloc(m_memory, m_bytes)
+#define _free_block(m_memory) free(m_memory)
+
+#define MEM_USAGE_ADD(m_bytes) max_usage.exchange_if_greater(mem_usage.add(m_bytes))
+#define MEM_USAGE_SUB(m_bytes) mem_usage.sub(m_bytes)
+#endif
+
+#ifdef DEBUG_ENABLED
+// Allocation profiler sites live in a fixed-size table, as it can't allocate
+// memory itself. Entries are claimed lock-free and never released.
+#define PROFILER_SITE_TABLE_SIZE 16384
+#define PROFILER_SITE_MAX_PROBES 64
+#define PROFILER_SITE_OVERFLOW (PROFILER_SITE_TABLE_SIZE + 1)
+
+// The rest of the padding belongs to the caller (see CowData or memnew_arr), so
+// the index of the site is kept in the upper bits of the stored size (0 for none).
+#define PROFILER_SITE_SHIFT 48
+#define PROFILER_SIZE_MASK ((uint64_t(1) << PROFILER_SITE_SHIFT) - 1)
+static_assert(PROFILER_SITE_OVERFLOW < (1 << (64 - PROFILER_SITE_SHIFT)), "Too many profiler sites for the allocation header.");
+
+struct ProfilerSite {
+	std::atomic<const char *> site;
+	std::atomic<int64_t> live_bytes;
+	std::atomic<int64_t> live_count;
+	std::atomic<uint64_t> total_bytes;
+	std::atomic<uint64_t> total_count;
+
+	_FORCE_INLINE_ void add(int64_t p_bytes, int64_t p_count) {
+		live_bytes.fetch_add(p_bytes, std::memory_order_relaxed);
+		if (p_bytes > 0) {
+			total_bytes.fetch_add(p_bytes, std::memory_order_relaxed);
+		}
+		if (p_count) {
+			live_count.fetch_add(p_count, std::memory_order_relaxed);
+			if (p_count > 0) {
+				total_count.fetch_add(p_count, std::memory_order_relaxed);
+			}
+		}
+	}
+};
+
+// Index 0 is unused, the last entry collects sites that don't fit in the table.
+static ProfilerSite profiler_sites[PROFILER_SITE_OVERFLOW + 1];
+static std::atomic<bool> profiling = { false };
+static const char *profiler_untagged = "(untagged)";
+static const char *profiler_overflow = "(other sites)";
+
+static uint64_t _profiler_get_site(const char *p_site) {
+	if (!p_site || !*p_site) {
+		p_site = profiler_untagged;
+	}
+
+	uint64_t hash = (uint64_t)(uintptr_t)p_site;
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+
+	for (uint32_t i = 0; i < PROFILER_SITE_MAX_PROBES; i++) {
+		const uint64_t index = 1 + ((hash + i) & (PROFILER_SITE_TABLE_SIZE - 1));
+		ProfilerSite &entry = profiler_sites[index];
+		const char *site = entry.site.load(std::memory_order_acquire);
+		if (site == p_site) {
+			return index;
+		}
+		if (!site && (entry.site.compare_exchange_strong(site, p_site, std::memory_order_acq_rel) || site == p_site)) {
+			return index;
+		}
+	}
+
+	profiler_sites[PROFILER_SITE_OVERFLOW].site.store(profiler_overflow, std::memory_order_release);
+	return PROFILER_SITE_OVERFLOW;
+}
+#endif
+
+void *Memory::alloc_static(size_t p_bytes, bool p_pad_align, const char *p_site) {
 #ifdef DEBUG_ENABLED
 	bool prepad = true;
 #else
 	bool prepad = p_pad_align;
 #endif
 
-	void *mem = malloc(p_bytes + (prepad ? PAD_ALIGN : 0));
+	void *mem = _alloc_block(p_bytes + (prepad ? PAD_ALIGN : 0));
 
 	ERR_FAIL_COND_V(!mem, nullptr);
 
+#ifndef SMALL_ALLOCATOR_ENABLED
 	alloc_count.increment();
+#endif
 
 	if (prepad) {
 		uint64_t *s = (uint64_t *)mem;
@@ -85,8 +206,13 @@ void *Memory::alloc_static(size_t p_bytes, bool p_pad_align) {
 		uint8_t *s8 = (uint8_t *)mem;
 
 #ifdef DEBUG_ENABLED
-		uint64_t new_mem_usage = mem_usage.add(p_bytes);
-		max_usage.exchange_if_greater(new_mem_usage);
+		MEM_USAGE_ADD(p_bytes);
+
+		if (unlikely(profiling.load(std::memory_order_relaxed))) {
+			const uint64_t site = _profiler_get_site(p_site);
+			profiler_sites[site].add(p_bytes, 1);
+			*s |= site << PROFILER_SITE_SHIFT;
+		}
 #endif
 		return s8 + PAD_ALIGN;
 	} else {
@@ -94,9 +220,9 @@ void *Memory::alloc_static(size_t p_bytes, bool p_pad_align) {
 	}
 }
 
-void *Memory::realloc_static(void *p_memory, size_t p_bytes, bool p_pad_align) {
+void *Memory::realloc_static(void *p_memory, size_t p_bytes, bool p_pad_align, const char *p_site) {
 	if (p_memory == nullptr) {
-		return alloc_static(p_bytes, p_pad_align);
+		return alloc_static(p_bytes, p_pad_align, p_site);
 	}
 
 	uint8_t *mem = (uint8_t *)p_memory;
@@ -112,31 +238,42 @@ void *Memory::realloc_static(void *p_memory, size_t p_bytes, bool p_pad_align) {
 		uint64_t *s = (uint64_t *)mem;
 
 #ifdef DEBUG_ENABLED
-		if (p_bytes > *s) {
-			uint64_t new_mem_usage = mem_usage.add(p_bytes - *s);
-			max_usage.exchange_if_greater(new_mem_usage);
+		uint64_t site = *s >> PROFILER_SITE_SHIFT;
+		const uint64_t old_bytes = *s & PROFILER_SIZE_MASK;
+		if (p_bytes > old_bytes) {
+			MEM_USAGE_ADD(p_bytes - old_bytes);
 		} else {
-			mem_usage.sub(*s - p_bytes);
+			MEM_USAGE_SUB(old_bytes - p_bytes);
 		}
+		if (site) {
+			profiler_sites[site].add((int64_t)p_bytes - (int64_t)old_bytes, p_bytes == 0 ? -1 : 0);
+		} else if (unlikely(profiling.load(std::memory_order_relaxed)) && p_bytes > 0) {
+			// Allocated before profiling started, from now on it belongs to whoever grows it.
+			site = _profiler_get_site(p_site);
+			profiler_sites[site].add(p_bytes, 1);
+		}
+		const uint64_t header = p_bytes | (site << PROFILER_SITE_SHIFT);
+#else
+		const uint64_t header = p_bytes;
 #endif
 
 		if (p_bytes == 0) {
-			free(mem);
+			_free_block(mem);
 			return nullptr;
 		} else {
-			*s = p_bytes;
+			*s = header;
 
-			mem = (uint8_t *)realloc(mem, p_bytes + PAD_ALIGN);
+			mem = (uint8_t *)_realloc_block(mem, p_bytes + PAD_ALIGN);
 			ERR_FAIL_COND_V(!mem, nullptr);
 
 			s = (uint64_t *)mem;
 
-			*s = p_bytes;
+			*s = header;
 
 			return mem + PAD_ALIGN;
 		}
 	} else {
-		mem = (uint8_t *)realloc(mem, p_bytes);
+		mem = (uint8_t *)_realloc_block(mem, p_bytes);
 
 		ERR_FAIL_COND_V(mem == nullptr && p_bytes > 0, nullptr);
 
@@ -155,19 +292,27 @@ void Memory::free_static(void *p_ptr, bool p_pad_align) {
 	bool prepad = p_pad_align;
 #endif
 
+#ifndef SMALL_ALLOCATOR_ENABLED
 	alloc_count.decrement();
+#endif
 
 	if (prepad) {
 		mem -= PAD_ALIGN;
 
 #ifdef DEBUG_ENABLED
 		uint64_t *s = (uint64_t *)mem;
-		mem_usage.sub(*s);
+		const uint64_t bytes = *s & PROFILER_SIZE_MASK;
+		MEM_USAGE_SUB(bytes);
+
+		const uint64_t site = *s >> PROFILER_SITE_SHIFT;
+		if (site) {
+			profiler_sites[site].add(-(int64_t)bytes, -1);
+		}
 #endif
 
-		free(mem);
+		_free_block(mem);
 	} else {
-		free(mem);
+		_free_block(mem);
 	}
 }
 
@@ -176,7 +321,11 @@ uint64_t Memory::get_mem_available() {
 }
 
 uint64_t Memory::get_mem_usage() {
-#ifdef DEBUG_ENABLED
+#if defined(DEBUG_ENABLED) && defined(SMALL_ALLOCATOR_ENABLED)
+	uint64_t usage = SmallAllocator::get_usage();
+	max_usage.exchange_if_greater(usage);
+	return usage;
+#elif defined(DEBUG_ENABLED)
 	return mem_usage.get();
 #else
 	return 0;
@@ -184,13 +333,46 @@ uint64_t Memory::get_mem_usage() {
 }
 
 uint64_t Memory::get_mem_max_usage() {
-#ifdef DEBUG_ENABLED
+#if defined(DEBUG_ENABLED) && defined(SMALL_ALLOCATOR_ENABLED)
+	return max_usage.exchange_if_greater(SmallAllocator::get_usage());
+#elif defined(DEBUG_ENABLED)
 	return max_usage.get();
 #else
 	return 0;
 #endif
 }
 
+#ifdef DEBUG_ENABLED
+void Memory::set_profiling(bool p_enabled) {
+	profiling.store(p_enabled, std::memory_order_relaxed);
+}
+
+bool Memory::is_profiling() {
+	return profiling.load(std::memory_order_relaxed);
+}
+
+uint32_t Memory::get_allocation_sites(AllocationSite *r_sites, uint32_t p_max) {
+	uint32_t count = 0;
+	for (uint32_t i = 1; i <= PROFILER_SITE_OVERFLOW; i++) {
+		const ProfilerSite &entry = profiler_sites[i];
+		const char *site = entry.site.load(std::memory_order_acquire);
+		if (!site) {
+			continue;
+		}
+		if (count < p_max) {
+			AllocationSite &r = r_sites[count];
+			r.site = site;
+			r.live_bytes = entry.live_bytes.load(std::memory_order_relaxed);
+			r.live_count = entry.live_count.load(std::memory_order_relaxed);
+			r.total_bytes = entry.total_bytes.load(std::memory_order_relaxed);
+			r.total_count = entry.total_count.load(std::memory_order_relaxed);
+		}
+		count++;
+	}
+	return count;
+}
+#endif
+
 _GlobalNil::_GlobalNil() {
 	left = this;
 	right = this;
@@ -41,6 +41,27 @@
 #define PAD_ALIGN 16 //must always be greater than this at much
 #endif
 
+#ifdef DEBUG_ENABLED
+// Source location of an allocation, used by the allocation profiler.
+#define MEMORY_SITE __FILE__ ":" _MKSTR(__LINE__)
+#else
+#define MEMORY_SITE ""
+#endif
+
+// Site named after a type, for memory that generic code (containers, ClassDB)
+// allocates on behalf of its users, where the source location would always be
+// the same template.
+template <class T>
+const char *memory_type_site() {
+#ifndef DEBUG_ENABLED
+	return "";
+#elif defined(_MSC_VER)
+	return __FUNCSIG__;
+#else
+	return __PRETTY_FUNCTION__;
+#endif
+}
+
 class Memory {
 #ifdef DEBUG_ENABLED
 	static SafeNumeric<uint64_t> mem_usage;
@@ -50,13 +71,34 @@ class Memory {
 	static SafeNumeric<uint64_t> alloc_count;
 
 public:
-	static void *alloc_static(size_t p_bytes, bool p_pad_align = false);
-	static void *realloc_static(void *p_memory, size_t p_bytes, bool p_pad_align = false);
+	static void *alloc_static(size_t p_bytes, bool p_pad_align = false, const char *p_site = nullptr);
+	static void *realloc_static(void *p_memory, size_t p_bytes, bool p_pad_align = false, const char *p_site = nullptr);
 	static void free_static(void *p_ptr, bool p_pad_align = false);
 
 	static uint64_t get_mem_available();
 	static uint64_t get_mem_usage();
 	static uint64_t get_mem_max_usage();
+
+#ifdef DEBUG_ENABLED
+	// Allocation profiler, only in debug builds as it relies on the debug
+	// allocation header. While enabled, allocations are attributed to the
+	// MEMORY_SITE or memory_type_site() they were made from; the site is kept
+	// in the allocation padding, so blocks allocated while profiling are
+	// accounted for until freed, even after profiling is disabled. Blocks
+	// allocated before are attributed once they are reallocated.
+	struct AllocationSite {
+		const char *site = nullptr;
+		int64_t live_bytes = 0;
+		int64_t live_count = 0;
+		uint64_t total_bytes = 0; // Cumulative, never decreases.
+		uint64_t total_count = 0;
+	};
+
+	static void set_profiling(bool p_enabled);
+	static bool is_profiling();
+	// Copies at most `p_max` sites to `r_sites`, returns the number of sites.
+	static uint32_t get_allocation_sites(AllocationSite *r_sites, uint32_t p_max);
+#endif
 };
 
 class DefaultAllocator {
@@ -78,8 +120,8 @@ void operator delete(void *p_mem, void *(*p_allocfunc)(size_t p_size));
 void operator delete(void *p_mem, void *p_pointer, size_t check, const char *p_description);
 #endif
 
-#define memalloc(m_size) Memory::alloc_static(m_size)
-#define memrealloc(m_mem, m_size) Memory::realloc_static(m_mem, m_size)
+#define memalloc(m_size) Memory::alloc_static(m_size, false, MEMORY_SITE)
+#define memrealloc(m_mem, m_size) Memory::realloc_static(m_mem, m_size, false, MEMORY_SITE)
 #define memfree(m_mem) Memory::free_static(m_mem)
 
 _ALWAYS_INLINE_ void postinitialize_handler(void *) {}
@@ -90,7 +132,7 @@ _ALWAYS_INLINE_ T *_post_initialize(T *p_obj) {
 	return p_obj;
 }
 
-#define memnew(m_class) _post_initialize(new ("") m_class)
+#define memnew(m_class) _post_initialize(new (MEMORY_SITE) m_class)
 
 #define memnew_allocator(m_class, m_allocator) _post_initialize(new (m_allocator::alloc) m_class)
 #define memnew_placement(m_placement, m_class) _post_initialize(new (m_placement) m_class)
@@ -130,10 +172,10 @@ void memdelete_allocator(T *p_class) {
 		}                      \
 	}
 
-#define memnew_arr(m_class, m_count) memnew_arr_template<m_class>(m_count)
+#define memnew_arr(m_class, m_count) memnew_arr_template<m_class>(m_count, MEMORY_SITE)
 
 template <typename T>
-T *memnew_arr_template(size_t p_elements) {
+T *memnew_arr_template(size_t p_elements, const char *p_site = nullptr) {
 	if (p_elements == 0) {
 		return nullptr;
 	}
@@ -141,7 +183,7 @@ T *memnew_arr_template(size_t p_elements) {
 	same strategy used by std::vector, and the Vector class, so it should be safe.*/
 
 	size_t len = sizeof(T) * p_elements;
-	uint64_t *mem = (uint64_t *)Memory::alloc_static(len, true);
+	uint64_t *mem = (uint64_t *)Memory::alloc_static(len, true, p_site);
 	T *failptr = nullptr; //get rid of a warning
 	ERR_FAIL_COND_V(!mem, failptr);
 	*(mem - 1) = p_elements;
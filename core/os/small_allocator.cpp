@@ -0,0 +1,294 @@
+/*************************************************************************/
+/*  small_allocator.cpp                                                  */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "small_allocator.h"
+
+#include "core/os/spin_lock.h"
+
+#include <stdlib.h>
+#include <atomic>
+#include <new>
+
+#define SMALL_ALLOCATOR_SLABS_PER_CHUNK 16
+#define SMALL_ALLOCATOR_CACHE_LINE 64
+
+struct SmallAllocator::ThreadCache {
+	// Only accessed by the thread holding the cache.
+	void *free_list[SIZE_CLASS_COUNT] = {};
+	uint8_t *carve_from[SIZE_CLASS_COUNT] = {};
+	uint8_t *carve_end[SIZE_CLASS_COUNT] = {};
+	// Written by the owning thread only, read when aggregating statistics.
+	std::atomic<int64_t> usage = { 0 };
+
+	ThreadCache *next = nullptr;
+	ThreadCache *next_free = nullptr;
+
+	// Blocks freed by other threads, kept on their own cache line so remote frees
+	// don't keep invalidating the owner's free lists.
+	alignas(SMALL_ALLOCATOR_CACHE_LINE) std::atomic<void *> remote_free[SIZE_CLASS_COUNT];
+
+	ThreadCache() {
+		for (int i = 0; i < SIZE_CLASS_COUNT; i++) {
+			remote_free[i].store(nullptr, std::memory_order_relaxed);
+		}
+	}
+};
+
+// Stored at the start of every slab, blocks follow it.
+struct SmallAllocatorSlab {
+	SmallAllocator::ThreadCache *owner;
+	uint32_t size_class;
+};
+
+#define SMALL_ALLOCATOR_SLAB_HEADER_SIZE SMALL_ALLOCATOR_CACHE_LINE
+static_assert(sizeof(SmallAllocatorSlab) <= SMALL_ALLOCATOR_SLAB_HEADER_SIZE, "Slab header does not fit.");
+
+// Two-level map of which SLAB_SIZE pages are slabs, so owns() works for any
+// pointer without a header in front of every block. Leaves are never freed.
+#define SMALL_ALLOCATOR_PAGEMAP_LEAF_SHIFT 16
+#define SMALL_ALLOCATOR_PAGEMAP_LEAF_SIZE (1 << SMALL_ALLOCATOR_PAGEMAP_LEAF_SHIFT)
+static constexpr uint64_t pagemap_root_size = sizeof(void *) == 8 ? (1 << 16) : 1;
+static std::atomic<uint8_t *> pagemap[pagemap_root_size];
+
+static SpinLock global_lock;
+static SmallAllocator::ThreadCache *caches = nullptr; // All caches, never freed.
+static SmallAllocator::ThreadCache *free_caches = nullptr; // Caches of exited threads.
+static uint8_t *chunk_from = nullptr;
+static uint8_t *chunk_end = nullptr;
+static uint64_t reserved = 0;
+static std::atomic<int64_t> orphan_usage = { 0 }; // Usage changes from threads without a cache.
+
+static thread_local SmallAllocator::ThreadCache *thread_cache = nullptr;
+static thread_local bool thread_cache_released = false;
+
+struct SmallAllocatorThreadCacheReleaser {
+	bool registered = false;
+
+	~SmallAllocatorThreadCacheReleaser() {
+		SmallAllocator::ThreadCache *cache = thread_cache;
+		if (!cache) {
+			return;
+		}
+		// Frees happening later during thread (or process) exit go through the
+		// remote lists, allocations fall back to malloc().
+		thread_cache = nullptr;
+		thread_cache_released = true;
+
+		global_lock.lock();
+		cache->next_free = free_caches;
+		free_caches = cache;
+		global_lock.unlock();
+	}
+};
+
+static thread_local SmallAllocatorThreadCacheReleaser thread_cache_releaser;
+
+static _FORCE_INLINE_ SmallAllocatorSlab *_get_slab(const void *p_ptr) {
+	return (SmallAllocatorSlab *)((uintptr_t)p_ptr & ~(uintptr_t)(SmallAllocator::SLAB_SIZE - 1));
+}
+
+// Must be called with the global lock held.
+static uint8_t *_new_slab() {
+	if (chunk_from == chunk_end) {
+		const size_t size = (size_t)SmallAllocator::SLAB_SIZE * (SMALL_ALLOCATOR_SLABS_PER_CHUNK + 1);
+		uint8_t *chunk = (uint8_t *)malloc(size);
+		if (!chunk) {
+			return nullptr;
+		}
+		reserved += size;
+		chunk_from = (uint8_t *)(((uintptr_t)chunk + SmallAllocator::SLAB_SIZE - 1) & ~(uintptr_t)(SmallAllocator::SLAB_SIZE - 1));
+		chunk_end = chunk_from + (size_t)SmallAllocator::SLAB_SIZE * SMALL_ALLOCATOR_SLABS_PER_CHUNK;
+	}
+
+	const uintptr_t page = (uintptr_t)chunk_from >> SmallAllocator::SLAB_SHIFT;
+	const uint64_t root = (uint64_t)page >> SMALL_ALLOCATOR_PAGEMAP_LEAF_SHIFT;
+	if (root >= pagemap_root_size) {
+		return nullptr; // Address space larger than the page map covers.
+	}
+	uint8_t *leaf = pagemap[root].load(std::memory_order_relaxed);
+	if (!leaf) {
+		leaf = (uint8_t *)calloc(SMALL_ALLOCATOR_PAGEMAP_LEAF_SIZE, 1);
+		if (!leaf) {
+			return nullptr;
+		}
+		pagemap[root].store(leaf, std::memory_order_release);
+	}
+	leaf[page & (SMALL_ALLOCATOR_PAGEMAP_LEAF_SIZE - 1)] = 1;
+
+	uint8_t *slab = chunk_from;
+	chunk_from += SmallAllocator::SLAB_SIZE;
+	return slab;
+}
+
+SmallAllocator::ThreadCache *SmallAllocator::_create_thread_cache() {
+	if (thread_cache_released) {
+		return nullptr;
+	}
+
+	global_lock.lock();
+	ThreadCache *cache = free_caches;
+	if (cache) {
+		free_caches = cache->next_free;
+		cache->next_free = nullptr;
+	} else {
+		// Caches are never freed, so the alignment padding is not kept track of.
+		uint8_t *mem = (uint8_t *)malloc(sizeof(ThreadCache) + SMALL_ALLOCATOR_CACHE_LINE);
+		if (mem) {
+			mem = (uint8_t *)(((uintptr_t)mem + SMALL_ALLOCATOR_CACHE_LINE - 1) & ~(uintptr_t)(SMALL_ALLOCATOR_CACHE_LINE - 1));
+			cache = new (mem) ThreadCache;
+			cache->next = caches;
+			caches = cache;
+		}
+	}
+	global_lock.unlock();
+
+	if (cache) {
+		thread_cache = cache;
+		// Touching the releaser registers its destructor for this thread.
+		thread_cache_releaser.registered = true;
+	}
+	return cache;
+}
+
+void *SmallAllocator::_refill(ThreadCache *p_cache, uint32_t p_size_class) {
+	// Take back whatever other threads freed in the meantime.
+	void *mem = p_cache->remote_free[p_size_class].exchange(nullptr, std::memory_order_acquire);
+	if (mem) {
+		p_cache->free_list[p_size_class] = *(void **)mem;
+		return mem;
+	}
+
+	const size_t size = (size_t)(p_size_class + 1) << SIZE_CLASS_SHIFT;
+	if (p_cache->carve_from[p_size_class] + size > p_cache->carve_end[p_size_class]) {
+		global_lock.lock();
+		uint8_t *slab = _new_slab();
+		global_lock.unlock();
+		if (!slab) {
+			return nullptr;
+		}
+
+		SmallAllocatorSlab *header = (SmallAllocatorSlab *)slab;
+		header->owner = p_cache;
+		header->size_class = p_size_class;
+		p_cache->carve_from[p_size_class] = slab + SMALL_ALLOCATOR_SLAB_HEADER_SIZE;
+		p_cache->carve_end[p_size_class] = slab + SLAB_SIZE;
+	}
+
+	mem = p_cache->carve_from[p_size_class];
+	p_cache->carve_from[p_size_class] += size;
+	return mem;
+}
+
+void *SmallAllocator::alloc(size_t p_bytes) {
+	if (unlikely(p_bytes > MAX_SIZE)) {
+		return nullptr;
+	}
+
+	ThreadCache *cache = thread_cache;
+	if (unlikely(!cache)) {
+		cache = _create_thread_cache();
+		if (!cache) {
+			return nullptr;
+		}
+	}
+
+	const uint32_t size_class = p_bytes ? (uint32_t)((p_bytes - 1) >> SIZE_CLASS_SHIFT) : 0;
+	void *mem = cache->free_list[size_class];
+	if (likely(mem)) {
+		cache->free_list[size_class] = *(void **)mem;
+		return mem;
+	}
+	return _refill(cache, size_class);
+}
+
+void SmallAllocator::free(void *p_ptr) {
+	const SmallAllocatorSlab *slab = _get_slab(p_ptr);
+	ThreadCache *owner = slab->owner;
+	const uint32_t size_class = slab->size_class;
+
+	if (likely(owner == thread_cache)) {
+		*(void **)p_ptr = owner->free_list[size_class];
+		owner->free_list[size_class] = p_ptr;
+		return;
+	}
+
+	// Only the owner ever takes the whole list, so there is no ABA problem here.
+	std::atomic<void *> &remote = owner->remote_free[size_class];
+	void *head = remote.load(std::memory_order_relaxed);
+	do {
+		*(void **)p_ptr = head;
+	} while (!remote.compare_exchange_weak(head, p_ptr, std::memory_order_release, std::memory_order_relaxed));
+}
+
+bool SmallAllocator::owns(const void *p_ptr) {
+	const uintptr_t page = (uintptr_t)p_ptr >> SLAB_SHIFT;
+	const uint64_t root = (uint64_t)page >> SMALL_ALLOCATOR_PAGEMAP_LEAF_SHIFT;
+	if (root >= pagemap_root_size) {
+		return false;
+	}
+	const uint8_t *leaf = pagemap[root].load(std::memory_order_acquire);
+	return leaf && leaf[page & (SMALL_ALLOCATOR_PAGEMAP_LEAF_SIZE - 1)];
+}
+
+size_t SmallAllocator::get_size(const void *p_ptr) {
+	return (size_t)(_get_slab(p_ptr)->size_class + 1) << SIZE_CLASS_SHIFT;
+}
+
+void SmallAllocator::add_usage(int64_t p_bytes) {
+	ThreadCache *cache = thread_cache;
+	if (unlikely(!cache)) {
+		cache = _create_thread_cache();
+		if (!cache) {
+			orphan_usage.fetch_add(p_bytes, std::memory_order_relaxed);
+			return;
+		}
+	}
+	// Single writer, so no atomic read-modify-write needed.
+	cache->usage.store(cache->usage.load(std::memory_order_relaxed) + p_bytes, std::memory_order_relaxed);
+}
+
+uint64_t SmallAllocator::get_usage() {
+	// Blocks freed on other threads than they were allocated on make single
+	// counters go negative, only the sum is meaningful.
+	int64_t usage = orphan_usage.load(std::memory_order_relaxed);
+	global_lock.lock();
+	for (const ThreadCache *cache = caches; cache; cache = cache->next) {
+		usage += cache->usage.load(std::memory_order_relaxed);
+	}
+	global_lock.unlock();
+	return usage > 0 ? (uint64_t)usage : 0;
+}
+
+uint64_t SmallAllocator::get_reserved() {
+	global_lock.lock();
+	uint64_t ret = reserved;
+	global_lock.unlock();
+	return ret;
+}
@@ -0,0 +1,85 @@
+/*************************************************************************/
+/*  small_allocator.h                                                    */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef SMALL_ALLOCATOR_H
+#define SMALL_ALLOCATOR_H
+
+#include "core/typedefs.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Size-class allocator for small memory blocks, used by Memory when built
+// with `small_allocator=yes` (SMALL_ALLOCATOR_ENABLED).
+//
+// Blocks are carved out of SLAB_SIZE-aligned slabs, each slab holding blocks
+// of a single size class and belonging to a single thread cache. Allocation and
+// freeing on the owning thread only touch that thread's free lists. Blocks freed
+// by another thread are pushed to a lock-free list on the owning cache and are
+// picked up the next time the owner runs out of blocks of that size.
+//
+// Slab memory is kept for reuse and never returned to the system. Thread caches
+// are recycled when their thread exits, so a block freed after its thread is
+// gone is still reused by the next thread that takes over the cache.
+class SmallAllocator {
+public:
+	enum {
+		SLAB_SHIFT = 16,
+		SLAB_SIZE = 1 << SLAB_SHIFT,
+		SIZE_CLASS_SHIFT = 4,
+		SIZE_CLASS_GRANULARITY = 1 << SIZE_CLASS_SHIFT, // Keeps blocks aligned like malloc() does.
+		SIZE_CLASS_COUNT = 32,
+		MAX_SIZE = SIZE_CLASS_COUNT * SIZE_CLASS_GRANULARITY,
+	};
+
+	struct ThreadCache;
+
+private:
+	static ThreadCache *_create_thread_cache();
+	static void *_refill(ThreadCache *p_cache, uint32_t p_size_class);
+
+public:
+	// Returns nullptr when the block can't be served (too large, out of memory
+	// or called while the thread is exiting); the caller should fall back to malloc().
+	static void *alloc(size_t p_bytes);
+	// `p_ptr` must have been returned by alloc(), see owns().
+	static void free(void *p_ptr);
+	static bool owns(const void *p_ptr);
+	// Usable size of a block returned by alloc().
+	static size_t get_size(const void *p_ptr);
+
+	// Per-thread memory statistics. Each thread only writes its own counters,
+	// the totals are summed over all threads when requested.
+	static void add_usage(int64_t p_bytes);
+	static uint64_t get_usage();
+	static uint64_t get_reserved();
+};
+
+#endif // SMALL_ALLOCATOR_H
@@ -35,6 +35,7 @@
 #include "core/os/thread.h"
 #include "core/os/thread_safe.h"
 #include "core/templates/safe_refcount.h"
+#include "core/templates/worker_thread_pool.h"
 
 template <class C, class U>
 struct ThreadArrayProcessData {
@@ -49,47 +50,15 @@ struct ThreadArrayProcessData {
 	}
 };
 
-#ifndef NO_THREADS
-
-template <class T>
-void process_array_thread(void *ud) {
-	T &data = *(T *)ud;
-	while (true) {
-		uint32_t index = data.index.increment();
-		if (index >= data.elements) {
-			break;
-		}
-		data.process(index);
-	}
-}
-
+// Runs on the engine-wide worker thread pool, the calling thread takes part.
 template <class C, class M, class U>
 void thread_process_array(uint32_t p_elements, C *p_instance, M p_method, U p_userdata) {
-	ThreadArrayProcessData<C, U> data;
-	data.method = p_method;
-	data.instance = p_instance;
-	data.userdata = p_userdata;
-	data.index.set(0);
-	data.elements = p_elements;
-	data.process(0); //process first, let threads increment for next
-
-	int thread_count = OS::get_singleton()->get_processor_count();
-	Thread *threads = memnew_arr(Thread, thread_count);
-
-	for (int i = 0; i < thread_count; i++) {
-		threads[i].start(process_array_thread<ThreadArrayProcessData<C, U>>, &data);
+	WorkerThreadPool *pool = WorkerThreadPool::get_singleton();
+	if (pool) {
+		pool->parallel_for(p_elements, p_instance, p_method, p_userdata);
+		return;
 	}
 
-	for (int i = 0; i < thread_count; i++) {
-		threads[i].wait_to_finish();
-	}
-	memdelete_arr(threads);
-}
-
-#else
-
-template <class C, class M, class U>
-void thread_process_array(uint32_t p_elements, C *p_instance, M p_method, U p_userdata) {
 	ThreadArrayProcessData<C, U> data;
 	data.method = p_method;
 	data.instance = p_instance;
@@ -101,6 +70,4 @@ void thread_process_array(uint32_t p_elements, C *p_instance, M p_method, U p_us
 	}
 }
 
-#endif
-
 #endif // THREADED_ARRAY_PROCESSOR_H
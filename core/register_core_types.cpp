@@ -77,6 +77,7 @@
 #include "core/os/time.h"
 #include "core/string/optimized_translation.h"
 #include "core/string/translation.h"
+#include "core/templates/worker_thread_pool.h"
 
 static Ref<ResourceFormatSaverBinary> resource_saver_binary;
 static Ref<ResourceFormatLoaderBinary> resource_loader_binary;
@@ -109,6 +110,8 @@ extern void unregister_global_constants();
 
 static ResourceUID *resource_uid = nullptr;
 
+static WorkerThreadPool *worker_thread_pool = nullptr;
+
 static bool _is_core_extensions_registered = false;
 
 void register_core_types() {
@@ -117,6 +120,9 @@ void register_core_types() {
 
 	ObjectDB::setup();
 
+	// Threads are only started once project settings are available, until then all work runs on the calling thread.
+	worker_thread_pool = memnew(WorkerThreadPool);
+
 	StringName::setup();
 	ResourceLoader::initialize();
 
@@ -388,4 +394,6 @@ void unregister_core_types() {
 	ResourceCache::clear();
 	CoreStringNames::free();
 	StringName::cleanup();
+
+	memdelete(worker_thread_pool);
 }
@@ -40,13 +40,13 @@ StaticCString StaticCString::create(const char *p_ptr) {
 }
 
 StringName::_Data *StringName::_table[STRING_TABLE_LEN];
+StringName::_Shard StringName::_shards[STRING_TABLE_SHARDS];
 
 StringName _scs_create(const char *p_chr, bool p_static) {
 	return (p_chr[0] ? StringName(StaticCString::create(p_chr), p_static) : StringName());
 }
 
 bool StringName::configured = false;
-Mutex StringName::mutex;
 
 #ifdef DEBUG_ENABLED
 bool StringName::debug_stringname = false;
@@ -61,7 +61,9 @@ void StringName::setup() {
 }
 
 void StringName::cleanup() {
-	MutexLock lock(mutex);
+	for (int i = 0; i < STRING_TABLE_SHARDS; i++) {
+		_shards[i].mutex.lock();
+	}
 
 #ifdef DEBUG_ENABLED
 	if (unlikely(debug_stringname)) {
@@ -115,14 +117,36 @@ void StringName::cleanup() {
 	if (lost_strings) {
 		print_verbose("StringName: " + itos(lost_strings) + " unclaimed string names at exit.");
 	}
+	print_verbose(vformat("StringName: Table locked %d times, %d of them waited for another thread.", get_lock_count(), get_contended_lock_count()));
 	configured = false;
+
+	for (int i = 0; i < STRING_TABLE_SHARDS; i++) {
+		_shards[i].mutex.unlock();
+	}
+}
+
+uint64_t StringName::get_lock_count() {
+	uint64_t count = 0;
+	for (int i = 0; i < STRING_TABLE_SHARDS; i++) {
+		count += _shards[i].lock_count.get();
+	}
+	return count;
+}
+
+uint64_t StringName::get_contended_lock_count() {
+	uint64_t count = 0;
+	for (int i = 0; i < STRING_TABLE_SHARDS; i++) {
+		count += _shards[i].contended_count.get();
+	}
+	return count;
 }
 
 void StringName::unref() {
 	ERR_FAIL_COND(!configured);
 
 	if (_data && _data->refcount.unref()) {
-		MutexLock lock(mutex);
+		// Lookups that find it before it's unlinked fail to reference it and make a new one.
+		_ShardLock lock(_data->idx);
 
 		if (_data->static_count.get() > 0) {
 			if (_data->cname) {
@@ -206,12 +230,12 @@ StringName::StringName(const char *p_name, bool p_static) {
 		return; //empty, ignore
 	}
 
-	MutexLock lock(mutex);
-
 	uint32_t hash = String::hash(p_name);
 
 	uint32_t idx = hash & STRING_TABLE_MASK;
 
+	_ShardLock lock(idx);
+
 	_data = _table[idx];
 
 	while (_data) {
@@ -233,9 +257,8 @@ StringName::StringName(const char *p_name, bool p_static) {
 				_data->debug_references++;
 			}
 #endif
+			return;
 		}
-
-		return;
 	}
 
 	_data = memnew(_Data);
@@ -267,12 +290,12 @@ StringName::StringName(const StaticCString &p_static_string, bool p_static) {
 
 	ERR_FAIL_COND(!p_static_string.ptr || !p_static_string.ptr[0]);
 
-	MutexLock lock(mutex);
-
 	uint32_t hash = String::hash(p_static_string.ptr);
 
 	uint32_t idx = hash & STRING_TABLE_MASK;
 
+	_ShardLock lock(idx);
+
 	_data = _table[idx];
 
 	while (_data) {
@@ -329,11 +352,11 @@ StringName::StringName(const String &p_name, bool p_static) {
 		return;
 	}
 
-	MutexLock lock(mutex);
-
 	uint32_t hash = p_name.hash();
 	uint32_t idx = hash & STRING_TABLE_MASK;
 
+	_ShardLock lock(idx);
+
 	_data = _table[idx];
 
 	while (_data) {
@@ -389,11 +412,11 @@ StringName StringName::search(const char *p_name) {
 		return StringName();
 	}
 
-	MutexLock lock(mutex);
-
 	uint32_t hash = String::hash(p_name);
 	uint32_t idx = hash & STRING_TABLE_MASK;
 
+	_ShardLock lock(idx);
+
 	_Data *_data = _table[idx];
 
 	while (_data) {
@@ -425,12 +448,12 @@ StringName StringName::search(const char32_t *p_name) {
 		return StringName();
 	}
 
-	MutexLock lock(mutex);
-
 	uint32_t hash = String::hash(p_name);
 
 	uint32_t idx = hash & STRING_TABLE_MASK;
 
+	_ShardLock lock(idx);
+
 	_Data *_data = _table[idx];
 
 	while (_data) {
@@ -451,12 +474,12 @@ StringName StringName::search(const char32_t *p_name) {
 StringName StringName::search(const String &p_name) {
 	ERR_FAIL_COND_V(p_name.is_empty(), StringName());
 
-	MutexLock lock(mutex);
-
 	uint32_t hash = p_name.hash();
 
 	uint32_t idx = hash & STRING_TABLE_MASK;
 
+	_ShardLock lock(idx);
+
 	_Data *_data = _table[idx];
 
 	while (_data) {
@@ -46,7 +46,10 @@ class StringName {
 	enum {
 		STRING_TABLE_BITS = 16,
 		STRING_TABLE_LEN = 1 << STRING_TABLE_BITS,
-		STRING_TABLE_MASK = STRING_TABLE_LEN - 1
+		STRING_TABLE_MASK = STRING_TABLE_LEN - 1,
+		STRING_TABLE_SHARD_BITS = 6,
+		STRING_TABLE_SHARDS = 1 << STRING_TABLE_SHARD_BITS,
+		STRING_TABLE_SHARD_MASK = STRING_TABLE_SHARDS - 1
 	};
 
 	struct _Data {
@@ -67,6 +70,34 @@ class StringName {
 
 	static _Data *_table[STRING_TABLE_LEN];
 
+	// Each shard guards the buckets whose index ends with its bits, so threads
+	// only wait on each other when they touch names that hash alike.
+	struct alignas(64) _Shard {
+		BinaryMutex mutex;
+		SafeNumeric<uint64_t> lock_count;
+		SafeNumeric<uint64_t> contended_count;
+	};
+
+	static _Shard _shards[STRING_TABLE_SHARDS];
+
+	class _ShardLock {
+		_Shard &shard;
+
+	public:
+		_FORCE_INLINE_ explicit _ShardLock(uint32_t p_idx) :
+				shard(_shards[p_idx & STRING_TABLE_SHARD_MASK]) {
+			if (shard.mutex.try_lock() != OK) {
+				shard.contended_count.increment();
+				shard.mutex.lock();
+			}
+			shard.lock_count.increment();
+		}
+
+		_FORCE_INLINE_ ~_ShardLock() {
+			shard.mutex.unlock();
+		}
+	};
+
 	_Data *_data = nullptr;
 
 	union _HashUnion {
@@ -78,7 +109,6 @@ class StringName {
 	friend void register_core_types();
 	friend void unregister_core_types();
 	friend class Main;
-	static Mutex mutex;
 	static void setup();
 	static void cleanup();
 	static bool configured;
@@ -136,6 +166,10 @@ public:
 	static StringName search(const char32_t *p_name);
 	static StringName search(const String &p_name);
 
+	// How many times the table was locked, and how many of those had to wait for another thread.
+	static uint64_t get_lock_count();
+	static uint64_t get_contended_lock_count();
+
 	struct AlphCompare {
 		_FORCE_INLINE_ bool operator()(const StringName &l, const StringName &r) const {
 			const char *l_cname = l._data ? l._data->cname : "";
@@ -33,12 +33,162 @@
 #include "core/config/project_settings.h"
 #include "core/os/os.h"
 
-void CommandQueueMT::lock() {
-	mutex.lock();
+// Queues that are still alive, so exiting threads only give back producers that still exist.
+static Mutex live_queues_mutex;
+static LocalVector<uint64_t> live_queues;
+static SafeNumeric<uint64_t> last_queue_id;
+
+thread_local CommandQueueMT::ProducerCache CommandQueueMT::producer_cache;
+
+CommandQueueMT::ProducerCache::~ProducerCache() {
+	MutexLock lock(live_queues_mutex);
+	for (uint32_t i = 0; i < slots.size(); i++) {
+		if (live_queues.find(slots[i].queue_id) == -1) {
+			continue;
+		}
+		Producer *producer = slots[i].producer;
+		if (producer->batch_depth > 0) {
+			producer->batch_depth = 0;
+			producer->write_segment->committed.store(producer->write_pos, std::memory_order_release);
+		}
+		producer->claimed.store(false, std::memory_order_release);
+	}
+}
+
+CommandQueueMT::Producer *CommandQueueMT::_find_producer() {
+	ProducerCache &cache = producer_cache;
+	Producer *producer = nullptr;
+	for (uint32_t i = 0; i < cache.slots.size(); i++) {
+		if (cache.slots[i].queue_id == id) {
+			producer = cache.slots[i].producer;
+			break;
+		}
+	}
+
+	if (!producer) {
+		producer = _claim_producer();
+
+		{
+			// Forget about the queues that were destroyed since this thread last got here.
+			MutexLock lock(live_queues_mutex);
+			for (uint32_t i = 0; i < cache.slots.size(); i++) {
+				if (live_queues.find(cache.slots[i].queue_id) == -1) {
+					cache.slots.remove_at_unordered(i);
+					i--;
+				}
+			}
+		}
+
+		ProducerSlot slot;
+		slot.queue_id = id;
+		slot.producer = producer;
+		cache.slots.push_back(slot);
+	}
+
+	cache.last_queue_id = id;
+	cache.last_producer = producer;
+	return producer;
+}
+
+CommandQueueMT::Producer *CommandQueueMT::_claim_producer() {
+	MutexLock lock(producers_mutex);
+
+	// Reuse the producer of a thread that has exited, if any.
+	for (Producer *producer = producers.load(std::memory_order_acquire); producer; producer = producer->next) {
+		bool claimed = false;
+		if (producer->claimed.compare_exchange_strong(claimed, true, std::memory_order_acquire)) {
+			return producer;
+		}
+	}
+
+	Producer *producer = memnew(Producer);
+	producer->write_segment = memnew(Segment);
+	producer->read_segment = producer->write_segment;
+	producer->next = producers.load(std::memory_order_relaxed);
+	producers.store(producer, std::memory_order_release);
+	return producer;
+}
+
+void CommandQueueMT::_next_segment(Producer *p_producer) {
+	// Only this thread takes segments out of the free list, so it can't suffer from ABA.
+	Segment *segment = p_producer->free_segments.load(std::memory_order_acquire);
+	while (segment && !p_producer->free_segments.compare_exchange_weak(segment, segment->next_free, std::memory_order_acquire, std::memory_order_acquire)) {
+	}
+
+	if (segment) {
+		segment->committed.store(0, std::memory_order_relaxed);
+		segment->next.store(nullptr, std::memory_order_relaxed);
+		segment->next_free = nullptr;
+	} else {
+		segment = memnew(Segment);
+	}
+
+	// Everything in the old segment must be visible before the consumer can move past it.
+	Segment *old_segment = p_producer->write_segment;
+	old_segment->committed.store(p_producer->write_pos, std::memory_order_release);
+	old_segment->next.store(segment, std::memory_order_release);
+
+	p_producer->write_segment = segment;
+	p_producer->write_pos = 0;
+}
+
+CommandQueueMT::CommandHeader *CommandQueueMT::_peek(Producer *p_producer) {
+	while (true) {
+		Segment *segment = p_producer->read_segment;
+		if (p_producer->read_pos < segment->committed.load(std::memory_order_acquire)) {
+			return reinterpret_cast<CommandHeader *>(&segment->data[p_producer->read_pos]);
+		}
+
+		Segment *next = segment->next.load(std::memory_order_acquire);
+		if (!next) {
+			return nullptr;
+		}
+		if (p_producer->read_pos < segment->committed.load(std::memory_order_acquire)) {
+			continue; // Committed for the last time right before moving on.
+		}
+
+		p_producer->read_segment = next;
+		p_producer->read_pos = 0;
+
+		Segment *free_head = p_producer->free_segments.load(std::memory_order_relaxed);
+		do {
+			segment->next_free = free_head;
+		} while (!p_producer->free_segments.compare_exchange_weak(free_head, segment, std::memory_order_release, std::memory_order_relaxed));
+	}
 }
 
-void CommandQueueMT::unlock() {
-	mutex.unlock();
+void CommandQueueMT::_flush() {
+	MutexLock lock(flush_mutex);
+	if (flush_depth > 0) {
+		// Flushing from inside a command, whatever it pushed is picked up by the outer flush.
+		return;
+	}
+	flush_depth++;
+
+	while (true) {
+		// Merge the producers back into a single stream, oldest ticket first.
+		Producer *producer = nullptr;
+		CommandHeader *header = nullptr;
+		for (Producer *E = producers.load(std::memory_order_acquire); E; E = E->next) {
+			CommandHeader *candidate = _peek(E);
+			if (candidate && (!header || candidate->ticket < header->ticket)) {
+				producer = E;
+				header = candidate;
+			}
+		}
+		if (!header) {
+			break;
+		}
+
+		producer->read_pos += sizeof(CommandHeader) + header->size;
+		CommandBase *cmd = reinterpret_cast<CommandBase *>(header + 1);
+		cmd->call(); //execute the function
+		cmd->post(); //release in case it needs sync/ret
+		cmd->~CommandBase(); //should be done, so erase the command
+		executed_tickets.increment();
+	}
+
+	flush_depth--;
 }
 
 void CommandQueueMT::wait_for_flush() {
@@ -47,36 +197,55 @@ void CommandQueueMT::wait_for_flush() {
 }
 
 CommandQueueMT::SyncSemaphore *CommandQueueMT::_alloc_sync_sem() {
-	int idx = -1;
-
 	while (true) {
-		lock();
 		for (int i = 0; i < SYNC_SEMAPHORES; i++) {
-			if (!sync_sems[i].in_use) {
-				sync_sems[i].in_use = true;
-				idx = i;
-				break;
+			bool in_use = false;
+			if (sync_sems[i].in_use.compare_exchange_strong(in_use, true, std::memory_order_acquire)) {
+				return &sync_sems[i];
 			}
 		}
-		unlock();
-
-		if (idx == -1) {
-			wait_for_flush();
-		} else {
-			break;
-		}
+		wait_for_flush();
 	}
-
-	return &sync_sems[idx];
 }
 
 CommandQueueMT::CommandQueueMT(bool p_sync) {
+	id = last_queue_id.increment();
+	{
+		MutexLock lock(live_queues_mutex);
+		live_queues.push_back(id);
+	}
+
 	if (p_sync) {
 		sync = memnew(Semaphore);
 	}
 }
 
 CommandQueueMT::~CommandQueueMT() {
+	{
+		MutexLock lock(live_queues_mutex);
+		live_queues.erase(id);
+	}
+
+	Producer *producer = producers.load(std::memory_order_acquire);
+	while (producer) {
+		Segment *segment = producer->read_segment;
+		while (segment) {
+			Segment *next = segment->next.load(std::memory_order_relaxed);
+			memdelete(segment);
+			segment = next;
+		}
+		segment = producer->free_segments.load(std::memory_order_relaxed);
+		while (segment) {
+			Segment *next = segment->next_free;
+			memdelete(segment);
+			segment = next;
+		}
+
+		Producer *next = producer->next;
+		memdelete(producer);
+		producer = next;
+	}
+
 	if (sync) {
 		memdelete(sync);
 	}
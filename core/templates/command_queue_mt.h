@@ -36,9 +36,12 @@
 #include "core/os/semaphore.h"
 #include "core/string/print_string.h"
 #include "core/templates/local_vector.h"
+#include "core/templates/safe_refcount.h"
 #include "core/templates/simple_type.h"
 #include "core/typedefs.h"
 
+#include <atomic>
+
 #define COMMA(N) _COMMA_##N
 #define _COMMA_0
 #define _COMMA_1 ,
@@ -250,13 +253,12 @@
 #define DECL_PUSH(N)                                                         \
 	template <class T, class M COMMA(N) COMMA_SEP_LIST(TYPE_PARAM, N)>       \
 	void push(T *p_instance, M p_method COMMA(N) COMMA_SEP_LIST(PARAM, N)) { \
-		CMD_TYPE(N) *cmd = allocate_and_lock<CMD_TYPE(N)>();                 \
+		Producer *producer = _get_producer();                                \
+		CMD_TYPE(N) *cmd = _allocate<CMD_TYPE(N)>(producer);                 \
 		cmd->instance = p_instance;                                          \
 		cmd->method = p_method;                                              \
 		SEMIC_SEP_LIST(CMD_ASSIGN_PARAM, N);                                 \
-		unlock();                                                            \
-		if (sync)                                                            \
-			sync->post();                                                    \
+		_commit(producer);                                                   \
 	}
 
 #define CMD_RET_TYPE(N) CommandRet##N<T, M, COMMA_SEP_LIST(TYPE_ARG, N) COMMA(N) R>
@@ -265,17 +267,16 @@
 	template <class T, class M, COMMA_SEP_LIST(TYPE_PARAM, N) COMMA(N) class R>                \
 	void push_and_ret(T *p_instance, M p_method, COMMA_SEP_LIST(PARAM, N) COMMA(N) R *r_ret) { \
 		SyncSemaphore *ss = _alloc_sync_sem();                                                 \
-		CMD_RET_TYPE(N) *cmd = allocate_and_lock<CMD_RET_TYPE(N)>();                           \
+		Producer *producer = _get_producer();                                                  \
+		CMD_RET_TYPE(N) *cmd = _allocate<CMD_RET_TYPE(N)>(producer);                           \
 		cmd->instance = p_instance;                                                            \
 		cmd->method = p_method;                                                                \
 		SEMIC_SEP_LIST(CMD_ASSIGN_PARAM, N);                                                   \
 		cmd->ret = r_ret;                                                                      \
 		cmd->sync_sem = ss;                                                                    \
-		unlock();                                                                              \
-		if (sync)                                                                              \
-			sync->post();                                                                      \
+		_commit_now(producer);                                                                 \
 		ss->sem.wait();                                                                        \
-		ss->in_use = false;                                                                    \
+		ss->in_use.store(false, std::memory_order_release);                                    \
 	}
 
 #define CMD_SYNC_TYPE(N) CommandSync##N<T, M COMMA(N) COMMA_SEP_LIST(TYPE_ARG, N)>
@@ -284,16 +285,15 @@
 	template <class T, class M COMMA(N) COMMA_SEP_LIST(TYPE_PARAM, N)>                \
 	void push_and_sync(T *p_instance, M p_method COMMA(N) COMMA_SEP_LIST(PARAM, N)) { \
 		SyncSemaphore *ss = _alloc_sync_sem();                                        \
-		CMD_SYNC_TYPE(N) *cmd = allocate_and_lock<CMD_SYNC_TYPE(N)>();                \
+		Producer *producer = _get_producer();                                         \
+		CMD_SYNC_TYPE(N) *cmd = _allocate<CMD_SYNC_TYPE(N)>(producer);                \
 		cmd->instance = p_instance;                                                   \
 		cmd->method = p_method;                                                       \
 		SEMIC_SEP_LIST(CMD_ASSIGN_PARAM, N);                                          \
 		cmd->sync_sem = ss;                                                           \
-		unlock();                                                                     \
-		if (sync)                                                                     \
-			sync->post();                                                             \
+		_commit_now(producer);                                                        \
 		ss->sem.wait();                                                               \
-		ss->in_use = false;                                                           \
+		ss->in_use.store(false, std::memory_order_release);                           \
 	}
 
 #define MAX_CMD_PARAMS 15
@@ -301,7 +301,7 @@
 class CommandQueueMT {
 	struct SyncSemaphore {
 		Semaphore sem;
-		bool in_use = false;
+		std::atomic<bool> in_use = { false };
 	};
 
 	struct CommandBase {
@@ -332,57 +332,115 @@ class CommandQueueMT {
 	/***** BASE *******/
 
 	enum {
-		DEFAULT_COMMAND_MEM_SIZE_KB = 256,
+		SEGMENT_SIZE = 64 * 1024,
 		SYNC_SEMAPHORES = 8
 	};
 
-	LocalVector<uint8_t> command_mem;
+	// Tickets come from a single counter, so the consumer can replay the
+	// commands of all producers in the order they were pushed.
+	struct CommandHeader {
+		uint64_t ticket = 0;
+		uint64_t size = 0;
+	};
+
+	// Commands are written by a single producer thread and read by the consumer
+	// up to the committed offset. Once full, the producer links the next one.
+	struct Segment {
+		std::atomic<uint32_t> committed = { 0 };
+		std::atomic<Segment *> next = { nullptr };
+		Segment *next_free = nullptr;
+		alignas(8) uint8_t data[SEGMENT_SIZE];
+	};
+
+	struct Producer {
+		Producer *next = nullptr; // Never changes once the consumer can see the producer.
+		std::atomic<bool> claimed = { true };
+
+		// Only touched by the thread that claimed the producer.
+		Segment *write_segment = nullptr;
+		uint32_t write_pos = 0;
+		uint32_t batch_depth = 0;
+
+		// Only touched by the consumer.
+		Segment *read_segment = nullptr;
+		uint32_t read_pos = 0;
+
+		// Segments the consumer is done with, given back to the producer to reuse.
+		std::atomic<Segment *> free_segments = { nullptr };
+	};
+
+	struct ProducerSlot {
+		uint64_t queue_id = 0;
+		Producer *producer = nullptr;
+	};
+
+	// Remembers the producer each thread uses for every queue, and gives them
+	// back for other threads to claim when the thread exits.
+	struct ProducerCache {
+		uint64_t last_queue_id = 0;
+		Producer *last_producer = nullptr;
+		LocalVector<ProducerSlot> slots;
+
+		~ProducerCache();
+	};
+
+	static thread_local ProducerCache producer_cache;
+
+	uint64_t id = 0;
+	std::atomic<Producer *> producers = { nullptr };
+	Mutex producers_mutex; // Only taken the first time a thread pushes to this queue.
+	SafeNumeric<uint64_t> next_ticket;
+	SafeNumeric<uint64_t> executed_tickets;
+
 	SyncSemaphore sync_sems[SYNC_SEMAPHORES];
-	Mutex mutex;
+	Mutex flush_mutex;
+	uint32_t flush_depth = 0;
 	Semaphore *sync = nullptr;
 
+	_FORCE_INLINE_ Producer *_get_producer() {
+		if (likely(producer_cache.last_queue_id == id)) {
+			return producer_cache.last_producer;
+		}
+		return _find_producer();
+	}
+
 	template <class T>
-	T *allocate() {
-		// alloc size is size+T+safeguard
+	T *_allocate(Producer *p_producer) {
+		static_assert(sizeof(CommandHeader) + sizeof(T) <= SEGMENT_SIZE, "Command is too big for a queue segment.");
+		// alloc size is header+T, keeping the next header aligned
 		uint32_t alloc_size = ((sizeof(T) + 8 - 1) & ~(8 - 1));
-		uint64_t size = command_mem.size();
-		command_mem.resize(size + alloc_size + 8);
-		*(uint64_t *)&command_mem[size] = alloc_size;
-		T *cmd = memnew_placement(&command_mem[size + 8], T);
+		uint32_t total_size = sizeof(CommandHeader) + alloc_size;
+		if (unlikely(p_producer->write_pos + total_size > SEGMENT_SIZE)) {
+			_next_segment(p_producer);
+		}
+		CommandHeader *header = reinterpret_cast<CommandHeader *>(&p_producer->write_segment->data[p_producer->write_pos]);
+		header->ticket = next_ticket.postincrement();
+		header->size = alloc_size;
+		p_producer->write_pos += total_size;
+		T *cmd = memnew_placement(header + 1, T);
 		return cmd;
 	}
 
-	template <class T>
-	T *allocate_and_lock() {
-		lock();
-		T *ret = allocate<T>();
-		return ret;
+	_FORCE_INLINE_ void _commit_now(Producer *p_producer) {
+		p_producer->write_segment->committed.store(p_producer->write_pos, std::memory_order_release);
+		if (sync) {
+			sync->post();
+		}
 	}
 
-	void _flush() {
-		lock();
-
-		uint64_t read_ptr = 0;
-		uint64_t limit = command_mem.size();
-
-		while (read_ptr < limit) {
-			uint64_t size = *(uint64_t *)&command_mem[read_ptr];
-			read_ptr += 8;
-			CommandBase *cmd = reinterpret_cast<CommandBase *>(&command_mem[read_ptr]);
-
-			cmd->call(); //execute the function
-			cmd->post(); //release in case it needs sync/ret
-			cmd->~CommandBase(); //should be done, so erase the command
-
-			read_ptr += size;
+	_FORCE_INLINE_ void _commit(Producer *p_producer) {
+		if (p_producer->batch_depth > 0) {
+			return; // end_batch() commits everything at once.
 		}
-
-		command_mem.clear();
-		unlock();
+		_commit_now(p_producer);
 	}
 
-	void lock();
-	void unlock();
+	Producer *_find_producer();
+	Producer *_claim_producer();
+	void _next_segment(Producer *p_producer);
+	CommandHeader *_peek(Producer *p_producer);
+	void _flush();
+
 	void wait_for_flush();
 	SyncSemaphore *_alloc_sync_sem();
 
@@ -399,8 +457,23 @@ public:
 	DECL_PUSH_AND_SYNC(0)
 	SPACE_SEP_LIST(DECL_PUSH_AND_SYNC, 15)
 
+	// Commands pushed by the calling thread until the matching end_batch() are
+	// handed to the consumer at once, waking it up a single time.
+	void begin_batch() {
+		_get_producer()->batch_depth++;
+	}
+
+	void end_batch() {
+		Producer *producer = _get_producer();
+		ERR_FAIL_COND(producer->batch_depth == 0);
+		producer->batch_depth--;
+		if (producer->batch_depth == 0 && producer->write_segment->committed.load(std::memory_order_relaxed) != producer->write_pos) {
+			_commit_now(producer);
+		}
+	}
+
 	_FORCE_INLINE_ void flush_if_pending() {
-		if (unlikely(command_mem.size() > 0)) {
+		if (unlikely(next_ticket.get() != executed_tickets.get())) {
 			_flush();
 		}
 	}
@@ -0,0 +1,406 @@
+/*************************************************************************/
+/*  dense_hash_map.h                                                     */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef DENSE_HASH_MAP_H
+#define DENSE_HASH_MAP_H
+
+#include "core/error/error_macros.h"
+#include "core/os/memory.h"
+#include "core/templates/hashfuncs.h"
+#include "core/templates/pair.h"
+
+/**
+ * An insertion-ordered hash map with open addressing.
+ *
+ * Elements are stored contiguously in the order they were inserted, so
+ * iterating is a linear walk and inserting never allocates a node. A separate
+ * table of (hash, element index) slots, probed with Robin Hood hashing, is
+ * used to find them. Lookups only touch the slots until the hash matches.
+ *
+ * Erasing leaves a hole in the elements, skipped while iterating, which is
+ * compacted away when the map grows or when more than half of it is holes.
+ * Inserting or erasing invalidates iterators and pointers to elements.
+ */
+template <class TKey, class TValue,
+		class Hasher = HashMapHasherDefault,
+		class Comparator = HashMapComparatorDefault<TKey>>
+class DenseHashMap {
+public:
+	typedef KeyValue<TKey, TValue> Element;
+
+private:
+	struct Slot {
+		uint32_t hash = EMPTY_HASH;
+		uint32_t index = 0;
+	};
+
+	static const uint32_t EMPTY_HASH = 0;
+	static const uint32_t MIN_CAPACITY_BITS = 3;
+
+	Element *elements = nullptr;
+	uint32_t *element_hashes = nullptr; // EMPTY_HASH for erased elements.
+	uint32_t element_count = 0; // Including erased ones.
+	uint32_t erased_count = 0;
+
+	Slot *slots = nullptr;
+	uint32_t capacity_bits = 0;
+
+	_FORCE_INLINE_ uint32_t _get_slot_capacity() const {
+		return slots ? (1u << capacity_bits) : 0;
+	}
+
+	_FORCE_INLINE_ uint32_t _get_element_capacity() const {
+		// Keeps the slots at most three quarters full.
+		return _get_slot_capacity() / 4 * 3;
+	}
+
+	_FORCE_INLINE_ static uint32_t _hash(const TKey &p_key) {
+		uint32_t hash = Hasher::hash(p_key);
+		return hash == EMPTY_HASH ? EMPTY_HASH + 1 : hash;
+	}
+
+	_FORCE_INLINE_ uint32_t _get_home(uint32_t p_hash) const {
+		// Fibonacci hashing, so hashes that only differ in their high bits still spread out.
+		return (p_hash * 2654435769u) >> (32 - capacity_bits);
+	}
+
+	_FORCE_INLINE_ uint32_t _get_probe_length(uint32_t p_pos, uint32_t p_hash) const {
+		return (p_pos - _get_home(p_hash)) & (_get_slot_capacity() - 1);
+	}
+
+	int32_t _find_slot(const TKey &p_key, uint32_t p_hash) const {
+		if (unlikely(!slots)) {
+			return -1;
+		}
+
+		uint32_t mask = _get_slot_capacity() - 1;
+		uint32_t pos = _get_home(p_hash);
+		uint32_t distance = 0;
+		while (true) {
+			const Slot &slot = slots[pos];
+			if (slot.hash == EMPTY_HASH || distance > _get_probe_length(pos, slot.hash)) {
+				return -1;
+			}
+			if (slot.hash == p_hash && Comparator::compare(elements[slot.index].key, p_key)) {
+				return pos;
+			}
+			pos = (pos + 1) & mask;
+			distance++;
+		}
+	}
+
+	void _insert_slot(uint32_t p_hash, uint32_t p_index) {
+		uint32_t mask = _get_slot_capacity() - 1;
+		Slot slot;
+		slot.hash = p_hash;
+		slot.index = p_index;
+		uint32_t pos = _get_home(p_hash);
+		uint32_t distance = 0;
+		while (true) {
+			if (slots[pos].hash == EMPTY_HASH) {
+				slots[pos] = slot;
+				return;
+			}
+
+			// Take the place of slots closer to their home than this one.
+			uint32_t existing_distance = _get_probe_length(pos, slots[pos].hash);
+			if (existing_distance < distance) {
+				SWAP(slot, slots[pos]);
+				distance = existing_distance;
+			}
+			pos = (pos + 1) & mask;
+			distance++;
+		}
+	}
+
+	void _rehash(uint32_t p_capacity_bits) {
+		uint32_t new_slot_capacity = 1u << p_capacity_bits;
+		uint32_t new_element_capacity = new_slot_capacity / 4 * 3;
+
+		Element *new_elements = (Element *)Memory::alloc_static(sizeof(Element) * new_element_capacity);
+		uint32_t *new_element_hashes = (uint32_t *)Memory::alloc_static(sizeof(uint32_t) * new_element_capacity);
+
+		// Compact the live elements, keeping their order.
+		uint32_t new_count = 0;
+		for (uint32_t i = 0; i < element_count; i++) {
+			if (element_hashes[i] == EMPTY_HASH) {
+				continue;
+			}
+			memnew_placement(&new_elements[new_count], Element(elements[i]));
+			new_element_hashes[new_count] = element_hashes[i];
+			elements[i].~Element();
+			new_count++;
+		}
+
+		if (elements) {
+			Memory::free_static(elements);
+			Memory::free_static(element_hashes);
+			Memory::free_static(slots);
+		}
+		elements = new_elements;
+		element_hashes = new_element_hashes;
+		element_count = new_count;
+		erased_count = 0;
+
+		capacity_bits = p_capacity_bits;
+		slots = (Slot *)Memory::alloc_static(sizeof(Slot) * new_slot_capacity);
+		for (uint32_t i = 0; i < new_slot_capacity; i++) {
+			slots[i] = Slot();
+		}
+		for (uint32_t i = 0; i < element_count; i++) {
+			_insert_slot(element_hashes[i], i);
+		}
+	}
+
+	void _make_room() {
+		if (likely(element_count < _get_element_capacity())) {
+			return;
+		}
+
+		// Grow unless compacting the holes frees at least half of the room.
+		uint32_t bits = slots ? capacity_bits : MIN_CAPACITY_BITS;
+		uint32_t live_count = element_count - erased_count;
+		while (live_count + 1 > ((1u << bits) / 4 * 3) / 2) {
+			bits++;
+		}
+		_rehash(bits);
+	}
+
+	Element *_insert_new(uint32_t p_hash, const TKey &p_key, const TValue &p_value) {
+		_make_room();
+		uint32_t index = element_count++;
+		memnew_placement(&elements[index], Element(p_key, p_value));
+		element_hashes[index] = p_hash;
+		_insert_slot(p_hash, index);
+		return &elements[index];
+	}
+
+	void _erase_slot(uint32_t p_pos) {
+		uint32_t mask = _get_slot_capacity() - 1;
+		uint32_t index = slots[p_pos].index;
+
+		// Shift the following slots back, instead of leaving a tombstone.
+		uint32_t pos = p_pos;
+		uint32_t next = (pos + 1) & mask;
+		while (slots[next].hash != EMPTY_HASH && _get_probe_length(next, slots[next].hash) != 0) {
+			slots[pos] = slots[next];
+			pos = next;
+			next = (next + 1) & mask;
+		}
+		slots[pos].hash = EMPTY_HASH;
+
+		elements[index].~Element();
+		element_hashes[index] = EMPTY_HASH;
+		erased_count++;
+
+		// Erased elements at the end don't need to stay as holes.
+		while (element_count > 0 && element_hashes[element_count - 1] == EMPTY_HASH) {
+			element_count--;
+			erased_count--;
+		}
+
+		if (erased_count > element_count / 2) {
+			_rehash(capacity_bits);
+		}
+	}
+
+public:
+	template <class TElement, class TMap>
+	struct IteratorBase {
+		TMap *map = nullptr;
+		uint32_t index = 0;
+
+		_FORCE_INLINE_ TElement &operator*() const {
+			return map->elements[index];
+		}
+		_FORCE_INLINE_ TElement *operator->() const {
+			return &map->elements[index];
+		}
+		_FORCE_INLINE_ IteratorBase &operator++() {
+			index++;
+			while (index < map->element_count && map->element_hashes[index] == EMPTY_HASH) {
+				index++;
+			}
+			return *this;
+		}
+		_FORCE_INLINE_ bool operator==(const IteratorBase &p_it) const { return map == p_it.map && index == p_it.index; }
+		_FORCE_INLINE_ bool operator!=(const IteratorBase &p_it) const { return map != p_it.map || index != p_it.index; }
+
+		IteratorBase(TMap *p_map, uint32_t p_index) :
+				map(p_map), index(p_index) {
+			while (index < map->element_count && map->element_hashes[index] == EMPTY_HASH) {
+				index++;
+			}
+		}
+	};
+
+	typedef IteratorBase<Element, DenseHashMap> Iterator;
+	typedef IteratorBase<const Element, const DenseHashMap> ConstIterator;
+
+	_FORCE_INLINE_ Iterator begin() { return Iterator(this, 0); }
+	_FORCE_INLINE_ Iterator end() { return Iterator(this, element_count); }
+	_FORCE_INLINE_ ConstIterator begin() const { return ConstIterator(this, 0); }
+	_FORCE_INLINE_ ConstIterator end() const { return ConstIterator(this, element_count); }
+
+	_FORCE_INLINE_ uint32_t size() const { return element_count - erased_count; }
+	_FORCE_INLINE_ bool is_empty() const { return element_count == erased_count; }
+
+	Iterator find(const TKey &p_key) {
+		int32_t pos = _find_slot(p_key, _hash(p_key));
+		return pos < 0 ? end() : Iterator(this, slots[pos].index);
+	}
+
+	ConstIterator find(const TKey &p_key) const {
+		int32_t pos = _find_slot(p_key, _hash(p_key));
+		return pos < 0 ? end() : ConstIterator(this, slots[pos].index);
+	}
+
+	_FORCE_INLINE_ bool has(const TKey &p_key) const {
+		return _find_slot(p_key, _hash(p_key)) >= 0;
+	}
+
+	TValue *getptr(const TKey &p_key) {
+		int32_t pos = _find_slot(p_key, _hash(p_key));
+		return pos < 0 ? nullptr : &elements[slots[pos].index].value;
+	}
+
+	const TValue *getptr(const TKey &p_key) const {
+		int32_t pos = _find_slot(p_key, _hash(p_key));
+		return pos < 0 ? nullptr : &elements[slots[pos].index].value;
+	}
+
+	const TValue &get(const TKey &p_key) const {
+		const TValue *value = getptr(p_key);
+		CRASH_COND_MSG(!value, "DenseHashMap key not found.");
+		return *value;
+	}
+
+	TValue &get(const TKey &p_key) {
+		TValue *value = getptr(p_key);
+		CRASH_COND_MSG(!value, "DenseHashMap key not found.");
+		return *value;
+	}
+
+	// Replaces the value if the key is already there, it keeps its place in the order.
+	Iterator insert(const TKey &p_key, const TValue &p_value) {
+		uint32_t hash = _hash(p_key);
+		int32_t pos = _find_slot(p_key, hash);
+		if (pos >= 0) {
+			uint32_t index = slots[pos].index;
+			elements[index].value = p_value;
+			return Iterator(this, index);
+		}
+		Element *element = _insert_new(hash, p_key, p_value);
+		return Iterator(this, element - elements);
+	}
+
+	TValue &operator[](const TKey &p_key) {
+		uint32_t hash = _hash(p_key);
+		int32_t pos = _find_slot(p_key, hash);
+		if (pos >= 0) {
+			return elements[slots[pos].index].value;
+		}
+		return _insert_new(hash, p_key, TValue())->value;
+	}
+
+	bool erase(const TKey &p_key) {
+		int32_t pos = _find_slot(p_key, _hash(p_key));
+		if (pos < 0) {
+			return false;
+		}
+		_erase_slot(pos);
+		return true;
+	}
+
+	void reserve(uint32_t p_count) {
+		if (p_count <= _get_element_capacity()) {
+			return;
+		}
+		uint32_t bits = MIN_CAPACITY_BITS;
+		while (p_count > (1u << bits) / 4 * 3) {
+			bits++;
+		}
+		_rehash(bits);
+	}
+
+	// Keeps the memory around to fill the map again.
+	void clear() {
+		for (uint32_t i = 0; i < element_count; i++) {
+			if (element_hashes[i] != EMPTY_HASH) {
+				elements[i].~Element();
+			}
+		}
+		element_count = 0;
+		erased_count = 0;
+
+		uint32_t slot_capacity = _get_slot_capacity();
+		for (uint32_t i = 0; i < slot_capacity; i++) {
+			slots[i].hash = EMPTY_HASH;
+		}
+	}
+
+	void reset() {
+		clear();
+		if (elements) {
+			Memory::free_static(elements);
+			Memory::free_static(element_hashes);
+			Memory::free_static(slots);
+			elements = nullptr;
+			element_hashes = nullptr;
+			slots = nullptr;
+		}
+		capacity_bits = 0;
+	}
+
+	void operator=(const DenseHashMap &p_other) {
+		if (this == &p_other) {
+			return;
+		}
+		clear();
+		reserve(p_other.size());
+		for (const Element &E : p_other) {
+			_insert_new(_hash(E.key), E.key, E.value);
+		}
+	}
+
+	DenseHashMap(const DenseHashMap &p_other) {
+		operator=(p_other);
+	}
+
+	DenseHashMap(uint32_t p_initial_capacity = 0) {
+		reserve(p_initial_capacity);
+	}
+
+	~DenseHashMap() {
+		reset();
+	}
+};
+
+#endif // DENSE_HASH_MAP_H
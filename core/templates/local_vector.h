@@ -61,7 +61,7 @@ public:
 			} else {
 				capacity <<= 1;
 			}
-			data = (T *)memrealloc(data, capacity * sizeof(T));
+			data = (T *)Memory::realloc_static(data, capacity * sizeof(T), false, memory_type_site<LocalVector>());
 			CRASH_COND_MSG(!data, "Out of memory");
 		}
 
@@ -124,7 +124,7 @@ public:
 		p_size = nearest_power_of_2_templated(p_size);
 		if (p_size > capacity) {
 			capacity = p_size;
-			data = (T *)memrealloc(data, capacity * sizeof(T));
+			data = (T *)Memory::realloc_static(data, capacity * sizeof(T), false, memory_type_site<LocalVector>());
 			CRASH_COND_MSG(!data, "Out of memory");
 		}
 	}
@@ -146,7 +146,7 @@ public:
 				while (capacity < p_size) {
 					capacity <<= 1;
 				}
-				data = (T *)memrealloc(data, capacity * sizeof(T));
+				data = (T *)Memory::realloc_static(data, capacity * sizeof(T), false, memory_type_site<LocalVector>());
 				CRASH_COND_MSG(!data, "Out of memory");
 			}
 			if (!__has_trivial_constructor(T) && !force_trivial) {
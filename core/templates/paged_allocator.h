@@ -59,11 +59,12 @@ public:
 			uint32_t pages_used = pages_allocated;
 
 			pages_allocated++;
-			page_pool = (T **)memrealloc(page_pool, sizeof(T *) * pages_allocated);
-			available_pool = (T ***)memrealloc(available_pool, sizeof(T **) * pages_allocated);
+			const char *site = memory_type_site<PagedAllocator>();
+			page_pool = (T **)Memory::realloc_static(page_pool, sizeof(T *) * pages_allocated, false, site);
+			available_pool = (T ***)Memory::realloc_static(available_pool, sizeof(T **) * pages_allocated, false, site);
 
-			page_pool[pages_used] = (T *)memalloc(sizeof(T) * page_size);
-			available_pool[pages_used] = (T **)memalloc(sizeof(T *) * page_size);
+			page_pool[pages_used] = (T *)Memory::alloc_static(sizeof(T) * page_size, false, site);
+			available_pool[pages_used] = (T **)Memory::alloc_static(sizeof(T *) * page_size, false, site);
 
 			for (uint32_t i = 0; i < page_size; i++) {
 				available_pool[0][i] = &page_pool[pages_used][i];
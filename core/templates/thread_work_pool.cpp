@@ -30,50 +30,25 @@
 
 #include "thread_work_pool.h"
 
-#include "core/os/os.h"
+void ThreadWorkPool::init(int p_thread_count, const Thread::Settings &p_settings) {
+	ERR_FAIL_COND(thread_count != 0);
 
-void ThreadWorkPool::_thread_function(void *p_user) {
-	ThreadData *thread = static_cast<ThreadData *>(p_user);
-	while (true) {
-		thread->start.wait();
-		if (thread->exit.load()) {
-			break;
-		}
-		thread->work->work();
-		thread->completed.post();
-	}
-}
-
-void ThreadWorkPool::init(int p_thread_count) {
-	ERR_FAIL_COND(threads != nullptr);
+	WorkerThreadPool *pool = WorkerThreadPool::get_singleton();
+	// The calling thread always takes part in the work too.
+	uint32_t available = (pool ? pool->get_thread_count() : 0) + 1;
 	if (p_thread_count < 0) {
-		p_thread_count = OS::get_singleton()->get_default_thread_pool_size();
-	}
-
-	thread_count = p_thread_count;
-	threads = memnew_arr(ThreadData, thread_count);
-
-	for (uint32_t i = 0; i < thread_count; i++) {
-		threads[i].exit.store(false);
-		threads[i].thread.start(&ThreadWorkPool::_thread_function, &threads[i]);
+		thread_count = available;
+	} else {
+		thread_count = CLAMP((uint32_t)p_thread_count, 1u, available);
 	}
+	priority = p_settings.priority == Thread::PRIORITY_HIGH ? WorkerThreadPool::PRIORITY_HIGH : WorkerThreadPool::PRIORITY_NORMAL;
 }
 
 void ThreadWorkPool::finish() {
-	if (threads == nullptr) {
-		return;
-	}
-
-	for (uint32_t i = 0; i < thread_count; i++) {
-		threads[i].exit.store(true);
-		threads[i].start.post();
+	if (current_work) {
+		end_work();
 	}
-	for (uint32_t i = 0; i < thread_count; i++) {
-		threads[i].thread.wait_to_finish();
-	}
-
-	memdelete_arr(threads);
-	threads = nullptr;
+	thread_count = 0;
 }
 
 ThreadWorkPool::~ThreadWorkPool() {
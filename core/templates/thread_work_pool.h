@@ -32,75 +32,47 @@
 #define THREAD_WORK_POOL_H
 
 #include "core/os/memory.h"
-#include "core/os/semaphore.h"
 #include "core/os/thread.h"
+#include "core/templates/worker_thread_pool.h"
 
-#include <atomic>
-
+// Runs work on the engine-wide WorkerThreadPool. It no longer owns threads,
+// it only bounds how many threads take part in the work submitted through it.
 class ThreadWorkPool {
-	std::atomic<uint32_t> index;
-
-	struct BaseWork {
-		std::atomic<uint32_t> *index = nullptr;
-		uint32_t max_elements = 0;
-		virtual void work() = 0;
-		virtual ~BaseWork() = default;
+	enum {
+		WORK_STORAGE_SIZE = 256,
 	};
 
-	template <class C, class M, class U>
-	struct Work : public BaseWork {
-		C *instance;
-		M method;
-		U userdata;
-		virtual void work() override {
-			while (true) {
-				uint32_t work_index = index->fetch_add(1, std::memory_order_relaxed);
-				if (work_index >= max_elements) {
-					break;
-				}
-				(instance->*method)(work_index, userdata);
-			}
-		}
-	};
+	// Work objects are constructed in place, so dispatching work never allocates.
+	alignas(16) uint8_t work_storage[WORK_STORAGE_SIZE];
+	WorkerThreadPool::ParallelJob *current_work = nullptr;
+	WorkerThreadPool::JobGroup group;
+	WorkerThreadPool::Priority priority = WorkerThreadPool::PRIORITY_NORMAL;
 
-	struct ThreadData {
-		Thread thread;
-		Semaphore start;
-		Semaphore completed;
-		std::atomic<bool> exit;
-		BaseWork *work = nullptr;
-	};
-
-	ThreadData *threads = nullptr;
 	uint32_t thread_count = 0;
-	uint32_t threads_working = 0;
-	BaseWork *current_work = nullptr;
 
-	static void _thread_function(void *p_user);
+	_FORCE_INLINE_ WorkerThreadPool *_get_pool() const {
+		WorkerThreadPool *pool = WorkerThreadPool::get_singleton();
+		return pool && pool->get_thread_count() > 0 ? pool : nullptr;
+	}
 
 public:
 	template <class C, class M, class U>
 	void begin_work(uint32_t p_elements, C *p_instance, M p_method, U p_userdata) {
-		ERR_FAIL_COND(!threads); //never initialized
+		ERR_FAIL_COND(thread_count == 0); //never initialized
 		ERR_FAIL_COND(current_work != nullptr);
 
-		index.store(0, std::memory_order_release);
-
-		Work<C, M, U> *w = memnew((Work<C, M, U>));
-		w->instance = p_instance;
-		w->userdata = p_userdata;
-		w->method = p_method;
-		w->index = &index;
-		w->max_elements = p_elements;
-
+		typedef WorkerThreadPool::ParallelForJob<C, M, U> Work;
+		static_assert(sizeof(Work) <= WORK_STORAGE_SIZE, "Increase WORK_STORAGE_SIZE.");
+		Work *w = memnew_placement(work_storage, Work(p_elements, p_instance, p_method, p_userdata));
 		current_work = w;
 
-		threads_working = MIN(p_elements, thread_count);
-
-		for (uint32_t i = 0; i < threads_working; i++) {
-			threads[i].work = w;
-			threads[i].start.post();
+		WorkerThreadPool *pool = _get_pool();
+		if (!pool) {
+			// No workers, get it over with right away.
+			WorkerThreadPool::run_inline(w);
+			return;
 		}
+		pool->submit_parallel(w, MIN(p_elements, thread_count), &group, priority);
 	}
 
 	bool is_working() const {
@@ -109,24 +81,22 @@ public:
 
 	bool is_done_dispatching() const {
 		ERR_FAIL_COND_V(current_work == nullptr, true);
-		return index.load(std::memory_order_acquire) >= current_work->max_elements;
+		return current_work->is_done_dispatching();
 	}
 
 	uint32_t get_work_index() const {
 		ERR_FAIL_COND_V(current_work == nullptr, 0);
-		uint32_t idx = index.load(std::memory_order_acquire);
-		return MIN(idx, current_work->max_elements);
+		return current_work->get_work_index();
 	}
 
 	void end_work() {
 		ERR_FAIL_COND(current_work == nullptr);
-		for (uint32_t i = 0; i < threads_working; i++) {
-			threads[i].completed.wait();
-			threads[i].work = nullptr;
+		WorkerThreadPool *pool = _get_pool();
+		if (pool) {
+			pool->wait(&group, priority);
 		}
 
-		threads_working = 0;
-		memdelete(current_work);
+		current_work->~ParallelJob();
 		current_work = nullptr;
 	}
 
@@ -141,15 +111,24 @@ public:
 				// and we're going to wait for it to finish. Just run it right here.
 				(p_instance->*p_method)(0, p_userdata);
 				break;
-			default:
-				// Multiple jobs to do; commence threaded business.
-				begin_work(p_elements, p_instance, p_method, p_userdata);
-				end_work();
+			default: {
+				// Multiple jobs to do; commence threaded business. The calling thread takes part.
+				WorkerThreadPool *pool = _get_pool();
+				if (pool) {
+					pool->parallel_for(p_elements, p_instance, p_method, p_userdata, priority, thread_count);
+				} else {
+					for (uint32_t i = 0; i < p_elements; i++) {
+						(p_instance->*p_method)(i, p_userdata);
+					}
+				}
+			}
 		}
 	}
 
 	_FORCE_INLINE_ int get_thread_count() const { return thread_count; }
-	void init(int p_thread_count = -1);
+	// If p_thread_count is negative, as many threads as the worker pool provides take part.
+	// High priority settings make waiters only help with high priority work, so they never pick up long unrelated jobs.
+	void init(int p_thread_count = -1, const Thread::Settings &p_settings = Thread::Settings());
 	void finish();
 	~ThreadWorkPool();
 };
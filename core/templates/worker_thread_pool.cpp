@@ -0,0 +1,348 @@
+/*************************************************************************/
+/*  worker_thread_pool.cpp                                               */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "worker_thread_pool.h"
+
+#include "core/os/os.h"
+
+#include <thread>
+
+WorkerThreadPool *WorkerThreadPool::singleton = nullptr;
+thread_local WorkerThreadPool::ThreadData *WorkerThreadPool::current_thread = nullptr;
+
+void WorkerThreadPool::Job::add_dependency(Job *p_job) {
+	ERR_FAIL_NULL(p_job);
+	ERR_FAIL_COND_MSG(p_job->dependent_count >= MAX_DEPENDENTS, "Too many jobs depend on the same job.");
+	p_job->dependents[p_job->dependent_count++] = this;
+	blockers.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool WorkerThreadPool::Deque::push(Job *p_job) {
+	int64_t b = bottom.load(std::memory_order_relaxed);
+	int64_t t = top.load(std::memory_order_acquire);
+	if (b - t >= CAPACITY) {
+		return false;
+	}
+	buffer[b % CAPACITY].store(p_job, std::memory_order_relaxed);
+	bottom.store(b + 1, std::memory_order_release);
+	return true;
+}
+
+WorkerThreadPool::Job *WorkerThreadPool::Deque::pop() {
+	int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+	bottom.store(b, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t t = top.load(std::memory_order_relaxed);
+	if (t > b) {
+		// Empty.
+		bottom.store(b + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+	Job *job = buffer[b % CAPACITY].load(std::memory_order_relaxed);
+	if (t == b) {
+		// Last job, race against thieves for it.
+		if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+			job = nullptr;
+		}
+		bottom.store(b + 1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+WorkerThreadPool::Job *WorkerThreadPool::Deque::steal() {
+	int64_t t = top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t b = bottom.load(std::memory_order_acquire);
+	if (t >= b) {
+		return nullptr;
+	}
+	Job *job = buffer[t % CAPACITY].load(std::memory_order_relaxed);
+	if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+		return nullptr; // Lost the race, the caller will look for work again.
+	}
+	return job;
+}
+
+bool WorkerThreadPool::SharedQueue::push(Job *p_job) {
+	MutexLock lock(mutex);
+	if (count == CAPACITY) {
+		return false;
+	}
+	buffer[(head + count) % CAPACITY] = p_job;
+	count++;
+	return true;
+}
+
+WorkerThreadPool::Job *WorkerThreadPool::SharedQueue::pop() {
+	MutexLock lock(mutex);
+	if (count == 0) {
+		return nullptr;
+	}
+	Job *job = buffer[head];
+	head = (head + 1) % CAPACITY;
+	count--;
+	return job;
+}
+
+void WorkerThreadPool::_push(Job *p_job) {
+	if (get_thread_count(p_job->priority) == 0) {
+		_execute(p_job);
+		return;
+	}
+
+	bool pushed;
+	if (current_thread && current_thread->pool == this) {
+		pushed = current_thread->deques[p_job->priority].push(p_job);
+	} else {
+		pushed = shared_queues[p_job->priority].push(p_job);
+	}
+	if (!pushed) {
+		// Out of room, doing the work right here is still better than allocating.
+		_execute(p_job);
+		return;
+	}
+
+	// Prefer waking a reserved worker for high priority jobs, the others may be needed for normal ones.
+	if (p_job->priority == PRIORITY_HIGH && sleeping[PRIORITY_HIGH].load(std::memory_order_seq_cst) > 0) {
+		wake_semaphores[PRIORITY_HIGH].post();
+	} else if (sleeping[PRIORITY_NORMAL].load(std::memory_order_seq_cst) > 0) {
+		wake_semaphores[PRIORITY_NORMAL].post();
+	}
+}
+
+WorkerThreadPool::Job *WorkerThreadPool::_take_job(Priority p_lowest_priority) {
+	ThreadData *own = (current_thread && current_thread->pool == this) ? current_thread : nullptr;
+
+	for (int priority = 0; priority <= p_lowest_priority; priority++) {
+		Job *job = nullptr;
+		if (own) {
+			job = own->deques[priority].pop();
+			if (job) {
+				return job;
+			}
+		}
+
+		job = shared_queues[priority].pop();
+		if (job) {
+			return job;
+		}
+
+		// Steal, starting from a different worker every time to spread the contention.
+		uint32_t total_thread_count = thread_count + high_priority_thread_count;
+		uint32_t from = own ? own->steal_from++ : 0;
+		for (uint32_t i = 0; i < total_thread_count; i++) {
+			ThreadData &victim = threads[(from + i) % total_thread_count];
+			if (&victim == own) {
+				continue;
+			}
+			job = victim.deques[priority].steal();
+			if (job) {
+				return job;
+			}
+		}
+	}
+	return nullptr;
+}
+
+void WorkerThreadPool::_execute(Job *p_job) {
+	p_job->execute();
+
+	// Release the dependents, they may run as soon as they have no blockers left.
+	// Parallel jobs never have any, so nothing is written while other threads run the same job.
+	uint32_t dependent_count = p_job->dependent_count;
+	if (dependent_count > 0) {
+		p_job->dependent_count = 0;
+		for (uint32_t i = 0; i < dependent_count; i++) {
+			Job *dependent = p_job->dependents[i];
+			if (dependent->blockers.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+				_push(dependent);
+			}
+		}
+	}
+	p_job->blockers.store(1, std::memory_order_relaxed);
+
+	// Must be the last access, the group and the job may be gone as soon as the waiter sees it done.
+	JobGroup *group = p_job->group;
+	if (group) {
+		group->pending.fetch_sub(1, std::memory_order_acq_rel);
+	}
+}
+
+void WorkerThreadPool::_thread_function(void *p_user) {
+	ThreadData *thread = static_cast<ThreadData *>(p_user);
+	WorkerThreadPool *pool = thread->pool;
+	Priority lowest_priority = thread->lowest_priority;
+	current_thread = thread;
+
+	while (!pool->exit.load(std::memory_order_acquire)) {
+		Job *job = pool->_take_job(lowest_priority);
+		if (job) {
+			pool->_execute(job);
+			continue;
+		}
+
+		// Look once more after announcing we're going to sleep, so a job pushed in between is never missed.
+		pool->sleeping[lowest_priority].fetch_add(1, std::memory_order_seq_cst);
+		job = pool->_take_job(lowest_priority);
+		if (job) {
+			pool->sleeping[lowest_priority].fetch_sub(1, std::memory_order_seq_cst);
+			pool->_execute(job);
+			continue;
+		}
+		if (!pool->exit.load(std::memory_order_acquire)) {
+			pool->wake_semaphores[lowest_priority].wait();
+		}
+		pool->sleeping[lowest_priority].fetch_sub(1, std::memory_order_seq_cst);
+	}
+
+	current_thread = nullptr;
+}
+
+void WorkerThreadPool::submit(Job *p_job, JobGroup *p_group, Priority p_priority) {
+	ERR_FAIL_NULL(p_job);
+	ERR_FAIL_INDEX(p_priority, PRIORITY_MAX);
+
+	p_job->group = p_group;
+	p_job->priority = p_priority;
+	if (p_group) {
+		p_group->pending.fetch_add(1, std::memory_order_relaxed);
+	}
+	if (p_job->blockers.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		_push(p_job);
+	}
+}
+
+void WorkerThreadPool::submit_parallel(Job *p_job, uint32_t p_count, JobGroup *p_group, Priority p_priority) {
+	ERR_FAIL_NULL(p_job);
+	ERR_FAIL_INDEX(p_priority, PRIORITY_MAX);
+	ERR_FAIL_COND_MSG(p_job->dependent_count != 0 || p_job->blockers.load() != 1, "Jobs submitted in parallel can't have dependencies.");
+
+	p_job->group = p_group;
+	p_job->priority = p_priority;
+	if (p_group) {
+		p_group->pending.fetch_add(p_count, std::memory_order_relaxed);
+	}
+	for (uint32_t i = 0; i < p_count; i++) {
+		_push(p_job);
+	}
+}
+
+void WorkerThreadPool::wait(JobGroup *p_group, Priority p_priority) {
+	ERR_FAIL_NULL(p_group);
+
+	uint32_t idle_spins = 0;
+	while (!p_group->is_done()) {
+		Job *job = _take_job(p_priority);
+		if (job) {
+			_execute(job);
+			idle_spins = 0;
+			continue;
+		}
+		// The remaining jobs are running on other threads.
+		if (idle_spins < 64) {
+			idle_spins++;
+		} else {
+			std::this_thread::yield();
+		}
+	}
+}
+
+bool WorkerThreadPool::is_worker_thread() const {
+	return current_thread && current_thread->pool == this;
+}
+
+void WorkerThreadPool::init(int p_thread_count, int p_high_priority_thread_count) {
+	ERR_FAIL_COND(threads != nullptr);
+
+#ifdef NO_THREADS
+	p_thread_count = 0;
+	p_high_priority_thread_count = 0;
+#else
+	if (p_thread_count < 0) {
+		p_thread_count = OS::get_singleton()->get_default_thread_pool_size() - 1;
+	}
+#endif
+
+	thread_count = MAX(0, p_thread_count);
+	high_priority_thread_count = MAX(0, p_high_priority_thread_count);
+	uint32_t total_thread_count = thread_count + high_priority_thread_count;
+	if (total_thread_count == 0) {
+		return;
+	}
+
+	exit.store(false);
+	threads = memnew_arr(ThreadData, total_thread_count);
+	for (uint32_t i = 0; i < total_thread_count; i++) {
+		threads[i].pool = this;
+		threads[i].index = i;
+		threads[i].steal_from = i + 1;
+		threads[i].lowest_priority = i < thread_count ? PRIORITY_NORMAL : PRIORITY_HIGH;
+	}
+	// Only start once all deques exist, workers steal from each other right away.
+	for (uint32_t i = 0; i < total_thread_count; i++) {
+		threads[i].thread.start(&WorkerThreadPool::_thread_function, &threads[i]);
+	}
+}
+
+void WorkerThreadPool::finish() {
+	if (threads == nullptr) {
+		return;
+	}
+
+	uint32_t total_thread_count = thread_count + high_priority_thread_count;
+	exit.store(true, std::memory_order_release);
+	for (uint32_t i = 0; i < total_thread_count; i++) {
+		wake_semaphores[threads[i].lowest_priority].post();
+	}
+	for (uint32_t i = 0; i < total_thread_count; i++) {
+		threads[i].thread.wait_to_finish();
+	}
+
+	memdelete_arr(threads);
+	threads = nullptr;
+	thread_count = 0;
+	high_priority_thread_count = 0;
+}
+
+WorkerThreadPool::WorkerThreadPool() {
+	for (int i = 0; i < PRIORITY_MAX; i++) {
+		sleeping[i].store(0);
+	}
+	if (!singleton) {
+		singleton = this;
+	}
+}
+
+WorkerThreadPool::~WorkerThreadPool() {
+	finish();
+	if (singleton == this) {
+		singleton = nullptr;
+	}
+}
@@ -0,0 +1,238 @@
+/*************************************************************************/
+/*  worker_thread_pool.h                                                 */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef WORKER_THREAD_POOL_H
+#define WORKER_THREAD_POOL_H
+
+#include "core/os/memory.h"
+#include "core/os/mutex.h"
+#include "core/os/semaphore.h"
+#include "core/os/thread.h"
+#include "core/templates/local_vector.h"
+
+#include <atomic>
+
+// Engine-wide work-stealing scheduler, shared by every subsystem so they don't oversubscribe the cores with their own threads.
+//
+// Every worker owns one deque per priority, it pops its own jobs from the bottom and steals from the top of the others.
+// Jobs submitted from threads that are not workers go to a shared queue. Jobs and groups are owned by the caller,
+// and all queues have a fixed capacity, so submitting work never allocates. When a queue is full, the job runs right away.
+//
+// Waiting for a group helps executing jobs instead of blocking, so parallel loops can be nested from inside jobs,
+// and the waiting thread always takes part in its own work. Waiters only help with jobs of their own priority or higher,
+// so a high priority waiter (like the audio thread) never ends up running a long, unrelated job.
+// Some workers can be reserved for high priority jobs, so those never wait for long normal priority jobs to finish.
+class WorkerThreadPool {
+public:
+	enum Priority {
+		PRIORITY_HIGH,
+		PRIORITY_NORMAL,
+		PRIORITY_MAX,
+	};
+
+	// Counts unfinished jobs, can be waited on. Must outlive the jobs submitted to it.
+	class JobGroup {
+		friend class WorkerThreadPool;
+		std::atomic<uint32_t> pending = { 0 };
+
+	public:
+		_FORCE_INLINE_ bool is_done() const { return pending.load(std::memory_order_acquire) == 0; }
+	};
+
+	// Must stay alive until it has finished, and can be submitted again afterwards.
+	class Job {
+		friend class WorkerThreadPool;
+
+		enum {
+			MAX_DEPENDENTS = 8,
+		};
+
+		JobGroup *group = nullptr;
+		Priority priority = PRIORITY_NORMAL;
+		// Unfinished dependencies, plus one until the job is submitted.
+		std::atomic<uint32_t> blockers = { 1 };
+		Job *dependents[MAX_DEPENDENTS];
+		uint32_t dependent_count = 0;
+
+	protected:
+		virtual void execute() = 0;
+
+	public:
+		// Don't run this job before p_job has finished. Must be called before either of them is submitted.
+		void add_dependency(Job *p_job);
+
+		virtual ~Job() {}
+	};
+
+	// Shares a range of elements between all the threads running it. Meant to be submitted with submit_parallel().
+	class ParallelJob : public Job {
+	protected:
+		uint32_t elements = 0;
+		std::atomic<uint32_t> index = { 0 };
+
+	public:
+		_FORCE_INLINE_ uint32_t get_work_index() const { return MIN(index.load(std::memory_order_acquire), elements); }
+		_FORCE_INLINE_ uint32_t get_elements() const { return elements; }
+		_FORCE_INLINE_ bool is_done_dispatching() const { return index.load(std::memory_order_acquire) >= elements; }
+	};
+
+	template <class C, class M, class U>
+	class ParallelForJob : public ParallelJob {
+		C *instance = nullptr;
+		M method;
+		U userdata;
+
+	protected:
+		virtual void execute() override {
+			while (true) {
+				uint32_t work_index = index.fetch_add(1, std::memory_order_relaxed);
+				if (work_index >= elements) {
+					break;
+				}
+				(instance->*method)(work_index, userdata);
+			}
+		}
+
+	public:
+		ParallelForJob(uint32_t p_elements, C *p_instance, M p_method, U p_userdata) :
+				instance(p_instance), method(p_method), userdata(p_userdata) {
+			elements = p_elements;
+		}
+	};
+
+private:
+	// Bounded Chase-Lev deque. Only the owner pushes and pops, any thread can steal.
+	struct Deque {
+		enum {
+			CAPACITY = 256,
+		};
+
+		std::atomic<int64_t> top = { 0 };
+		std::atomic<int64_t> bottom = { 0 };
+		std::atomic<Job *> buffer[CAPACITY];
+
+		bool push(Job *p_job);
+		Job *pop();
+		Job *steal();
+	};
+
+	// For jobs submitted by threads that are not workers.
+	struct SharedQueue {
+		enum {
+			CAPACITY = 1024,
+		};
+
+		BinaryMutex mutex;
+		Job *buffer[CAPACITY];
+		uint32_t head = 0;
+		uint32_t count = 0;
+
+		bool push(Job *p_job);
+		Job *pop();
+	};
+
+	struct ThreadData {
+		WorkerThreadPool *pool = nullptr;
+		uint32_t index = 0;
+		uint32_t steal_from = 0;
+		Priority lowest_priority = PRIORITY_NORMAL; // PRIORITY_HIGH for reserved workers.
+		Thread thread;
+		Deque deques[PRIORITY_MAX];
+	};
+
+	static WorkerThreadPool *singleton;
+	static thread_local ThreadData *current_thread;
+
+	// The workers taking any job come first, followed by the ones reserved for high priority jobs.
+	ThreadData *threads = nullptr;
+	uint32_t thread_count = 0;
+	uint32_t high_priority_thread_count = 0;
+	SharedQueue shared_queues[PRIORITY_MAX];
+
+	// Indexed by the lowest priority the sleeping workers take, so normal jobs never wake reserved workers.
+	Semaphore wake_semaphores[PRIORITY_MAX];
+	std::atomic<uint32_t> sleeping[PRIORITY_MAX];
+	std::atomic<bool> exit = { false };
+
+	static void _thread_function(void *p_user);
+
+	void _push(Job *p_job);
+	Job *_take_job(Priority p_lowest_priority);
+	void _execute(Job *p_job);
+
+public:
+	static WorkerThreadPool *get_singleton() { return singleton; }
+
+	// Submits a job, it runs as soon as all its dependencies have finished.
+	void submit(Job *p_job, JobGroup *p_group = nullptr, Priority p_priority = PRIORITY_NORMAL);
+	// Submits a job p_count times at once, so up to p_count threads run it concurrently. It must not have dependencies.
+	void submit_parallel(Job *p_job, uint32_t p_count, JobGroup *p_group, Priority p_priority = PRIORITY_NORMAL);
+	// Runs a job that is shared between several threads on the calling thread too, without submitting it.
+	static _FORCE_INLINE_ void run_inline(ParallelJob *p_job) { p_job->execute(); }
+	// Executes jobs of p_priority or higher until the group is done.
+	void wait(JobGroup *p_group, Priority p_priority = PRIORITY_NORMAL);
+
+	// Calls the method once per element and returns when all of them have been processed. The calling thread takes part.
+	// If p_max_concurrency is zero, all workers may take part.
+	template <class C, class M, class U>
+	void parallel_for(uint32_t p_elements, C *p_instance, M p_method, U p_userdata, Priority p_priority = PRIORITY_NORMAL, uint32_t p_max_concurrency = 0) {
+		uint32_t concurrency = MIN(p_elements, get_thread_count(p_priority) + 1);
+		if (p_max_concurrency > 0) {
+			concurrency = MIN(concurrency, p_max_concurrency);
+		}
+		if (concurrency <= 1) {
+			for (uint32_t i = 0; i < p_elements; i++) {
+				(p_instance->*p_method)(i, p_userdata);
+			}
+			return;
+		}
+
+		ParallelForJob<C, M, U> job(p_elements, p_instance, p_method, p_userdata);
+		JobGroup group;
+		submit_parallel(&job, concurrency - 1, &group, p_priority);
+		run_inline(&job);
+		wait(&group, p_priority);
+	}
+
+	// Returns the amount of workers that take jobs of p_priority.
+	_FORCE_INLINE_ uint32_t get_thread_count(Priority p_priority = PRIORITY_NORMAL) const { return p_priority == PRIORITY_HIGH ? thread_count + high_priority_thread_count : thread_count; }
+	// Returns true if the calling thread is one of the workers of this pool.
+	bool is_worker_thread() const;
+
+	// If p_thread_count is negative, one thread per processor core is started, minus one for the main thread.
+	// p_high_priority_thread_count more workers are started that only take high priority jobs.
+	void init(int p_thread_count = -1, int p_high_priority_thread_count = 0);
+	void finish();
+
+	WorkerThreadPool();
+	~WorkerThreadPool();
+};
+
+#endif // WORKER_THREAD_POOL_H
@@ -30,7 +30,6 @@
 
 #include "dictionary.h"
 
-#include "core/templates/ordered_hash_map.h"
 #include "core/templates/safe_refcount.h"
 #include "core/variant/variant.h"
 // required in this order by VariantInternal, do not remove this comment.
@@ -39,26 +38,252 @@
 #include "core/variant/type_info.h"
 #include "core/variant/variant_internal.h"
 
+#if defined(__GNUC__)
+#define CLZ32(x) __builtin_clz(x)
+#elif defined(_MSC_VER)
+#include <intrin.h>
+static int __bsr_clz32(uint32_t x) {
+	unsigned long index;
+	_BitScanReverse(&index, x);
+	return 31 - index;
+}
+#define CLZ32(x) __bsr_clz32(x)
+#endif
+
+// Entries are kept in insertion order, in blocks that never move once allocated, so references to keys and values
+// stay valid while the dictionary grows. Erased entries are left as holes until they outnumber the live ones, then
+// erase() compacts the live entries, invalidating references to them.
+// Small dictionaries are searched linearly, larger ones through an open addressing table of entry positions.
 struct DictionaryPrivate {
+	static constexpr uint32_t SMALL_SIZE = 8; // Also the size of the first two blocks, every following block doubles.
+	static constexpr uint32_t MAX_BLOCKS = 30;
+	static constexpr uint32_t INDEX_EMPTY = 0xFFFFFFFF;
+	static constexpr uint32_t INDEX_ERASED = 0xFFFFFFFE;
+
+	struct Entry {
+		Variant key;
+		Variant value;
+		uint32_t hash = 0;
+		bool erased = false;
+	};
+
 	SafeRefCount refcount;
-	OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator> variant_map;
-};
+	Entry *blocks[MAX_BLOCKS] = {};
+	uint32_t used = 0; // Entries appended so far, erased ones included.
+	uint32_t count = 0; // Live entries.
+	uint32_t erased_indices = 0;
+	uint32_t *indices = nullptr;
+	uint32_t index_mask = 0;
 
-void Dictionary::get_key_list(List<Variant> *p_keys) const {
-	if (_p->variant_map.is_empty()) {
-		return;
+	static _FORCE_INLINE_ uint32_t _get_block(uint32_t p_pos) {
+		return p_pos < SMALL_SIZE ? 0 : 32 - CLZ32(p_pos / SMALL_SIZE);
+	}
+
+	static _FORCE_INLINE_ uint32_t _get_block_start(uint32_t p_block) {
+		return p_block == 0 ? 0 : SMALL_SIZE << (p_block - 1);
+	}
+
+	// Returns the key to look up and its hash. StringName keys are stored as String, so both refer to the same entry,
+	// but they already know their hash.
+	static _FORCE_INLINE_ const Variant &get_key(const Variant &p_key, Variant &r_string_key, uint32_t &r_hash) {
+		if (p_key.get_type() == Variant::STRING_NAME) {
+			const StringName *sn = VariantInternal::get_string_name(&p_key);
+			r_string_key = sn->operator String();
+			r_hash = *sn != StringName() ? sn->hash() : String().hash();
+			return r_string_key;
+		}
+		r_hash = VariantHasher::hash(p_key);
+		return p_key;
+	}
+
+	_FORCE_INLINE_ Entry *get_entry(uint32_t p_pos) const {
+		const uint32_t block = _get_block(p_pos);
+		return blocks[block] + (p_pos - _get_block_start(block));
+	}
+
+	// Returns the position of the entry, or INDEX_EMPTY. r_slot receives its slot in the index table, if there is one.
+	uint32_t find(const Variant &p_key, uint32_t p_hash, uint32_t *r_slot = nullptr) const {
+		if (!indices) {
+			// Everything is in the first block.
+			for (uint32_t i = 0; i < used; i++) {
+				const Entry &e = blocks[0][i];
+				if (e.hash == p_hash && !e.erased && VariantComparator::compare(e.key, p_key)) {
+					return i;
+				}
+			}
+			return INDEX_EMPTY;
+		}
+
+		for (uint32_t slot = p_hash & index_mask;; slot = (slot + 1) & index_mask) {
+			const uint32_t pos = indices[slot];
+			if (pos == INDEX_EMPTY) {
+				return INDEX_EMPTY;
+			}
+			if (pos != INDEX_ERASED) {
+				const Entry *e = get_entry(pos);
+				if (e->hash == p_hash && VariantComparator::compare(e->key, p_key)) {
+					if (r_slot) {
+						*r_slot = slot;
+					}
+					return pos;
+				}
+			}
+		}
+	}
+
+	void _insert_index(uint32_t p_pos, uint32_t p_hash) {
+		uint32_t slot = p_hash & index_mask;
+		while (indices[slot] != INDEX_EMPTY) {
+			slot = (slot + 1) & index_mask;
+		}
+		indices[slot] = p_pos;
+	}
+
+	void _rebuild_indices() {
+		if (indices) {
+			memfree(indices);
+			indices = nullptr;
+		}
+		erased_indices = 0;
+		if (used <= SMALL_SIZE) {
+			index_mask = 0;
+			return;
+		}
+
+		// Keep the load factor, erased slots included, under one half.
+		const uint32_t size = next_power_of_2(used * 4);
+		indices = (uint32_t *)memalloc(sizeof(uint32_t) * size);
+		memset(indices, 0xFF, sizeof(uint32_t) * size);
+		index_mask = size - 1;
+		for (uint32_t i = 0; i < used; i++) {
+			const Entry *e = get_entry(i);
+			if (!e->erased) {
+				_insert_index(i, e->hash);
+			}
+		}
 	}
 
-	for (OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator>::Element E = _p->variant_map.front(); E; E = E.next()) {
-		p_keys->push_back(E.key());
+	Variant &insert(const Variant &p_key, uint32_t p_hash) {
+		const uint32_t pos = used;
+		const uint32_t block = _get_block(pos);
+		if (!blocks[block]) {
+			ERR_FAIL_COND_V_MSG(block == MAX_BLOCKS - 1, get_entry(pos - 1)->value, "Dictionary is too large.");
+			blocks[block] = memnew_arr(Entry, block == 0 ? SMALL_SIZE : _get_block_start(block));
+		}
+		Entry *e = blocks[block] + (pos - _get_block_start(block));
+		e->key = p_key;
+		e->hash = p_hash;
+		e->erased = false;
+		used++;
+		count++;
+
+		if (indices && (count + erased_indices) * 2 <= index_mask + 1) {
+			_insert_index(pos, p_hash);
+		} else if (used > SMALL_SIZE) {
+			_rebuild_indices();
+		}
+		return e->value;
+	}
+
+	bool erase(const Variant &p_key, uint32_t p_hash) {
+		uint32_t slot = 0;
+		const uint32_t pos = find(p_key, p_hash, &slot);
+		if (pos == INDEX_EMPTY) {
+			return false;
+		}
+
+		Entry *e = get_entry(pos);
+		e->key = Variant();
+		e->value = Variant();
+		e->erased = true;
+		count--;
+		if (indices) {
+			indices[slot] = INDEX_ERASED;
+			erased_indices++;
+		}
+
+		if (count == 0) {
+			clear();
+		} else if (used - count > count && used - count >= SMALL_SIZE) {
+			_compact();
+		}
+		return true;
+	}
+
+	// Moves live entries over the holes left by erased ones. Invalidates references to entries.
+	void _compact() {
+		uint32_t write = 0;
+		for (uint32_t i = 0; i < used; i++) {
+			Entry *e = get_entry(i);
+			if (e->erased) {
+				continue;
+			}
+			if (write != i) {
+				Entry *dst = get_entry(write);
+				dst->key = e->key;
+				dst->value = e->value;
+				dst->hash = e->hash;
+				dst->erased = false;
+				e->key = Variant();
+				e->value = Variant();
+				e->erased = true;
+			}
+			write++;
+		}
+		used = write;
+
+		const uint32_t blocks_used = used == 0 ? 0 : _get_block(used - 1) + 1;
+		for (uint32_t i = blocks_used; i < MAX_BLOCKS && blocks[i]; i++) {
+			memdelete_arr(blocks[i]);
+			blocks[i] = nullptr;
+		}
+		_rebuild_indices();
+	}
+
+	uint32_t next_live(uint32_t p_pos) const {
+		while (p_pos < used && get_entry(p_pos)->erased) {
+			p_pos++;
+		}
+		return p_pos;
+	}
+
+	void clear() {
+		for (uint32_t i = 0; i < MAX_BLOCKS && blocks[i]; i++) {
+			memdelete_arr(blocks[i]);
+			blocks[i] = nullptr;
+		}
+		if (indices) {
+			memfree(indices);
+			indices = nullptr;
+		}
+		index_mask = 0;
+		erased_indices = 0;
+		used = 0;
+		count = 0;
+	}
+
+	~DictionaryPrivate() {
+		clear();
+	}
+};
+
+void Dictionary::get_key_list(List<Variant> *p_keys) const {
+	for (uint32_t i = _p->next_live(0); i < _p->used; i = _p->next_live(i + 1)) {
+		p_keys->push_back(_p->get_entry(i)->key);
 	}
 }
 
 Variant Dictionary::get_key_at_index(int p_index) const {
+	ERR_FAIL_COND_V(p_index < 0, Variant());
+	if (_p->used == _p->count) {
+		// No holes, positions are indices.
+		return uint32_t(p_index) < _p->used ? _p->get_entry(p_index)->key : Variant();
+	}
+
 	int index = 0;
-	for (OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator>::Element E = _p->variant_map.front(); E; E = E.next()) {
+	for (uint32_t i = _p->next_live(0); i < _p->used; i = _p->next_live(i + 1)) {
 		if (index == p_index) {
-			return E.key();
+			return _p->get_entry(i)->key;
 		}
 		index++;
 	}
@@ -67,10 +292,15 @@ Variant Dictionary::get_key_at_index(int p_index) const {
 }
 
 Variant Dictionary::get_value_at_index(int p_index) const {
+	ERR_FAIL_COND_V(p_index < 0, Variant());
+	if (_p->used == _p->count) {
+		return uint32_t(p_index) < _p->used ? _p->get_entry(p_index)->value : Variant();
+	}
+
 	int index = 0;
-	for (OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator>::Element E = _p->variant_map.front(); E; E = E.next()) {
+	for (uint32_t i = _p->next_live(0); i < _p->used; i = _p->next_live(i + 1)) {
 		if (index == p_index) {
-			return E.value();
+			return _p->get_entry(i)->value;
 		}
 		index++;
 	}
@@ -79,68 +309,55 @@ Variant Dictionary::get_value_at_index(int p_index) const {
 }
 
 Variant &Dictionary::operator[](const Variant &p_key) {
-	if (p_key.get_type() == Variant::STRING_NAME) {
-		const StringName *sn = VariantInternal::get_string_name(&p_key);
-		return _p->variant_map[sn->operator String()];
-	} else {
-		return _p->variant_map[p_key];
+	Variant string_key;
+	uint32_t hash;
+	const Variant &key = DictionaryPrivate::get_key(p_key, string_key, hash);
+	const uint32_t pos = _p->find(key, hash);
+	if (pos != DictionaryPrivate::INDEX_EMPTY) {
+		return _p->get_entry(pos)->value;
 	}
+	return _p->insert(key, hash);
 }
 
 const Variant &Dictionary::operator[](const Variant &p_key) const {
-	if (p_key.get_type() == Variant::STRING_NAME) {
-		const StringName *sn = VariantInternal::get_string_name(&p_key);
-		return _p->variant_map[sn->operator String()];
-	} else {
-		return _p->variant_map[p_key];
+	Variant string_key;
+	uint32_t hash;
+	const Variant &key = DictionaryPrivate::get_key(p_key, string_key, hash);
+	const uint32_t pos = _p->find(key, hash);
+	if (pos != DictionaryPrivate::INDEX_EMPTY) {
+		return _p->get_entry(pos)->value;
 	}
+	return _p->insert(key, hash);
 }
 
 const Variant *Dictionary::getptr(const Variant &p_key) const {
-	OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator>::ConstElement E;
-
-	if (p_key.get_type() == Variant::STRING_NAME) {
-		const StringName *sn = VariantInternal::get_string_name(&p_key);
-		E = ((const OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator> *)&_p->variant_map)->find(sn->operator String());
-	} else {
-		E = ((const OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator> *)&_p->variant_map)->find(p_key);
-	}
-
-	if (!E) {
+	Variant string_key;
+	uint32_t hash;
+	const Variant &key = DictionaryPrivate::get_key(p_key, string_key, hash);
+	const uint32_t pos = _p->find(key, hash);
+	if (pos == DictionaryPrivate::INDEX_EMPTY) {
 		return nullptr;
 	}
-	return &E.get();
+	return &_p->get_entry(pos)->value;
 }
 
 Variant *Dictionary::getptr(const Variant &p_key) {
-	OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator>::Element E;
-
-	if (p_key.get_type() == Variant::STRING_NAME) {
-		const StringName *sn = VariantInternal::get_string_name(&p_key);
-		E = ((OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator> *)&_p->variant_map)->find(sn->operator String());
-	} else {
-		E = ((OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator> *)&_p->variant_map)->find(p_key);
-	}
-	if (!E) {
+	Variant string_key;
+	uint32_t hash;
+	const Variant &key = DictionaryPrivate::get_key(p_key, string_key, hash);
+	const uint32_t pos = _p->find(key, hash);
+	if (pos == DictionaryPrivate::INDEX_EMPTY) {
 		return nullptr;
 	}
-	return &E.get();
+	return &_p->get_entry(pos)->value;
 }
 
 Variant Dictionary::get_valid(const Variant &p_key) const {
-	OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator>::ConstElement E;
-
-	if (p_key.get_type() == Variant::STRING_NAME) {
-		const StringName *sn = VariantInternal::get_string_name(&p_key);
-		E = ((const OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator> *)&_p->variant_map)->find(sn->operator String());
-	} else {
-		E = ((const OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator> *)&_p->variant_map)->find(p_key);
-	}
-
-	if (!E) {
+	const Variant *result = getptr(p_key);
+	if (!result) {
 		return Variant();
 	}
-	return E.get();
+	return *result;
 }
 
 Variant Dictionary::get(const Variant &p_key, const Variant &p_default) const {
@@ -153,20 +370,15 @@ Variant Dictionary::get(const Variant &p_key, const Variant &p_default) const {
 }
 
 int Dictionary::size() const {
-	return _p->variant_map.size();
+	return _p->count;
 }
 
 bool Dictionary::is_empty() const {
-	return !_p->variant_map.size();
+	return !_p->count;
 }
 
 bool Dictionary::has(const Variant &p_key) const {
-	if (p_key.get_type() == Variant::STRING_NAME) {
-		const StringName *sn = VariantInternal::get_string_name(&p_key);
-		return _p->variant_map.has(sn->operator String());
-	} else {
-		return _p->variant_map.has(p_key);
-	}
+	return getptr(p_key) != nullptr;
 }
 
 bool Dictionary::has_all(const Array &p_keys) const {
@@ -179,12 +391,10 @@ bool Dictionary::has_all(const Array &p_keys) const {
 }
 
 bool Dictionary::erase(const Variant &p_key) {
-	if (p_key.get_type() == Variant::STRING_NAME) {
-		const StringName *sn = VariantInternal::get_string_name(&p_key);
-		return _p->variant_map.erase(sn->operator String());
-	} else {
-		return _p->variant_map.erase(p_key);
-	}
+	Variant string_key;
+	uint32_t hash;
+	const Variant &key = DictionaryPrivate::get_key(p_key, string_key, hash);
+	return _p->erase(key, hash);
 }
 
 bool Dictionary::operator==(const Dictionary &p_dictionary) const {
@@ -200,7 +410,7 @@ bool Dictionary::recursive_equal(const Dictionary &p_dictionary, int recursion_c
 	if (_p == p_dictionary._p) {
 		return true;
 	}
-	if (_p->variant_map.size() != p_dictionary._p->variant_map.size()) {
+	if (_p->count != p_dictionary._p->count) {
 		return false;
 	}
 
@@ -210,9 +420,10 @@ bool Dictionary::recursive_equal(const Dictionary &p_dictionary, int recursion_c
 		return true;
 	}
 	recursion_count++;
-	for (OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator>::ConstElement this_E = ((const OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator> *)&_p->variant_map)->front(); this_E; this_E = this_E.next()) {
-		OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator>::ConstElement other_E = ((const OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator> *)&p_dictionary._p->variant_map)->find(this_E.key());
-		if (!other_E || !this_E.value().hash_compare(other_E.value(), recursion_count)) {
+	for (uint32_t i = _p->next_live(0); i < _p->used; i = _p->next_live(i + 1)) {
+		const DictionaryPrivate::Entry *this_e = _p->get_entry(i);
+		const uint32_t other_pos = p_dictionary._p->find(this_e->key, this_e->hash);
+		if (other_pos == DictionaryPrivate::INDEX_EMPTY || !this_e->value.hash_compare(p_dictionary._p->get_entry(other_pos)->value, recursion_count)) {
 			return false;
 		}
 	}
@@ -237,7 +448,7 @@ void Dictionary::_ref(const Dictionary &p_from) const {
 }
 
 void Dictionary::clear() {
-	_p->variant_map.clear();
+	_p->clear();
 }
 
 void Dictionary::_unref() const {
@@ -261,9 +472,10 @@ uint32_t Dictionary::recursive_hash(int recursion_count) const {
 	uint32_t h = hash_djb2_one_32(Variant::DICTIONARY);
 
 	recursion_count++;
-	for (OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator>::Element E = _p->variant_map.front(); E; E = E.next()) {
-		h = hash_djb2_one_32(E.key().recursive_hash(recursion_count), h);
-		h = hash_djb2_one_32(E.value().recursive_hash(recursion_count), h);
+	for (uint32_t i = _p->next_live(0); i < _p->used; i = _p->next_live(i + 1)) {
+		const DictionaryPrivate::Entry *e = _p->get_entry(i);
+		h = hash_djb2_one_32(e->key.recursive_hash(recursion_count), h);
+		h = hash_djb2_one_32(e->value.recursive_hash(recursion_count), h);
 	}
 
 	return h;
@@ -271,15 +483,15 @@ uint32_t Dictionary::recursive_hash(int recursion_count) const {
 
 Array Dictionary::keys() const {
 	Array varr;
-	if (_p->variant_map.is_empty()) {
+	if (_p->count == 0) {
 		return varr;
 	}
 
 	varr.resize(size());
 
 	int i = 0;
-	for (OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator>::Element E = _p->variant_map.front(); E; E = E.next()) {
-		varr[i] = E.key();
+	for (uint32_t pos = _p->next_live(0); pos < _p->used; pos = _p->next_live(pos + 1)) {
+		varr[i] = _p->get_entry(pos)->key;
 		i++;
 	}
 
@@ -288,15 +500,15 @@ Array Dictionary::keys() const {
 
 Array Dictionary::values() const {
 	Array varr;
-	if (_p->variant_map.is_empty()) {
+	if (_p->count == 0) {
 		return varr;
 	}
 
 	varr.resize(size());
 
 	int i = 0;
-	for (OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator>::Element E = _p->variant_map.front(); E; E = E.next()) {
-		varr[i] = E.get();
+	for (uint32_t pos = _p->next_live(0); pos < _p->used; pos = _p->next_live(pos + 1)) {
+		varr[i] = _p->get_entry(pos)->value;
 		i++;
 	}
 
@@ -304,17 +516,21 @@ Array Dictionary::values() const {
 }
 
 const Variant *Dictionary::next(const Variant *p_key) const {
-	if (p_key == nullptr) {
-		// caller wants to get the first element
-		if (_p->variant_map.front()) {
-			return &_p->variant_map.front().key();
+	uint32_t pos = 0;
+	if (p_key != nullptr) {
+		Variant string_key;
+		uint32_t hash;
+		const Variant &key = DictionaryPrivate::get_key(*p_key, string_key, hash);
+		pos = _p->find(key, hash);
+		if (pos == DictionaryPrivate::INDEX_EMPTY) {
+			return nullptr;
 		}
-		return nullptr;
+		pos++;
 	}
-	OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator>::Element E = _p->variant_map.find(*p_key);
 
-	if (E && E.next()) {
-		return &E.next().key();
+	pos = _p->next_live(pos);
+	if (pos < _p->used) {
+		return &_p->get_entry(pos)->key;
 	}
 	return nullptr;
 }
@@ -333,12 +549,14 @@ Dictionary Dictionary::recursive_duplicate(bool p_deep, int recursion_count) con
 
 	if (p_deep) {
 		recursion_count++;
-		for (OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator>::Element E = _p->variant_map.front(); E; E = E.next()) {
-			n[E.key().recursive_duplicate(true, recursion_count)] = E.value().recursive_duplicate(true, recursion_count);
+		for (uint32_t i = _p->next_live(0); i < _p->used; i = _p->next_live(i + 1)) {
+			const DictionaryPrivate::Entry *e = _p->get_entry(i);
+			n[e->key.recursive_duplicate(true, recursion_count)] = e->value.recursive_duplicate(true, recursion_count);
 		}
 	} else {
-		for (OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator>::Element E = _p->variant_map.front(); E; E = E.next()) {
-			n[E.key()] = E.value();
+		for (uint32_t i = _p->next_live(0); i < _p->used; i = _p->next_live(i + 1)) {
+			const DictionaryPrivate::Entry *e = _p->get_entry(i);
+			n._p->insert(e->key, e->hash) = e->value;
 		}
 	}
 
@@ -66,6 +66,8 @@ public:
 	bool has(const Variant &p_key) const;
 	bool has_all(const Array &p_keys) const;
 
+	// Once erased entries outnumber live ones, erasing moves the live entries and frees unused storage, which
+	// invalidates pointers and references from getptr(), operator[] and next(). Inserting never moves entries.
 	bool erase(const Variant &p_key);
 
 	bool operator==(const Dictionary &p_dictionary) const;
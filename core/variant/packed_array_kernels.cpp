@@ -0,0 +1,460 @@
+/*************************************************************************/
+/*  packed_array_kernels.cpp                                             */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "packed_array_kernels.h"
+
+#include "core/error/error_macros.h"
+#include "core/math/math_funcs.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PACKED_ARRAY_KERNELS_SSE2
+#include <emmintrin.h>
+#endif
+
+// The reductions convert to double precision lanes, which 32-bit NEON lacks.
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define PACKED_ARRAY_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+/* Scalar */
+
+#define SCALAR_BINARY_KERNEL(m_name, m_op)                                                              \
+	static void _##m_name##_scalar(float *p_dst, const float *p_a, const float *p_b, int64_t p_count) { \
+		for (int64_t i = 0; i < p_count; i++) {                                                          \
+			p_dst[i] = p_a[i] m_op p_b[i];                                                               \
+		}                                                                                                \
+	}
+
+SCALAR_BINARY_KERNEL(add, +)
+SCALAR_BINARY_KERNEL(subtract, -)
+SCALAR_BINARY_KERNEL(multiply, *)
+SCALAR_BINARY_KERNEL(divide, /)
+
+static void _add_scalar_scalar(float *p_dst, const float *p_a, float p_value, int64_t p_count) {
+	for (int64_t i = 0; i < p_count; i++) {
+		p_dst[i] = p_a[i] + p_value;
+	}
+}
+
+static void _multiply_scalar_scalar(float *p_dst, const float *p_a, float p_value, int64_t p_count) {
+	for (int64_t i = 0; i < p_count; i++) {
+		p_dst[i] = p_a[i] * p_value;
+	}
+}
+
+static void _clamp_scalar(float *p_dst, const float *p_a, float p_min, float p_max, int64_t p_count) {
+	for (int64_t i = 0; i < p_count; i++) {
+		p_dst[i] = CLAMP(p_a[i], p_min, p_max);
+	}
+}
+
+static void _lerp_scalar(float *p_dst, const float *p_from, const float *p_to, float p_weight, int64_t p_count) {
+	for (int64_t i = 0; i < p_count; i++) {
+		p_dst[i] = p_from[i] + (p_to[i] - p_from[i]) * p_weight;
+	}
+}
+
+static double _sum_scalar(const float *p_a, int64_t p_count) {
+	double total = 0.0;
+	for (int64_t i = 0; i < p_count; i++) {
+		total += p_a[i];
+	}
+	return total;
+}
+
+static double _dot_scalar(const float *p_a, const float *p_b, int64_t p_count) {
+	double total = 0.0;
+	for (int64_t i = 0; i < p_count; i++) {
+		total += double(p_a[i]) * double(p_b[i]);
+	}
+	return total;
+}
+
+static void _xform_vector2_scalar(float *p_dst, const float *p_src, const float *p_xform, int64_t p_count) {
+	for (int64_t i = 0; i < p_count; i++) {
+		const float x = p_src[i * 2 + 0];
+		const float y = p_src[i * 2 + 1];
+		p_dst[i * 2 + 0] = p_xform[0] * x + p_xform[2] * y + p_xform[4];
+		p_dst[i * 2 + 1] = p_xform[1] * x + p_xform[3] * y + p_xform[5];
+	}
+}
+
+static void _xform_vector3_scalar(float *p_dst, const float *p_src, const float *p_xform, int64_t p_count) {
+	for (int64_t i = 0; i < p_count; i++) {
+		const float x = p_src[i * 3 + 0];
+		const float y = p_src[i * 3 + 1];
+		const float z = p_src[i * 3 + 2];
+		p_dst[i * 3 + 0] = p_xform[0] * x + p_xform[3] * y + p_xform[6] * z + p_xform[9];
+		p_dst[i * 3 + 1] = p_xform[1] * x + p_xform[4] * y + p_xform[7] * z + p_xform[10];
+		p_dst[i * 3 + 2] = p_xform[2] * x + p_xform[5] * y + p_xform[8] * z + p_xform[11];
+	}
+}
+
+/* SSE2 */
+
+#ifdef PACKED_ARRAY_KERNELS_SSE2
+
+#define SSE2_BINARY_KERNEL(m_name, m_op, m_intrinsic)                                                 \
+	static void _##m_name##_sse2(float *p_dst, const float *p_a, const float *p_b, int64_t p_count) { \
+		int64_t i = 0;                                                                                 \
+		for (; i + 4 <= p_count; i += 4) {                                                             \
+			_mm_storeu_ps(p_dst + i, m_intrinsic(_mm_loadu_ps(p_a + i), _mm_loadu_ps(p_b + i)));       \
+		}                                                                                              \
+		for (; i < p_count; i++) {                                                                     \
+			p_dst[i] = p_a[i] m_op p_b[i];                                                             \
+		}                                                                                              \
+	}
+
+SSE2_BINARY_KERNEL(add, +, _mm_add_ps)
+SSE2_BINARY_KERNEL(subtract, -, _mm_sub_ps)
+SSE2_BINARY_KERNEL(multiply, *, _mm_mul_ps)
+SSE2_BINARY_KERNEL(divide, /, _mm_div_ps)
+
+static void _add_scalar_sse2(float *p_dst, const float *p_a, float p_value, int64_t p_count) {
+	const __m128 value = _mm_set1_ps(p_value);
+	int64_t i = 0;
+	for (; i + 4 <= p_count; i += 4) {
+		_mm_storeu_ps(p_dst + i, _mm_add_ps(_mm_loadu_ps(p_a + i), value));
+	}
+	for (; i < p_count; i++) {
+		p_dst[i] = p_a[i] + p_value;
+	}
+}
+
+static void _multiply_scalar_sse2(float *p_dst, const float *p_a, float p_value, int64_t p_count) {
+	const __m128 value = _mm_set1_ps(p_value);
+	int64_t i = 0;
+	for (; i + 4 <= p_count; i += 4) {
+		_mm_storeu_ps(p_dst + i, _mm_mul_ps(_mm_loadu_ps(p_a + i), value));
+	}
+	for (; i < p_count; i++) {
+		p_dst[i] = p_a[i] * p_value;
+	}
+}
+
+static void _clamp_sse2(float *p_dst, const float *p_a, float p_min, float p_max, int64_t p_count) {
+	const __m128 min = _mm_set1_ps(p_min);
+	const __m128 max = _mm_set1_ps(p_max);
+	int64_t i = 0;
+	for (; i + 4 <= p_count; i += 4) {
+		_mm_storeu_ps(p_dst + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(p_a + i), min), max));
+	}
+	for (; i < p_count; i++) {
+		p_dst[i] = CLAMP(p_a[i], p_min, p_max);
+	}
+}
+
+static void _lerp_sse2(float *p_dst, const float *p_from, const float *p_to, float p_weight, int64_t p_count) {
+	const __m128 weight = _mm_set1_ps(p_weight);
+	int64_t i = 0;
+	for (; i + 4 <= p_count; i += 4) {
+		const __m128 from = _mm_loadu_ps(p_from + i);
+		_mm_storeu_ps(p_dst + i, _mm_add_ps(from, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(p_to + i), from), weight)));
+	}
+	for (; i < p_count; i++) {
+		p_dst[i] = p_from[i] + (p_to[i] - p_from[i]) * p_weight;
+	}
+}
+
+static double _sse2_horizontal_sum(__m128d p_value) {
+	return _mm_cvtsd_f64(_mm_add_sd(p_value, _mm_unpackhi_pd(p_value, p_value)));
+}
+
+static double _sum_sse2(const float *p_a, int64_t p_count) {
+	__m128d total_lo = _mm_setzero_pd();
+	__m128d total_hi = _mm_setzero_pd();
+	int64_t i = 0;
+	for (; i + 4 <= p_count; i += 4) {
+		const __m128 a = _mm_loadu_ps(p_a + i);
+		total_lo = _mm_add_pd(total_lo, _mm_cvtps_pd(a));
+		total_hi = _mm_add_pd(total_hi, _mm_cvtps_pd(_mm_movehl_ps(a, a)));
+	}
+	double total = _sse2_horizontal_sum(_mm_add_pd(total_lo, total_hi));
+	for (; i < p_count; i++) {
+		total += p_a[i];
+	}
+	return total;
+}
+
+static double _dot_sse2(const float *p_a, const float *p_b, int64_t p_count) {
+	__m128d total_lo = _mm_setzero_pd();
+	__m128d total_hi = _mm_setzero_pd();
+	int64_t i = 0;
+	for (; i + 4 <= p_count; i += 4) {
+		const __m128 a = _mm_loadu_ps(p_a + i);
+		const __m128 b = _mm_loadu_ps(p_b + i);
+		total_lo = _mm_add_pd(total_lo, _mm_mul_pd(_mm_cvtps_pd(a), _mm_cvtps_pd(b)));
+		total_hi = _mm_add_pd(total_hi, _mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(a, a)), _mm_cvtps_pd(_mm_movehl_ps(b, b))));
+	}
+	double total = _sse2_horizontal_sum(_mm_add_pd(total_lo, total_hi));
+	for (; i < p_count; i++) {
+		total += double(p_a[i]) * double(p_b[i]);
+	}
+	return total;
+}
+
+static void _xform_vector2_sse2(float *p_dst, const float *p_src, const float *p_xform, int64_t p_count) {
+	// Two points per register, [x0, y0, x1, y1].
+	const __m128 x_axis = _mm_setr_ps(p_xform[0], p_xform[1], p_xform[0], p_xform[1]);
+	const __m128 y_axis = _mm_setr_ps(p_xform[2], p_xform[3], p_xform[2], p_xform[3]);
+	const __m128 origin = _mm_setr_ps(p_xform[4], p_xform[5], p_xform[4], p_xform[5]);
+	int64_t i = 0;
+	for (; i + 2 <= p_count; i += 2) {
+		const __m128 v = _mm_loadu_ps(p_src + i * 2);
+		const __m128 x = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 0, 0));
+		const __m128 y = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 1, 1));
+		_mm_storeu_ps(p_dst + i * 2, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x_axis, x), _mm_mul_ps(y_axis, y)), origin));
+	}
+	_xform_vector2_scalar(p_dst + i * 2, p_src + i * 2, p_xform, p_count - i);
+}
+
+static void _xform_vector3_sse2(float *p_dst, const float *p_src, const float *p_xform, int64_t p_count) {
+	const __m128 x_axis = _mm_setr_ps(p_xform[0], p_xform[1], p_xform[2], 0.0f);
+	const __m128 y_axis = _mm_setr_ps(p_xform[3], p_xform[4], p_xform[5], 0.0f);
+	const __m128 z_axis = _mm_setr_ps(p_xform[6], p_xform[7], p_xform[8], 0.0f);
+	const __m128 origin = _mm_setr_ps(p_xform[9], p_xform[10], p_xform[11], 0.0f);
+	for (int64_t i = 0; i < p_count; i++) {
+		const float *src = p_src + i * 3;
+		float *dst = p_dst + i * 3;
+		__m128 r = _mm_add_ps(origin, _mm_mul_ps(x_axis, _mm_set1_ps(src[0])));
+		r = _mm_add_ps(r, _mm_mul_ps(y_axis, _mm_set1_ps(src[1])));
+		r = _mm_add_ps(r, _mm_mul_ps(z_axis, _mm_set1_ps(src[2])));
+		// Only three lanes may be written, the next point follows right after.
+		_mm_storel_pi((__m64 *)dst, r);
+		_mm_store_ss(dst + 2, _mm_movehl_ps(r, r));
+	}
+}
+
+#endif // PACKED_ARRAY_KERNELS_SSE2
+
+/* NEON */
+
+#ifdef PACKED_ARRAY_KERNELS_NEON
+
+#define NEON_BINARY_KERNEL(m_name, m_op, m_intrinsic)                                                 \
+	static void _##m_name##_neon(float *p_dst, const float *p_a, const float *p_b, int64_t p_count) { \
+		int64_t i = 0;                                                                                 \
+		for (; i + 4 <= p_count; i += 4) {                                                             \
+			vst1q_f32(p_dst + i, m_intrinsic(vld1q_f32(p_a + i), vld1q_f32(p_b + i)));                 \
+		}                                                                                              \
+		for (; i < p_count; i++) {                                                                     \
+			p_dst[i] = p_a[i] m_op p_b[i];                                                             \
+		}                                                                                              \
+	}
+
+NEON_BINARY_KERNEL(add, +, vaddq_f32)
+NEON_BINARY_KERNEL(subtract, -, vsubq_f32)
+NEON_BINARY_KERNEL(multiply, *, vmulq_f32)
+NEON_BINARY_KERNEL(divide, /, vdivq_f32)
+
+static void _add_scalar_neon(float *p_dst, const float *p_a, float p_value, int64_t p_count) {
+	const float32x4_t value = vdupq_n_f32(p_value);
+	int64_t i = 0;
+	for (; i + 4 <= p_count; i += 4) {
+		vst1q_f32(p_dst + i, vaddq_f32(vld1q_f32(p_a + i), value));
+	}
+	for (; i < p_count; i++) {
+		p_dst[i] = p_a[i] + p_value;
+	}
+}
+
+static void _multiply_scalar_neon(float *p_dst, const float *p_a, float p_value, int64_t p_count) {
+	int64_t i = 0;
+	for (; i + 4 <= p_count; i += 4) {
+		vst1q_f32(p_dst + i, vmulq_n_f32(vld1q_f32(p_a + i), p_value));
+	}
+	for (; i < p_count; i++) {
+		p_dst[i] = p_a[i] * p_value;
+	}
+}
+
+static void _clamp_neon(float *p_dst, const float *p_a, float p_min, float p_max, int64_t p_count) {
+	const float32x4_t min = vdupq_n_f32(p_min);
+	const float32x4_t max = vdupq_n_f32(p_max);
+	int64_t i = 0;
+	for (; i + 4 <= p_count; i += 4) {
+		vst1q_f32(p_dst + i, vminq_f32(vmaxq_f32(vld1q_f32(p_a + i), min), max));
+	}
+	for (; i < p_count; i++) {
+		p_dst[i] = CLAMP(p_a[i], p_min, p_max);
+	}
+}
+
+static void _lerp_neon(float *p_dst, const float *p_from, const float *p_to, float p_weight, int64_t p_count) {
+	int64_t i = 0;
+	for (; i + 4 <= p_count; i += 4) {
+		const float32x4_t from = vld1q_f32(p_from + i);
+		vst1q_f32(p_dst + i, vmlaq_n_f32(from, vsubq_f32(vld1q_f32(p_to + i), from), p_weight));
+	}
+	for (; i < p_count; i++) {
+		p_dst[i] = p_from[i] + (p_to[i] - p_from[i]) * p_weight;
+	}
+}
+
+static double _sum_neon(const float *p_a, int64_t p_count) {
+	float64x2_t total_lo = vdupq_n_f64(0.0);
+	float64x2_t total_hi = vdupq_n_f64(0.0);
+	int64_t i = 0;
+	for (; i + 4 <= p_count; i += 4) {
+		const float32x4_t a = vld1q_f32(p_a + i);
+		total_lo = vaddq_f64(total_lo, vcvt_f64_f32(vget_low_f32(a)));
+		total_hi = vaddq_f64(total_hi, vcvt_high_f64_f32(a));
+	}
+	double total = vaddvq_f64(vaddq_f64(total_lo, total_hi));
+	for (; i < p_count; i++) {
+		total += p_a[i];
+	}
+	return total;
+}
+
+static double _dot_neon(const float *p_a, const float *p_b, int64_t p_count) {
+	float64x2_t total_lo = vdupq_n_f64(0.0);
+	float64x2_t total_hi = vdupq_n_f64(0.0);
+	int64_t i = 0;
+	for (; i + 4 <= p_count; i += 4) {
+		const float32x4_t a = vld1q_f32(p_a + i);
+		const float32x4_t b = vld1q_f32(p_b + i);
+		total_lo = vaddq_f64(total_lo, vmulq_f64(vcvt_f64_f32(vget_low_f32(a)), vcvt_f64_f32(vget_low_f32(b))));
+		total_hi = vaddq_f64(total_hi, vmulq_f64(vcvt_high_f64_f32(a), vcvt_high_f64_f32(b)));
+	}
+	double total = vaddvq_f64(vaddq_f64(total_lo, total_hi));
+	for (; i < p_count; i++) {
+		total += double(p_a[i]) * double(p_b[i]);
+	}
+	return total;
+}
+
+static void _xform_vector2_neon(float *p_dst, const float *p_src, const float *p_xform, int64_t p_count) {
+	int64_t i = 0;
+	for (; i + 4 <= p_count; i += 4) {
+		// Deinterleave four points into [x0..x3] and [y0..y3].
+		float32x4x2_t v = vld2q_f32(p_src + i * 2);
+		float32x4x2_t r;
+		r.val[0] = vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(p_xform[4]), v.val[0], p_xform[0]), v.val[1], p_xform[2]);
+		r.val[1] = vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(p_xform[5]), v.val[0], p_xform[1]), v.val[1], p_xform[3]);
+		vst2q_f32(p_dst + i * 2, r);
+	}
+	_xform_vector2_scalar(p_dst + i * 2, p_src + i * 2, p_xform, p_count - i);
+}
+
+static void _xform_vector3_neon(float *p_dst, const float *p_src, const float *p_xform, int64_t p_count) {
+	int64_t i = 0;
+	for (; i + 4 <= p_count; i += 4) {
+		// Deinterleave four points into [x0..x3], [y0..y3] and [z0..z3].
+		float32x4x3_t v = vld3q_f32(p_src + i * 3);
+		float32x4x3_t r;
+		for (int j = 0; j < 3; j++) {
+			float32x4_t c = vmlaq_n_f32(vdupq_n_f32(p_xform[9 + j]), v.val[0], p_xform[j]);
+			c = vmlaq_n_f32(c, v.val[1], p_xform[3 + j]);
+			r.val[j] = vmlaq_n_f32(c, v.val[2], p_xform[6 + j]);
+		}
+		vst3q_f32(p_dst + i * 3, r);
+	}
+	_xform_vector3_scalar(p_dst + i * 3, p_src + i * 3, p_xform, p_count - i);
+}
+
+#endif // PACKED_ARRAY_KERNELS_NEON
+
+/* Selection */
+
+#define SET_KERNELS(m_kernels, m_suffix)                     \
+	m_kernels.add = _add_##m_suffix;                         \
+	m_kernels.subtract = _subtract_##m_suffix;               \
+	m_kernels.multiply = _multiply_##m_suffix;               \
+	m_kernels.divide = _divide_##m_suffix;                   \
+	m_kernels.add_scalar = _add_scalar_##m_suffix;           \
+	m_kernels.multiply_scalar = _multiply_scalar_##m_suffix; \
+	m_kernels.clamp = _clamp_##m_suffix;                     \
+	m_kernels.lerp = _lerp_##m_suffix;                       \
+	m_kernels.sum = _sum_##m_suffix;                         \
+	m_kernels.dot = _dot_##m_suffix;                         \
+	m_kernels.xform_vector2 = _xform_vector2_##m_suffix;     \
+	m_kernels.xform_vector3 = _xform_vector3_##m_suffix;
+
+const PackedArrayKernels *PackedArrayKernels::get_kernels(Level p_level) {
+	switch (p_level) {
+		case LEVEL_SCALAR: {
+			static const PackedArrayKernels scalar = []() {
+				PackedArrayKernels k;
+				k.name = "Scalar";
+				k.level = LEVEL_SCALAR;
+				SET_KERNELS(k, scalar);
+				return k;
+			}();
+			return &scalar;
+		}
+		case LEVEL_SSE2: {
+#ifdef PACKED_ARRAY_KERNELS_SSE2
+			static const PackedArrayKernels sse2 = []() {
+				PackedArrayKernels k;
+				k.name = "SSE2";
+				k.level = LEVEL_SSE2;
+				SET_KERNELS(k, sse2);
+				return k;
+			}();
+			return &sse2;
+#else
+			return nullptr;
+#endif
+		}
+		case LEVEL_NEON: {
+#ifdef PACKED_ARRAY_KERNELS_NEON
+			static const PackedArrayKernels neon = []() {
+				PackedArrayKernels k;
+				k.name = "NEON";
+				k.level = LEVEL_NEON;
+				SET_KERNELS(k, neon);
+				return k;
+			}();
+			return &neon;
+#else
+			return nullptr;
+#endif
+		}
+		case LEVEL_MAX:
+			break;
+	}
+	ERR_FAIL_V(nullptr);
+}
+
+const PackedArrayKernels *PackedArrayKernels::get_singleton() {
+	static const PackedArrayKernels *best = []() {
+		const Level preferred[] = { LEVEL_NEON, LEVEL_SSE2 };
+		for (Level level : preferred) {
+			const PackedArrayKernels *kernels = get_kernels(level);
+			if (kernels) {
+				return kernels;
+			}
+		}
+		return get_kernels(LEVEL_SCALAR);
+	}();
+	return best;
+}
@@ -0,0 +1,76 @@
+/*************************************************************************/
+/*  packed_array_kernels.h                                               */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef PACKED_ARRAY_KERNELS_H
+#define PACKED_ARRAY_KERNELS_H
+
+#include "core/typedefs.h"
+
+// Vectorized bulk math on single precision packed arrays.
+// Every instruction set provides the same set of kernels, the best one supported by the running CPU is picked at runtime.
+// All kernels accept p_dst aliasing one of the sources, and produce the same results as the scalar versions save for rounding.
+struct PackedArrayKernels {
+	enum Level {
+		LEVEL_SCALAR,
+		LEVEL_SSE2,
+		LEVEL_NEON,
+		LEVEL_MAX
+	};
+
+	const char *name = "";
+	Level level = LEVEL_SCALAR;
+
+	// p_dst[i] = p_a[i] (op) p_b[i]
+	void (*add)(float *p_dst, const float *p_a, const float *p_b, int64_t p_count) = nullptr;
+	void (*subtract)(float *p_dst, const float *p_a, const float *p_b, int64_t p_count) = nullptr;
+	void (*multiply)(float *p_dst, const float *p_a, const float *p_b, int64_t p_count) = nullptr;
+	void (*divide)(float *p_dst, const float *p_a, const float *p_b, int64_t p_count) = nullptr;
+	// p_dst[i] = p_a[i] (op) p_value
+	void (*add_scalar)(float *p_dst, const float *p_a, float p_value, int64_t p_count) = nullptr;
+	void (*multiply_scalar)(float *p_dst, const float *p_a, float p_value, int64_t p_count) = nullptr;
+	// p_dst[i] = CLAMP(p_a[i], p_min, p_max)
+	void (*clamp)(float *p_dst, const float *p_a, float p_min, float p_max, int64_t p_count) = nullptr;
+	// p_dst[i] = p_from[i] + (p_to[i] - p_from[i]) * p_weight
+	void (*lerp)(float *p_dst, const float *p_from, const float *p_to, float p_weight, int64_t p_count) = nullptr;
+	// Reductions accumulate in double precision, so large arrays don't lose precision.
+	double (*sum)(const float *p_a, int64_t p_count) = nullptr;
+	double (*dot)(const float *p_a, const float *p_b, int64_t p_count) = nullptr;
+	// Transforms p_count packed 2D points by the columns [x_axis, y_axis, origin] in p_xform.
+	void (*xform_vector2)(float *p_dst, const float *p_src, const float *p_xform, int64_t p_count) = nullptr;
+	// Transforms p_count packed 3D points by the columns [x_axis, y_axis, z_axis, origin] in p_xform.
+	void (*xform_vector3)(float *p_dst, const float *p_src, const float *p_xform, int64_t p_count) = nullptr;
+
+	// Returns nullptr if the level is not supported by this build.
+	static const PackedArrayKernels *get_kernels(Level p_level);
+	// The fastest kernels available.
+	static const PackedArrayKernels *get_singleton();
+};
+
+#endif // PACKED_ARRAY_KERNELS_H
@@ -39,6 +39,7 @@
 #include "core/os/os.h"
 #include "core/templates/local_vector.h"
 #include "core/templates/oa_hash_map.h"
+#include "core/variant/packed_array_kernels.h"
 
 typedef void (*VariantFunc)(Variant &r_ret, Variant &p_self, const Variant **p_args);
 typedef void (*VariantConstructFunc)(Variant &r_ret, const Variant **p_args);
@@ -545,6 +546,143 @@ static _FORCE_INLINE_ void vc_ptrcall(void (*method)(T *, P...), void *p_base, c
 		}                                                                                                                                                         \
 	};
 
+// Bulk math on packed arrays works on the flat components of the elements.
+// Single precision data goes through the SIMD kernels, double precision data through plain loops.
+
+template <class T>
+struct PackedArrayComponents {
+	typedef T Type;
+	static constexpr int COUNT = 1;
+};
+
+template <>
+struct PackedArrayComponents<Vector2> {
+	typedef real_t Type;
+	static constexpr int COUNT = 2;
+};
+
+template <>
+struct PackedArrayComponents<Vector3> {
+	typedef real_t Type;
+	static constexpr int COUNT = 3;
+};
+
+static _FORCE_INLINE_ void _packed_add(float *p_dst, const float *p_src, int64_t p_count) {
+	PackedArrayKernels::get_singleton()->add(p_dst, p_dst, p_src, p_count);
+}
+static _FORCE_INLINE_ void _packed_subtract(float *p_dst, const float *p_src, int64_t p_count) {
+	PackedArrayKernels::get_singleton()->subtract(p_dst, p_dst, p_src, p_count);
+}
+static _FORCE_INLINE_ void _packed_multiply(float *p_dst, const float *p_src, int64_t p_count) {
+	PackedArrayKernels::get_singleton()->multiply(p_dst, p_dst, p_src, p_count);
+}
+static _FORCE_INLINE_ void _packed_divide(float *p_dst, const float *p_src, int64_t p_count) {
+	PackedArrayKernels::get_singleton()->divide(p_dst, p_dst, p_src, p_count);
+}
+static _FORCE_INLINE_ void _packed_add_scalar(float *p_dst, float p_value, int64_t p_count) {
+	PackedArrayKernels::get_singleton()->add_scalar(p_dst, p_dst, p_value, p_count);
+}
+static _FORCE_INLINE_ void _packed_multiply_scalar(float *p_dst, float p_value, int64_t p_count) {
+	PackedArrayKernels::get_singleton()->multiply_scalar(p_dst, p_dst, p_value, p_count);
+}
+static _FORCE_INLINE_ void _packed_clamp(float *p_dst, float p_min, float p_max, int64_t p_count) {
+	PackedArrayKernels::get_singleton()->clamp(p_dst, p_dst, p_min, p_max, p_count);
+}
+static _FORCE_INLINE_ void _packed_lerp(float *p_dst, const float *p_to, float p_weight, int64_t p_count) {
+	PackedArrayKernels::get_singleton()->lerp(p_dst, p_dst, p_to, p_weight, p_count);
+}
+static _FORCE_INLINE_ double _packed_sum(const float *p_src, int64_t p_count) {
+	return PackedArrayKernels::get_singleton()->sum(p_src, p_count);
+}
+static _FORCE_INLINE_ double _packed_dot(const float *p_a, const float *p_b, int64_t p_count) {
+	return PackedArrayKernels::get_singleton()->dot(p_a, p_b, p_count);
+}
+static _FORCE_INLINE_ void _packed_xform(float *p_dst, const Transform2D &p_xform, int64_t p_count) {
+	const float xform[6] = {
+		(float)p_xform.elements[0].x, (float)p_xform.elements[0].y,
+		(float)p_xform.elements[1].x, (float)p_xform.elements[1].y,
+		(float)p_xform.elements[2].x, (float)p_xform.elements[2].y
+	};
+	PackedArrayKernels::get_singleton()->xform_vector2(p_dst, p_dst, xform, p_count);
+}
+static _FORCE_INLINE_ void _packed_xform(float *p_dst, const Transform3D &p_xform, int64_t p_count) {
+	const Basis &b = p_xform.basis;
+	const float xform[12] = {
+		(float)b.elements[0].x, (float)b.elements[1].x, (float)b.elements[2].x,
+		(float)b.elements[0].y, (float)b.elements[1].y, (float)b.elements[2].y,
+		(float)b.elements[0].z, (float)b.elements[1].z, (float)b.elements[2].z,
+		(float)p_xform.origin.x, (float)p_xform.origin.y, (float)p_xform.origin.z
+	};
+	PackedArrayKernels::get_singleton()->xform_vector3(p_dst, p_dst, xform, p_count);
+}
+
+static _FORCE_INLINE_ void _packed_add(double *p_dst, const double *p_src, int64_t p_count) {
+	for (int64_t i = 0; i < p_count; i++) {
+		p_dst[i] += p_src[i];
+	}
+}
+static _FORCE_INLINE_ void _packed_subtract(double *p_dst, const double *p_src, int64_t p_count) {
+	for (int64_t i = 0; i < p_count; i++) {
+		p_dst[i] -= p_src[i];
+	}
+}
+static _FORCE_INLINE_ void _packed_multiply(double *p_dst, const double *p_src, int64_t p_count) {
+	for (int64_t i = 0; i < p_count; i++) {
+		p_dst[i] *= p_src[i];
+	}
+}
+static _FORCE_INLINE_ void _packed_divide(double *p_dst, const double *p_src, int64_t p_count) {
+	for (int64_t i = 0; i < p_count; i++) {
+		p_dst[i] /= p_src[i];
+	}
+}
+static _FORCE_INLINE_ void _packed_add_scalar(double *p_dst, double p_value, int64_t p_count) {
+	for (int64_t i = 0; i < p_count; i++) {
+		p_dst[i] += p_value;
+	}
+}
+static _FORCE_INLINE_ void _packed_multiply_scalar(double *p_dst, double p_value, int64_t p_count) {
+	for (int64_t i = 0; i < p_count; i++) {
+		p_dst[i] *= p_value;
+	}
+}
+static _FORCE_INLINE_ void _packed_clamp(double *p_dst, double p_min, double p_max, int64_t p_count) {
+	for (int64_t i = 0; i < p_count; i++) {
+		p_dst[i] = CLAMP(p_dst[i], p_min, p_max);
+	}
+}
+static _FORCE_INLINE_ void _packed_lerp(double *p_dst, const double *p_to, double p_weight, int64_t p_count) {
+	for (int64_t i = 0; i < p_count; i++) {
+		p_dst[i] += (p_to[i] - p_dst[i]) * p_weight;
+	}
+}
+static _FORCE_INLINE_ double _packed_sum(const double *p_src, int64_t p_count) {
+	double total = 0.0;
+	for (int64_t i = 0; i < p_count; i++) {
+		total += p_src[i];
+	}
+	return total;
+}
+static _FORCE_INLINE_ double _packed_dot(const double *p_a, const double *p_b, int64_t p_count) {
+	double total = 0.0;
+	for (int64_t i = 0; i < p_count; i++) {
+		total += p_a[i] * p_b[i];
+	}
+	return total;
+}
+static _FORCE_INLINE_ void _packed_xform(double *p_dst, const Transform2D &p_xform, int64_t p_count) {
+	Vector2 *points = (Vector2 *)p_dst;
+	for (int64_t i = 0; i < p_count; i++) {
+		points[i] = p_xform.xform(points[i]);
+	}
+}
+static _FORCE_INLINE_ void _packed_xform(double *p_dst, const Transform3D &p_xform, int64_t p_count) {
+	Vector3 *points = (Vector3 *)p_dst;
+	for (int64_t i = 0; i < p_count; i++) {
+		points[i] = p_xform.xform(points[i]);
+	}
+}
+
 struct _VariantCall {
 	static String func_PackedByteArray_get_string_from_ascii(PackedByteArray *p_instance) {
 		String s;
@@ -877,6 +1015,98 @@ struct _VariantCall {
 		return len;
 	}
 
+	template <class T>
+	static void func_PackedArray_add_array(Vector<T> *p_instance, const Vector<T> &p_array) {
+		ERR_FAIL_COND_MSG(p_instance->size() != p_array.size(), "Both arrays must have the same size.");
+		typedef typename PackedArrayComponents<T>::Type C;
+		C *w = (C *)p_instance->ptrw();
+		_packed_add(w, (const C *)p_array.ptr(), int64_t(p_array.size()) * PackedArrayComponents<T>::COUNT);
+	}
+
+	template <class T>
+	static void func_PackedArray_subtract_array(Vector<T> *p_instance, const Vector<T> &p_array) {
+		ERR_FAIL_COND_MSG(p_instance->size() != p_array.size(), "Both arrays must have the same size.");
+		typedef typename PackedArrayComponents<T>::Type C;
+		C *w = (C *)p_instance->ptrw();
+		_packed_subtract(w, (const C *)p_array.ptr(), int64_t(p_array.size()) * PackedArrayComponents<T>::COUNT);
+	}
+
+	template <class T>
+	static void func_PackedArray_multiply_array(Vector<T> *p_instance, const Vector<T> &p_array) {
+		ERR_FAIL_COND_MSG(p_instance->size() != p_array.size(), "Both arrays must have the same size.");
+		typedef typename PackedArrayComponents<T>::Type C;
+		C *w = (C *)p_instance->ptrw();
+		_packed_multiply(w, (const C *)p_array.ptr(), int64_t(p_array.size()) * PackedArrayComponents<T>::COUNT);
+	}
+
+	template <class T>
+	static void func_PackedArray_divide_array(Vector<T> *p_instance, const Vector<T> &p_array) {
+		ERR_FAIL_COND_MSG(p_instance->size() != p_array.size(), "Both arrays must have the same size.");
+		typedef typename PackedArrayComponents<T>::Type C;
+		C *w = (C *)p_instance->ptrw();
+		_packed_divide(w, (const C *)p_array.ptr(), int64_t(p_array.size()) * PackedArrayComponents<T>::COUNT);
+	}
+
+	template <class T>
+	static void func_PackedArray_add_scalar(Vector<T> *p_instance, double p_value) {
+		typedef typename PackedArrayComponents<T>::Type C;
+		_packed_add_scalar((C *)p_instance->ptrw(), C(p_value), int64_t(p_instance->size()) * PackedArrayComponents<T>::COUNT);
+	}
+
+	template <class T>
+	static void func_PackedArray_multiply_scalar(Vector<T> *p_instance, double p_value) {
+		typedef typename PackedArrayComponents<T>::Type C;
+		_packed_multiply_scalar((C *)p_instance->ptrw(), C(p_value), int64_t(p_instance->size()) * PackedArrayComponents<T>::COUNT);
+	}
+
+	template <class T>
+	static void func_PackedArray_clamp(Vector<T> *p_instance, double p_min, double p_max) {
+		typedef typename PackedArrayComponents<T>::Type C;
+		_packed_clamp((C *)p_instance->ptrw(), C(p_min), C(p_max), int64_t(p_instance->size()) * PackedArrayComponents<T>::COUNT);
+	}
+
+	template <class T>
+	static void func_PackedArray_lerp(Vector<T> *p_instance, const Vector<T> &p_to, double p_weight) {
+		ERR_FAIL_COND_MSG(p_instance->size() != p_to.size(), "Both arrays must have the same size.");
+		typedef typename PackedArrayComponents<T>::Type C;
+		C *w = (C *)p_instance->ptrw();
+		_packed_lerp(w, (const C *)p_to.ptr(), C(p_weight), int64_t(p_to.size()) * PackedArrayComponents<T>::COUNT);
+	}
+
+	template <class T>
+	static double func_PackedArray_sum(Vector<T> *p_instance) {
+		return _packed_sum(p_instance->ptr(), p_instance->size());
+	}
+
+	template <class T>
+	static double func_PackedArray_dot(Vector<T> *p_instance, const Vector<T> &p_array) {
+		ERR_FAIL_COND_V_MSG(p_instance->size() != p_array.size(), 0.0, "Both arrays must have the same size.");
+		typedef typename PackedArrayComponents<T>::Type C;
+		return _packed_dot((const C *)p_instance->ptr(), (const C *)p_array.ptr(), int64_t(p_instance->size()) * PackedArrayComponents<T>::COUNT);
+	}
+
+	template <class T>
+	static T func_PackedArray_sum_vectors(Vector<T> *p_instance) {
+		const T *r = p_instance->ptr();
+		T total;
+		for (int i = 0; i < p_instance->size(); i++) {
+			total += r[i];
+		}
+		return total;
+	}
+
+	static void func_PackedVector2Array_transform(PackedVector2Array *p_instance, const Transform2D &p_xform) {
+		_packed_xform((real_t *)p_instance->ptrw(), p_xform, p_instance->size());
+	}
+
+	static void func_PackedVector3Array_transform(PackedVector3Array *p_instance, const Transform3D &p_xform) {
+		_packed_xform((real_t *)p_instance->ptrw(), p_xform, p_instance->size());
+	}
+
+	static void func_PackedVector3Array_transform_basis(PackedVector3Array *p_instance, const Basis &p_basis) {
+		_packed_xform((real_t *)p_instance->ptrw(), Transform3D(p_basis, Vector3()), p_instance->size());
+	}
+
 	static void func_Callable_call(Variant *v, const Variant **p_args, int p_argcount, Variant &r_ret, Callable::CallError &r_error) {
 		Callable *callable = VariantGetInternalPtr<Callable>::get_ptr(v);
 		callable->call(p_args, p_argcount, r_ret, r_error);
@@ -1976,6 +2206,17 @@ static void _register_variant_builtin_methods() {
 	bind_method(PackedFloat32Array, bsearch, sarray("value", "before"), varray(true));
 	bind_method(PackedFloat32Array, duplicate, sarray(), varray());
 
+	bind_functionnc(PackedFloat32Array, add_array, _VariantCall::func_PackedArray_add_array<float>, sarray("array"), varray());
+	bind_functionnc(PackedFloat32Array, subtract_array, _VariantCall::func_PackedArray_subtract_array<float>, sarray("array"), varray());
+	bind_functionnc(PackedFloat32Array, multiply_array, _VariantCall::func_PackedArray_multiply_array<float>, sarray("array"), varray());
+	bind_functionnc(PackedFloat32Array, divide_array, _VariantCall::func_PackedArray_divide_array<float>, sarray("array"), varray());
+	bind_functionnc(PackedFloat32Array, add_scalar, _VariantCall::func_PackedArray_add_scalar<float>, sarray("value"), varray());
+	bind_functionnc(PackedFloat32Array, multiply_scalar, _VariantCall::func_PackedArray_multiply_scalar<float>, sarray("value"), varray());
+	bind_functionnc(PackedFloat32Array, clamp, _VariantCall::func_PackedArray_clamp<float>, sarray("min", "max"), varray());
+	bind_functionnc(PackedFloat32Array, lerp, _VariantCall::func_PackedArray_lerp<float>, sarray("to", "weight"), varray());
+	bind_function(PackedFloat32Array, sum, _VariantCall::func_PackedArray_sum<float>, sarray(), varray());
+	bind_function(PackedFloat32Array, dot, _VariantCall::func_PackedArray_dot<float>, sarray("array"), varray());
+
 	/* Float64 Array */
 
 	bind_method(PackedFloat64Array, size, sarray(), varray());
@@ -1996,6 +2237,17 @@ static void _register_variant_builtin_methods() {
 	bind_method(PackedFloat64Array, bsearch, sarray("value", "before"), varray(true));
 	bind_method(PackedFloat64Array, duplicate, sarray(), varray());
 
+	bind_functionnc(PackedFloat64Array, add_array, _VariantCall::func_PackedArray_add_array<double>, sarray("array"), varray());
+	bind_functionnc(PackedFloat64Array, subtract_array, _VariantCall::func_PackedArray_subtract_array<double>, sarray("array"), varray());
+	bind_functionnc(PackedFloat64Array, multiply_array, _VariantCall::func_PackedArray_multiply_array<double>, sarray("array"), varray());
+	bind_functionnc(PackedFloat64Array, divide_array, _VariantCall::func_PackedArray_divide_array<double>, sarray("array"), varray());
+	bind_functionnc(PackedFloat64Array, add_scalar, _VariantCall::func_PackedArray_add_scalar<double>, sarray("value"), varray());
+	bind_functionnc(PackedFloat64Array, multiply_scalar, _VariantCall::func_PackedArray_multiply_scalar<double>, sarray("value"), varray());
+	bind_functionnc(PackedFloat64Array, clamp, _VariantCall::func_PackedArray_clamp<double>, sarray("min", "max"), varray());
+	bind_functionnc(PackedFloat64Array, lerp, _VariantCall::func_PackedArray_lerp<double>, sarray("to", "weight"), varray());
+	bind_function(PackedFloat64Array, sum, _VariantCall::func_PackedArray_sum<double>, sarray(), varray());
+	bind_function(PackedFloat64Array, dot, _VariantCall::func_PackedArray_dot<double>, sarray("array"), varray());
+
 	/* String Array */
 
 	bind_method(PackedStringArray, size, sarray(), varray());
@@ -2036,6 +2288,18 @@ static void _register_variant_builtin_methods() {
 	bind_method(PackedVector2Array, bsearch, sarray("value", "before"), varray(true));
 	bind_method(PackedVector2Array, duplicate, sarray(), varray());
 
+	bind_functionnc(PackedVector2Array, add_array, _VariantCall::func_PackedArray_add_array<Vector2>, sarray("array"), varray());
+	bind_functionnc(PackedVector2Array, subtract_array, _VariantCall::func_PackedArray_subtract_array<Vector2>, sarray("array"), varray());
+	bind_functionnc(PackedVector2Array, multiply_array, _VariantCall::func_PackedArray_multiply_array<Vector2>, sarray("array"), varray());
+	bind_functionnc(PackedVector2Array, divide_array, _VariantCall::func_PackedArray_divide_array<Vector2>, sarray("array"), varray());
+	bind_functionnc(PackedVector2Array, add_scalar, _VariantCall::func_PackedArray_add_scalar<Vector2>, sarray("value"), varray());
+	bind_functionnc(PackedVector2Array, multiply_scalar, _VariantCall::func_PackedArray_multiply_scalar<Vector2>, sarray("value"), varray());
+	bind_functionnc(PackedVector2Array, clamp, _VariantCall::func_PackedArray_clamp<Vector2>, sarray("min", "max"), varray());
+	bind_functionnc(PackedVector2Array, lerp, _VariantCall::func_PackedArray_lerp<Vector2>, sarray("to", "weight"), varray());
+	bind_function(PackedVector2Array, sum, _VariantCall::func_PackedArray_sum_vectors<Vector2>, sarray(), varray());
+	bind_function(PackedVector2Array, dot, _VariantCall::func_PackedArray_dot<Vector2>, sarray("array"), varray());
+	bind_functionnc(PackedVector2Array, transform, _VariantCall::func_PackedVector2Array_transform, sarray("xform"), varray());
+
 	/* Vector3 Array */
 
 	bind_method(PackedVector3Array, size, sarray(), varray());
@@ -2056,6 +2320,19 @@ static void _register_variant_builtin_methods() {
 	bind_method(PackedVector3Array, bsearch, sarray("value", "before"), varray(true));
 	bind_method(PackedVector3Array, duplicate, sarray(), varray());
 
+	bind_functionnc(PackedVector3Array, add_array, _VariantCall::func_PackedArray_add_array<Vector3>, sarray("array"), varray());
+	bind_functionnc(PackedVector3Array, subtract_array, _VariantCall::func_PackedArray_subtract_array<Vector3>, sarray("array"), varray());
+	bind_functionnc(PackedVector3Array, multiply_array, _VariantCall::func_PackedArray_multiply_array<Vector3>, sarray("array"), varray());
+	bind_functionnc(PackedVector3Array, divide_array, _VariantCall::func_PackedArray_divide_array<Vector3>, sarray("array"), varray());
+	bind_functionnc(PackedVector3Array, add_scalar, _VariantCall::func_PackedArray_add_scalar<Vector3>, sarray("value"), varray());
+	bind_functionnc(PackedVector3Array, multiply_scalar, _VariantCall::func_PackedArray_multiply_scalar<Vector3>, sarray("value"), varray());
+	bind_functionnc(PackedVector3Array, clamp, _VariantCall::func_PackedArray_clamp<Vector3>, sarray("min", "max"), varray());
+	bind_functionnc(PackedVector3Array, lerp, _VariantCall::func_PackedArray_lerp<Vector3>, sarray("to", "weight"), varray());
+	bind_function(PackedVector3Array, sum, _VariantCall::func_PackedArray_sum_vectors<Vector3>, sarray(), varray());
+	bind_function(PackedVector3Array, dot, _VariantCall::func_PackedArray_dot<Vector3>, sarray("array"), varray());
+	bind_functionnc(PackedVector3Array, transform, _VariantCall::func_PackedVector3Array_transform, sarray("xform"), varray());
+	bind_functionnc(PackedVector3Array, transform_basis, _VariantCall::func_PackedVector3Array_transform_basis, sarray("basis"), varray());
+
 	/* Color Array */
 
 	bind_method(PackedColorArray, size, sarray(), varray());
@@ -50,6 +50,7 @@
 #include "core/os/time.h"
 #include "core/register_core_types.h"
 #include "core/string/translation.h"
+#include "core/templates/worker_thread_pool.h"
 #include "core/version.h"
 #include "drivers/register_driver_types.h"
 #include "main/app_icon.gen.h"
@@ -175,6 +176,7 @@ static bool use_debug_profiler = false;
 #ifdef DEBUG_ENABLED
 static bool debug_collisions = false;
 static bool debug_navigation = false;
+static String memory_profile_path;
 #endif
 static int frame_delay = 0;
 static bool disable_render_loop = false;
@@ -354,6 +356,7 @@ void Main::print_help(const char *p_binary) {
 	OS::get_singleton()->print("  --debug-navigation                           Show navigation polygons when running the scene.\n");
 	OS::get_singleton()->print("  --debug-stringnames                          Print all StringName allocations to stdout when the engine quits.\n");
 #endif
+	OS::get_singleton()->print("  --profile-memory <file>                      Attribute allocations to their source location or type and save a report to <file> when the engine quits (debug builds only).\n");
 	OS::get_singleton()->print("  --frame-delay <ms>                           Simulate high CPU load (delay each frame by <ms> milliseconds).\n");
 	OS::get_singleton()->print("  --time-scale <scale>                         Force time scale (higher values are faster, 1.0 is normal speed).\n");
 	OS::get_singleton()->print("  --disable-render-loop                        Disable render loop so rendering only occurs when called explicitly from script.\n");
@@ -1073,6 +1076,22 @@ Error Main::setup(const char *execpath, int argc, char *argv[], bool p_second_ph
 			debug_navigation = true;
 		} else if (I->get() == "--debug-stringnames") {
 			StringName::set_debug_stringnames(true);
+		} else if (I->get() == "--profile-memory") {
+			if (I->next()) {
+				memory_profile_path = I->next()->get();
+				Memory::set_profiling(true);
+				performance->add_memory_profiler_monitors();
+				N = I->next()->next();
+			} else {
+				OS::get_singleton()->print("Missing memory profile output file, aborting.\n");
+				goto error;
+			}
+#else
+		} else if (I->get() == "--profile-memory") {
+			OS::get_singleton()->print("The memory profiler is only available in debug builds, ignoring --profile-memory.\n");
+			if (I->next()) {
+				N = I->next()->next();
+			}
 #endif
 		} else if (I->get() == "--remote-debug") {
 			if (I->next()) {
@@ -1169,6 +1188,13 @@ Error Main::setup(const char *execpath, int argc, char *argv[], bool p_second_ph
 	// Initialize user data dir.
 	OS::get_singleton()->ensure_user_data_dir();
 
+	// Start the worker threads shared by all subsystems.
+	GLOBAL_DEF_RST("threading/worker_pool/max_threads", -1);
+	ProjectSettings::get_singleton()->set_custom_property_info("threading/worker_pool/max_threads", PropertyInfo(Variant::INT, "threading/worker_pool/max_threads", PROPERTY_HINT_RANGE, "-1,256,1,or_greater"));
+	GLOBAL_DEF_RST("threading/worker_pool/high_priority_threads", 1);
+	ProjectSettings::get_singleton()->set_custom_property_info("threading/worker_pool/high_priority_threads", PropertyInfo(Variant::INT, "threading/worker_pool/high_priority_threads", PROPERTY_HINT_RANGE, "0,16,1"));
+	WorkerThreadPool::get_singleton()->init(GLOBAL_GET("threading/worker_pool/max_threads"), GLOBAL_GET("threading/worker_pool/high_priority_threads"));
+
 	register_core_extensions(); // core extensions must be registered after globals setup and before display
 
 	ResourceUID::get_singleton()->load_from_cache(); // load UUIDs from cache.
@@ -2833,6 +2859,13 @@ void Main::cleanup(bool p_force) {
 	// Flush before uninitializing the scene, but delete the MessageQueue as late as possible.
 	message_queue->flush();
 
+#ifdef DEBUG_ENABLED
+	if (!memory_profile_path.is_empty()) {
+		performance->save_memory_profile(memory_profile_path);
+		memory_profile_path = String();
+	}
+#endif
+
 	OS::get_singleton()->delete_main_loop();
 
 	OS::get_singleton()->_cmdline.clear();
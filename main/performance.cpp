@@ -30,6 +30,7 @@
 
 #include "performance.h"
 
+#include "core/io/file_access.h"
 #include "core/object/message_queue.h"
 #include "core/os/os.h"
 #include "scene/main/node.h"
@@ -258,6 +259,202 @@ uint64_t Performance::get_monitor_modification_time() {
 	return _monitor_modification_time;
 }
 
+#ifdef DEBUG_ENABLED
+Performance::AllocationSubsystem Performance::_get_allocation_subsystem(const char *p_site) {
+	// Most sites are source locations, so the subsystem follows from the path. Type sites
+	// (see memory_type_site()) are containers, or objects created by ClassDB.
+	static const struct {
+		const char *path;
+		AllocationSubsystem subsystem;
+	} rules[] = {
+		{ "CowData<char", ALLOCATION_SUBSYSTEM_STRING },
+		{ "CowData<", ALLOCATION_SUBSYSTEM_CONTAINERS },
+		{ "LocalVector<", ALLOCATION_SUBSYSTEM_CONTAINERS },
+		{ "PagedAllocator<", ALLOCATION_SUBSYSTEM_CONTAINERS },
+		{ "memory_type_site", ALLOCATION_SUBSYSTEM_OBJECT },
+		{ "core/variant/", ALLOCATION_SUBSYSTEM_VARIANT },
+		{ "core/string/", ALLOCATION_SUBSYSTEM_STRING },
+		{ "core/object/", ALLOCATION_SUBSYSTEM_OBJECT },
+		{ "core/io/resource", ALLOCATION_SUBSYSTEM_RESOURCE },
+		{ "scene/resources/", ALLOCATION_SUBSYSTEM_RESOURCE },
+		{ "core/templates/", ALLOCATION_SUBSYSTEM_CONTAINERS },
+		{ "servers/", ALLOCATION_SUBSYSTEM_SERVERS },
+		{ "scene/", ALLOCATION_SUBSYSTEM_SCENE },
+		{ "modules/gdscript/", ALLOCATION_SUBSYSTEM_SCRIPT },
+		{ "modules/mono/", ALLOCATION_SUBSYSTEM_SCRIPT },
+		{ "modules/", ALLOCATION_SUBSYSTEM_MODULES },
+		{ "editor/", ALLOCATION_SUBSYSTEM_EDITOR },
+	};
+
+	for (uint32_t i = 0; i < sizeof(rules) / sizeof(rules[0]); i++) {
+		if (strstr(p_site, rules[i].path)) {
+			return rules[i].subsystem;
+		}
+	}
+	return ALLOCATION_SUBSYSTEM_OTHER;
+}
+
+String Performance::_get_allocation_site_name(const char *p_site) {
+	// Type sites are function signatures, keep only the type.
+	const String site = p_site;
+	if (!site.contains("memory_type_site")) {
+		return site;
+	}
+	String type;
+	if (site.contains("T = ")) { // GCC, Clang.
+		type = site.get_slice("T = ", 1).trim_suffix("]");
+	} else { // MSVC.
+		type = site.get_slice("memory_type_site<", 1).trim_suffix(">(void)");
+	}
+	return type.replace("class ", "").replace("struct ", "");
+}
+
+const char *Performance::_get_allocation_subsystem_name(AllocationSubsystem p_subsystem) {
+	static const char *names[ALLOCATION_SUBSYSTEM_MAX] = {
+		"variant",
+		"string",
+		"object",
+		"resource",
+		"containers",
+		"servers",
+		"scene",
+		"script",
+		"modules",
+		"editor",
+		"other",
+	};
+	return names[p_subsystem];
+}
+
+void Performance::_update_allocation_sites(bool p_force) {
+	// Monitors are polled one by one, refresh the snapshot at most a few times per second.
+	const uint64_t ticks = OS::get_singleton()->get_ticks_usec();
+	if (!p_force && _allocation_update_usec && ticks - _allocation_update_usec < 250000) {
+		return;
+	}
+
+	uint32_t count = Memory::get_allocation_sites(nullptr, 0);
+	_allocation_sites.resize(count + 64); // Room for sites added meanwhile.
+	count = MIN(Memory::get_allocation_sites(_allocation_sites.ptr(), _allocation_sites.size()), _allocation_sites.size());
+	_allocation_sites.resize(count);
+
+	uint64_t total_bytes = 0;
+	_allocation_live_bytes = 0;
+	for (int i = 0; i < ALLOCATION_SUBSYSTEM_MAX; i++) {
+		_allocation_subsystem_bytes[i] = 0;
+	}
+	for (uint32_t i = 0; i < count; i++) {
+		const Memory::AllocationSite &site = _allocation_sites[i];
+		_allocation_subsystem_bytes[_get_allocation_subsystem(site.site)] += site.live_bytes;
+		_allocation_live_bytes += site.live_bytes;
+		total_bytes += site.total_bytes;
+	}
+
+	if (_allocation_update_usec) {
+		_allocation_rate = double(total_bytes - _allocation_total_bytes) * 1000000.0 / double(MAX(ticks - _allocation_update_usec, (uint64_t)1));
+	}
+	_allocation_total_bytes = total_bytes;
+	_allocation_update_usec = ticks;
+}
+
+Variant Performance::_get_memory_profiler_monitor(int p_monitor) {
+	_update_allocation_sites(false);
+	switch (p_monitor) {
+		case MEMORY_PROFILER_LIVE_BYTES:
+			return _allocation_live_bytes;
+		case MEMORY_PROFILER_ALLOCATION_RATE:
+			return _allocation_rate;
+		default:
+			ERR_FAIL_INDEX_V(p_monitor, ALLOCATION_SUBSYSTEM_MAX, Variant());
+			return _allocation_subsystem_bytes[p_monitor];
+	}
+}
+
+void Performance::add_memory_profiler_monitors() {
+	if (has_custom_monitor("memory_profiler/live_bytes")) {
+		return;
+	}
+
+	add_custom_monitor("memory_profiler/live_bytes", callable_mp(this, &Performance::_get_memory_profiler_monitor), varray(MEMORY_PROFILER_LIVE_BYTES));
+	add_custom_monitor("memory_profiler/allocation_rate", callable_mp(this, &Performance::_get_memory_profiler_monitor), varray(MEMORY_PROFILER_ALLOCATION_RATE));
+	for (int i = 0; i < ALLOCATION_SUBSYSTEM_MAX; i++) {
+		add_custom_monitor(vformat("memory_profiler/%s_bytes", _get_allocation_subsystem_name(AllocationSubsystem(i))), callable_mp(this, &Performance::_get_memory_profiler_monitor), varray(i));
+	}
+}
+
+String Performance::get_memory_profile_report(int p_max_sites) {
+	_update_allocation_sites(true);
+
+	// The same site can show up more than once when its string literal is not
+	// merged across translation units, so merge sites by content.
+	struct SiteSort {
+		_FORCE_INLINE_ bool operator()(const Memory::AllocationSite &p_a, const Memory::AllocationSite &p_b) const {
+			return strcmp(p_a.site, p_b.site) < 0;
+		}
+	};
+	struct LiveBytesSort {
+		_FORCE_INLINE_ bool operator()(const Memory::AllocationSite &p_a, const Memory::AllocationSite &p_b) const {
+			return p_a.live_bytes > p_b.live_bytes;
+		}
+	};
+
+	LocalVector<Memory::AllocationSite> sites = _allocation_sites;
+	sites.sort_custom<SiteSort>();
+	uint32_t merged = 0;
+	for (uint32_t i = 0; i < sites.size(); i++) {
+		if (merged > 0 && strcmp(sites[merged - 1].site, sites[i].site) == 0) {
+			Memory::AllocationSite &site = sites[merged - 1];
+			site.live_bytes += sites[i].live_bytes;
+			site.live_count += sites[i].live_count;
+			site.total_bytes += sites[i].total_bytes;
+			site.total_count += sites[i].total_count;
+		} else {
+			sites[merged++] = sites[i];
+		}
+	}
+	sites.resize(merged);
+	sites.sort_custom<LiveBytesSort>();
+
+	int64_t subsystem_count[ALLOCATION_SUBSYSTEM_MAX] = {};
+	uint64_t subsystem_total[ALLOCATION_SUBSYSTEM_MAX] = {};
+	int64_t live_count = 0;
+	uint64_t total_count = 0;
+	for (uint32_t i = 0; i < sites.size(); i++) {
+		const AllocationSubsystem subsystem = _get_allocation_subsystem(sites[i].site);
+		subsystem_count[subsystem] += sites[i].live_count;
+		subsystem_total[subsystem] += sites[i].total_bytes;
+		live_count += sites[i].live_count;
+		total_count += sites[i].total_count;
+	}
+
+	String report = "Memory allocation profile\n\n";
+	report += vformat("Live: %d bytes in %d allocations.\n", _allocation_live_bytes, live_count);
+	report += vformat("Allocated while profiling: %d bytes in %d allocations.\n", (int64_t)_allocation_total_bytes, (int64_t)total_count);
+	report += vformat("Allocation rate: %d bytes/s.\n\n", (int64_t)_allocation_rate);
+
+	report += "Subsystem\tLive bytes\tLive allocations\tAllocated bytes\n";
+	for (int i = 0; i < ALLOCATION_SUBSYSTEM_MAX; i++) {
+		report += vformat("%s\t%d\t%d\t%d\n", _get_allocation_subsystem_name(AllocationSubsystem(i)), _allocation_subsystem_bytes[i], subsystem_count[i], (int64_t)subsystem_total[i]);
+	}
+
+	report += "\nTop allocation sites by live bytes:\n";
+	report += "Live bytes\tLive allocations\tAllocated bytes\tAllocations\tSite\n";
+	for (uint32_t i = 0; i < sites.size() && int(i) < p_max_sites; i++) {
+		const Memory::AllocationSite &site = sites[i];
+		report += vformat("%d\t%d\t%d\t%d\t%s\n", site.live_bytes, site.live_count, (int64_t)site.total_bytes, (int64_t)site.total_count, _get_allocation_site_name(site.site));
+	}
+	return report;
+}
+
+Error Performance::save_memory_profile(const String &p_path) {
+	Error err;
+	Ref<FileAccess> f = FileAccess::open(p_path, FileAccess::WRITE, &err);
+	ERR_FAIL_COND_V_MSG(err != OK, err, "Can't save the memory profile to: '" + p_path + "'.");
+	f->store_string(get_memory_profile_report());
+	return OK;
+}
+#endif
+
 Performance::Performance() {
 	_process_time = 0;
 	_physics_process_time = 0;
@@ -32,6 +32,7 @@
 #define PERFORMANCE_H
 
 #include "core/object/class_db.h"
+#include "core/templates/local_vector.h"
 #include "core/templates/ordered_hash_map.h"
 
 #define PERF_WARN_OFFLINE_FUNCTION
@@ -61,6 +62,41 @@ class Performance : public Object {
 	OrderedHashMap<StringName, MonitorCall> _monitor_map;
 	uint64_t _monitor_modification_time;
 
+#ifdef DEBUG_ENABLED
+	enum AllocationSubsystem {
+		ALLOCATION_SUBSYSTEM_VARIANT,
+		ALLOCATION_SUBSYSTEM_STRING,
+		ALLOCATION_SUBSYSTEM_OBJECT,
+		ALLOCATION_SUBSYSTEM_RESOURCE,
+		ALLOCATION_SUBSYSTEM_CONTAINERS,
+		ALLOCATION_SUBSYSTEM_SERVERS,
+		ALLOCATION_SUBSYSTEM_SCENE,
+		ALLOCATION_SUBSYSTEM_SCRIPT,
+		ALLOCATION_SUBSYSTEM_MODULES,
+		ALLOCATION_SUBSYSTEM_EDITOR,
+		ALLOCATION_SUBSYSTEM_OTHER,
+		ALLOCATION_SUBSYSTEM_MAX
+	};
+
+	enum {
+		MEMORY_PROFILER_LIVE_BYTES = ALLOCATION_SUBSYSTEM_MAX,
+		MEMORY_PROFILER_ALLOCATION_RATE,
+	};
+
+	LocalVector<Memory::AllocationSite> _allocation_sites;
+	int64_t _allocation_subsystem_bytes[ALLOCATION_SUBSYSTEM_MAX] = {};
+	int64_t _allocation_live_bytes = 0;
+	uint64_t _allocation_total_bytes = 0;
+	uint64_t _allocation_update_usec = 0;
+	double _allocation_rate = 0.0;
+
+	static AllocationSubsystem _get_allocation_subsystem(const char *p_site);
+	static String _get_allocation_site_name(const char *p_site);
+	static const char *_get_allocation_subsystem_name(AllocationSubsystem p_subsystem);
+	void _update_allocation_sites(bool p_force);
+	Variant _get_memory_profiler_monitor(int p_monitor);
+#endif
+
 public:
 	enum Monitor {
 		TIME_FPS,
@@ -112,6 +148,13 @@ public:
 
 	uint64_t get_monitor_modification_time();
 
+#ifdef DEBUG_ENABLED
+	// Allocation profiler results, see Memory::set_profiling().
+	void add_memory_profiler_monitors();
+	String get_memory_profile_report(int p_max_sites = 50);
+	Error save_memory_profile(const String &p_path);
+#endif
+
 	static Performance *get_singleton() { return singleton; }
 
 	Performance();
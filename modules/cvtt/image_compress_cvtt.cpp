@@ -31,9 +31,8 @@
 #include "image_compress_cvtt.h"
 
 #include "core/os/os.h"
-#include "core/os/thread.h"
 #include "core/string/print_string.h"
-#include "core/templates/safe_refcount.h"
+#include "core/templates/worker_thread_pool.h"
 
 #include <ConvectionKernels.h>
 
@@ -57,7 +56,8 @@ struct CVTTCompressionJobQueue {
 	CVTTCompressionJobParams job_params;
 	const CVTTCompressionRowTask *job_tasks;
 	uint32_t num_tasks = 0;
-	SafeNumeric<uint32_t> current_task;
+
+	void digest_row_task(uint32_t p_index, void *p_userdata);
 };
 
 static void _digest_row_task(const CVTTCompressionJobParams &p_job_params, const CVTTCompressionRowTask &p_row_task) {
@@ -129,12 +129,8 @@ static void _digest_row_task(const CVTTCompressionJobParams &p_job_params, const
 	}
 }
 
-static void _digest_job_queue(void *p_job_queue) {
-	CVTTCompressionJobQueue *job_queue = static_cast<CVTTCompressionJobQueue *>(p_job_queue);
-
-	for (uint32_t next_task = job_queue->current_task.increment(); next_task <= job_queue->num_tasks; next_task = job_queue->current_task.increment()) {
-		_digest_row_task(job_queue->job_params, job_queue->job_tasks[next_task - 1]);
-	}
+void CVTTCompressionJobQueue::digest_row_task(uint32_t p_index, void *p_userdata) {
+	_digest_row_task(job_params, job_tasks[p_index]);
 }
 
 void image_compress_cvtt(Image *p_image, float p_lossy_quality, Image::UsedChannels p_channels) {
@@ -202,14 +198,7 @@ void image_compress_cvtt(Image *p_image, float p_lossy_quality, Image::UsedChann
 	job_queue.job_params.bytes_per_pixel = is_hdr ? 6 : 4;
 	cvtt::Kernels::ConfigureBC7EncodingPlanFromQuality(job_queue.job_params.bc7_plan, 5);
 
-	int num_job_threads = 0;
-	// Amdahl's law (Wikipedia)
-	// If a program needs 20 hours to complete using a single thread, but a one-hour portion of the program cannot be parallelized,
-	// therefore only the remaining 19 hours (p = 0.95) of execution time can be parallelized, then regardless of how many threads are devoted
-	// to a parallelized execution of this program, the minimum execution time cannot be less than one hour.
-	//
-	// The number of executions with different inputs can be increased while the latency is the same.
-
+	// Rows are compressed independently, on the worker thread pool.
 	Vector<CVTTCompressionRowTask> tasks;
 
 	for (int i = 0; i <= mm_count; i++) {
@@ -229,11 +218,7 @@ void image_compress_cvtt(Image *p_image, float p_lossy_quality, Image::UsedChann
 			row_task.in_mm_bytes = in_bytes;
 			row_task.out_mm_bytes = out_bytes;
 
-			if (num_job_threads > 0) {
-				tasks.push_back(row_task);
-			} else {
-				_digest_row_task(job_queue.job_params, row_task);
-			}
+			tasks.push_back(row_task);
 
 			out_bytes += 16 * (bw / 4);
 		}
@@ -243,27 +228,13 @@ void image_compress_cvtt(Image *p_image, float p_lossy_quality, Image::UsedChann
 		h = MAX(h / 2, 1);
 	}
 
-	if (num_job_threads > 0) {
-		Vector<Thread *> threads;
-		threads.resize(num_job_threads);
-
-		Thread **threads_wb = threads.ptrw();
-
-		const CVTTCompressionRowTask *tasks_rb = tasks.ptr();
-
-		job_queue.job_tasks = &tasks_rb[0];
-		job_queue.current_task.set(0);
-		job_queue.num_tasks = static_cast<uint32_t>(tasks.size());
-
-		for (int i = 0; i < num_job_threads; i++) {
-			threads_wb[i] = memnew(Thread);
-			threads_wb[i]->start(_digest_job_queue, &job_queue);
-		}
-		_digest_job_queue(&job_queue);
-
-		for (int i = 0; i < num_job_threads; i++) {
-			threads_wb[i]->wait_to_finish();
-			memdelete(threads_wb[i]);
+	job_queue.job_tasks = tasks.ptr();
+	job_queue.num_tasks = static_cast<uint32_t>(tasks.size());
+	if (WorkerThreadPool::get_singleton()) {
+		WorkerThreadPool::get_singleton()->parallel_for(job_queue.num_tasks, &job_queue, &CVTTCompressionJobQueue::digest_row_task, (void *)nullptr);
+	} else {
+		for (uint32_t i = 0; i < job_queue.num_tasks; i++) {
+			job_queue.digest_row_task(i, nullptr);
 		}
 	}
 	p_image->create(p_image->get_width(), p_image->get_height(), p_image->has_mipmaps(), target_format, data);
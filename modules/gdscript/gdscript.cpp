@@ -40,10 +40,12 @@
 #include "core/io/file_access_encrypted.h"
 #include "core/os/os.h"
 #include "gdscript_analyzer.h"
+#include "gdscript_bytecode_cache.h"
 #include "gdscript_cache.h"
 #include "gdscript_compiler.h"
 #include "gdscript_parser.h"
 #include "gdscript_rpc_callable.h"
+#include "gdscript_sampling_profiler.h"
 #include "gdscript_warning.h"
 
 #ifdef TESTS_ENABLED
@@ -1019,12 +1021,16 @@ void GDScript::_bind_methods() {
 }
 
 Vector<uint8_t> GDScript::get_as_byte_code() const {
-	return Vector<uint8_t>();
+	return GDScriptBytecodeCache::serialize(this);
 };
 
-// TODO: Fully remove this. There's not this kind of "bytecode" anymore.
 Error GDScript::load_byte_code(const String &p_path) {
-	return ERR_COMPILATION_FAILED;
+	Error err;
+	Vector<uint8_t> bytecode = FileAccess::get_file_as_array(p_path, &err);
+	if (err) {
+		return err;
+	}
+	return GDScriptBytecodeCache::load(this, bytecode);
 }
 
 Error GDScript::load_source_code(const String &p_path) {
@@ -1710,6 +1716,8 @@ void GDScriptLanguage::init() {
 		_add_global(E.name, E.ptr);
 	}
 
+	GDScriptSamplingProfiler::handle_cmdline();
+
 #ifdef TESTS_ENABLED
 	GDScriptTests::GDScriptTestRunner::handle_cmdline();
 #endif
@@ -1729,6 +1737,7 @@ Error GDScriptLanguage::execute_file(const String &p_path) {
 }
 
 void GDScriptLanguage::finish() {
+	GDScriptSamplingProfiler::finish();
 }
 
 void GDScriptLanguage::profiling_start() {
@@ -2221,6 +2230,10 @@ GDScriptLanguage::GDScriptLanguage() {
 		_call_stack = nullptr;
 	}
 
+	// Calls after which a function switches to specialized instructions, 0 disables it.
+	_specialize_call_threshold = GLOBAL_DEF("gdscript/optimization/specialize_call_threshold", 64);
+	ProjectSettings::get_singleton()->set_custom_property_info("gdscript/optimization/specialize_call_threshold", PropertyInfo(Variant::INT, "gdscript/optimization/specialize_call_threshold", PROPERTY_HINT_RANGE, "0,1024,1,or_greater"));
+
 #ifdef DEBUG_ENABLED
 	GLOBAL_DEF("debug/gdscript/warnings/enable", true);
 	GLOBAL_DEF("debug/gdscript/warnings/treat_warnings_as_errors", false);
@@ -72,6 +72,7 @@ class GDScript : public Script {
 	friend class GDScriptFunction;
 	friend class GDScriptAnalyzer;
 	friend class GDScriptCompiler;
+	friend class GDScriptBytecodeCache;
 	friend class GDScriptLanguage;
 	friend struct GDScriptUtilityFunctionsDefinitions;
 
@@ -330,6 +331,7 @@ class GDScriptLanguage : public ScriptLanguage {
 	String _debug_error;
 	int _debug_call_stack_pos;
 	int _debug_max_call_stack;
+	uint32_t _specialize_call_threshold;
 	CallLevel *_call_stack = nullptr;
 
 	void _add_global(const StringName &p_name, const Variant &p_value);
@@ -427,6 +429,7 @@ public:
 	_FORCE_INLINE_ int get_global_array_size() const { return global_array.size(); }
 	_FORCE_INLINE_ Variant *get_global_array() { return _global_array; }
 	_FORCE_INLINE_ const Map<StringName, int> &get_global_map() const { return globals; }
+	_FORCE_INLINE_ uint32_t get_specialize_call_threshold() const { return _specialize_call_threshold; }
 	_FORCE_INLINE_ const Map<StringName, Variant> &get_named_globals_map() const { return named_globals; }
 
 	_FORCE_INLINE_ static GDScriptLanguage *get_singleton() { return singleton; }
@@ -188,7 +188,7 @@ GDScriptFunction *GDScriptByteCodeGenerator::write_end() {
 			opcodes.write[temporaries[i].bytecode_indices[j]] = stack_index | (GDScriptFunction::ADDR_TYPE_STACK << GDScriptFunction::ADDR_BITS);
 		}
 		if (temporaries[i].type != Variant::NIL) {
-			function->temporary_slots[stack_index] = temporaries[i].type;
+			function->temporary_slots.push_back(Pair<int, Variant::Type>(stack_index, temporaries[i].type));
 		}
 	}
 
@@ -565,6 +565,7 @@ void GDScriptByteCodeGenerator::write_binary_operator(const Address &p_target, V
 		// Gather specific operator.
 		Variant::ValidatedOperatorEvaluator op_func = Variant::get_validated_operator_evaluator(p_operator, p_left_operand.type.builtin_type, p_right_operand.type.builtin_type);
 
+		function->operator_positions.push_back(opcodes.size());
 		append(GDScriptFunction::OPCODE_OPERATOR_VALIDATED, 3);
 		append(p_left_operand);
 		append(p_right_operand);
@@ -870,6 +871,7 @@ void GDScriptByteCodeGenerator::write_assign_default_parameter(const Address &p_
 void GDScriptByteCodeGenerator::write_store_global(const Address &p_dst, int p_global_index) {
 	append(GDScriptFunction::OPCODE_STORE_GLOBAL, 1);
 	append(p_dst);
+	function->global_index_positions.push_back(opcodes.size());
 	append(p_global_index);
 }
 
@@ -0,0 +1,1293 @@
+/*************************************************************************/
+/*  gdscript_bytecode_cache.cpp                                          */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "gdscript_bytecode_cache.h"
+
+#include "core/io/file_access.h"
+#include "core/io/marshalls.h"
+#include "core/version.h"
+#include "gdscript_cache.h"
+
+static const char *GDSCRIPT_BYTECODE_CACHE_MAGIC = "GDBC";
+
+static String _get_engine_version() {
+	// Bytecode depends on opcode numbering and on the native API it was resolved against,
+	// so only the exact same build (down to the commit) can reuse it.
+	return String(VERSION_FULL_BUILD) + "." + String(VERSION_HASH);
+}
+
+template <class T, class K>
+static const K *_find_key(const Map<T, K> &p_map, const T &p_value) {
+	const typename Map<T, K>::Element *E = p_map.find(p_value);
+	return E ? &E->get() : nullptr;
+}
+
+String GDScriptBytecodeCache::get_cache_path(const String &p_script_path) {
+	return p_script_path.get_basename() + ".gdc";
+}
+
+void GDScriptBytecodeCache::_fail(const String &p_error) {
+	if (!failed) {
+		failed = true;
+		error = p_error;
+	}
+}
+
+void GDScriptBytecodeCache::_build_reverse_maps() {
+	GDScriptLanguage *language = GDScriptLanguage::get_singleton();
+	for (const KeyValue<StringName, int> &E : language->get_global_map()) {
+		global_indices[E.value] = E.key;
+		const Variant &global = language->get_global_array()[E.value];
+		if (global.get_type() == Variant::OBJECT && global.get_validated_object()) {
+			global_objects[global.get_validated_object()] = E.key;
+		}
+	}
+
+	for (int i = 0; i < Variant::VARIANT_MAX; i++) {
+		Variant::Type type = Variant::Type(i);
+
+		for (int op = 0; op < Variant::OP_MAX; op++) {
+			for (int j = 0; j < Variant::VARIANT_MAX; j++) {
+				Variant::ValidatedOperatorEvaluator evaluator = Variant::get_validated_operator_evaluator(Variant::Operator(op), type, Variant::Type(j));
+				if (evaluator && !operator_keys.has(evaluator)) {
+					OperatorKey key;
+					key.op = Variant::Operator(op);
+					key.type_a = type;
+					key.type_b = Variant::Type(j);
+					operator_keys[evaluator] = key;
+				}
+			}
+		}
+
+		List<StringName> members;
+		Variant::get_member_list(type, &members);
+		for (const StringName &E : members) {
+			MemberKey key;
+			key.type = type;
+			key.name = E;
+			Variant::ValidatedSetter setter = Variant::get_member_validated_setter(type, E);
+			if (setter && !setter_keys.has(setter)) {
+				setter_keys[setter] = key;
+			}
+			Variant::ValidatedGetter getter = Variant::get_member_validated_getter(type, E);
+			if (getter && !getter_keys.has(getter)) {
+				getter_keys[getter] = key;
+			}
+		}
+
+		Variant::ValidatedKeyedSetter keyed_setter = Variant::get_member_validated_keyed_setter(type);
+		if (keyed_setter && !keyed_setter_keys.has(keyed_setter)) {
+			keyed_setter_keys[keyed_setter] = type;
+		}
+		Variant::ValidatedKeyedGetter keyed_getter = Variant::get_member_validated_keyed_getter(type);
+		if (keyed_getter && !keyed_getter_keys.has(keyed_getter)) {
+			keyed_getter_keys[keyed_getter] = type;
+		}
+		Variant::ValidatedIndexedSetter indexed_setter = Variant::get_member_validated_indexed_setter(type);
+		if (indexed_setter && !indexed_setter_keys.has(indexed_setter)) {
+			indexed_setter_keys[indexed_setter] = type;
+		}
+		Variant::ValidatedIndexedGetter indexed_getter = Variant::get_member_validated_indexed_getter(type);
+		if (indexed_getter && !indexed_getter_keys.has(indexed_getter)) {
+			indexed_getter_keys[indexed_getter] = type;
+		}
+
+		List<StringName> methods;
+		Variant::get_builtin_method_list(type, &methods);
+		for (const StringName &E : methods) {
+			Variant::ValidatedBuiltInMethod method = Variant::get_validated_builtin_method(type, E);
+			if (method && !builtin_method_keys.has(method)) {
+				MemberKey key;
+				key.type = type;
+				key.name = E;
+				builtin_method_keys[method] = key;
+			}
+		}
+
+		for (int j = 0; j < Variant::get_constructor_count(type); j++) {
+			Variant::ValidatedConstructor constructor = Variant::get_validated_constructor(type, j);
+			if (constructor && !constructor_keys.has(constructor)) {
+				ConstructorKey key;
+				key.type = type;
+				key.index = j;
+				constructor_keys[constructor] = key;
+			}
+		}
+	}
+
+	List<StringName> utilities;
+	Variant::get_utility_function_list(&utilities);
+	for (const StringName &E : utilities) {
+		Variant::ValidatedUtilityFunction utility = Variant::get_validated_utility_function(E);
+		if (utility && !utility_keys.has(utility)) {
+			utility_keys[utility] = E;
+		}
+	}
+
+	List<StringName> gds_utilities;
+	GDScriptUtilityFunctions::get_function_list(&gds_utilities);
+	for (const StringName &E : gds_utilities) {
+		GDScriptUtilityFunctions::FunctionPtr utility = GDScriptUtilityFunctions::get_function(E);
+		if (utility && !gds_utility_keys.has(utility)) {
+			gds_utility_keys[utility] = E;
+		}
+	}
+}
+
+const GDScript *GDScriptBytecodeCache::_get_root(const GDScript *p_script, Vector<StringName> *r_chain) {
+	const GDScript *script = p_script;
+	while (script->_owner) {
+		if (r_chain) {
+			// Inner classes are registered in their owner under their class name.
+			r_chain->insert(0, script->name);
+		}
+		script = script->_owner;
+	}
+	return script;
+}
+
+/* WRITING */
+
+void GDScriptBytecodeCache::_put_u8(uint8_t p_value) {
+	buffer.push_back(p_value);
+}
+
+void GDScriptBytecodeCache::_put_u32(uint32_t p_value) {
+	int ofs = buffer.size();
+	buffer.resize(ofs + 4);
+	encode_uint32(p_value, buffer.ptrw() + ofs);
+}
+
+void GDScriptBytecodeCache::_put_u64(uint64_t p_value) {
+	int ofs = buffer.size();
+	buffer.resize(ofs + 8);
+	encode_uint64(p_value, buffer.ptrw() + ofs);
+}
+
+void GDScriptBytecodeCache::_put_string(const String &p_string) {
+	CharString utf8 = p_string.utf8();
+	_put_u32(utf8.length());
+	int ofs = buffer.size();
+	buffer.resize(ofs + utf8.length());
+	memcpy(buffer.ptrw() + ofs, utf8.get_data(), utf8.length());
+}
+
+void GDScriptBytecodeCache::_put_variant(const Variant &p_value) {
+	switch (p_value.get_type()) {
+		case Variant::OBJECT: {
+			const Object *obj = p_value.get_validated_object();
+			if (!obj) {
+				_put_u8(VARIANT_NULL_OBJECT);
+				return;
+			}
+
+			// Singletons and native classes are looked up again by name.
+			const StringName *global = _find_key(global_objects, obj);
+			if (global) {
+				_put_u8(VARIANT_GLOBAL);
+				_put_string(*global);
+				return;
+			}
+
+			const Script *script = Object::cast_to<Script>(obj);
+			if (script) {
+				_put_u8(VARIANT_SCRIPT);
+				_put_script_ref(script);
+				return;
+			}
+
+			const Resource *resource = Object::cast_to<Resource>(obj);
+			if (resource && resource->get_path().is_resource_file()) {
+				_put_u8(VARIANT_RESOURCE);
+				_put_string(resource->get_path());
+				return;
+			}
+
+			_fail("Constant of type '" + obj->get_class() + "' can't be stored.");
+		} break;
+		case Variant::ARRAY: {
+			Array array = p_value;
+			_put_u8(VARIANT_ARRAY);
+			_put_u32(array.get_typed_builtin());
+			_put_string(array.get_typed_class_name());
+			_put_variant(array.get_typed_script());
+			_put_u32(array.size());
+			for (int i = 0; i < array.size(); i++) {
+				_put_variant(array[i]);
+			}
+		} break;
+		case Variant::DICTIONARY: {
+			Dictionary dict = p_value;
+			List<Variant> keys;
+			dict.get_key_list(&keys);
+			_put_u8(VARIANT_DICTIONARY);
+			_put_u32(keys.size());
+			for (const Variant &E : keys) {
+				_put_variant(E);
+				_put_variant(dict[E]);
+			}
+		} break;
+		case Variant::RID:
+		case Variant::CALLABLE:
+		case Variant::SIGNAL: {
+			_fail("Constant of type '" + Variant::get_type_name(p_value.get_type()) + "' can't be stored.");
+		} break;
+		default: {
+			int len = 0;
+			Error err = encode_variant(p_value, nullptr, len);
+			if (err) {
+				_fail("Failed to encode constant.");
+				return;
+			}
+			_put_u8(VARIANT_VALUE);
+			int ofs = buffer.size();
+			buffer.resize(ofs + len);
+			encode_variant(p_value, buffer.ptrw() + ofs, len);
+		} break;
+	}
+}
+
+void GDScriptBytecodeCache::_add_dependency(const GDScript *p_script) {
+	dependencies[p_script->get_path()] = p_script->get_source_code().hash64();
+}
+
+void GDScriptBytecodeCache::_put_script_ref(const Script *p_script) {
+	if (!p_script) {
+		_put_u8(SCRIPT_REF_NONE);
+		return;
+	}
+
+	const GDScript *gdscript = Object::cast_to<GDScript>(p_script);
+	if (!gdscript) {
+		if (!p_script->get_path().is_resource_file()) {
+			_fail("Built-in scripts can't be referenced.");
+			return;
+		}
+		_put_u8(SCRIPT_REF_RESOURCE);
+		_put_string(p_script->get_path());
+		return;
+	}
+
+	Vector<StringName> chain;
+	const GDScript *root = _get_root(gdscript, &chain);
+	if (root == main_script) {
+		_put_u8(SCRIPT_REF_LOCAL);
+	} else {
+		if (!root->get_path().is_resource_file()) {
+			_fail("Built-in scripts can't be referenced.");
+			return;
+		}
+		_put_u8(SCRIPT_REF_GDSCRIPT);
+		_put_string(root->get_path());
+		_add_dependency(root);
+	}
+	_put_u32(chain.size());
+	for (int i = 0; i < chain.size(); i++) {
+		_put_string(chain[i]);
+	}
+}
+
+void GDScriptBytecodeCache::_put_data_type(const GDScriptDataType &p_type) {
+	_put_u8(p_type.has_type);
+	_put_u8(p_type.kind);
+	_put_u32(p_type.builtin_type);
+	_put_string(p_type.native_type);
+	_put_script_ref(p_type.script_type);
+	_put_u8(p_type.script_type_ref.is_valid());
+	_put_u8(p_type.has_container_element_type());
+	if (p_type.has_container_element_type()) {
+		_put_data_type(p_type.get_container_element_type());
+	}
+}
+
+void GDScriptBytecodeCache::_put_function(const GDScriptFunction *p_function) {
+	_put_string(p_function->name);
+	_put_string(p_function->source);
+	_put_u8(p_function->_static);
+	_put_string(p_function->rpc_config.name);
+	_put_u32(p_function->rpc_config.rpc_mode);
+	_put_u8(p_function->rpc_config.call_local);
+	_put_u32(p_function->rpc_config.transfer_mode);
+	_put_u32(p_function->rpc_config.channel);
+
+	_put_u32(p_function->_argument_count);
+	_put_u32(p_function->_stack_size);
+	_put_u32(p_function->_instruction_args_size);
+	_put_u32(p_function->_ptrcall_args_size);
+	_put_u32(p_function->_initial_line);
+
+	_put_data_type(p_function->return_type);
+	_put_u32(p_function->argument_types.size());
+	for (int i = 0; i < p_function->argument_types.size(); i++) {
+		_put_data_type(p_function->argument_types[i]);
+	}
+#ifdef TOOLS_ENABLED
+	_put_u32(p_function->arg_names.size());
+	for (int i = 0; i < p_function->arg_names.size(); i++) {
+		_put_string(p_function->arg_names[i]);
+	}
+#else
+	_put_u32(0);
+#endif
+	_put_u32(p_function->default_arguments.size());
+	for (int i = 0; i < p_function->default_arguments.size(); i++) {
+		_put_u32(p_function->default_arguments[i]);
+	}
+	_put_u32(p_function->temporary_slots.size());
+	for (int i = 0; i < p_function->temporary_slots.size(); i++) {
+		_put_u32(p_function->temporary_slots[i].first);
+		_put_u32(p_function->temporary_slots[i].second);
+	}
+
+	_put_u32(p_function->code.size());
+	for (int i = 0; i < p_function->code.size(); i++) {
+		_put_u32(p_function->code[i]);
+	}
+	// Global indices depend on registration order, store the names instead.
+	_put_u32(p_function->global_index_positions.size());
+	for (int i = 0; i < p_function->global_index_positions.size(); i++) {
+		int pos = p_function->global_index_positions[i];
+		const StringName *global = _find_key(global_indices, p_function->code[pos]);
+		if (!global) {
+			_fail("Unknown global index.");
+			return;
+		}
+		_put_u32(pos);
+		_put_string(*global);
+	}
+	_put_u32(p_function->operator_positions.size());
+	for (int i = 0; i < p_function->operator_positions.size(); i++) {
+		_put_u32(p_function->operator_positions[i]);
+	}
+
+	_put_u32(p_function->constants.size());
+	for (int i = 0; i < p_function->constants.size(); i++) {
+		_put_variant(p_function->constants[i]);
+	}
+	_put_u32(p_function->global_names.size());
+	for (int i = 0; i < p_function->global_names.size(); i++) {
+		_put_string(p_function->global_names[i]);
+	}
+
+	_put_u32(p_function->operator_funcs.size());
+	for (int i = 0; i < p_function->operator_funcs.size(); i++) {
+		const OperatorKey *key = _find_key(operator_keys, p_function->operator_funcs[i]);
+		if (!key) {
+			_fail("Unknown operator evaluator.");
+			return;
+		}
+		_put_u32(key->op);
+		_put_u32(key->type_a);
+		_put_u32(key->type_b);
+	}
+	_put_u32(p_function->setters.size());
+	for (int i = 0; i < p_function->setters.size(); i++) {
+		const MemberKey *key = _find_key(setter_keys, p_function->setters[i]);
+		if (!key) {
+			_fail("Unknown member setter.");
+			return;
+		}
+		_put_u32(key->type);
+		_put_string(key->name);
+	}
+	_put_u32(p_function->getters.size());
+	for (int i = 0; i < p_function->getters.size(); i++) {
+		const MemberKey *key = _find_key(getter_keys, p_function->getters[i]);
+		if (!key) {
+			_fail("Unknown member getter.");
+			return;
+		}
+		_put_u32(key->type);
+		_put_string(key->name);
+	}
+	_put_u32(p_function->keyed_setters.size());
+	for (int i = 0; i < p_function->keyed_setters.size(); i++) {
+		const Variant::Type *type = _find_key(keyed_setter_keys, p_function->keyed_setters[i]);
+		if (!type) {
+			_fail("Unknown keyed setter.");
+			return;
+		}
+		_put_u32(*type);
+	}
+	_put_u32(p_function->keyed_getters.size());
+	for (int i = 0; i < p_function->keyed_getters.size(); i++) {
+		const Variant::Type *type = _find_key(keyed_getter_keys, p_function->keyed_getters[i]);
+		if (!type) {
+			_fail("Unknown keyed getter.");
+			return;
+		}
+		_put_u32(*type);
+	}
+	_put_u32(p_function->indexed_setters.size());
+	for (int i = 0; i < p_function->indexed_setters.size(); i++) {
+		const Variant::Type *type = _find_key(indexed_setter_keys, p_function->indexed_setters[i]);
+		if (!type) {
+			_fail("Unknown indexed setter.");
+			return;
+		}
+		_put_u32(*type);
+	}
+	_put_u32(p_function->indexed_getters.size());
+	for (int i = 0; i < p_function->indexed_getters.size(); i++) {
+		const Variant::Type *type = _find_key(indexed_getter_keys, p_function->indexed_getters[i]);
+		if (!type) {
+			_fail("Unknown indexed getter.");
+			return;
+		}
+		_put_u32(*type);
+	}
+	_put_u32(p_function->builtin_methods.size());
+	for (int i = 0; i < p_function->builtin_methods.size(); i++) {
+		const MemberKey *key = _find_key(builtin_method_keys, p_function->builtin_methods[i]);
+		if (!key) {
+			_fail("Unknown built-in method.");
+			return;
+		}
+		_put_u32(key->type);
+		_put_string(key->name);
+	}
+	_put_u32(p_function->constructors.size());
+	for (int i = 0; i < p_function->constructors.size(); i++) {
+		const ConstructorKey *key = _find_key(constructor_keys, p_function->constructors[i]);
+		if (!key) {
+			_fail("Unknown constructor.");
+			return;
+		}
+		_put_u32(key->type);
+		_put_u32(key->index);
+	}
+	_put_u32(p_function->utilities.size());
+	for (int i = 0; i < p_function->utilities.size(); i++) {
+		const StringName *name = _find_key(utility_keys, p_function->utilities[i]);
+		if (!name) {
+			_fail("Unknown utility function.");
+			return;
+		}
+		_put_string(*name);
+	}
+	_put_u32(p_function->gds_utilities.size());
+	for (int i = 0; i < p_function->gds_utilities.size(); i++) {
+		const StringName *name = _find_key(gds_utility_keys, p_function->gds_utilities[i]);
+		if (!name) {
+			_fail("Unknown GDScript utility function.");
+			return;
+		}
+		_put_string(*name);
+	}
+	_put_u32(p_function->methods.size());
+	for (int i = 0; i < p_function->methods.size(); i++) {
+		const MethodBind *method = p_function->methods[i];
+		if (!method) {
+			_fail("Unknown method bind.");
+			return;
+		}
+		_put_string(method->get_instance_class());
+		_put_string(method->get_name());
+	}
+
+	_put_u32(p_function->lambdas.size());
+	for (int i = 0; i < p_function->lambdas.size(); i++) {
+		_put_function(p_function->lambdas[i]);
+	}
+}
+
+void GDScriptBytecodeCache::_put_class_tree(const GDScript *p_class) {
+	_put_u32(p_class->subclasses.size());
+	for (const KeyValue<StringName, Ref<GDScript>> &E : p_class->subclasses) {
+		_put_string(E.key);
+		_put_class_tree(E.value.ptr());
+	}
+}
+
+void GDScriptBytecodeCache::_put_class(const GDScript *p_class) {
+	_put_u8(p_class->tool);
+	_put_string(p_class->name);
+	_put_string(p_class->native.is_valid() ? String(p_class->native->get_name()) : String());
+	_put_script_ref(p_class->base.ptr());
+	// Member indices are inherited, so the whole base chain must stay unchanged.
+	for (const GDScript *base = p_class->_base; base; base = base->_base) {
+		const GDScript *root = _get_root(base);
+		if (root != main_script) {
+			_add_dependency(root);
+		}
+	}
+
+	_put_u32(p_class->members.size());
+	for (const Set<StringName>::Element *E = p_class->members.front(); E; E = E->next()) {
+		_put_string(E->get());
+	}
+	_put_u32(p_class->member_indices.size());
+	for (const KeyValue<StringName, GDScript::MemberInfo> &E : p_class->member_indices) {
+		_put_string(E.key);
+		_put_u32(E.value.index);
+		_put_string(E.value.setter);
+		_put_string(E.value.getter);
+		_put_data_type(E.value.data_type);
+	}
+	_put_u32(p_class->member_info.size());
+	for (const KeyValue<StringName, PropertyInfo> &E : p_class->member_info) {
+		_put_string(E.key);
+		_put_u32(E.value.type);
+		_put_string(E.value.name);
+		_put_string(E.value.class_name);
+		_put_u32(E.value.hint);
+		_put_string(E.value.hint_string);
+		_put_u32(E.value.usage);
+	}
+	_put_u32(p_class->_signals.size());
+	for (const KeyValue<StringName, Vector<StringName>> &E : p_class->_signals) {
+		_put_string(E.key);
+		_put_u32(E.value.size());
+		for (int i = 0; i < E.value.size(); i++) {
+			_put_string(E.value[i]);
+		}
+	}
+	_put_u32(p_class->constants.size());
+	for (const KeyValue<StringName, Variant> &E : p_class->constants) {
+		_put_string(E.key);
+		_put_variant(E.value);
+	}
+	_put_u32(p_class->member_functions.size());
+	for (const KeyValue<StringName, GDScriptFunction *> &E : p_class->member_functions) {
+		_put_string(E.key);
+		_put_function(E.value);
+	}
+
+	for (const KeyValue<StringName, Ref<GDScript>> &E : p_class->subclasses) {
+		_put_class(E.value.ptr());
+	}
+}
+
+Vector<uint8_t> GDScriptBytecodeCache::serialize(const GDScript *p_script) {
+	ERR_FAIL_NULL_V(p_script, Vector<uint8_t>());
+	ERR_FAIL_COND_V_MSG(!p_script->valid, Vector<uint8_t>(), "Only successfully compiled scripts can be cached.");
+	ERR_FAIL_COND_V_MSG(p_script->_owner != nullptr, Vector<uint8_t>(), "Inner classes are cached along with their main script.");
+
+	GDScriptBytecodeCache cache;
+	cache.main_script = p_script;
+	cache._build_reverse_maps();
+
+	// Write the body first, the header lists the dependencies found in it.
+	cache._put_class_tree(p_script);
+	cache._put_class(p_script);
+	if (cache.failed) {
+		print_verbose("GDScript: Can't cache bytecode of '" + p_script->get_path() + "': " + cache.error);
+		return Vector<uint8_t>();
+	}
+	Vector<uint8_t> body = cache.buffer;
+
+	cache.buffer.clear();
+	for (int i = 0; i < 4; i++) {
+		cache._put_u8(GDSCRIPT_BYTECODE_CACHE_MAGIC[i]);
+	}
+	cache._put_u32(FORMAT_VERSION);
+	cache._put_string(_get_engine_version());
+	cache._put_u32(sizeof(real_t));
+	cache._put_u64(p_script->source.hash64());
+	cache._put_u32(cache.dependencies.size());
+	for (const KeyValue<String, uint64_t> &E : cache.dependencies) {
+		cache._put_string(E.key);
+		cache._put_u64(E.value);
+	}
+	cache.buffer.append_array(body);
+
+	return cache.buffer;
+}
+
+/* READING */
+
+uint8_t GDScriptBytecodeCache::_get_u8() {
+	if (read_pos + 1 > read_size) {
+		_fail("Unexpected end of data.");
+		return 0;
+	}
+	return read_ptr[read_pos++];
+}
+
+uint32_t GDScriptBytecodeCache::_get_u32() {
+	if (read_pos + 4 > read_size) {
+		_fail("Unexpected end of data.");
+		return 0;
+	}
+	uint32_t value = decode_uint32(read_ptr + read_pos);
+	read_pos += 4;
+	return value;
+}
+
+uint64_t GDScriptBytecodeCache::_get_u64() {
+	if (read_pos + 8 > read_size) {
+		_fail("Unexpected end of data.");
+		return 0;
+	}
+	uint64_t value = decode_uint64(read_ptr + read_pos);
+	read_pos += 8;
+	return value;
+}
+
+String GDScriptBytecodeCache::_get_string() {
+	uint32_t len = _get_u32();
+	if (len > uint32_t(read_size - read_pos)) {
+		_fail("Unexpected end of data.");
+		return String();
+	}
+	String string = String::utf8((const char *)read_ptr + read_pos, len);
+	read_pos += len;
+	return string;
+}
+
+Variant GDScriptBytecodeCache::_get_variant() {
+	switch (_get_u8()) {
+		case VARIANT_VALUE: {
+			if (failed) {
+				return Variant();
+			}
+			Variant value;
+			int len = 0;
+			Error err = decode_variant(value, read_ptr + read_pos, read_size - read_pos, &len);
+			if (err) {
+				_fail("Failed to decode constant.");
+				return Variant();
+			}
+			read_pos += len;
+			return value;
+		}
+		case VARIANT_NULL_OBJECT: {
+			return Variant((Object *)nullptr);
+		}
+		case VARIANT_GLOBAL: {
+			StringName name = _get_string();
+			GDScriptLanguage *language = GDScriptLanguage::get_singleton();
+			const Map<StringName, int>::Element *E = language->get_global_map().find(name);
+			if (!E) {
+				_fail("Unknown global '" + String(name) + "'.");
+				return Variant();
+			}
+			return language->get_global_array()[E->get()];
+		}
+		case VARIANT_SCRIPT: {
+			return _get_script_ref();
+		}
+		case VARIANT_RESOURCE: {
+			String path = _get_string();
+			RES resource = ResourceLoader::load(path);
+			if (resource.is_null()) {
+				_fail("Can't load resource '" + path + "'.");
+			}
+			return resource;
+		}
+		case VARIANT_ARRAY: {
+			Array array;
+			uint32_t typed_builtin = _get_u32();
+			StringName typed_class_name = _get_string();
+			Variant typed_script = _get_variant();
+			if (typed_builtin >= Variant::VARIANT_MAX) {
+				_fail("Invalid array type.");
+				return Variant();
+			}
+			if (typed_builtin != Variant::NIL) {
+				array.set_typed(typed_builtin, typed_class_name, typed_script);
+			}
+			uint32_t size = _get_u32();
+			for (uint32_t i = 0; i < size && !failed; i++) {
+				array.push_back(_get_variant());
+			}
+			return array;
+		}
+		case VARIANT_DICTIONARY: {
+			Dictionary dict;
+			uint32_t size = _get_u32();
+			for (uint32_t i = 0; i < size && !failed; i++) {
+				Variant key = _get_variant();
+				dict[key] = _get_variant();
+			}
+			return dict;
+		}
+		default: {
+			_fail("Invalid constant.");
+		} break;
+	}
+	return Variant();
+}
+
+Ref<Script> GDScriptBytecodeCache::_get_script_ref(bool p_full) {
+	uint8_t ref = _get_u8();
+	switch (ref) {
+		case SCRIPT_REF_NONE: {
+			return Ref<Script>();
+		}
+		case SCRIPT_REF_RESOURCE: {
+			String path = _get_string();
+			Ref<Script> script = ResourceLoader::load(path);
+			if (script.is_null()) {
+				_fail("Can't load script '" + path + "'.");
+			}
+			return script;
+		}
+		case SCRIPT_REF_LOCAL:
+		case SCRIPT_REF_GDSCRIPT: {
+			String path;
+			if (ref == SCRIPT_REF_GDSCRIPT) {
+				path = _get_string();
+			}
+			Vector<StringName> chain;
+			uint32_t chain_size = _get_u32();
+			for (uint32_t i = 0; i < chain_size && !failed; i++) {
+				chain.push_back(_get_string());
+			}
+			if (failed) {
+				return Ref<Script>();
+			}
+
+			Ref<GDScript> script;
+			if (ref == SCRIPT_REF_LOCAL) {
+				script = Ref<GDScript>(loading_script);
+			} else if (p_full || !chain.is_empty()) {
+				// Inner classes only exist once their script is compiled.
+				Error err = OK;
+				script = GDScriptCache::get_full_script(path, err, loading_script->get_path());
+				if (err) {
+					_fail("Can't load script '" + path + "'.");
+					return Ref<Script>();
+				}
+			} else {
+				// Same as the compiler, other scripts are compiled once this one is done.
+				script = GDScriptCache::get_shallow_script(path, loading_script->get_path());
+			}
+
+			for (int i = 0; i < chain.size() && script.is_valid(); i++) {
+				const Map<StringName, Ref<GDScript>>::Element *E = script->subclasses.find(chain[i]);
+				script = E ? E->get() : Ref<GDScript>();
+			}
+			if (script.is_null()) {
+				_fail("Can't find class in script '" + path + "'.");
+			}
+			return script;
+		}
+		default: {
+			_fail("Invalid script reference.");
+		} break;
+	}
+	return Ref<Script>();
+}
+
+GDScriptDataType GDScriptBytecodeCache::_get_data_type() {
+	GDScriptDataType type;
+	type.has_type = _get_u8();
+	uint8_t kind = _get_u8();
+	uint32_t builtin_type = _get_u32();
+	if (kind > GDScriptDataType::GDSCRIPT || builtin_type >= Variant::VARIANT_MAX) {
+		_fail("Invalid data type.");
+		return GDScriptDataType();
+	}
+	type.kind = GDScriptDataType::Kind(kind);
+	type.builtin_type = Variant::Type(builtin_type);
+	type.native_type = _get_string();
+	Ref<Script> script = _get_script_ref();
+	type.script_type = script.ptr();
+	if (_get_u8()) {
+		type.script_type_ref = script;
+	}
+	if (_get_u8()) {
+		type.set_container_element_type(_get_data_type());
+	}
+	return type;
+}
+
+GDScriptFunction *GDScriptBytecodeCache::_get_function(GDScript *p_script) {
+	GDScriptFunction *function = memnew(GDScriptFunction);
+	function->_script = p_script;
+	function->name = _get_string();
+	function->source = _get_string();
+	function->_static = _get_u8();
+	function->rpc_config.name = _get_string();
+	function->rpc_config.rpc_mode = Multiplayer::RPCMode(_get_u32());
+	function->rpc_config.call_local = _get_u8();
+	function->rpc_config.transfer_mode = Multiplayer::TransferMode(_get_u32());
+	function->rpc_config.channel = _get_u32();
+
+	function->_argument_count = _get_u32();
+	function->_stack_size = _get_u32();
+	function->_instruction_args_size = _get_u32();
+	function->_ptrcall_args_size = _get_u32();
+	function->_initial_line = _get_u32();
+
+	function->return_type = _get_data_type();
+	uint32_t count = _get_u32();
+	for (uint32_t i = 0; i < count && !failed; i++) {
+		function->argument_types.push_back(_get_data_type());
+	}
+	count = _get_u32();
+	for (uint32_t i = 0; i < count && !failed; i++) {
+		StringName arg_name = _get_string();
+#ifdef TOOLS_ENABLED
+		function->arg_names.push_back(arg_name);
+#endif
+	}
+	count = _get_u32();
+	for (uint32_t i = 0; i < count && !failed; i++) {
+		function->default_arguments.push_back(_get_u32());
+	}
+	count = _get_u32();
+	for (uint32_t i = 0; i < count && !failed; i++) {
+		uint32_t slot = _get_u32();
+		uint32_t type = _get_u32();
+		if (slot >= uint32_t(function->_stack_size) || type >= Variant::VARIANT_MAX) {
+			_fail("Invalid temporary slot.");
+			break;
+		}
+		function->temporary_slots.push_back(Pair<int, Variant::Type>(slot, Variant::Type(type)));
+	}
+
+	count = _get_u32();
+	if (count > uint32_t(read_size - read_pos) / 4) {
+		_fail("Unexpected end of data.");
+	} else {
+		function->code.resize(count);
+		int *code = function->code.ptrw();
+		for (uint32_t i = 0; i < count; i++) {
+			code[i] = _get_u32();
+		}
+	}
+	count = _get_u32();
+	for (uint32_t i = 0; i < count && !failed; i++) {
+		uint32_t pos = _get_u32();
+		StringName global = _get_string();
+		const Map<StringName, int>::Element *E = GDScriptLanguage::get_singleton()->get_global_map().find(global);
+		if (!E || pos >= uint32_t(function->code.size())) {
+			_fail("Unknown global '" + String(global) + "'.");
+			break;
+		}
+		function->code.write[pos] = E->get();
+	}
+	count = _get_u32();
+	for (uint32_t i = 0; i < count && !failed; i++) {
+		uint32_t pos = _get_u32();
+		if (pos >= uint32_t(function->code.size())) {
+			_fail("Invalid operator position.");
+			break;
+		}
+		function->operator_positions.push_back(pos);
+	}
+
+	count = _get_u32();
+	for (uint32_t i = 0; i < count && !failed; i++) {
+		function->constants.push_back(_get_variant());
+	}
+	count = _get_u32();
+	for (uint32_t i = 0; i < count && !failed; i++) {
+		function->global_names.push_back(_get_string());
+	}
+
+	count = _get_u32();
+	for (uint32_t i = 0; i < count && !failed; i++) {
+		uint32_t op = _get_u32();
+		uint32_t type_a = _get_u32();
+		uint32_t type_b = _get_u32();
+		Variant::ValidatedOperatorEvaluator evaluator = nullptr;
+		if (op < Variant::OP_MAX && type_a < Variant::VARIANT_MAX && type_b < Variant::VARIANT_MAX) {
+			evaluator = Variant::get_validated_operator_evaluator(Variant::Operator(op), Variant::Type(type_a), Variant::Type(type_b));
+		}
+		if (!evaluator) {
+			_fail("Unknown operator evaluator.");
+			break;
+		}
+		function->operator_funcs.push_back(evaluator);
+	}
+	count = _get_u32();
+	for (uint32_t i = 0; i < count && !failed; i++) {
+		uint32_t type = _get_u32();
+		StringName member = _get_string();
+		Variant::ValidatedSetter setter = type < Variant::VARIANT_MAX ? Variant::get_member_validated_setter(Variant::Type(type), member) : nullptr;
+		if (!setter) {
+			_fail("Unknown member setter '" + String(member) + "'.");
+			break;
+		}
+		function->setters.push_back(setter);
+	}
+	count = _get_u32();
+	for (uint32_t i = 0; i < count && !failed; i++) {
+		uint32_t type = _get_u32();
+		StringName member = _get_string();
+		Variant::ValidatedGetter getter = type < Variant::VARIANT_MAX ? Variant::get_member_validated_getter(Variant::Type(type), member) : nullptr;
+		if (!getter) {
+			_fail("Unknown member getter '" + String(member) + "'.");
+			break;
+		}
+		function->getters.push_back(getter);
+	}
+	count = _get_u32();
+	for (uint32_t i = 0; i < count && !failed; i++) {
+		uint32_t type = _get_u32();
+		Variant::ValidatedKeyedSetter setter = type < Variant::VARIANT_MAX ? Variant::get_member_validated_keyed_setter(Variant::Type(type)) : nullptr;
+		if (!setter) {
+			_fail("Unknown keyed setter.");
+			break;
+		}
+		function->keyed_setters.push_back(setter);
+	}
+	count = _get_u32();
+	for (uint32_t i = 0; i < count && !failed; i++) {
+		uint32_t type = _get_u32();
+		Variant::ValidatedKeyedGetter getter = type < Variant::VARIANT_MAX ? Variant::get_member_validated_keyed_getter(Variant::Type(type)) : nullptr;
+		if (!getter) {
+			_fail("Unknown keyed getter.");
+			break;
+		}
+		function->keyed_getters.push_back(getter);
+	}
+	count = _get_u32();
+	for (uint32_t i = 0; i < count && !failed; i++) {
+		uint32_t type = _get_u32();
+		Variant::ValidatedIndexedSetter setter = type < Variant::VARIANT_MAX ? Variant::get_member_validated_indexed_setter(Variant::Type(type)) : nullptr;
+		if (!setter) {
+			_fail("Unknown indexed setter.");
+			break;
+		}
+		function->indexed_setters.push_back(setter);
+	}
+	count = _get_u32();
+	for (uint32_t i = 0; i < count && !failed; i++) {
+		uint32_t type = _get_u32();
+		Variant::ValidatedIndexedGetter getter = type < Variant::VARIANT_MAX ? Variant::get_member_validated_indexed_getter(Variant::Type(type)) : nullptr;
+		if (!getter) {
+			_fail("Unknown indexed getter.");
+			break;
+		}
+		function->indexed_getters.push_back(getter);
+	}
+	count = _get_u32();
+	for (uint32_t i = 0; i < count && !failed; i++) {
+		uint32_t type = _get_u32();
+		StringName method_name = _get_string();
+		Variant::ValidatedBuiltInMethod method = nullptr;
+		if (type < Variant::VARIANT_MAX && Variant::has_builtin_method(Variant::Type(type), method_name)) {
+			method = Variant::get_validated_builtin_method(Variant::Type(type), method_name);
+		}
+		if (!method) {
+			_fail("Unknown built-in method '" + String(method_name) + "'.");
+			break;
+		}
+		function->builtin_methods.push_back(method);
+	}
+	count = _get_u32();
+	for (uint32_t i = 0; i < count && !failed; i++) {
+		uint32_t type = _get_u32();
+		uint32_t index = _get_u32();
+		Variant::ValidatedConstructor constructor = nullptr;
+		if (type < Variant::VARIANT_MAX && index < uint32_t(Variant::get_constructor_count(Variant::Type(type)))) {
+			constructor = Variant::get_validated_constructor(Variant::Type(type), index);
+		}
+		if (!constructor) {
+			_fail("Unknown constructor.");
+			break;
+		}
+		function->constructors.push_back(constructor);
+	}
+	count = _get_u32();
+	for (uint32_t i = 0; i < count && !failed; i++) {
+		StringName utility_name = _get_string();
+		Variant::ValidatedUtilityFunction utility = Variant::get_validated_utility_function(utility_name);
+		if (!utility) {
+			_fail("Unknown utility function '" + String(utility_name) + "'.");
+			break;
+		}
+		function->utilities.push_back(utility);
+	}
+	count = _get_u32();
+	for (uint32_t i = 0; i < count && !failed; i++) {
+		StringName utility_name = _get_string();
+		GDScriptUtilityFunctions::FunctionPtr utility = nullptr;
+		if (GDScriptUtilityFunctions::function_exists(utility_name)) {
+			utility = GDScriptUtilityFunctions::get_function(utility_name);
+		}
+		if (!utility) {
+			_fail("Unknown GDScript utility function '" + String(utility_name) + "'.");
+			break;
+		}
+		function->gds_utilities.push_back(utility);
+	}
+	count = _get_u32();
+	for (uint32_t i = 0; i < count && !failed; i++) {
+		StringName class_name = _get_string();
+		StringName method_name = _get_string();
+		MethodBind *method = ClassDB::get_method(class_name, method_name);
+		if (!method) {
+			_fail("Unknown method '" + String(class_name) + "." + String(method_name) + "'.");
+			break;
+		}
+		function->methods.push_back(method);
+	}
+
+	count = _get_u32();
+	for (uint32_t i = 0; i < count && !failed; i++) {
+		GDScriptFunction *lambda = _get_function(p_script);
+		if (lambda) {
+			function->lambdas.push_back(lambda);
+		}
+	}
+
+	if (failed) {
+		memdelete(function);
+		return nullptr;
+	}
+
+	// Same as GDScriptByteCodeGenerator::write_end().
+	function->_code_ptr = function->code.is_empty() ? nullptr : function->code.ptr();
+	function->_code_size = function->code.size();
+	function->_constants_ptr = function->constants.is_empty() ? nullptr : function->constants.ptrw();
+	function->_constant_count = function->constants.size();
+	function->_global_names_ptr = function->global_names.is_empty() ? nullptr : function->global_names.ptr();
+	function->_global_names_count = function->global_names.size();
+	function->_default_arg_ptr = function->default_arguments.is_empty() ? nullptr : function->default_arguments.ptr();
+	function->_default_arg_count = function->default_arguments.is_empty() ? 0 : function->default_arguments.size() - 1;
+	function->_operator_funcs_ptr = function->operator_funcs.is_empty() ? nullptr : function->operator_funcs.ptr();
+	function->_operator_funcs_count = function->operator_funcs.size();
+	function->_setters_ptr = function->setters.is_empty() ? nullptr : function->setters.ptr();
+	function->_setters_count = function->setters.size();
+	function->_getters_ptr = function->getters.is_empty() ? nullptr : function->getters.ptr();
+	function->_getters_count = function->getters.size();
+	function->_keyed_setters_ptr = function->keyed_setters.is_empty() ? nullptr : function->keyed_setters.ptr();
+	function->_keyed_setters_count = function->keyed_setters.size();
+	function->_keyed_getters_ptr = function->keyed_getters.is_empty() ? nullptr : function->keyed_getters.ptr();
+	function->_keyed_getters_count = function->keyed_getters.size();
+	function->_indexed_setters_ptr = function->indexed_setters.is_empty() ? nullptr : function->indexed_setters.ptr();
+	function->_indexed_setters_count = function->indexed_setters.size();
+	function->_indexed_getters_ptr = function->indexed_getters.is_empty() ? nullptr : function->indexed_getters.ptr();
+	function->_indexed_getters_count = function->indexed_getters.size();
+	function->_builtin_methods_ptr = function->builtin_methods.is_empty() ? nullptr : function->builtin_methods.ptr();
+	function->_builtin_methods_count = function->builtin_methods.size();
+	function->_constructors_ptr = function->constructors.is_empty() ? nullptr : function->constructors.ptr();
+	function->_constructors_count = function->constructors.size();
+	function->_utilities_ptr = function->utilities.is_empty() ? nullptr : function->utilities.ptr();
+	function->_utilities_count = function->utilities.size();
+	function->_gds_utilities_ptr = function->gds_utilities.is_empty() ? nullptr : function->gds_utilities.ptr();
+	function->_gds_utilities_count = function->gds_utilities.size();
+	function->_methods_ptr = function->methods.is_empty() ? nullptr : function->methods.ptrw();
+	function->_methods_count = function->methods.size();
+	function->_lambdas_ptr = function->lambdas.is_empty() ? nullptr : function->lambdas.ptrw();
+	function->_lambdas_count = function->lambdas.size();
+
+#ifdef DEBUG_ENABLED
+	function->func_cname = (String(function->source) + " - " + String(function->name)).utf8();
+	function->_func_cname = function->func_cname.get_data();
+#endif
+
+	return function;
+}
+
+void GDScriptBytecodeCache::_get_class_tree(GDScript *p_class) {
+	p_class->subclasses.clear();
+
+	uint32_t count = _get_u32();
+	for (uint32_t i = 0; i < count && !failed; i++) {
+		StringName name = _get_string();
+		String fully_qualified_name = p_class->fully_qualified_name + "::" + name;
+
+		Ref<GDScript> subclass = GDScriptLanguage::get_singleton()->get_orphan_subclass(fully_qualified_name);
+		if (subclass.is_null()) {
+			subclass.instantiate();
+		}
+		subclass->_owner = p_class;
+		subclass->fully_qualified_name = fully_qualified_name;
+		p_class->subclasses.insert(name, subclass);
+
+		_get_class_tree(subclass.ptr());
+	}
+}
+
+void GDScriptBytecodeCache::_get_class(GDScript *p_class) {
+	p_class->native = Ref<GDScriptNativeClass>();
+	p_class->base = Ref<GDScript>();
+	p_class->_base = nullptr;
+	p_class->members.clear();
+	p_class->constants.clear();
+	for (const KeyValue<StringName, GDScriptFunction *> &E : p_class->member_functions) {
+		memdelete(E.value);
+	}
+	p_class->member_functions.clear();
+	p_class->member_indices.clear();
+	p_class->member_info.clear();
+	p_class->_signals.clear();
+	p_class->initializer = nullptr;
+	p_class->implicit_initializer = nullptr;
+
+	p_class->tool = _get_u8();
+	p_class->name = _get_string();
+
+	StringName native = _get_string();
+	if (native != StringName()) {
+		GDScriptLanguage *language = GDScriptLanguage::get_singleton();
+		const Map<StringName, int>::Element *E = language->get_global_map().find(native);
+		if (E) {
+			p_class->native = language->get_global_array()[E->get()];
+		}
+		if (p_class->native.is_null()) {
+			_fail("Unknown native class '" + String(native) + "'.");
+			return;
+		}
+	}
+
+	Ref<GDScript> base = _get_script_ref(true);
+	if (base.is_valid()) {
+		p_class->base = base;
+		p_class->_base = base.ptr();
+	}
+
+	uint32_t count = _get_u32();
+	for (uint32_t i = 0; i < count && !failed; i++) {
+		p_class->members.insert(_get_string());
+	}
+	count = _get_u32();
+	for (uint32_t i = 0; i < count && !failed; i++) {
+		StringName name = _get_string();
+		GDScript::MemberInfo minfo;
+		minfo.index = _get_u32();
+		minfo.setter = _get_string();
+		minfo.getter = _get_string();
+		minfo.data_type = _get_data_type();
+		p_class->member_indices[name] = minfo;
+	}
+	count = _get_u32();
+	for (uint32_t i = 0; i < count && !failed; i++) {
+		StringName name = _get_string();
+		PropertyInfo info;
+		info.type = Variant::Type(_get_u32());
+		info.name = _get_string();
+		info.class_name = _get_string();
+		info.hint = PropertyHint(_get_u32());
+		info.hint_string = _get_string();
+		info.usage = _get_u32();
+		if (info.type >= Variant::VARIANT_MAX) {
+			_fail("Invalid member type.");
+			return;
+		}
+		p_class->member_info[name] = info;
+	}
+	count = _get_u32();
+	for (uint32_t i = 0; i < count && !failed; i++) {
+		StringName name = _get_string();
+		Vector<StringName> parameters;
+		uint32_t parameter_count = _get_u32();
+		for (uint32_t j = 0; j < parameter_count && !failed; j++) {
+			parameters.push_back(_get_string());
+		}
+		p_class->_signals[name] = parameters;
+	}
+	count = _get_u32();
+	for (uint32_t i = 0; i < count && !failed; i++) {
+		StringName name = _get_string();
+		p_class->constants[name] = _get_variant();
+	}
+	count = _get_u32();
+	for (uint32_t i = 0; i < count && !failed; i++) {
+		StringName name = _get_string();
+		GDScriptFunction *function = _get_function(p_class);
+		if (function) {
+			p_class->member_functions[name] = function;
+		}
+	}
+
+	for (KeyValue<StringName, Ref<GDScript>> &E : p_class->subclasses) {
+		if (failed) {
+			return;
+		}
+		_get_class(E.value.ptr());
+	}
+}
+
+void GDScriptBytecodeCache::_finish_class(GDScript *p_class) {
+	// Same lookups the compiler does while parsing functions.
+	const Map<StringName, GDScriptFunction *>::Element *E = p_class->member_functions.find(GDScriptLanguage::get_singleton()->strings._init);
+	p_class->initializer = E ? E->get() : nullptr;
+	E = p_class->member_functions.find("@implicit_new");
+	p_class->implicit_initializer = E ? E->get() : nullptr;
+	p_class->valid = true;
+
+	for (KeyValue<StringName, Ref<GDScript>> &F : p_class->subclasses) {
+		_finish_class(F.value.ptr());
+	}
+}
+
+Error GDScriptBytecodeCache::load(GDScript *p_script, const Vector<uint8_t> &p_buffer) {
+	ERR_FAIL_NULL_V(p_script, ERR_INVALID_PARAMETER);
+
+	GDScriptBytecodeCache cache;
+	cache.main_script = p_script;
+	cache.loading_script = p_script;
+	cache.read_ptr = p_buffer.ptr();
+	cache.read_size = p_buffer.size();
+
+	if (p_buffer.size() < 4 || memcmp(p_buffer.ptr(), GDSCRIPT_BYTECODE_CACHE_MAGIC, 4) != 0) {
+		return ERR_FILE_UNRECOGNIZED;
+	}
+	cache.read_pos = 4;
+
+	if (cache._get_u32() != FORMAT_VERSION || cache._get_string() != _get_engine_version() || cache._get_u32() != sizeof(real_t)) {
+		return ERR_FILE_UNRECOGNIZED;
+	}
+
+	// Stale caches are expected (e.g. sources patched after export), fall back silently.
+	if (cache._get_u64() != p_script->source.hash64()) {
+		return ERR_FILE_MISSING_DEPENDENCIES;
+	}
+	uint32_t dependency_count = cache._get_u32();
+	for (uint32_t i = 0; i < dependency_count && !cache.failed; i++) {
+		String path = cache._get_string();
+		uint64_t hash = cache._get_u64();
+		if (cache.failed || !FileAccess::exists(path) || GDScriptCache::get_source_code(path).hash64() != hash) {
+			return ERR_FILE_MISSING_DEPENDENCIES;
+		}
+	}
+
+	p_script->valid = false;
+	p_script->fully_qualified_name = p_script->path;
+	p_script->_owner = nullptr;
+
+	cache._get_class_tree(p_script);
+	cache._get_class(p_script);
+	if (!cache.failed && cache.read_pos != cache.read_size) {
+		cache._fail("Trailing data.");
+	}
+	if (cache.failed) {
+		ERR_PRINT("Invalid bytecode cache for '" + p_script->get_path() + "': " + cache.error + " Compiling from source.");
+		return ERR_FILE_CORRUPT;
+	}
+
+	cache._finish_class(p_script);
+	for (KeyValue<StringName, Ref<GDScript>> &E : p_script->subclasses) {
+		p_script->_set_subclass_path(E.value, p_script->path);
+	}
+	p_script->_init_rpc_methods_properties();
+
+	if (p_script->get_path().is_empty()) {
+		return OK;
+	}
+	return GDScriptCache::finish_compiling(p_script->get_path());
+}
@@ -0,0 +1,149 @@
+/*************************************************************************/
+/*  gdscript_bytecode_cache.h                                            */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef GDSCRIPT_BYTECODE_CACHE_H
+#define GDSCRIPT_BYTECODE_CACHE_H
+
+#include "core/templates/map.h"
+#include "core/templates/vector.h"
+#include "gdscript.h"
+
+// Ahead-of-time compiled form of a GDScript file, written on export next to
+// the source and used at load time to skip the parser, analyzer and compiler.
+//
+// Everything the compiler leaves in GDScript and GDScriptFunction is stored,
+// except native pointers: operator evaluators, setters, method binds, utility
+// functions and global indices are written by name and resolved again when
+// loading. The cache is rejected (and the script compiled from source) if the
+// format, engine build, script source or any script it inherits from changed.
+class GDScriptBytecodeCache {
+	enum {
+		FORMAT_VERSION = 1,
+	};
+
+	enum VariantTag {
+		VARIANT_VALUE,
+		VARIANT_NULL_OBJECT,
+		VARIANT_GLOBAL,
+		VARIANT_SCRIPT,
+		VARIANT_RESOURCE,
+		VARIANT_ARRAY,
+		VARIANT_DICTIONARY,
+	};
+
+	enum ScriptRef {
+		SCRIPT_REF_NONE,
+		SCRIPT_REF_LOCAL, // Main script or one of its inner classes.
+		SCRIPT_REF_GDSCRIPT, // Another GDScript file, optionally an inner class of it.
+		SCRIPT_REF_RESOURCE, // Script in another language.
+	};
+
+	struct OperatorKey {
+		Variant::Operator op = Variant::OP_MAX;
+		Variant::Type type_a = Variant::NIL;
+		Variant::Type type_b = Variant::NIL;
+	};
+
+	struct MemberKey {
+		Variant::Type type = Variant::NIL;
+		StringName name;
+	};
+
+	struct ConstructorKey {
+		Variant::Type type = Variant::NIL;
+		int index = 0;
+	};
+
+	const GDScript *main_script = nullptr;
+	bool failed = false;
+	String error;
+
+	// Writing.
+	Vector<uint8_t> buffer;
+	Map<String, uint64_t> dependencies;
+	Map<const Object *, StringName> global_objects;
+	Map<int, StringName> global_indices;
+	Map<Variant::ValidatedOperatorEvaluator, OperatorKey> operator_keys;
+	Map<Variant::ValidatedSetter, MemberKey> setter_keys;
+	Map<Variant::ValidatedGetter, MemberKey> getter_keys;
+	Map<Variant::ValidatedKeyedSetter, Variant::Type> keyed_setter_keys;
+	Map<Variant::ValidatedKeyedGetter, Variant::Type> keyed_getter_keys;
+	Map<Variant::ValidatedIndexedSetter, Variant::Type> indexed_setter_keys;
+	Map<Variant::ValidatedIndexedGetter, Variant::Type> indexed_getter_keys;
+	Map<Variant::ValidatedBuiltInMethod, MemberKey> builtin_method_keys;
+	Map<Variant::ValidatedConstructor, ConstructorKey> constructor_keys;
+	Map<Variant::ValidatedUtilityFunction, StringName> utility_keys;
+	Map<GDScriptUtilityFunctions::FunctionPtr, StringName> gds_utility_keys;
+
+	void _fail(const String &p_error);
+	void _build_reverse_maps();
+
+	void _put_u8(uint8_t p_value);
+	void _put_u32(uint32_t p_value);
+	void _put_u64(uint64_t p_value);
+	void _put_string(const String &p_string);
+	void _put_variant(const Variant &p_value);
+	void _put_script_ref(const Script *p_script);
+	void _put_data_type(const GDScriptDataType &p_type);
+	void _put_function(const GDScriptFunction *p_function);
+	void _put_class_tree(const GDScript *p_class);
+	void _put_class(const GDScript *p_class);
+	void _add_dependency(const GDScript *p_script);
+
+	// Reading.
+	GDScript *loading_script = nullptr;
+	const uint8_t *read_ptr = nullptr;
+	int read_size = 0;
+	int read_pos = 0;
+
+	uint8_t _get_u8();
+	uint32_t _get_u32();
+	uint64_t _get_u64();
+	String _get_string();
+	Variant _get_variant();
+	Ref<Script> _get_script_ref(bool p_full = false);
+	GDScriptDataType _get_data_type();
+	GDScriptFunction *_get_function(GDScript *p_script);
+	void _get_class_tree(GDScript *p_class);
+	void _get_class(GDScript *p_class);
+	void _finish_class(GDScript *p_class);
+
+	static const GDScript *_get_root(const GDScript *p_script, Vector<StringName> *r_chain = nullptr);
+
+public:
+	static String get_cache_path(const String &p_script_path);
+
+	// Returns an empty buffer if the script can't be cached (e.g. it holds
+	// constants that only exist at runtime), the source is used then.
+	static Vector<uint8_t> serialize(const GDScript *p_script);
+	static Error load(GDScript *p_script, const Vector<uint8_t> &p_buffer);
+};
+
+#endif // GDSCRIPT_BYTECODE_CACHE_H
@@ -30,10 +30,13 @@
 
 #include "gdscript_cache.h"
 
+#include "core/config/engine.h"
+#include "core/debugger/engine_debugger.h"
 #include "core/io/file_access.h"
 #include "core/templates/vector.h"
 #include "gdscript.h"
 #include "gdscript_analyzer.h"
+#include "gdscript_bytecode_cache.h"
 #include "gdscript_parser.h"
 
 bool GDScriptParserRef::is_valid() const {
@@ -206,9 +209,19 @@ Ref<GDScript> GDScriptCache::get_full_script(const String &p_path, Error &r_erro
 		return script;
 	}
 
-	r_error = script->reload();
-	if (r_error) {
-		return script;
+	// Exported projects ship the compiled bytecode next to the source, which saves parsing and analyzing it.
+	// Debugging needs the stack information the compiler only emits with the debugger attached.
+	bool from_cache = false;
+	if (!Engine::get_singleton()->is_editor_hint() && !EngineDebugger::is_active()) {
+		String cache_path = GDScriptBytecodeCache::get_cache_path(p_path);
+		from_cache = FileAccess::exists(cache_path) && script->load_byte_code(cache_path) == OK;
+	}
+
+	if (!from_cache) {
+		r_error = script->reload();
+		if (r_error) {
+			return script;
+		}
 	}
 
 	singleton->full_gdscript_cache[p_path] = script.ptr();
@@ -134,6 +134,48 @@ void GDScriptFunction::disassemble(const Vector<String> &p_code_lines) const {
 
 				incr += 5;
 			} break;
+
+#define DISASSEMBLE_OPERATOR_TYPED(m_name, m_op) \
+	case OPCODE_OPERATOR_##m_name: {             \
+		text += "typed operator (";              \
+		text += #m_name;                         \
+		text += ") ";                            \
+		text += DADDR(3);                        \
+		text += " = ";                           \
+		text += DADDR(1);                        \
+		text += " " #m_op " ";                   \
+		text += DADDR(2);                        \
+		incr += 5;                               \
+	} break
+
+				DISASSEMBLE_OPERATOR_TYPED(ADD_INT, +);
+				DISASSEMBLE_OPERATOR_TYPED(SUBTRACT_INT, -);
+				DISASSEMBLE_OPERATOR_TYPED(MULTIPLY_INT, *);
+				DISASSEMBLE_OPERATOR_TYPED(EQUAL_INT, ==);
+				DISASSEMBLE_OPERATOR_TYPED(NOT_EQUAL_INT, !=);
+				DISASSEMBLE_OPERATOR_TYPED(LESS_INT, <);
+				DISASSEMBLE_OPERATOR_TYPED(LESS_EQUAL_INT, <=);
+				DISASSEMBLE_OPERATOR_TYPED(GREATER_INT, >);
+				DISASSEMBLE_OPERATOR_TYPED(GREATER_EQUAL_INT, >=);
+				DISASSEMBLE_OPERATOR_TYPED(ADD_FLOAT, +);
+				DISASSEMBLE_OPERATOR_TYPED(SUBTRACT_FLOAT, -);
+				DISASSEMBLE_OPERATOR_TYPED(MULTIPLY_FLOAT, *);
+				DISASSEMBLE_OPERATOR_TYPED(DIVIDE_FLOAT, /);
+				DISASSEMBLE_OPERATOR_TYPED(LESS_FLOAT, <);
+				DISASSEMBLE_OPERATOR_TYPED(LESS_EQUAL_FLOAT, <=);
+				DISASSEMBLE_OPERATOR_TYPED(GREATER_FLOAT, >);
+				DISASSEMBLE_OPERATOR_TYPED(GREATER_EQUAL_FLOAT, >=);
+				DISASSEMBLE_OPERATOR_TYPED(ADD_VECTOR2, +);
+				DISASSEMBLE_OPERATOR_TYPED(SUBTRACT_VECTOR2, -);
+				DISASSEMBLE_OPERATOR_TYPED(MULTIPLY_VECTOR2, *);
+				DISASSEMBLE_OPERATOR_TYPED(MULTIPLY_VECTOR2_FLOAT, *);
+				DISASSEMBLE_OPERATOR_TYPED(DIVIDE_VECTOR2_FLOAT, /);
+				DISASSEMBLE_OPERATOR_TYPED(ADD_VECTOR3, +);
+				DISASSEMBLE_OPERATOR_TYPED(SUBTRACT_VECTOR3, -);
+				DISASSEMBLE_OPERATOR_TYPED(MULTIPLY_VECTOR3, *);
+				DISASSEMBLE_OPERATOR_TYPED(MULTIPLY_VECTOR3_FLOAT, *);
+				DISASSEMBLE_OPERATOR_TYPED(DIVIDE_VECTOR3_FLOAT, /);
+
 			case OPCODE_EXTENDS_TEST: {
 				text += "is object ";
 				text += DADDR(3);
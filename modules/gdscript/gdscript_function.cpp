@@ -138,6 +138,76 @@ void GDScriptFunction::debug_get_stack_member_state(int p_line, List<Pair<String
 	}
 }
 
+void GDScriptFunction::_specialize() {
+	struct TypedOperator {
+		Variant::Operator op;
+		Variant::Type left;
+		Variant::Type right;
+		Opcode opcode;
+	};
+
+	static const TypedOperator typed_operators[] = {
+		{ Variant::OP_ADD, Variant::INT, Variant::INT, OPCODE_OPERATOR_ADD_INT },
+		{ Variant::OP_SUBTRACT, Variant::INT, Variant::INT, OPCODE_OPERATOR_SUBTRACT_INT },
+		{ Variant::OP_MULTIPLY, Variant::INT, Variant::INT, OPCODE_OPERATOR_MULTIPLY_INT },
+		{ Variant::OP_EQUAL, Variant::INT, Variant::INT, OPCODE_OPERATOR_EQUAL_INT },
+		{ Variant::OP_NOT_EQUAL, Variant::INT, Variant::INT, OPCODE_OPERATOR_NOT_EQUAL_INT },
+		{ Variant::OP_LESS, Variant::INT, Variant::INT, OPCODE_OPERATOR_LESS_INT },
+		{ Variant::OP_LESS_EQUAL, Variant::INT, Variant::INT, OPCODE_OPERATOR_LESS_EQUAL_INT },
+		{ Variant::OP_GREATER, Variant::INT, Variant::INT, OPCODE_OPERATOR_GREATER_INT },
+		{ Variant::OP_GREATER_EQUAL, Variant::INT, Variant::INT, OPCODE_OPERATOR_GREATER_EQUAL_INT },
+		{ Variant::OP_ADD, Variant::FLOAT, Variant::FLOAT, OPCODE_OPERATOR_ADD_FLOAT },
+		{ Variant::OP_SUBTRACT, Variant::FLOAT, Variant::FLOAT, OPCODE_OPERATOR_SUBTRACT_FLOAT },
+		{ Variant::OP_MULTIPLY, Variant::FLOAT, Variant::FLOAT, OPCODE_OPERATOR_MULTIPLY_FLOAT },
+		{ Variant::OP_DIVIDE, Variant::FLOAT, Variant::FLOAT, OPCODE_OPERATOR_DIVIDE_FLOAT },
+		{ Variant::OP_LESS, Variant::FLOAT, Variant::FLOAT, OPCODE_OPERATOR_LESS_FLOAT },
+		{ Variant::OP_LESS_EQUAL, Variant::FLOAT, Variant::FLOAT, OPCODE_OPERATOR_LESS_EQUAL_FLOAT },
+		{ Variant::OP_GREATER, Variant::FLOAT, Variant::FLOAT, OPCODE_OPERATOR_GREATER_FLOAT },
+		{ Variant::OP_GREATER_EQUAL, Variant::FLOAT, Variant::FLOAT, OPCODE_OPERATOR_GREATER_EQUAL_FLOAT },
+		{ Variant::OP_ADD, Variant::VECTOR2, Variant::VECTOR2, OPCODE_OPERATOR_ADD_VECTOR2 },
+		{ Variant::OP_SUBTRACT, Variant::VECTOR2, Variant::VECTOR2, OPCODE_OPERATOR_SUBTRACT_VECTOR2 },
+		{ Variant::OP_MULTIPLY, Variant::VECTOR2, Variant::VECTOR2, OPCODE_OPERATOR_MULTIPLY_VECTOR2 },
+		{ Variant::OP_MULTIPLY, Variant::VECTOR2, Variant::FLOAT, OPCODE_OPERATOR_MULTIPLY_VECTOR2_FLOAT },
+		{ Variant::OP_DIVIDE, Variant::VECTOR2, Variant::FLOAT, OPCODE_OPERATOR_DIVIDE_VECTOR2_FLOAT },
+		{ Variant::OP_ADD, Variant::VECTOR3, Variant::VECTOR3, OPCODE_OPERATOR_ADD_VECTOR3 },
+		{ Variant::OP_SUBTRACT, Variant::VECTOR3, Variant::VECTOR3, OPCODE_OPERATOR_SUBTRACT_VECTOR3 },
+		{ Variant::OP_MULTIPLY, Variant::VECTOR3, Variant::VECTOR3, OPCODE_OPERATOR_MULTIPLY_VECTOR3 },
+		{ Variant::OP_MULTIPLY, Variant::VECTOR3, Variant::FLOAT, OPCODE_OPERATOR_MULTIPLY_VECTOR3_FLOAT },
+		{ Variant::OP_DIVIDE, Variant::VECTOR3, Variant::FLOAT, OPCODE_OPERATOR_DIVIDE_VECTOR3_FLOAT },
+	};
+
+	// Rewrite a copy, the original code is kept for the disassembler and bytecode caching.
+	// Instructions keep their layout, so frames awaiting in the original code can resume in the copy.
+	Vector<int> specialized = code;
+	bool changed = false;
+
+	for (int i = 0; i < operator_positions.size(); i++) {
+		int pos = operator_positions[i];
+		ERR_CONTINUE(pos + 4 >= specialized.size() || (specialized[pos] & INSTR_MASK) != OPCODE_OPERATOR_VALIDATED);
+
+		int operator_idx = specialized[pos + 4];
+		ERR_CONTINUE(operator_idx < 0 || operator_idx >= operator_funcs.size());
+		Variant::ValidatedOperatorEvaluator operator_func = operator_funcs[operator_idx];
+
+		for (const TypedOperator &typed : typed_operators) {
+			if (Variant::get_validated_operator_evaluator(typed.op, typed.left, typed.right) == operator_func) {
+				specialized.write[pos] = (specialized[pos] & INSTR_ARGS_MASK) | typed.opcode;
+				changed = true;
+				break;
+			}
+		}
+	}
+
+	if (!changed) {
+		return;
+	}
+
+	// Only the call reaching the threshold gets here, but other threads may be running the original code.
+	// They pick up the copy on their next call, the pointer is published once the copy is complete.
+	specialized_code = specialized;
+	specialized_code_ptr.set(specialized_code.ptr());
+}
+
 GDScriptFunction::GDScriptFunction() {
 	name = "<anonymous>";
 #ifdef DEBUG_ENABLED
@@ -36,6 +36,7 @@
 #include "core/os/thread.h"
 #include "core/string/string_name.h"
 #include "core/templates/pair.h"
+#include "core/templates/safe_refcount.h"
 #include "core/templates/self_list.h"
 #include "core/variant/variant.h"
 #include "gdscript_utility_functions.h"
@@ -219,6 +220,33 @@ public:
 	enum Opcode {
 		OPCODE_OPERATOR,
 		OPCODE_OPERATOR_VALIDATED,
+		OPCODE_OPERATOR_ADD_INT,
+		OPCODE_OPERATOR_SUBTRACT_INT,
+		OPCODE_OPERATOR_MULTIPLY_INT,
+		OPCODE_OPERATOR_EQUAL_INT,
+		OPCODE_OPERATOR_NOT_EQUAL_INT,
+		OPCODE_OPERATOR_LESS_INT,
+		OPCODE_OPERATOR_LESS_EQUAL_INT,
+		OPCODE_OPERATOR_GREATER_INT,
+		OPCODE_OPERATOR_GREATER_EQUAL_INT,
+		OPCODE_OPERATOR_ADD_FLOAT,
+		OPCODE_OPERATOR_SUBTRACT_FLOAT,
+		OPCODE_OPERATOR_MULTIPLY_FLOAT,
+		OPCODE_OPERATOR_DIVIDE_FLOAT,
+		OPCODE_OPERATOR_LESS_FLOAT,
+		OPCODE_OPERATOR_LESS_EQUAL_FLOAT,
+		OPCODE_OPERATOR_GREATER_FLOAT,
+		OPCODE_OPERATOR_GREATER_EQUAL_FLOAT,
+		OPCODE_OPERATOR_ADD_VECTOR2,
+		OPCODE_OPERATOR_SUBTRACT_VECTOR2,
+		OPCODE_OPERATOR_MULTIPLY_VECTOR2,
+		OPCODE_OPERATOR_MULTIPLY_VECTOR2_FLOAT,
+		OPCODE_OPERATOR_DIVIDE_VECTOR2_FLOAT,
+		OPCODE_OPERATOR_ADD_VECTOR3,
+		OPCODE_OPERATOR_SUBTRACT_VECTOR3,
+		OPCODE_OPERATOR_MULTIPLY_VECTOR3,
+		OPCODE_OPERATOR_MULTIPLY_VECTOR3_FLOAT,
+		OPCODE_OPERATOR_DIVIDE_VECTOR3_FLOAT,
 		OPCODE_EXTENDS_TEST,
 		OPCODE_IS_BUILTIN,
 		OPCODE_SET_KEYED,
@@ -424,6 +452,7 @@ public:
 private:
 	friend class GDScriptCompiler;
 	friend class GDScriptByteCodeGenerator;
+	friend class GDScriptBytecodeCache;
 
 	StringName source;
 
@@ -491,10 +520,15 @@ private:
 	Vector<MethodBind *> methods;
 	Vector<GDScriptFunction *> lambdas;
 	Vector<int> code;
+	Vector<int> global_index_positions; // Code positions holding global indices, remapped when loading cached bytecode.
+	Vector<int> operator_positions; // Code positions of validated binary operators, candidates for specialization.
+	Vector<int> specialized_code;
+	SafeNumeric<const int *> specialized_code_ptr; // Published once, other threads may be calling the function meanwhile.
+	SafeNumeric<uint32_t> call_count;
 	Vector<GDScriptDataType> argument_types;
 	GDScriptDataType return_type;
 
-	Map<int, Variant::Type> temporary_slots;
+	Vector<Pair<int, Variant::Type>> temporary_slots;
 
 #ifdef TOOLS_ENABLED
 	Vector<StringName> arg_names;
@@ -504,6 +538,7 @@ private:
 	List<StackDebug> stack_debug;
 
 	Variant _get_default_variant_for_data_type(const GDScriptDataType &p_data_type);
+	void _specialize();
 
 	_FORCE_INLINE_ Variant *_get_variant(int p_address, GDScriptInstance *p_instance, Variant *p_stack, String &r_error) const;
 	_FORCE_INLINE_ String _get_call_error(const Callable::CallError &p_err, const String &p_where, const Variant **argptrs) const;
@@ -565,6 +600,7 @@ public:
 	void debug_get_stack_member_state(int p_line, List<Pair<StringName, int>> *r_stackvars) const;
 
 	_FORCE_INLINE_ bool is_empty() const { return _code_size == 0; }
+	_FORCE_INLINE_ bool is_specialized() const { return specialized_code_ptr.get() != nullptr; }
 
 	int get_argument_count() const { return _argument_count; }
 	StringName get_argument_name(int p_idx) const {
@@ -0,0 +1,261 @@
+/*************************************************************************/
+/*  gdscript_sampling_profiler.cpp                                       */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "gdscript_sampling_profiler.h"
+
+#include "core/io/file_access.h"
+#include "core/object/method_bind.h"
+#include "core/os/os.h"
+#include "gdscript_function.h"
+
+SafeFlag GDScriptSamplingProfiler::active;
+SafeFlag GDScriptSamplingProfiler::exit_thread;
+SafeNumeric<uint32_t> GDScriptSamplingProfiler::tick;
+thread_local GDScriptSamplingProfiler::ThreadData *GDScriptSamplingProfiler::thread_data = nullptr;
+
+Mutex GDScriptSamplingProfiler::mutex;
+Thread GDScriptSamplingProfiler::thread;
+uint32_t GDScriptSamplingProfiler::interval_usec = 1000;
+uint64_t GDScriptSamplingProfiler::start_time = 0;
+uint64_t GDScriptSamplingProfiler::sample_count = 0;
+String GDScriptSamplingProfiler::output_path;
+LocalVector<GDScriptSamplingProfiler::ThreadData *> GDScriptSamplingProfiler::threads;
+LocalVector<GDScriptSamplingProfiler::Node> GDScriptSamplingProfiler::nodes;
+HashMap<String, int> GDScriptSamplingProfiler::node_map;
+LocalVector<GDScriptSamplingProfiler::Sample> GDScriptSamplingProfiler::timeline;
+
+void GDScriptSamplingProfiler::_thread_func(void *p_user) {
+	while (!exit_thread.is_set()) {
+		OS::get_singleton()->delay_usec(interval_usec);
+		tick.increment();
+	}
+}
+
+GDScriptSamplingProfiler::ThreadData *GDScriptSamplingProfiler::_create_thread_data() {
+	ThreadData *td = memnew(ThreadData);
+	td->id = Thread::get_caller_id();
+	td->last_tick = tick.get();
+	{
+		MutexLock lock(mutex);
+		threads.push_back(td);
+	}
+	thread_data = td;
+	return td;
+}
+
+int GDScriptSamplingProfiler::_get_node(int p_parent, const String &p_name) {
+	const String key = itos(p_parent) + "|" + p_name;
+	const int *idx = node_map.getptr(key);
+	if (idx) {
+		return *idx;
+	}
+
+	Node node;
+	node.name = p_name;
+	node.parent = p_parent;
+	nodes.push_back(node);
+	node_map[key] = nodes.size() - 1;
+	return nodes.size() - 1;
+}
+
+String GDScriptSamplingProfiler::_get_node_stack(int p_node) {
+	String stack = nodes[p_node].name;
+	for (int parent = nodes[p_node].parent; parent != -1; parent = nodes[parent].parent) {
+		stack = nodes[parent].name + ";" + stack;
+	}
+	return stack;
+}
+
+void GDScriptSamplingProfiler::take_sample(const MethodBind *p_native) {
+	ThreadData *td = thread_data;
+	const uint32_t now = tick.get();
+	// A thread stuck in a long native call sees several ticks at once, weight the sample by them.
+	const uint32_t weight = now - td->last_tick;
+	td->last_tick = now;
+	if (weight == 0 || td->frames.is_empty()) {
+		return;
+	}
+
+	MutexLock lock(mutex);
+	if (!active.is_set()) {
+		return;
+	}
+
+	int node = -1;
+	for (uint32_t i = 0; i < td->frames.size(); i++) {
+		const Frame &frame = td->frames[i];
+		node = _get_node(node, String(frame.function->get_name()) + " (" + String(frame.function->get_source()) + ":" + itos(*frame.line) + ")");
+	}
+	if (p_native) {
+		node = _get_node(node, String(p_native->get_instance_class()) + "::" + String(p_native->get_name()) + " (native)");
+	}
+
+	nodes[node].samples += weight;
+	sample_count += weight;
+
+	if (timeline.size() < MAX_TIMELINE_SAMPLES) {
+		Sample sample;
+		sample.time = OS::get_singleton()->get_ticks_usec() - start_time;
+		sample.thread = td->id;
+		sample.node = node;
+		sample.weight = weight;
+		timeline.push_back(sample);
+	}
+}
+
+void GDScriptSamplingProfiler::start(uint32_t p_rate) {
+	ERR_FAIL_COND_MSG(active.is_set(), "The GDScript sampling profiler is already running.");
+	ERR_FAIL_COND_MSG(p_rate == 0, "The sampling rate must be greater than zero.");
+
+	MutexLock lock(mutex);
+	nodes.clear();
+	node_map.clear();
+	timeline.clear();
+	sample_count = 0;
+	interval_usec = MAX(1u, 1000000u / p_rate);
+	start_time = OS::get_singleton()->get_ticks_usec();
+
+	exit_thread.clear();
+	active.set();
+	thread.start(_thread_func, nullptr);
+}
+
+void GDScriptSamplingProfiler::stop() {
+	ERR_FAIL_COND_MSG(!active.is_set(), "The GDScript sampling profiler is not running.");
+
+	active.clear();
+	exit_thread.set();
+	thread.wait_to_finish();
+}
+
+uint64_t GDScriptSamplingProfiler::get_sample_count() {
+	MutexLock lock(mutex);
+	return sample_count;
+}
+
+String GDScriptSamplingProfiler::get_collapsed_stacks() {
+	MutexLock lock(mutex);
+
+	String text;
+	for (uint32_t i = 0; i < nodes.size(); i++) {
+		if (nodes[i].samples > 0) {
+			text += _get_node_stack(i) + " " + itos(nodes[i].samples) + "\n";
+		}
+	}
+	return text;
+}
+
+String GDScriptSamplingProfiler::get_chrome_trace() {
+	MutexLock lock(mutex);
+
+	String json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	for (uint32_t i = 0; i < threads.size(); i++) {
+		if (i > 0) {
+			json += ",";
+		}
+		const String tid = itos(threads[i]->id);
+		json += "{\"ph\":\"M\",\"pid\":1,\"tid\":" + tid + ",\"name\":\"thread_name\",\"args\":{\"name\":\"" + (threads[i]->id == Thread::get_main_id() ? String("Main thread") : "Thread " + tid) + "\"}}";
+	}
+
+	json += "],\"stackFrames\":{";
+	for (uint32_t i = 0; i < nodes.size(); i++) {
+		if (i > 0) {
+			json += ",";
+		}
+		json += "\"" + itos(i) + "\":{\"category\":\"GDScript\",\"name\":\"" + nodes[i].name.json_escape() + "\"";
+		if (nodes[i].parent != -1) {
+			json += ",\"parent\":\"" + itos(nodes[i].parent) + "\"";
+		}
+		json += "}";
+	}
+
+	json += "},\"samples\":[";
+	for (uint32_t i = 0; i < timeline.size(); i++) {
+		if (i > 0) {
+			json += ",";
+		}
+		const Sample &sample = timeline[i];
+		json += "{\"cpu\":0,\"pid\":1,\"tid\":" + itos(sample.thread) + ",\"ts\":" + itos(sample.time) + ",\"name\":\"GDScript\",\"sf\":\"" + itos(sample.node) + "\",\"weight\":" + itos(sample.weight) + "}";
+	}
+	json += "]}\n";
+
+	return json;
+}
+
+Error GDScriptSamplingProfiler::save(const String &p_path, Format p_format) {
+	Error err;
+	Ref<FileAccess> file = FileAccess::open(p_path, FileAccess::WRITE, &err);
+	ERR_FAIL_COND_V_MSG(err != OK, err, "Cannot open file '" + p_path + "' to save the GDScript sampling profile.");
+
+	file->store_string(p_format == FORMAT_CHROME_TRACE ? get_chrome_trace() : get_collapsed_stacks());
+	return OK;
+}
+
+void GDScriptSamplingProfiler::handle_cmdline() {
+	List<String> args = OS::get_singleton()->get_cmdline_args();
+
+	uint32_t rate = DEFAULT_RATE;
+	for (List<String>::Element *E = args.front(); E; E = E->next()) {
+		if (!E->next()) {
+			break;
+		}
+		if (E->get() == "--gdscript-sampling-profile") {
+			output_path = E->next()->get();
+		} else if (E->get() == "--gdscript-sampling-rate") {
+			rate = E->next()->get().to_int();
+		}
+	}
+
+	if (!output_path.is_empty()) {
+		start(rate);
+	}
+}
+
+void GDScriptSamplingProfiler::finish() {
+	if (active.is_set()) {
+		stop();
+	}
+
+	if (!output_path.is_empty()) {
+		const Format format = output_path.get_extension().to_lower() == "json" ? FORMAT_CHROME_TRACE : FORMAT_COLLAPSED;
+		if (save(output_path, format) == OK) {
+			print_line("GDScript sampling profile with " + itos(sample_count) + " samples saved to: " + output_path);
+		}
+		output_path = String();
+	}
+
+	// Nothing runs scripts anymore, free what threads left behind.
+	MutexLock lock(mutex);
+	for (uint32_t i = 0; i < threads.size(); i++) {
+		memdelete(threads[i]);
+	}
+	threads.clear();
+	thread_data = nullptr;
+}
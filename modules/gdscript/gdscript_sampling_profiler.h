@@ -0,0 +1,156 @@
+/*************************************************************************/
+/*  gdscript_sampling_profiler.h                                         */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef GDSCRIPT_SAMPLING_PROFILER_H
+#define GDSCRIPT_SAMPLING_PROFILER_H
+
+#include "core/os/mutex.h"
+#include "core/os/thread.h"
+#include "core/string/ustring.h"
+#include "core/templates/hash_map.h"
+#include "core/templates/local_vector.h"
+#include "core/templates/safe_refcount.h"
+
+class GDScriptFunction;
+class MethodBind;
+
+// Statistical profiler usable in release builds. A timer thread ticks at the
+// sampling rate, and every thread running GDScript records its own call stack
+// at its next safe point: a line, a function entry, a loop back-edge, or the
+// return of the native call it was in when the tick happened. Release builds
+// don't emit line markers, so there samples point at the line each function
+// starts on rather than the line running in it.
+// Samples are aggregated into a call tree and saved either as collapsed stacks
+// (for flame graph tools) or as a Chrome trace (chrome://tracing, Perfetto).
+//
+// Start it from the command line with:
+//     --gdscript-sampling-profile <file.folded|file.json> [--gdscript-sampling-rate <hz>]
+// The file is written when the engine quits.
+class GDScriptSamplingProfiler {
+public:
+	enum Format {
+		FORMAT_COLLAPSED,
+		FORMAT_CHROME_TRACE,
+	};
+
+private:
+	struct Frame {
+		const GDScriptFunction *function = nullptr;
+		const int *line = nullptr;
+	};
+
+	struct ThreadData {
+		LocalVector<Frame> frames;
+		uint32_t last_tick = 0;
+		Thread::ID id = 0;
+	};
+
+	struct Node {
+		String name;
+		int parent = -1;
+		uint64_t samples = 0;
+	};
+
+	struct Sample {
+		uint64_t time = 0;
+		Thread::ID thread = 0;
+		int node = -1;
+		uint32_t weight = 0;
+	};
+
+	enum {
+		DEFAULT_RATE = 1000,
+		MAX_TIMELINE_SAMPLES = 1 << 22, // Past this, samples are still counted but not kept for the trace.
+	};
+
+	static SafeFlag active;
+	static SafeFlag exit_thread;
+	static SafeNumeric<uint32_t> tick;
+	static thread_local ThreadData *thread_data;
+
+	static Mutex mutex;
+	static Thread thread;
+	static uint32_t interval_usec;
+	static uint64_t start_time;
+	static uint64_t sample_count;
+	static String output_path;
+	static LocalVector<ThreadData *> threads;
+	static LocalVector<Node> nodes;
+	static HashMap<String, int> node_map;
+	static LocalVector<Sample> timeline;
+
+	static void _thread_func(void *p_user);
+	static ThreadData *_create_thread_data();
+	static int _get_node(int p_parent, const String &p_name);
+	static String _get_node_stack(int p_node);
+
+public:
+	_FORCE_INLINE_ static bool is_active() { return active.is_set(); }
+
+	// Called by the VM when a function starts or stops running on this thread, only while active.
+	_FORCE_INLINE_ static void enter_function(const GDScriptFunction *p_function, const int *p_line) {
+		ThreadData *td = thread_data;
+		if (unlikely(!td)) {
+			td = _create_thread_data();
+		}
+		if (td->frames.is_empty()) {
+			// Ticks that happened outside of GDScript don't count.
+			td->last_tick = tick.get();
+		}
+		Frame frame;
+		frame.function = p_function;
+		frame.line = p_line;
+		td->frames.push_back(frame);
+	}
+
+	_FORCE_INLINE_ static void exit_function() {
+		thread_data->frames.resize(thread_data->frames.size() - 1);
+	}
+
+	// Only valid on threads that entered a function while active.
+	_FORCE_INLINE_ static bool is_sample_pending() {
+		return active.is_set() && tick.get() != thread_data->last_tick;
+	}
+
+	static void take_sample(const MethodBind *p_native = nullptr);
+
+	static void start(uint32_t p_rate = DEFAULT_RATE);
+	static void stop();
+	static uint64_t get_sample_count();
+
+	static String get_collapsed_stacks();
+	static String get_chrome_trace();
+	static Error save(const String &p_path, Format p_format);
+
+	static void handle_cmdline();
+	static void finish();
+};
+
+#endif // GDSCRIPT_SAMPLING_PROFILER_H
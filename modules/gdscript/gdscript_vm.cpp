@@ -34,6 +34,7 @@
 #include "core/os/os.h"
 #include "gdscript.h"
 #include "gdscript_lambda_callable.h"
+#include "gdscript_sampling_profiler.h"
 
 Variant *GDScriptFunction::_get_variant(int p_address, GDScriptInstance *p_instance, Variant *p_stack, String &r_error) const {
 	int address = p_address & ADDR_MASK;
@@ -227,6 +228,33 @@ void (*type_init_function_table[])(Variant *) = {
 	static const void *switch_table_ops[] = {        \
 		&&OPCODE_OPERATOR,                           \
 		&&OPCODE_OPERATOR_VALIDATED,                 \
+		&&OPCODE_OPERATOR_ADD_INT,                   \
+		&&OPCODE_OPERATOR_SUBTRACT_INT,              \
+		&&OPCODE_OPERATOR_MULTIPLY_INT,              \
+		&&OPCODE_OPERATOR_EQUAL_INT,                 \
+		&&OPCODE_OPERATOR_NOT_EQUAL_INT,             \
+		&&OPCODE_OPERATOR_LESS_INT,                  \
+		&&OPCODE_OPERATOR_LESS_EQUAL_INT,            \
+		&&OPCODE_OPERATOR_GREATER_INT,               \
+		&&OPCODE_OPERATOR_GREATER_EQUAL_INT,         \
+		&&OPCODE_OPERATOR_ADD_FLOAT,                 \
+		&&OPCODE_OPERATOR_SUBTRACT_FLOAT,            \
+		&&OPCODE_OPERATOR_MULTIPLY_FLOAT,            \
+		&&OPCODE_OPERATOR_DIVIDE_FLOAT,              \
+		&&OPCODE_OPERATOR_LESS_FLOAT,                \
+		&&OPCODE_OPERATOR_LESS_EQUAL_FLOAT,          \
+		&&OPCODE_OPERATOR_GREATER_FLOAT,             \
+		&&OPCODE_OPERATOR_GREATER_EQUAL_FLOAT,       \
+		&&OPCODE_OPERATOR_ADD_VECTOR2,               \
+		&&OPCODE_OPERATOR_SUBTRACT_VECTOR2,          \
+		&&OPCODE_OPERATOR_MULTIPLY_VECTOR2,          \
+		&&OPCODE_OPERATOR_MULTIPLY_VECTOR2_FLOAT,    \
+		&&OPCODE_OPERATOR_DIVIDE_VECTOR2_FLOAT,      \
+		&&OPCODE_OPERATOR_ADD_VECTOR3,               \
+		&&OPCODE_OPERATOR_SUBTRACT_VECTOR3,          \
+		&&OPCODE_OPERATOR_MULTIPLY_VECTOR3,          \
+		&&OPCODE_OPERATOR_MULTIPLY_VECTOR3_FLOAT,    \
+		&&OPCODE_OPERATOR_DIVIDE_VECTOR3_FLOAT,      \
 		&&OPCODE_EXTENDS_TEST,                       \
 		&&OPCODE_IS_BUILTIN,                         \
 		&&OPCODE_SET_KEYED,                          \
@@ -464,6 +492,12 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 		return _get_default_variant_for_data_type(return_type);
 	}
 
+	// Read once, hot functions may switch to their specialized code from another thread.
+	const int *code_ptr = specialized_code_ptr.get();
+	if (!code_ptr) {
+		code_ptr = _code_ptr;
+	}
+
 	r_err.error = Callable::CallError::CALL_OK;
 
 	Variant retvalue;
@@ -510,6 +544,12 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			}
 		}
 
+		// Hot functions switch to code with specialized typed instructions.
+		uint32_t specialize_threshold = GDScriptLanguage::get_singleton()->get_specialize_call_threshold();
+		if (unlikely(call_count.get() < specialize_threshold) && call_count.increment() == specialize_threshold) {
+			_specialize();
+		}
+
 		// Add 3 here for self, class, and nil.
 		alloca_size = sizeof(Variant *) * 3 + sizeof(Variant *) * _instruction_args_size + sizeof(Variant) * _stack_size;
 
@@ -569,8 +609,9 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 	memnew_placement(&stack[ADDR_STACK_CLASS], Variant(script));
 
-	for (const KeyValue<int, Variant::Type> &E : temporary_slots) {
-		type_init_function_table[E.value](&stack[E.key]);
+	const Pair<int, Variant::Type> *temporary_slots_ptr = temporary_slots.ptr();
+	for (int i = 0; i < temporary_slots.size(); i++) {
+		type_init_function_table[temporary_slots_ptr[i].second](&stack[temporary_slots_ptr[i].first]);
 	}
 
 	String err_text;
@@ -592,10 +633,10 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 #define CHECK_SPACE(m_space) \
 	GD_ERR_BREAK((ip + m_space) > _code_size)
 
-#define GET_VARIANT_PTR(m_v, m_code_ofs)                                         \
-	Variant *m_v;                                                                \
-	m_v = _get_variant(_code_ptr[ip + m_code_ofs], p_instance, stack, err_text); \
-	if (unlikely(!m_v))                                                          \
+#define GET_VARIANT_PTR(m_v, m_code_ofs)                                        \
+	Variant *m_v;                                                               \
+	m_v = _get_variant(code_ptr[ip + m_code_ofs], p_instance, stack, err_text); \
+	if (unlikely(!m_v))                                                         \
 		OPCODE_BREAK;
 
 #else
@@ -603,7 +644,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 #define CHECK_SPACE(m_space)
 #define GET_VARIANT_PTR(m_v, m_code_ofs) \
 	Variant *m_v;                        \
-	m_v = _get_variant(_code_ptr[ip + m_code_ofs], p_instance, stack, err_text);
+	m_v = _get_variant(code_ptr[ip + m_code_ofs], p_instance, stack, err_text);
 
 #endif
 
@@ -625,25 +666,35 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 	bool awaited = false;
 #endif
 
+	// Only frames entered while sampling are on the sampling profiler's stack.
+	const bool sampling = GDScriptSamplingProfiler::is_active();
+	if (unlikely(sampling)) {
+		GDScriptSamplingProfiler::enter_function(this, &line);
+		// Function entry and loop back-edges are safe points too, release builds don't emit OPCODE_LINE.
+		if (GDScriptSamplingProfiler::is_sample_pending()) {
+			GDScriptSamplingProfiler::take_sample();
+		}
+	}
+
 #ifdef DEBUG_ENABLED
 	OPCODE_WHILE(ip < _code_size) {
-		int last_opcode = _code_ptr[ip] & INSTR_MASK;
+		int last_opcode = code_ptr[ip] & INSTR_MASK;
 #else
 	OPCODE_WHILE(true) {
 #endif
 		// Load arguments for the instruction before each instruction.
-		int instr_arg_count = ((_code_ptr[ip]) & INSTR_ARGS_MASK) >> INSTR_BITS;
+		int instr_arg_count = ((code_ptr[ip]) & INSTR_ARGS_MASK) >> INSTR_BITS;
 		for (int i = 0; i < instr_arg_count; i++) {
 			GET_VARIANT_PTR(v, i + 1);
 			instruction_args[i] = v;
 		}
 
-		OPCODE_SWITCH(_code_ptr[ip] & INSTR_MASK) {
+		OPCODE_SWITCH(code_ptr[ip] & INSTR_MASK) {
 			OPCODE(OPCODE_OPERATOR) {
 				CHECK_SPACE(5);
 
 				bool valid;
-				Variant::Operator op = (Variant::Operator)_code_ptr[ip + 4];
+				Variant::Operator op = (Variant::Operator)code_ptr[ip + 4];
 				GD_ERR_BREAK(op >= Variant::OP_MAX);
 
 				GET_INSTRUCTION_ARG(a, 0);
@@ -677,7 +728,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			OPCODE(OPCODE_OPERATOR_VALIDATED) {
 				CHECK_SPACE(5);
 
-				int operator_idx = _code_ptr[ip + 4];
+				int operator_idx = code_ptr[ip + 4];
 				GD_ERR_BREAK(operator_idx < 0 || operator_idx >= _operator_funcs_count);
 				Variant::ValidatedOperatorEvaluator operator_func = _operator_funcs_ptr[operator_idx];
 
@@ -691,6 +742,47 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			}
 			DISPATCH_OPCODE;
 
+			// Specialized forms of OPCODE_OPERATOR_VALIDATED, swapped in by GDScriptFunction::_specialize().
+			// Same layout and semantics as the validated evaluators they replace, minus the indirect call.
+#define OPCODE_OPERATOR_TYPED(m_name, m_ret, m_left, m_op, m_right)                                                     \
+	OPCODE(OPCODE_OPERATOR_##m_name) {                                                                                  \
+		CHECK_SPACE(5);                                                                                                 \
+		GET_INSTRUCTION_ARG(a, 0);                                                                                      \
+		GET_INSTRUCTION_ARG(b, 1);                                                                                      \
+		GET_INSTRUCTION_ARG(dst, 2);                                                                                    \
+		*VariantInternal::get_##m_ret(dst) = *VariantInternal::get_##m_left(a) m_op *VariantInternal::get_##m_right(b); \
+		ip += 5;                                                                                                        \
+	}                                                                                                                   \
+	DISPATCH_OPCODE
+
+			OPCODE_OPERATOR_TYPED(ADD_INT, int, int, +, int);
+			OPCODE_OPERATOR_TYPED(SUBTRACT_INT, int, int, -, int);
+			OPCODE_OPERATOR_TYPED(MULTIPLY_INT, int, int, *, int);
+			OPCODE_OPERATOR_TYPED(EQUAL_INT, bool, int, ==, int);
+			OPCODE_OPERATOR_TYPED(NOT_EQUAL_INT, bool, int, !=, int);
+			OPCODE_OPERATOR_TYPED(LESS_INT, bool, int, <, int);
+			OPCODE_OPERATOR_TYPED(LESS_EQUAL_INT, bool, int, <=, int);
+			OPCODE_OPERATOR_TYPED(GREATER_INT, bool, int, >, int);
+			OPCODE_OPERATOR_TYPED(GREATER_EQUAL_INT, bool, int, >=, int);
+			OPCODE_OPERATOR_TYPED(ADD_FLOAT, float, float, +, float);
+			OPCODE_OPERATOR_TYPED(SUBTRACT_FLOAT, float, float, -, float);
+			OPCODE_OPERATOR_TYPED(MULTIPLY_FLOAT, float, float, *, float);
+			OPCODE_OPERATOR_TYPED(DIVIDE_FLOAT, float, float, /, float);
+			OPCODE_OPERATOR_TYPED(LESS_FLOAT, bool, float, <, float);
+			OPCODE_OPERATOR_TYPED(LESS_EQUAL_FLOAT, bool, float, <=, float);
+			OPCODE_OPERATOR_TYPED(GREATER_FLOAT, bool, float, >, float);
+			OPCODE_OPERATOR_TYPED(GREATER_EQUAL_FLOAT, bool, float, >=, float);
+			OPCODE_OPERATOR_TYPED(ADD_VECTOR2, vector2, vector2, +, vector2);
+			OPCODE_OPERATOR_TYPED(SUBTRACT_VECTOR2, vector2, vector2, -, vector2);
+			OPCODE_OPERATOR_TYPED(MULTIPLY_VECTOR2, vector2, vector2, *, vector2);
+			OPCODE_OPERATOR_TYPED(MULTIPLY_VECTOR2_FLOAT, vector2, vector2, *, float);
+			OPCODE_OPERATOR_TYPED(DIVIDE_VECTOR2_FLOAT, vector2, vector2, /, float);
+			OPCODE_OPERATOR_TYPED(ADD_VECTOR3, vector3, vector3, +, vector3);
+			OPCODE_OPERATOR_TYPED(SUBTRACT_VECTOR3, vector3, vector3, -, vector3);
+			OPCODE_OPERATOR_TYPED(MULTIPLY_VECTOR3, vector3, vector3, *, vector3);
+			OPCODE_OPERATOR_TYPED(MULTIPLY_VECTOR3_FLOAT, vector3, vector3, *, float);
+			OPCODE_OPERATOR_TYPED(DIVIDE_VECTOR3_FLOAT, vector3, vector3, /, float);
+
 			OPCODE(OPCODE_EXTENDS_TEST) {
 				CHECK_SPACE(4);
 
@@ -771,7 +863,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 				GET_INSTRUCTION_ARG(value, 0);
 				GET_INSTRUCTION_ARG(dst, 1);
-				Variant::Type var_type = (Variant::Type)_code_ptr[ip + 3];
+				Variant::Type var_type = (Variant::Type)code_ptr[ip + 3];
 
 				GD_ERR_BREAK(var_type < 0 || var_type >= Variant::VARIANT_MAX);
 
@@ -813,7 +905,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				GET_INSTRUCTION_ARG(index, 1);
 				GET_INSTRUCTION_ARG(value, 2);
 
-				int index_setter = _code_ptr[ip + 4];
+				int index_setter = code_ptr[ip + 4];
 				GD_ERR_BREAK(index_setter < 0 || index_setter >= _keyed_setters_count);
 				const Variant::ValidatedKeyedSetter setter = _keyed_setters_ptr[index_setter];
 
@@ -843,7 +935,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				GET_INSTRUCTION_ARG(index, 1);
 				GET_INSTRUCTION_ARG(value, 2);
 
-				int index_setter = _code_ptr[ip + 4];
+				int index_setter = code_ptr[ip + 4];
 				GD_ERR_BREAK(index_setter < 0 || index_setter >= _indexed_setters_count);
 				const Variant::ValidatedIndexedSetter setter = _indexed_setters_ptr[index_setter];
 
@@ -907,7 +999,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				GET_INSTRUCTION_ARG(key, 1);
 				GET_INSTRUCTION_ARG(dst, 2);
 
-				int index_getter = _code_ptr[ip + 4];
+				int index_getter = code_ptr[ip + 4];
 				GD_ERR_BREAK(index_getter < 0 || index_getter >= _keyed_getters_count);
 				const Variant::ValidatedKeyedGetter getter = _keyed_getters_ptr[index_getter];
 
@@ -943,7 +1035,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				GET_INSTRUCTION_ARG(index, 1);
 				GET_INSTRUCTION_ARG(dst, 2);
 
-				int index_getter = _code_ptr[ip + 4];
+				int index_getter = code_ptr[ip + 4];
 				GD_ERR_BREAK(index_getter < 0 || index_getter >= _indexed_getters_count);
 				const Variant::ValidatedIndexedGetter getter = _indexed_getters_ptr[index_getter];
 
@@ -974,7 +1066,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				GET_INSTRUCTION_ARG(dst, 0);
 				GET_INSTRUCTION_ARG(value, 1);
 
-				int indexname = _code_ptr[ip + 3];
+				int indexname = code_ptr[ip + 3];
 
 				GD_ERR_BREAK(indexname < 0 || indexname >= _global_names_count);
 				const StringName *index = &_global_names_ptr[indexname];
@@ -999,7 +1091,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				GET_INSTRUCTION_ARG(dst, 0);
 				GET_INSTRUCTION_ARG(value, 1);
 
-				int index_setter = _code_ptr[ip + 3];
+				int index_setter = code_ptr[ip + 3];
 				GD_ERR_BREAK(index_setter < 0 || index_setter >= _setters_count);
 				const Variant::ValidatedSetter setter = _setters_ptr[index_setter];
 
@@ -1014,7 +1106,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				GET_INSTRUCTION_ARG(src, 0);
 				GET_INSTRUCTION_ARG(dst, 1);
 
-				int indexname = _code_ptr[ip + 3];
+				int indexname = code_ptr[ip + 3];
 
 				GD_ERR_BREAK(indexname < 0 || indexname >= _global_names_count);
 				const StringName *index = &_global_names_ptr[indexname];
@@ -1048,7 +1140,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				GET_INSTRUCTION_ARG(src, 0);
 				GET_INSTRUCTION_ARG(dst, 1);
 
-				int index_getter = _code_ptr[ip + 3];
+				int index_getter = code_ptr[ip + 3];
 				GD_ERR_BREAK(index_getter < 0 || index_getter >= _getters_count);
 				const Variant::ValidatedGetter getter = _getters_ptr[index_getter];
 
@@ -1060,7 +1152,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			OPCODE(OPCODE_SET_MEMBER) {
 				CHECK_SPACE(3);
 				GET_INSTRUCTION_ARG(src, 0);
-				int indexname = _code_ptr[ip + 2];
+				int indexname = code_ptr[ip + 2];
 				GD_ERR_BREAK(indexname < 0 || indexname >= _global_names_count);
 				const StringName *index = &_global_names_ptr[indexname];
 
@@ -1084,7 +1176,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			OPCODE(OPCODE_GET_MEMBER) {
 				CHECK_SPACE(3);
 				GET_INSTRUCTION_ARG(dst, 0);
-				int indexname = _code_ptr[ip + 2];
+				int indexname = code_ptr[ip + 2];
 				GD_ERR_BREAK(indexname < 0 || indexname >= _global_names_count);
 				const StringName *index = &_global_names_ptr[indexname];
 #ifndef DEBUG_ENABLED
@@ -1136,7 +1228,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				GET_INSTRUCTION_ARG(dst, 0);
 				GET_INSTRUCTION_ARG(src, 1);
 
-				Variant::Type var_type = (Variant::Type)_code_ptr[ip + 3];
+				Variant::Type var_type = (Variant::Type)code_ptr[ip + 3];
 				GD_ERR_BREAK(var_type < 0 || var_type >= Variant::VARIANT_MAX);
 
 				if (src->get_type() != var_type) {
@@ -1266,7 +1358,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				CHECK_SPACE(4);
 				GET_INSTRUCTION_ARG(src, 0);
 				GET_INSTRUCTION_ARG(dst, 1);
-				Variant::Type to_type = (Variant::Type)_code_ptr[ip + 3];
+				Variant::Type to_type = (Variant::Type)code_ptr[ip + 3];
 
 				GD_ERR_BREAK(to_type < 0 || to_type >= Variant::VARIANT_MAX);
 
@@ -1376,9 +1468,9 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 				ip += instr_arg_count;
 
-				int argc = _code_ptr[ip + 1];
+				int argc = code_ptr[ip + 1];
 
-				Variant::Type t = Variant::Type(_code_ptr[ip + 2]);
+				Variant::Type t = Variant::Type(code_ptr[ip + 2]);
 				Variant **argptrs = instruction_args;
 
 				GET_INSTRUCTION_ARG(dst, argc);
@@ -1402,9 +1494,9 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 				ip += instr_arg_count;
 
-				int argc = _code_ptr[ip + 1];
+				int argc = code_ptr[ip + 1];
 
-				int constructor_idx = _code_ptr[ip + 2];
+				int constructor_idx = code_ptr[ip + 2];
 				GD_ERR_BREAK(constructor_idx < 0 || constructor_idx >= _constructors_count);
 				Variant::ValidatedConstructor constructor = _constructors_ptr[constructor_idx];
 
@@ -1422,7 +1514,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				CHECK_SPACE(1 + instr_arg_count);
 				ip += instr_arg_count;
 
-				int argc = _code_ptr[ip + 1];
+				int argc = code_ptr[ip + 1];
 				Array array;
 				array.resize(argc);
 
@@ -1443,11 +1535,11 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				CHECK_SPACE(3 + instr_arg_count);
 				ip += instr_arg_count;
 
-				int argc = _code_ptr[ip + 1];
+				int argc = code_ptr[ip + 1];
 
 				GET_INSTRUCTION_ARG(script_type, argc + 1);
-				Variant::Type builtin_type = (Variant::Type)_code_ptr[ip + 2];
-				int native_type_idx = _code_ptr[ip + 3];
+				Variant::Type builtin_type = (Variant::Type)code_ptr[ip + 2];
+				int native_type_idx = code_ptr[ip + 3];
 				GD_ERR_BREAK(native_type_idx < 0 || native_type_idx >= _global_names_count);
 				const StringName native_type = _global_names_ptr[native_type_idx];
 
@@ -1473,7 +1565,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 				ip += instr_arg_count;
 
-				int argc = _code_ptr[ip + 1];
+				int argc = code_ptr[ip + 1];
 				Dictionary dict;
 
 				for (int i = 0; i < argc; i++) {
@@ -1494,17 +1586,17 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			OPCODE(OPCODE_CALL_RETURN)
 			OPCODE(OPCODE_CALL) {
 				CHECK_SPACE(3 + instr_arg_count);
-				bool call_ret = (_code_ptr[ip] & INSTR_MASK) != OPCODE_CALL;
+				bool call_ret = (code_ptr[ip] & INSTR_MASK) != OPCODE_CALL;
 #ifdef DEBUG_ENABLED
-				bool call_async = (_code_ptr[ip] & INSTR_MASK) == OPCODE_CALL_ASYNC;
+				bool call_async = (code_ptr[ip] & INSTR_MASK) == OPCODE_CALL_ASYNC;
 #endif
 
 				ip += instr_arg_count;
 
-				int argc = _code_ptr[ip + 1];
+				int argc = code_ptr[ip + 1];
 				GD_ERR_BREAK(argc < 0);
 
-				int methodname_idx = _code_ptr[ip + 2];
+				int methodname_idx = code_ptr[ip + 2];
 				GD_ERR_BREAK(methodname_idx < 0 || methodname_idx >= _global_names_count);
 				const StringName *methodname = &_global_names_ptr[methodname_idx];
 
@@ -1593,14 +1685,14 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			OPCODE(OPCODE_CALL_METHOD_BIND)
 			OPCODE(OPCODE_CALL_METHOD_BIND_RET) {
 				CHECK_SPACE(3 + instr_arg_count);
-				bool call_ret = (_code_ptr[ip] & INSTR_MASK) == OPCODE_CALL_METHOD_BIND_RET;
+				bool call_ret = (code_ptr[ip] & INSTR_MASK) == OPCODE_CALL_METHOD_BIND_RET;
 
 				ip += instr_arg_count;
 
-				int argc = _code_ptr[ip + 1];
+				int argc = code_ptr[ip + 1];
 				GD_ERR_BREAK(argc < 0);
-				GD_ERR_BREAK(_code_ptr[ip + 2] < 0 || _code_ptr[ip + 2] >= _methods_count);
-				MethodBind *method = _methods_ptr[_code_ptr[ip + 2]];
+				GD_ERR_BREAK(code_ptr[ip + 2] < 0 || code_ptr[ip + 2] >= _methods_count);
+				MethodBind *method = _methods_ptr[code_ptr[ip + 2]];
 
 				GET_INSTRUCTION_ARG(base, argc);
 
@@ -1634,6 +1726,9 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				} else {
 					method->call(base_obj, (const Variant **)argptrs, argc, err);
 				}
+				if (unlikely(sampling) && GDScriptSamplingProfiler::is_sample_pending()) {
+					GDScriptSamplingProfiler::take_sample(method);
+				}
 
 #ifdef DEBUG_ENABLED
 				if (GDScriptLanguage::get_singleton()->profiling) {
@@ -1675,14 +1770,14 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 				ip += instr_arg_count;
 
-				GD_ERR_BREAK(_code_ptr[ip + 1] < 0 || _code_ptr[ip + 1] >= Variant::VARIANT_MAX);
-				Variant::Type builtin_type = (Variant::Type)_code_ptr[ip + 1];
+				GD_ERR_BREAK(code_ptr[ip + 1] < 0 || code_ptr[ip + 1] >= Variant::VARIANT_MAX);
+				Variant::Type builtin_type = (Variant::Type)code_ptr[ip + 1];
 
-				int methodname_idx = _code_ptr[ip + 2];
+				int methodname_idx = code_ptr[ip + 2];
 				GD_ERR_BREAK(methodname_idx < 0 || methodname_idx >= _global_names_count);
 				const StringName *methodname = &_global_names_ptr[methodname_idx];
 
-				int argc = _code_ptr[ip + 3];
+				int argc = code_ptr[ip + 3];
 				GD_ERR_BREAK(argc < 0);
 
 				GET_INSTRUCTION_ARG(ret, argc);
@@ -1720,10 +1815,10 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 				ip += instr_arg_count;
 
-				GD_ERR_BREAK(_code_ptr[ip + 1] < 0 || _code_ptr[ip + 1] >= _methods_count);
-				MethodBind *method = _methods_ptr[_code_ptr[ip + 1]];
+				GD_ERR_BREAK(code_ptr[ip + 1] < 0 || code_ptr[ip + 1] >= _methods_count);
+				MethodBind *method = _methods_ptr[code_ptr[ip + 1]];
 
-				int argc = _code_ptr[ip + 2];
+				int argc = code_ptr[ip + 2];
 				GD_ERR_BREAK(argc < 0);
 
 				GET_INSTRUCTION_ARG(ret, argc);
@@ -1761,11 +1856,11 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 	OPCODE(OPCODE_CALL_PTRCALL_##m_type) {                                           \
 		CHECK_SPACE(3 + instr_arg_count);                                            \
 		ip += instr_arg_count;                                                       \
-		int argc = _code_ptr[ip + 1];                                                \
+		int argc = code_ptr[ip + 1];                                                 \
 		GD_ERR_BREAK(argc < 0);                                                      \
 		GET_INSTRUCTION_ARG(base, argc);                                             \
-		GD_ERR_BREAK(_code_ptr[ip + 2] < 0 || _code_ptr[ip + 2] >= _methods_count);  \
-		MethodBind *method = _methods_ptr[_code_ptr[ip + 2]];                        \
+		GD_ERR_BREAK(code_ptr[ip + 2] < 0 || code_ptr[ip + 2] >= _methods_count);    \
+		MethodBind *method = _methods_ptr[code_ptr[ip + 2]];                         \
 		bool freed = false;                                                          \
 		Object *base_obj = base->get_validated_object_with_check(freed);             \
 		if (freed) {                                                                 \
@@ -1788,6 +1883,9 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 		VariantInternal::initialize(ret, Variant::m_type);                           \
 		void *ret_opaque = VariantInternal::OP_GET_##m_type(ret);                    \
 		method->ptrcall(base_obj, argptrs, ret_opaque);                              \
+		if (unlikely(sampling) && GDScriptSamplingProfiler::is_sample_pending()) {   \
+			GDScriptSamplingProfiler::take_sample(method);                           \
+		}                                                                            \
 		if (GDScriptLanguage::get_singleton()->profiling) {                          \
 			function_call_time += OS::get_singleton()->get_ticks_usec() - call_time; \
 		}                                                                            \
@@ -1795,25 +1893,28 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 	}                                                                                \
 	DISPATCH_OPCODE
 #else
-#define OPCODE_CALL_PTR(m_type)                                                   \
-	OPCODE(OPCODE_CALL_PTRCALL_##m_type) {                                        \
-		CHECK_SPACE(3 + instr_arg_count);                                         \
-		ip += instr_arg_count;                                                    \
-		int argc = _code_ptr[ip + 1];                                             \
-		GET_INSTRUCTION_ARG(base, argc);                                          \
-		MethodBind *method = _methods_ptr[_code_ptr[ip + 2]];                     \
-		Object *base_obj = *VariantInternal::get_object(base);                    \
-		const void **argptrs = call_args_ptr;                                     \
-		for (int i = 0; i < argc; i++) {                                          \
-			GET_INSTRUCTION_ARG(v, i);                                            \
-			argptrs[i] = VariantInternal::get_opaque_pointer((const Variant *)v); \
-		}                                                                         \
-		GET_INSTRUCTION_ARG(ret, argc + 1);                                       \
-		VariantInternal::initialize(ret, Variant::m_type);                        \
-		void *ret_opaque = VariantInternal::OP_GET_##m_type(ret);                 \
-		method->ptrcall(base_obj, argptrs, ret_opaque);                           \
-		ip += 3;                                                                  \
-	}                                                                             \
+#define OPCODE_CALL_PTR(m_type)                                                    \
+	OPCODE(OPCODE_CALL_PTRCALL_##m_type) {                                         \
+		CHECK_SPACE(3 + instr_arg_count);                                          \
+		ip += instr_arg_count;                                                     \
+		int argc = code_ptr[ip + 1];                                               \
+		GET_INSTRUCTION_ARG(base, argc);                                           \
+		MethodBind *method = _methods_ptr[code_ptr[ip + 2]];                       \
+		Object *base_obj = *VariantInternal::get_object(base);                     \
+		const void **argptrs = call_args_ptr;                                      \
+		for (int i = 0; i < argc; i++) {                                           \
+			GET_INSTRUCTION_ARG(v, i);                                             \
+			argptrs[i] = VariantInternal::get_opaque_pointer((const Variant *)v);  \
+		}                                                                          \
+		GET_INSTRUCTION_ARG(ret, argc + 1);                                        \
+		VariantInternal::initialize(ret, Variant::m_type);                         \
+		void *ret_opaque = VariantInternal::OP_GET_##m_type(ret);                  \
+		method->ptrcall(base_obj, argptrs, ret_opaque);                            \
+		if (unlikely(sampling) && GDScriptSamplingProfiler::is_sample_pending()) { \
+			GDScriptSamplingProfiler::take_sample(method);                         \
+		}                                                                          \
+		ip += 3;                                                                   \
+	}                                                                              \
 	DISPATCH_OPCODE
 #endif
 
@@ -1855,11 +1956,11 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 				ip += instr_arg_count;
 
-				int argc = _code_ptr[ip + 1];
+				int argc = code_ptr[ip + 1];
 				GD_ERR_BREAK(argc < 0);
 
-				GD_ERR_BREAK(_code_ptr[ip + 2] < 0 || _code_ptr[ip + 2] >= _methods_count);
-				MethodBind *method = _methods_ptr[_code_ptr[ip + 2]];
+				GD_ERR_BREAK(code_ptr[ip + 2] < 0 || code_ptr[ip + 2] >= _methods_count);
+				MethodBind *method = _methods_ptr[code_ptr[ip + 2]];
 
 				GET_INSTRUCTION_ARG(base, argc);
 #ifdef DEBUG_ENABLED
@@ -1895,6 +1996,9 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				Object **ret_opaque = VariantInternal::get_object(ret);
 				method->ptrcall(base_obj, argptrs, ret_opaque);
 				VariantInternal::object_assign(ret, *ret_opaque); // Set so ID is correct too.
+				if (unlikely(sampling) && GDScriptSamplingProfiler::is_sample_pending()) {
+					GDScriptSamplingProfiler::take_sample(method);
+				}
 
 #ifdef DEBUG_ENABLED
 				if (GDScriptLanguage::get_singleton()->profiling) {
@@ -1909,11 +2013,11 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 				ip += instr_arg_count;
 
-				int argc = _code_ptr[ip + 1];
+				int argc = code_ptr[ip + 1];
 				GD_ERR_BREAK(argc < 0);
 
-				GD_ERR_BREAK(_code_ptr[ip + 2] < 0 || _code_ptr[ip + 2] >= _methods_count);
-				MethodBind *method = _methods_ptr[_code_ptr[ip + 2]];
+				GD_ERR_BREAK(code_ptr[ip + 2] < 0 || code_ptr[ip + 2] >= _methods_count);
+				MethodBind *method = _methods_ptr[code_ptr[ip + 2]];
 
 				GET_INSTRUCTION_ARG(base, argc);
 #ifdef DEBUG_ENABLED
@@ -1946,6 +2050,9 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				GET_INSTRUCTION_ARG(ret, argc + 1);
 				VariantInternal::initialize(ret, Variant::NIL);
 				method->ptrcall(base_obj, argptrs, nullptr);
+				if (unlikely(sampling) && GDScriptSamplingProfiler::is_sample_pending()) {
+					GDScriptSamplingProfiler::take_sample(method);
+				}
 
 #ifdef DEBUG_ENABLED
 				if (GDScriptLanguage::get_singleton()->profiling) {
@@ -1961,13 +2068,13 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 				ip += instr_arg_count;
 
-				int argc = _code_ptr[ip + 1];
+				int argc = code_ptr[ip + 1];
 				GD_ERR_BREAK(argc < 0);
 
 				GET_INSTRUCTION_ARG(base, argc);
 
-				GD_ERR_BREAK(_code_ptr[ip + 2] < 0 || _code_ptr[ip + 2] >= _builtin_methods_count);
-				Variant::ValidatedBuiltInMethod method = _builtin_methods_ptr[_code_ptr[ip + 2]];
+				GD_ERR_BREAK(code_ptr[ip + 2] < 0 || code_ptr[ip + 2] >= _builtin_methods_count);
+				Variant::ValidatedBuiltInMethod method = _builtin_methods_ptr[code_ptr[ip + 2]];
 				Variant **argptrs = instruction_args;
 
 #ifdef DEBUG_ENABLED
@@ -1995,11 +2102,11 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 				ip += instr_arg_count;
 
-				int argc = _code_ptr[ip + 1];
+				int argc = code_ptr[ip + 1];
 				GD_ERR_BREAK(argc < 0);
 
-				GD_ERR_BREAK(_code_ptr[ip + 2] < 0 || _code_ptr[ip + 2] >= _global_names_count);
-				StringName function = _global_names_ptr[_code_ptr[ip + 2]];
+				GD_ERR_BREAK(code_ptr[ip + 2] < 0 || code_ptr[ip + 2] >= _global_names_count);
+				StringName function = _global_names_ptr[code_ptr[ip + 2]];
 
 				Variant **argptrs = instruction_args;
 
@@ -2029,11 +2136,11 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 				ip += instr_arg_count;
 
-				int argc = _code_ptr[ip + 1];
+				int argc = code_ptr[ip + 1];
 				GD_ERR_BREAK(argc < 0);
 
-				GD_ERR_BREAK(_code_ptr[ip + 2] < 0 || _code_ptr[ip + 2] >= _utilities_count);
-				Variant::ValidatedUtilityFunction function = _utilities_ptr[_code_ptr[ip + 2]];
+				GD_ERR_BREAK(code_ptr[ip + 2] < 0 || code_ptr[ip + 2] >= _utilities_count);
+				Variant::ValidatedUtilityFunction function = _utilities_ptr[code_ptr[ip + 2]];
 
 				Variant **argptrs = instruction_args;
 
@@ -2050,11 +2157,11 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 				ip += instr_arg_count;
 
-				int argc = _code_ptr[ip + 1];
+				int argc = code_ptr[ip + 1];
 				GD_ERR_BREAK(argc < 0);
 
-				GD_ERR_BREAK(_code_ptr[ip + 2] < 0 || _code_ptr[ip + 2] >= _gds_utilities_count);
-				GDScriptUtilityFunctions::FunctionPtr function = _gds_utilities_ptr[_code_ptr[ip + 2]];
+				GD_ERR_BREAK(code_ptr[ip + 2] < 0 || code_ptr[ip + 2] >= _gds_utilities_count);
+				GDScriptUtilityFunctions::FunctionPtr function = _gds_utilities_ptr[code_ptr[ip + 2]];
 
 				Variant **argptrs = instruction_args;
 
@@ -2085,10 +2192,10 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 				ip += instr_arg_count;
 
-				int argc = _code_ptr[ip + 1];
+				int argc = code_ptr[ip + 1];
 				GD_ERR_BREAK(argc < 0);
 
-				int self_fun = _code_ptr[ip + 2];
+				int self_fun = code_ptr[ip + 2];
 #ifdef DEBUG_ENABLED
 				if (self_fun < 0 || self_fun >= _global_names_count) {
 					err_text = "compiler bug, function name not found";
@@ -2192,9 +2299,11 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 					gdfs->function = this;
 
 					gdfs->state.stack.resize(alloca_size);
-					//copy variant stack
+					// Move the variant stack instead of copying it, Variants can be relocated bitwise.
+					// The slots left behind are reset, so the teardown below has nothing to release.
+					memcpy((void *)gdfs->state.stack.ptrw(), (const void *)stack, sizeof(Variant) * _stack_size);
 					for (int i = 0; i < _stack_size; i++) {
-						memnew_placement(&gdfs->state.stack.write[sizeof(Variant) * i], Variant(stack[i]));
+						memnew_placement(&stack[i], Variant);
 					}
 					gdfs->state.stack_size = _stack_size;
 					gdfs->state.alloca_size = alloca_size;
@@ -2254,10 +2363,10 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 				ip += instr_arg_count;
 
-				int captures_count = _code_ptr[ip + 1];
+				int captures_count = code_ptr[ip + 1];
 				GD_ERR_BREAK(captures_count < 0);
 
-				int lambda_index = _code_ptr[ip + 2];
+				int lambda_index = code_ptr[ip + 2];
 				GD_ERR_BREAK(lambda_index < 0 || lambda_index >= _lambdas_count);
 				GDScriptFunction *lambda = _lambdas_ptr[lambda_index];
 
@@ -2279,9 +2388,12 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 			OPCODE(OPCODE_JUMP) {
 				CHECK_SPACE(2);
-				int to = _code_ptr[ip + 1];
+				int to = code_ptr[ip + 1];
 
 				GD_ERR_BREAK(to < 0 || to > _code_size);
+				if (unlikely(sampling) && to < ip && GDScriptSamplingProfiler::is_sample_pending()) {
+					GDScriptSamplingProfiler::take_sample();
+				}
 				ip = to;
 			}
 			DISPATCH_OPCODE;
@@ -2294,7 +2406,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				bool result = test->booleanize();
 
 				if (result) {
-					int to = _code_ptr[ip + 2];
+					int to = code_ptr[ip + 2];
 					GD_ERR_BREAK(to < 0 || to > _code_size);
 					ip = to;
 				} else {
@@ -2311,7 +2423,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				bool result = test->booleanize();
 
 				if (!result) {
-					int to = _code_ptr[ip + 2];
+					int to = code_ptr[ip + 2];
 					GD_ERR_BREAK(to < 0 || to > _code_size);
 					ip = to;
 				} else {
@@ -2340,7 +2452,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				CHECK_SPACE(3);
 				GET_INSTRUCTION_ARG(r, 0);
 
-				Variant::Type ret_type = (Variant::Type)_code_ptr[ip + 2];
+				Variant::Type ret_type = (Variant::Type)code_ptr[ip + 2];
 				GD_ERR_BREAK(ret_type < 0 || ret_type >= Variant::VARIANT_MAX);
 
 				if (r->get_type() != ret_type) {
@@ -2372,8 +2484,8 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				GET_INSTRUCTION_ARG(r, 0);
 
 				GET_INSTRUCTION_ARG(script_type, 1);
-				Variant::Type builtin_type = (Variant::Type)_code_ptr[ip + 3];
-				int native_type_idx = _code_ptr[ip + 4];
+				Variant::Type builtin_type = (Variant::Type)code_ptr[ip + 3];
+				int native_type_idx = code_ptr[ip + 4];
 				GD_ERR_BREAK(native_type_idx < 0 || native_type_idx >= _global_names_count);
 				const StringName native_type = _global_names_ptr[native_type_idx];
 
@@ -2527,7 +2639,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 						OPCODE_BREAK;
 					}
 #endif
-					int jumpto = _code_ptr[ip + 4];
+					int jumpto = code_ptr[ip + 4];
 					GD_ERR_BREAK(jumpto < 0 || jumpto > _code_size);
 					ip = jumpto;
 				} else {
@@ -2565,7 +2677,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 					ip += 5;
 				} else {
 					// Jump to end of loop.
-					int jumpto = _code_ptr[ip + 4];
+					int jumpto = code_ptr[ip + 4];
 					GD_ERR_BREAK(jumpto < 0 || jumpto > _code_size);
 					ip = jumpto;
 				}
@@ -2592,7 +2704,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 					ip += 5;
 				} else {
 					// Jump to end of loop.
-					int jumpto = _code_ptr[ip + 4];
+					int jumpto = code_ptr[ip + 4];
 					GD_ERR_BREAK(jumpto < 0 || jumpto > _code_size);
 					ip = jumpto;
 				}
@@ -2619,7 +2731,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 					ip += 5;
 				} else {
 					// Jump to end of loop.
-					int jumpto = _code_ptr[ip + 4];
+					int jumpto = code_ptr[ip + 4];
 					GD_ERR_BREAK(jumpto < 0 || jumpto > _code_size);
 					ip = jumpto;
 				}
@@ -2646,7 +2758,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 					ip += 5;
 				} else {
 					// Jump to end of loop.
-					int jumpto = _code_ptr[ip + 4];
+					int jumpto = code_ptr[ip + 4];
 					GD_ERR_BREAK(jumpto < 0 || jumpto > _code_size);
 					ip = jumpto;
 				}
@@ -2678,7 +2790,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 					ip += 5;
 				} else {
 					// Jump to end of loop.
-					int jumpto = _code_ptr[ip + 4];
+					int jumpto = code_ptr[ip + 4];
 					GD_ERR_BREAK(jumpto < 0 || jumpto > _code_size);
 					ip = jumpto;
 				}
@@ -2710,7 +2822,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 					ip += 5;
 				} else {
 					// Jump to end of loop.
-					int jumpto = _code_ptr[ip + 4];
+					int jumpto = code_ptr[ip + 4];
 					GD_ERR_BREAK(jumpto < 0 || jumpto > _code_size);
 					ip = jumpto;
 				}
@@ -2737,7 +2849,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 					ip += 5;
 				} else {
 					// Jump to end of loop.
-					int jumpto = _code_ptr[ip + 4];
+					int jumpto = code_ptr[ip + 4];
 					GD_ERR_BREAK(jumpto < 0 || jumpto > _code_size);
 					ip = jumpto;
 				}
@@ -2762,7 +2874,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 					ip += 5;
 				} else {
 					// Jump to end of loop.
-					int jumpto = _code_ptr[ip + 4];
+					int jumpto = code_ptr[ip + 4];
 					GD_ERR_BREAK(jumpto < 0 || jumpto > _code_size);
 					ip = jumpto;
 				}
@@ -2788,7 +2900,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 					ip += 5;
 				} else {
 					// Jump to end of loop.
-					int jumpto = _code_ptr[ip + 4];
+					int jumpto = code_ptr[ip + 4];
 					GD_ERR_BREAK(jumpto < 0 || jumpto > _code_size);
 					ip = jumpto;
 				}
@@ -2810,7 +2922,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			*it = array->get(0);                                                                                           \
 			ip += 5;                                                                                                       \
 		} else {                                                                                                           \
-			int jumpto = _code_ptr[ip + 4];                                                                                \
+			int jumpto = code_ptr[ip + 4];                                                                                 \
 			GD_ERR_BREAK(jumpto<0 || jumpto> _code_size);                                                                  \
 			ip = jumpto;                                                                                                   \
 		}                                                                                                                  \
@@ -2865,7 +2977,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				}
 #endif
 				if (!has_next.booleanize()) {
-					int jumpto = _code_ptr[ip + 4];
+					int jumpto = code_ptr[ip + 4];
 					GD_ERR_BREAK(jumpto < 0 || jumpto > _code_size);
 					ip = jumpto;
 				} else {
@@ -2897,7 +3009,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 						OPCODE_BREAK;
 					}
 #endif
-					int jumpto = _code_ptr[ip + 4];
+					int jumpto = code_ptr[ip + 4];
 					GD_ERR_BREAK(jumpto < 0 || jumpto > _code_size);
 					ip = jumpto;
 				} else {
@@ -2927,7 +3039,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				(*count)++;
 
 				if (*count >= size) {
-					int jumpto = _code_ptr[ip + 4];
+					int jumpto = code_ptr[ip + 4];
 					GD_ERR_BREAK(jumpto < 0 || jumpto > _code_size);
 					ip = jumpto;
 				} else {
@@ -2951,7 +3063,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				(*count)++;
 
 				if (*count >= size) {
-					int jumpto = _code_ptr[ip + 4];
+					int jumpto = code_ptr[ip + 4];
 					GD_ERR_BREAK(jumpto < 0 || jumpto > _code_size);
 					ip = jumpto;
 				} else {
@@ -2975,7 +3087,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				(*count)++;
 
 				if (*count >= bounds->y) {
-					int jumpto = _code_ptr[ip + 4];
+					int jumpto = code_ptr[ip + 4];
 					GD_ERR_BREAK(jumpto < 0 || jumpto > _code_size);
 					ip = jumpto;
 				} else {
@@ -2999,7 +3111,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				(*count)++;
 
 				if (*count >= bounds->y) {
-					int jumpto = _code_ptr[ip + 4];
+					int jumpto = code_ptr[ip + 4];
 					GD_ERR_BREAK(jumpto < 0 || jumpto > _code_size);
 					ip = jumpto;
 				} else {
@@ -3023,7 +3135,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				*count += bounds->z;
 
 				if ((bounds->z < 0 && *count <= bounds->y) || (bounds->z > 0 && *count >= bounds->y)) {
-					int jumpto = _code_ptr[ip + 4];
+					int jumpto = code_ptr[ip + 4];
 					GD_ERR_BREAK(jumpto < 0 || jumpto > _code_size);
 					ip = jumpto;
 				} else {
@@ -3047,7 +3159,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				*count += bounds->z;
 
 				if ((bounds->z < 0 && *count <= bounds->y) || (bounds->z > 0 && *count >= bounds->y)) {
-					int jumpto = _code_ptr[ip + 4];
+					int jumpto = code_ptr[ip + 4];
 					GD_ERR_BREAK(jumpto < 0 || jumpto > _code_size);
 					ip = jumpto;
 				} else {
@@ -3070,7 +3182,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				(*idx)++;
 
 				if (*idx >= str->length()) {
-					int jumpto = _code_ptr[ip + 4];
+					int jumpto = code_ptr[ip + 4];
 					GD_ERR_BREAK(jumpto < 0 || jumpto > _code_size);
 					ip = jumpto;
 				} else {
@@ -3092,7 +3204,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				const Variant *next = dict->next(counter);
 
 				if (!next) {
-					int jumpto = _code_ptr[ip + 4];
+					int jumpto = code_ptr[ip + 4];
 					GD_ERR_BREAK(jumpto < 0 || jumpto > _code_size);
 					ip = jumpto;
 				} else {
@@ -3116,7 +3228,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				(*idx)++;
 
 				if (*idx >= array->size()) {
-					int jumpto = _code_ptr[ip + 4];
+					int jumpto = code_ptr[ip + 4];
 					GD_ERR_BREAK(jumpto < 0 || jumpto > _code_size);
 					ip = jumpto;
 				} else {
@@ -3137,7 +3249,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 		int64_t *idx = VariantInternal::get_int(counter);                                           \
 		(*idx)++;                                                                                   \
 		if (*idx >= array->size()) {                                                                \
-			int jumpto = _code_ptr[ip + 4];                                                         \
+			int jumpto = code_ptr[ip + 4];                                                          \
 			GD_ERR_BREAK(jumpto<0 || jumpto> _code_size);                                           \
 			ip = jumpto;                                                                            \
 		} else {                                                                                    \
@@ -3196,7 +3308,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				}
 #endif
 				if (!has_next.booleanize()) {
-					int jumpto = _code_ptr[ip + 4];
+					int jumpto = code_ptr[ip + 4];
 					GD_ERR_BREAK(jumpto < 0 || jumpto > _code_size);
 					ip = jumpto;
 				} else {
@@ -3216,7 +3328,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 			OPCODE(OPCODE_STORE_GLOBAL) {
 				CHECK_SPACE(3);
-				int global_idx = _code_ptr[ip + 2];
+				int global_idx = code_ptr[ip + 2];
 				GD_ERR_BREAK(global_idx < 0 || global_idx >= GDScriptLanguage::get_singleton()->get_global_array_size());
 
 				GET_INSTRUCTION_ARG(dst, 0);
@@ -3228,7 +3340,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 			OPCODE(OPCODE_STORE_NAMED_GLOBAL) {
 				CHECK_SPACE(3);
-				int globalname_idx = _code_ptr[ip + 2];
+				int globalname_idx = code_ptr[ip + 2];
 				GD_ERR_BREAK(globalname_idx < 0 || globalname_idx >= _global_names_count);
 				const StringName *globalname = &_global_names_ptr[globalname_idx];
 
@@ -3292,7 +3404,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 				if (!result) {
 					String message_str;
-					if (_code_ptr[ip + 2] != 0) {
+					if (code_ptr[ip + 2] != 0) {
 						GET_INSTRUCTION_ARG(message, 1);
 						message_str = *message;
 					}
@@ -3322,7 +3434,11 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			OPCODE(OPCODE_LINE) {
 				CHECK_SPACE(2);
 
-				line = _code_ptr[ip + 1];
+				if (unlikely(sampling) && GDScriptSamplingProfiler::is_sample_pending()) {
+					GDScriptSamplingProfiler::take_sample();
+				}
+
+				line = code_ptr[ip + 1];
 				ip += 2;
 
 				if (EngineDebugger::is_active()) {
@@ -3360,7 +3476,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 #if 0 // Enable for debugging.
 			default: {
-				err_text = "Illegal opcode " + itos(_code_ptr[ip]) + " at address " + itos(ip);
+				err_text = "Illegal opcode " + itos(code_ptr[ip]) + " at address " + itos(ip);
 				OPCODE_BREAK;
 			}
 #endif
@@ -3436,5 +3552,9 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 	}
 #endif
 
+	if (unlikely(sampling)) {
+		GDScriptSamplingProfiler::exit_function();
+	}
+
 	return retvalue;
 }
@@ -36,6 +36,7 @@
 #include "core/io/resource_loader.h"
 #include "gdscript.h"
 #include "gdscript_analyzer.h"
+#include "gdscript_bytecode_cache.h"
 #include "gdscript_cache.h"
 #include "gdscript_tokenizer.h"
 #include "gdscript_utility_functions.h"
@@ -85,8 +86,18 @@ public:
 			return;
 		}
 
-		// TODO: Re-add compiled GDScript on export.
-		return;
+		// The source stays in the pack, it's what the cache is validated against
+		// and what gets compiled if the cache can't be used.
+		Error err;
+		Ref<GDScript> script = GDScriptCache::get_full_script(p_path, err);
+		if (err != OK || script.is_null()) {
+			return;
+		}
+
+		Vector<uint8_t> bytecode = script->get_as_byte_code();
+		if (!bytecode.is_empty()) {
+			add_file(GDScriptBytecodeCache::get_cache_path(p_path), bytecode, false);
+		}
 	}
 };
 
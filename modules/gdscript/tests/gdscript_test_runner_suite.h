@@ -31,6 +31,9 @@
 #ifndef GDSCRIPT_TEST_RUNNER_SUITE_H
 #define GDSCRIPT_TEST_RUNNER_SUITE_H
 
+#include "../gdscript_bytecode_cache.h"
+#include "../gdscript_sampling_profiler.h"
+#include "core/os/os.h"
 #include "gdscript_test_runner.h"
 #include "tests/test_macros.h"
 
@@ -69,6 +72,227 @@ func _init():
 	CHECK_MESSAGE(int(ref_counted->get_meta("result")) == 42, "The script should assign object metadata successfully.");
 }
 
+TEST_CASE("[Modules][GDScript] Load cached bytecode and run it") {
+	const String source = R"(
+extends RefCounted
+
+const OFFSET = 2
+var values := [1, 2, 3]
+
+class Accumulator:
+	var total := 0
+
+	func add(p_value: int) -> void:
+		total += p_value
+
+func _init():
+	var accumulator := Accumulator.new()
+	var scale := func(p_value): return p_value * 10
+	for value in values:
+		accumulator.add(scale.call(value) + OFFSET)
+	set_meta("result", accumulator.total)
+	set_meta("text", str(accumulator.total).pad_zeros(4))
+)";
+
+	Ref<GDScript> compiled = memnew(GDScript);
+	compiled->set_source_code(source);
+	ERR_PRINT_OFF;
+	const Error error = compiled->reload();
+	ERR_PRINT_ON;
+	REQUIRE_MESSAGE(error == OK, "The script should parse successfully.");
+
+	const Vector<uint8_t> bytecode = compiled->get_as_byte_code();
+	REQUIRE_MESSAGE(!bytecode.is_empty(), "The compiled script should be serializable.");
+
+	Ref<GDScript> cached = memnew(GDScript);
+	cached->set_source_code(source);
+	CHECK_MESSAGE(GDScriptBytecodeCache::load(cached.ptr(), bytecode) == OK, "The bytecode should load without compiling the source.");
+	CHECK(cached->is_valid());
+	CHECK(cached->get_subclasses().has("Accumulator"));
+
+	Ref<RefCounted> ref_counted = memnew(RefCounted);
+	ref_counted->set_script(cached);
+	CHECK_MESSAGE(int(ref_counted->get_meta("result")) == 66, "The cached bytecode should run like the compiled script.");
+	CHECK(String(ref_counted->get_meta("text")) == "0066");
+
+	Ref<GDScript> edited = memnew(GDScript);
+	edited->set_source_code(source + "\n# Edited.\n");
+	CHECK_MESSAGE(GDScriptBytecodeCache::load(edited.ptr(), bytecode) != OK, "The bytecode should be rejected once the source changes.");
+}
+
+TEST_CASE("[Modules][GDScript] Specialize typed operators in hot functions") {
+	const String source = R"(
+extends RefCounted
+
+func step(p_position: Vector3, p_velocity: Vector3, p_delta: float) -> Vector3:
+	var position := p_position
+	for i in 4:
+		if i < 2:
+			position += p_velocity * p_delta
+		else:
+			position -= p_velocity / 2.0
+	return position
+)";
+
+	Ref<GDScript> script = memnew(GDScript);
+	script->set_source_code(source);
+	ERR_PRINT_OFF;
+	const Error error = script->reload();
+	ERR_PRINT_ON;
+	REQUIRE_MESSAGE(error == OK, "The script should parse successfully.");
+
+	const Map<StringName, GDScriptFunction *> &functions = script->get_member_functions();
+	REQUIRE(functions.has("step"));
+	GDScriptFunction *step = functions["step"];
+
+	Ref<RefCounted> ref_counted = memnew(RefCounted);
+	ref_counted->set_script(script);
+
+	const Vector3 expected = Vector3(1, 2, 3) + Vector3(4, 8, 2) * 0.5 * 2 - Vector3(4, 8, 2) / 2.0 * 2;
+	CHECK(Vector3(ref_counted->call("step", Vector3(1, 2, 3), Vector3(4, 8, 2), 0.5)) == expected);
+	CHECK_FALSE_MESSAGE(step->is_specialized(), "Cold functions should run the generic instructions.");
+
+	const uint32_t threshold = GDScriptLanguage::get_singleton()->get_specialize_call_threshold();
+	for (uint32_t i = 1; i < threshold; i++) {
+		ref_counted->call("step", Vector3(1, 2, 3), Vector3(4, 8, 2), 0.5);
+	}
+	if (threshold > 0) {
+		CHECK_MESSAGE(step->is_specialized(), "Hot functions should switch to specialized instructions.");
+	}
+	CHECK_MESSAGE(Vector3(ref_counted->call("step", Vector3(1, 2, 3), Vector3(4, 8, 2), 0.5)) == expected, "Specialized instructions should give the same result.");
+}
+
+// Records the references to an object right before a script awaits.
+class AwaitProbe : public Object {
+public:
+	RefCounted *tracked = nullptr;
+	int references = 0;
+
+	void record() { references = tracked->reference_get_count(); }
+};
+
+TEST_CASE("[Modules][GDScript] Await moves the stack of the suspended function") {
+	const String source = R"(
+extends RefCounted
+
+signal about_to_await
+signal resumed(p_value)
+
+var tracked: RefCounted
+var result := []
+
+func run(p_count: int) -> int:
+	var untyped = [tracked, "text %d" % p_count]
+	var typed_array: Array[int] = [p_count, p_count * 2]
+	var typed_dictionary := { "tracked": tracked }
+	var typed_text: String = "value %d" % p_count
+	var typed_vector := Vector3(p_count, 2, 3) * 2.0
+	about_to_await.emit()
+	var first = await resumed
+	var typed_object: RefCounted = tracked
+	about_to_await.emit()
+	var second: int = await resumed
+	result = [untyped[0] == tracked, untyped[1], typed_array[1], typed_dictionary["tracked"] == typed_object, typed_text, typed_vector, first, second]
+	return typed_array[0] + second
+)";
+
+	Ref<GDScript> script = memnew(GDScript);
+	script->set_source_code(source);
+	ERR_PRINT_OFF;
+	const Error error = script->reload();
+	ERR_PRINT_ON;
+	REQUIRE_MESSAGE(error == OK, "The script should parse successfully.");
+
+	Ref<RefCounted> ref_counted = memnew(RefCounted);
+	ref_counted->set_script(script);
+	Ref<RefCounted> tracked = memnew(RefCounted);
+	ref_counted->set("tracked", tracked);
+	AwaitProbe *probe = memnew(AwaitProbe);
+	probe->tracked = tracked.ptr();
+	ref_counted->connect(SNAME("about_to_await"), callable_mp(probe, &AwaitProbe::record));
+
+	Variant state = ref_counted->call("run", 7);
+	REQUIRE_MESSAGE(Object::cast_to<GDScriptFunctionState>(state) != nullptr, "The function should be suspended.");
+	CHECK_MESSAGE(tracked->reference_get_count() == probe->references, "Suspending should move references to the saved stack, not copy or drop them.");
+
+	ref_counted->emit_signal(SNAME("resumed"), "first");
+	CHECK_MESSAGE(tracked->reference_get_count() == probe->references, "Suspending a resumed function should move references again.");
+
+	ref_counted->emit_signal(SNAME("resumed"), 5);
+	Array expected;
+	expected.push_back(true);
+	expected.push_back("text 7");
+	expected.push_back(14);
+	expected.push_back(true);
+	expected.push_back("value 7");
+	expected.push_back(Vector3(14, 4, 6));
+	expected.push_back("first");
+	expected.push_back(5);
+	CHECK_MESSAGE(Array(ref_counted->get("result")) == expected, "Locals should keep their values across awaits.");
+
+	state = Variant();
+	CHECK_MESSAGE(tracked->reference_get_count() == 2, "The completed function should release its stack.");
+	ref_counted->set("tracked", Variant());
+	CHECK(tracked->reference_get_count() == 1);
+
+	memdelete(probe);
+}
+
+TEST_CASE("[Modules][GDScript] Sampling profiler attributes samples to functions and lines") {
+	const String source = R"(
+extends RefCounted
+
+func spin(p_count: int) -> int:
+	var total := 0
+	for i in p_count:
+		total += i % 7
+	return total
+
+func fib(p_n: int) -> int:
+	if p_n < 2:
+		return p_n
+	return fib(p_n - 1) + fib(p_n - 2)
+)";
+
+	Ref<GDScript> script = memnew(GDScript);
+	script->set_source_code(source);
+	ERR_PRINT_OFF;
+	const Error error = script->reload();
+	ERR_PRINT_ON;
+	REQUIRE_MESSAGE(error == OK, "The script should parse successfully.");
+
+	Ref<RefCounted> ref_counted = memnew(RefCounted);
+	ref_counted->set_script(script);
+
+	// Neither function calls native code, so they are only sampled at lines in debug builds,
+	// and at loop back-edges (spin) and function entries (fib) in release builds.
+	GDScriptSamplingProfiler::start(2000);
+	const uint64_t start = OS::get_singleton()->get_ticks_msec();
+	while (GDScriptSamplingProfiler::get_sample_count() < 50 && OS::get_singleton()->get_ticks_msec() - start < 5000) {
+		ref_counted->call("spin", 10000);
+		ref_counted->call("fib", 15);
+	}
+	GDScriptSamplingProfiler::stop();
+
+	REQUIRE_MESSAGE(GDScriptSamplingProfiler::get_sample_count() > 0, "Busy script code should get sampled.");
+
+	const String collapsed = GDScriptSamplingProfiler::get_collapsed_stacks();
+	CHECK_MESSAGE(collapsed.find("spin (") != -1, "Samples should be attributed to the running function.");
+	CHECK_MESSAGE(collapsed.find("fib (") != -1, "Functions without loops should get sampled too.");
+	CHECK_MESSAGE(collapsed.strip_edges().get_slice(" ", collapsed.strip_edges().get_slice_count(" ") - 1).to_int() > 0, "Each collapsed stack should end with its sample count.");
+#ifdef DEBUG_ENABLED
+	CHECK_MESSAGE(collapsed.find("spin (:7)") != -1, "Samples should point at the line running in the loop.");
+#else
+	CHECK_MESSAGE(collapsed.find("spin (:4)") != -1, "Without line markers, samples should point at the line the function starts on.");
+	CHECK(collapsed.find("spin (:7)") == -1);
+#endif
+
+	const String trace = GDScriptSamplingProfiler::get_chrome_trace();
+	CHECK(trace.begins_with("{"));
+	CHECK(trace.find("\"stackFrames\"") != -1);
+	CHECK(trace.find("\"samples\"") != -1);
+}
+
 } // namespace GDScriptTests
 
 #endif // GDSCRIPT_TEST_RUNNER_SUITE_H
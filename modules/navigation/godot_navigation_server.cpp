@@ -205,6 +205,13 @@ Vector<Vector3> GodotNavigationServer::map_get_path(RID p_map, Vector3 p_origin,
 	return map->get_path(p_origin, p_destination, p_optimize, p_layers);
 }
 
+Vector<Vector<Vector3>> GodotNavigationServer::map_get_paths(RID p_map, const Vector<Vector3> &p_origins, const Vector<Vector3> &p_destinations, bool p_optimize, uint32_t p_layers) const {
+	const NavMap *map = map_owner.get_or_null(p_map);
+	ERR_FAIL_COND_V(map == nullptr, Vector<Vector<Vector3>>());
+
+	return map->get_paths(p_origins, p_destinations, p_optimize, p_layers);
+}
+
 Vector3 GodotNavigationServer::map_get_closest_point_to_segment(RID p_map, const Vector3 &p_from, const Vector3 &p_to, const bool p_use_collision) const {
 	const NavMap *map = map_owner.get_or_null(p_map);
 	ERR_FAIL_COND_V(map == nullptr, Vector3());
@@ -99,6 +99,7 @@ public:
 	virtual real_t map_get_edge_connection_margin(RID p_map) const override;
 
 	virtual Vector<Vector3> map_get_path(RID p_map, Vector3 p_origin, Vector3 p_destination, bool p_optimize, uint32_t p_layers = 1) const override;
+	virtual Vector<Vector<Vector3>> map_get_paths(RID p_map, const Vector<Vector3> &p_origins, const Vector<Vector3> &p_destinations, bool p_optimize, uint32_t p_layers = 1) const override;
 
 	virtual Vector3 map_get_closest_point_to_segment(RID p_map, const Vector3 &p_from, const Vector3 &p_to, const bool p_use_collision = false) const override;
 	virtual Vector3 map_get_closest_point(RID p_map, const Vector3 &p_point) const override;
@@ -0,0 +1,324 @@
+/*************************************************************************/
+/*  nav_bvh.cpp                                                          */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "nav_bvh.h"
+
+#include "core/math/face3.h"
+#include "core/math/geometry_3d.h"
+#include "core/templates/sort_array.h"
+
+NavBVH::Bounds NavBVH::_get_polygon_bounds(const gd::Polygon &p_polygon) {
+	Bounds bounds;
+	if (p_polygon.points.empty()) {
+		return bounds;
+	}
+	bounds.min = p_polygon.points[0].pos;
+	bounds.max = p_polygon.points[0].pos;
+	for (size_t i = 1; i < p_polygon.points.size(); i++) {
+		const Vector3 &pos = p_polygon.points[i].pos;
+		bounds.merge_with({ pos, pos });
+	}
+	return bounds;
+}
+
+bool NavBVH::_intersects_segment(const Bounds &p_bounds, const Vector3 &p_from, const Vector3 &p_dir, real_t &r_t) {
+	real_t t_min = 0.0;
+	real_t t_max = 1.0;
+	for (int i = 0; i < 3; i++) {
+		if (Math::is_zero_approx(p_dir[i])) {
+			// Parallel to the slab, the segment must start inside it.
+			if (p_from[i] < p_bounds.min[i] - CMP_EPSILON || p_from[i] > p_bounds.max[i] + CMP_EPSILON) {
+				return false;
+			}
+			continue;
+		}
+
+		real_t t_a = (p_bounds.min[i] - p_from[i]) / p_dir[i];
+		real_t t_b = (p_bounds.max[i] - p_from[i]) / p_dir[i];
+		if (t_a > t_b) {
+			SWAP(t_a, t_b);
+		}
+		t_min = MAX(t_min, t_a);
+		t_max = MIN(t_max, t_b);
+		if (t_min > t_max + CMP_EPSILON) {
+			return false;
+		}
+	}
+	r_t = t_min;
+	return true;
+}
+
+uint32_t NavBVH::_build(uint32_t p_from, uint32_t p_to, uint32_t p_depth) {
+	max_depth = MAX(max_depth, p_depth);
+
+	const uint32_t node_id = nodes.size();
+	nodes.push_back(Node());
+
+	Bounds bounds = polygon_bounds[polygon_ids[p_from]];
+	Bounds centers = { bounds.get_center(), bounds.get_center() };
+	for (uint32_t i = p_from + 1; i < p_to; i++) {
+		const Bounds &polygon = polygon_bounds[polygon_ids[i]];
+		const Vector3 center = polygon.get_center();
+		bounds.merge_with(polygon);
+		centers.merge_with({ center, center });
+	}
+	nodes[node_id].bounds = bounds;
+
+	if (p_to - p_from <= LEAF_SIZE) {
+		nodes[node_id].index = p_from;
+		nodes[node_id].count = p_to - p_from;
+		return node_id;
+	}
+
+	// Split at the median of the polygon centers along the longest axis.
+	SortArray<uint32_t, CenterComparator> sorter;
+	sorter.compare.polygon_bounds = polygon_bounds.ptr();
+	sorter.compare.axis = (centers.max - centers.min).max_axis_index();
+	const uint32_t middle = (p_from + p_to) / 2;
+	sorter.nth_element(p_from, p_to, middle, polygon_ids.ptr());
+
+	_build(p_from, middle, p_depth + 1);
+	const uint32_t second = _build(middle, p_to, p_depth + 1);
+	nodes[node_id].index = second;
+	return node_id;
+}
+
+void NavBVH::build(const std::vector<gd::Polygon> &p_polygons) {
+	nodes.clear();
+	max_depth = 0;
+	build_area = 0.0;
+
+	polygon_ids.resize(p_polygons.size());
+	polygon_bounds.resize(p_polygons.size());
+	for (uint32_t i = 0; i < polygon_ids.size(); i++) {
+		polygon_ids[i] = i;
+		polygon_bounds[i] = _get_polygon_bounds(p_polygons[i]);
+	}
+
+	if (polygon_ids.is_empty()) {
+		return;
+	}
+
+	nodes.reserve(polygon_ids.size() / 2 + 1);
+	_build(0, polygon_ids.size(), 1);
+
+	for (uint32_t i = 0; i < nodes.size(); i++) {
+		build_area += nodes[i].bounds.get_area();
+	}
+}
+
+bool NavBVH::refit(const std::vector<gd::Polygon> &p_polygons) {
+	ERR_FAIL_COND_V(p_polygons.size() != polygon_ids.size(), false);
+
+	for (uint32_t i = 0; i < polygon_bounds.size(); i++) {
+		polygon_bounds[i] = _get_polygon_bounds(p_polygons[i]);
+	}
+
+	// Children are always stored after their parent.
+	real_t area = 0.0;
+	for (int64_t i = int64_t(nodes.size()) - 1; i >= 0; i--) {
+		Node &node = nodes[i];
+		if (node.count > 0) {
+			node.bounds = polygon_bounds[polygon_ids[node.index]];
+			for (uint32_t j = 1; j < node.count; j++) {
+				node.bounds.merge_with(polygon_bounds[polygon_ids[node.index + j]]);
+			}
+		} else {
+			node.bounds = nodes[i + 1].bounds;
+			node.bounds.merge_with(nodes[node.index].bounds);
+		}
+		area += node.bounds.get_area();
+	}
+
+	return area <= build_area * 2.0;
+}
+
+AABB NavBVH::get_bounds() const {
+	if (nodes.is_empty()) {
+		return AABB();
+	}
+	return AABB(nodes[0].bounds.min, nodes[0].bounds.max - nodes[0].bounds.min);
+}
+
+void NavBVH::get_closest_point(const std::vector<gd::Polygon> &p_polygons, const Vector3 &p_point, ClosestPoint &r_closest) const {
+	if (nodes.is_empty()) {
+		return;
+	}
+
+	uint32_t *stack = (uint32_t *)alloca(sizeof(uint32_t) * (max_depth + 1));
+	uint32_t depth = 0;
+	stack[depth++] = 0;
+
+	while (depth > 0) {
+		const uint32_t node_id = stack[--depth];
+		const Node &node = nodes[node_id];
+		if (node.bounds.distance_squared_to(p_point) >= r_closest.distance_squared) {
+			continue;
+		}
+
+		if (node.count == 0) {
+			// Visit the closest child first, it is pushed last.
+			uint32_t near_id = node_id + 1;
+			uint32_t far_id = node.index;
+			if (nodes[far_id].bounds.distance_squared_to(p_point) < nodes[near_id].bounds.distance_squared_to(p_point)) {
+				SWAP(near_id, far_id);
+			}
+			stack[depth++] = far_id;
+			stack[depth++] = near_id;
+			continue;
+		}
+
+		for (uint32_t i = node.index; i < node.index + node.count; i++) {
+			const gd::Polygon &p = p_polygons[polygon_ids[i]];
+
+			// For each face check the distance to the point
+			for (size_t point_id = 2; point_id < p.points.size(); point_id++) {
+				const Face3 f(p.points[0].pos, p.points[point_id - 1].pos, p.points[point_id].pos);
+				const Vector3 inters = f.get_closest_point_to(p_point);
+				const real_t ds = inters.distance_squared_to(p_point);
+				if (ds < r_closest.distance_squared) {
+					r_closest.polygon = &p;
+					r_closest.point = inters;
+					r_closest.normal = f.get_plane().normal;
+					r_closest.distance_squared = ds;
+				}
+			}
+		}
+	}
+}
+
+bool NavBVH::intersect_segment(const std::vector<gd::Polygon> &p_polygons, const Vector3 &p_from, const Vector3 &p_to, real_t &r_distance, Vector3 &r_point) const {
+	if (nodes.is_empty()) {
+		return false;
+	}
+
+	const Vector3 dir = p_to - p_from;
+	const real_t length = dir.length();
+	bool found = false;
+
+	uint32_t *stack = (uint32_t *)alloca(sizeof(uint32_t) * (max_depth + 1));
+	uint32_t depth = 0;
+	stack[depth++] = 0;
+
+	while (depth > 0) {
+		const uint32_t node_id = stack[--depth];
+		const Node &node = nodes[node_id];
+		real_t t;
+		if (!_intersects_segment(node.bounds, p_from, dir, t) || t * length > r_distance) {
+			continue;
+		}
+
+		if (node.count == 0) {
+			uint32_t near_id = node_id + 1;
+			uint32_t far_id = node.index;
+			if (nodes[far_id].bounds.distance_squared_to(p_from) < nodes[near_id].bounds.distance_squared_to(p_from)) {
+				SWAP(near_id, far_id);
+			}
+			stack[depth++] = far_id;
+			stack[depth++] = near_id;
+			continue;
+		}
+
+		for (uint32_t i = node.index; i < node.index + node.count; i++) {
+			const gd::Polygon &p = p_polygons[polygon_ids[i]];
+			for (size_t point_id = 2; point_id < p.points.size(); point_id++) {
+				const Face3 f(p.points[0].pos, p.points[point_id - 1].pos, p.points[point_id].pos);
+				Vector3 inters;
+				if (f.intersects_segment(p_from, p_to, &inters)) {
+					const real_t d = p_from.distance_to(inters);
+					if (d < r_distance) {
+						r_distance = d;
+						r_point = inters;
+						found = true;
+					}
+				}
+			}
+		}
+	}
+
+	return found;
+}
+
+bool NavBVH::get_closest_point_to_segment(const std::vector<gd::Polygon> &p_polygons, const Vector3 &p_from, const Vector3 &p_to, real_t &r_distance_squared, Vector3 &r_point) const {
+	if (nodes.is_empty()) {
+		return false;
+	}
+
+	// The bounds of the segment give a lower bound of its distance to the nodes.
+	Bounds segment = { p_from, p_from };
+	segment.merge_with({ p_to, p_to });
+	bool found = false;
+
+	uint32_t *stack = (uint32_t *)alloca(sizeof(uint32_t) * (max_depth + 1));
+	uint32_t depth = 0;
+	stack[depth++] = 0;
+
+	while (depth > 0) {
+		const uint32_t node_id = stack[--depth];
+		const Node &node = nodes[node_id];
+		if (node.bounds.distance_squared_to(segment) >= r_distance_squared) {
+			continue;
+		}
+
+		if (node.count == 0) {
+			uint32_t near_id = node_id + 1;
+			uint32_t far_id = node.index;
+			if (nodes[far_id].bounds.distance_squared_to(segment) < nodes[near_id].bounds.distance_squared_to(segment)) {
+				SWAP(near_id, far_id);
+			}
+			stack[depth++] = far_id;
+			stack[depth++] = near_id;
+			continue;
+		}
+
+		for (uint32_t i = node.index; i < node.index + node.count; i++) {
+			const gd::Polygon &p = p_polygons[polygon_ids[i]];
+			for (size_t point_id = 0; point_id < p.points.size(); point_id++) {
+				Vector3 a, b;
+				Geometry3D::get_closest_points_between_segments(
+						p_from,
+						p_to,
+						p.points[point_id].pos,
+						p.points[(point_id + 1) % p.points.size()].pos,
+						a,
+						b);
+
+				const real_t ds = a.distance_squared_to(b);
+				if (ds < r_distance_squared) {
+					r_distance_squared = ds;
+					r_point = b;
+					found = true;
+				}
+			}
+		}
+	}
+
+	return found;
+}
@@ -0,0 +1,145 @@
+/*************************************************************************/
+/*  nav_bvh.h                                                            */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef NAV_BVH_H
+#define NAV_BVH_H
+
+#include "core/math/aabb.h"
+#include "core/templates/local_vector.h"
+#include "nav_utils.h"
+
+/// Bounding volume hierarchy over the polygons of a region, used to answer the
+/// closest point and segment queries without visiting every polygon.
+///
+/// The nodes are stored depth first: the first child of an internal node
+/// follows it, so a refit only needs a reverse walk over the nodes.
+class NavBVH {
+	enum {
+		LEAF_SIZE = 4,
+	};
+
+	struct Bounds {
+		Vector3 min;
+		Vector3 max;
+
+		_FORCE_INLINE_ void merge_with(const Bounds &p_bounds) {
+			min.x = MIN(min.x, p_bounds.min.x);
+			min.y = MIN(min.y, p_bounds.min.y);
+			min.z = MIN(min.z, p_bounds.min.z);
+			max.x = MAX(max.x, p_bounds.max.x);
+			max.y = MAX(max.y, p_bounds.max.y);
+			max.z = MAX(max.z, p_bounds.max.z);
+		}
+
+		_FORCE_INLINE_ Vector3 get_center() const {
+			return (min + max) * 0.5;
+		}
+
+		_FORCE_INLINE_ real_t get_area() const {
+			const Vector3 size = max - min;
+			return 2.0 * (size.x * size.y + size.y * size.z + size.z * size.x);
+		}
+
+		_FORCE_INLINE_ real_t distance_squared_to(const Vector3 &p_point) const {
+			real_t d = 0.0;
+			for (int i = 0; i < 3; i++) {
+				const real_t v = MAX(MAX(min[i] - p_point[i], p_point[i] - max[i]), real_t(0.0));
+				d += v * v;
+			}
+			return d;
+		}
+
+		_FORCE_INLINE_ real_t distance_squared_to(const Bounds &p_bounds) const {
+			real_t d = 0.0;
+			for (int i = 0; i < 3; i++) {
+				const real_t v = MAX(MAX(min[i] - p_bounds.max[i], p_bounds.min[i] - max[i]), real_t(0.0));
+				d += v * v;
+			}
+			return d;
+		}
+	};
+
+	struct Node {
+		Bounds bounds;
+		/// Leaves: first entry in `polygon_ids`. Internal nodes: the second child.
+		uint32_t index = 0;
+		/// The number of polygons in a leaf, zero for internal nodes.
+		uint32_t count = 0;
+	};
+
+	struct CenterComparator {
+		const Bounds *polygon_bounds = nullptr;
+		int axis = 0;
+
+		_FORCE_INLINE_ bool operator()(uint32_t p_a, uint32_t p_b) const {
+			return polygon_bounds[p_a].get_center()[axis] < polygon_bounds[p_b].get_center()[axis];
+		}
+	};
+
+	LocalVector<Node> nodes;
+	LocalVector<uint32_t> polygon_ids;
+	LocalVector<Bounds> polygon_bounds;
+	uint32_t max_depth = 0;
+	/// The summed area of the nodes when the tree was built, to tell when refitting degraded it too much.
+	real_t build_area = 0.0;
+
+	static Bounds _get_polygon_bounds(const gd::Polygon &p_polygon);
+	static bool _intersects_segment(const Bounds &p_bounds, const Vector3 &p_from, const Vector3 &p_dir, real_t &r_t);
+	uint32_t _build(uint32_t p_from, uint32_t p_to, uint32_t p_depth);
+
+public:
+	struct ClosestPoint {
+		const gd::Polygon *polygon = nullptr;
+		Vector3 point;
+		Vector3 normal;
+		real_t distance_squared = 1e20;
+	};
+
+	void build(const std::vector<gd::Polygon> &p_polygons);
+	/// Recomputes the bounds without changing the tree, for polygons that only moved.
+	/// Returns `false` when the tree became too loose and should be built again.
+	bool refit(const std::vector<gd::Polygon> &p_polygons);
+
+	uint32_t get_polygon_count() const {
+		return polygon_ids.size();
+	}
+	AABB get_bounds() const;
+
+	// The queries only replace the results they are given when they find something closer,
+	// so that several trees can be queried in turn.
+
+	void get_closest_point(const std::vector<gd::Polygon> &p_polygons, const Vector3 &p_point, ClosestPoint &r_closest) const;
+	/// Finds the intersection of the segment with the polygons that is the closest to `p_from`.
+	bool intersect_segment(const std::vector<gd::Polygon> &p_polygons, const Vector3 &p_from, const Vector3 &p_to, real_t &r_distance, Vector3 &r_point) const;
+	/// Finds the point of the polygon edges that is the closest to the segment.
+	bool get_closest_point_to_segment(const std::vector<gd::Polygon> &p_polygons, const Vector3 &p_from, const Vector3 &p_to, real_t &r_distance_squared, Vector3 &r_point) const;
+};
+
+#endif // NAV_BVH_H
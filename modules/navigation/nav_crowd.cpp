@@ -0,0 +1,622 @@
+/*************************************************************************/
+/*  nav_crowd.cpp                                                        */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "nav_crowd.h"
+
+#include "core/math/math_funcs.h"
+#include "core/os/threaded_array_processor.h"
+#include "rvo_agent.h"
+
+#include <Definitions.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NAV_CROWD_SSE2
+#include <emmintrin.h>
+#endif
+
+// The number of cells a neighbor query looks at one by one, larger queries go through all the agents instead.
+#define MAX_QUERY_CELLS 64
+
+static const float RVO_EPSILON = 0.00001f;
+
+// The linear programs are the ones of RVO2, working on arrays of planes.
+
+static bool _linear_program1(const RVO::Plane *p_planes, uint32_t p_plane_no, const RVO::Vector3 &p_line_point, const RVO::Vector3 &p_line_direction, float p_radius, const RVO::Vector3 &p_opt_velocity, bool p_direction_opt, RVO::Vector3 &r_result) {
+	const float dot_product = p_line_point * p_line_direction;
+	const float discriminant = RVO::sqr(dot_product) + RVO::sqr(p_radius) - RVO::absSq(p_line_point);
+
+	if (discriminant < 0.0f) {
+		// Max speed sphere fully invalidates line.
+		return false;
+	}
+
+	const float sqrt_discriminant = std::sqrt(discriminant);
+	float t_left = -dot_product - sqrt_discriminant;
+	float t_right = -dot_product + sqrt_discriminant;
+
+	for (uint32_t i = 0; i < p_plane_no; i++) {
+		const float numerator = (p_planes[i].point - p_line_point) * p_planes[i].normal;
+		const float denominator = p_line_direction * p_planes[i].normal;
+
+		if (RVO::sqr(denominator) <= RVO_EPSILON) {
+			// Line is (almost) parallel to plane i.
+			if (numerator > 0.0f) {
+				return false;
+			} else {
+				continue;
+			}
+		}
+
+		const float t = numerator / denominator;
+
+		if (denominator >= 0.0f) {
+			// Plane i bounds line on the left.
+			t_left = MAX(t_left, t);
+		} else {
+			// Plane i bounds line on the right.
+			t_right = MIN(t_right, t);
+		}
+
+		if (t_left > t_right) {
+			return false;
+		}
+	}
+
+	if (p_direction_opt) {
+		// Optimize direction.
+		if (p_opt_velocity * p_line_direction > 0.0f) {
+			// Take right extreme.
+			r_result = p_line_point + t_right * p_line_direction;
+		} else {
+			// Take left extreme.
+			r_result = p_line_point + t_left * p_line_direction;
+		}
+	} else {
+		// Optimize closest point.
+		const float t = p_line_direction * (p_opt_velocity - p_line_point);
+
+		if (t < t_left) {
+			r_result = p_line_point + t_left * p_line_direction;
+		} else if (t > t_right) {
+			r_result = p_line_point + t_right * p_line_direction;
+		} else {
+			r_result = p_line_point + t * p_line_direction;
+		}
+	}
+
+	return true;
+}
+
+static bool _linear_program2(const RVO::Plane *p_planes, uint32_t p_plane_no, float p_radius, const RVO::Vector3 &p_opt_velocity, bool p_direction_opt, RVO::Vector3 &r_result) {
+	const RVO::Plane &plane = p_planes[p_plane_no];
+	const float plane_dist = plane.point * plane.normal;
+	const float plane_dist_sq = RVO::sqr(plane_dist);
+	const float radius_sq = RVO::sqr(p_radius);
+
+	if (plane_dist_sq > radius_sq) {
+		// Max speed sphere fully invalidates the plane.
+		return false;
+	}
+
+	const float plane_radius_sq = radius_sq - plane_dist_sq;
+
+	const RVO::Vector3 plane_center = plane_dist * plane.normal;
+
+	if (p_direction_opt) {
+		// Project direction on the plane.
+		const RVO::Vector3 plane_opt_velocity = p_opt_velocity - (p_opt_velocity * plane.normal) * plane.normal;
+		const float plane_opt_velocity_length_sq = RVO::absSq(plane_opt_velocity);
+
+		if (plane_opt_velocity_length_sq <= RVO_EPSILON) {
+			r_result = plane_center;
+		} else {
+			r_result = plane_center + std::sqrt(plane_radius_sq / plane_opt_velocity_length_sq) * plane_opt_velocity;
+		}
+	} else {
+		// Project point on the plane.
+		r_result = p_opt_velocity + ((plane.point - p_opt_velocity) * plane.normal) * plane.normal;
+
+		// If outside the plane circle, project on it.
+		if (RVO::absSq(r_result) > radius_sq) {
+			const RVO::Vector3 plane_result = r_result - plane_center;
+			const float plane_result_length_sq = RVO::absSq(plane_result);
+			r_result = plane_center + std::sqrt(plane_radius_sq / plane_result_length_sq) * plane_result;
+		}
+	}
+
+	for (uint32_t i = 0; i < p_plane_no; i++) {
+		if (p_planes[i].normal * (p_planes[i].point - r_result) > 0.0f) {
+			// Result does not satisfy constraint i, compute the intersection line of plane i and the plane.
+			const RVO::Vector3 cross_product = RVO::cross(p_planes[i].normal, plane.normal);
+
+			if (RVO::absSq(cross_product) <= RVO_EPSILON) {
+				// The planes are (almost) parallel, and plane i fully invalidates the plane.
+				return false;
+			}
+
+			const RVO::Vector3 line_direction = RVO::normalize(cross_product);
+			const RVO::Vector3 line_normal = RVO::cross(line_direction, plane.normal);
+			const RVO::Vector3 line_point = plane.point + (((p_planes[i].point - plane.point) * p_planes[i].normal) / (line_normal * p_planes[i].normal)) * line_normal;
+
+			if (!_linear_program1(p_planes, i, line_point, line_direction, p_radius, p_opt_velocity, p_direction_opt, r_result)) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+static uint32_t _linear_program3(const RVO::Plane *p_planes, uint32_t p_plane_count, float p_radius, const RVO::Vector3 &p_opt_velocity, bool p_direction_opt, RVO::Vector3 &r_result) {
+	if (p_direction_opt) {
+		// Optimize direction, the optimization velocity is of unit length in this case.
+		r_result = p_opt_velocity * p_radius;
+	} else if (RVO::absSq(p_opt_velocity) > RVO::sqr(p_radius)) {
+		// Optimize closest point and outside circle.
+		r_result = RVO::normalize(p_opt_velocity) * p_radius;
+	} else {
+		// Optimize closest point and inside circle.
+		r_result = p_opt_velocity;
+	}
+
+	for (uint32_t i = 0; i < p_plane_count; i++) {
+		if (p_planes[i].normal * (p_planes[i].point - r_result) > 0.0f) {
+			// Result does not satisfy constraint i, compute new optimal result.
+			const RVO::Vector3 temp_result = r_result;
+
+			if (!_linear_program2(p_planes, i, p_radius, p_opt_velocity, p_direction_opt, r_result)) {
+				r_result = temp_result;
+				return i;
+			}
+		}
+	}
+
+	return p_plane_count;
+}
+
+static void _linear_program4(const RVO::Plane *p_planes, uint32_t p_plane_count, uint32_t p_begin_plane, float p_radius, RVO::Vector3 &r_result) {
+	RVO::Plane *proj_planes = (RVO::Plane *)alloca(sizeof(RVO::Plane) * p_plane_count);
+	float distance = 0.0f;
+
+	for (uint32_t i = p_begin_plane; i < p_plane_count; i++) {
+		if (p_planes[i].normal * (p_planes[i].point - r_result) > distance) {
+			// Result does not satisfy constraint of plane i.
+			uint32_t proj_plane_count = 0;
+
+			for (uint32_t j = 0; j < i; j++) {
+				RVO::Plane plane;
+
+				const RVO::Vector3 cross_product = RVO::cross(p_planes[j].normal, p_planes[i].normal);
+
+				if (RVO::absSq(cross_product) <= RVO_EPSILON) {
+					// Plane i and plane j are (almost) parallel.
+					if (p_planes[i].normal * p_planes[j].normal > 0.0f) {
+						// Plane i and plane j point in the same direction.
+						continue;
+					} else {
+						// Plane i and plane j point in opposite direction.
+						plane.point = 0.5f * (p_planes[i].point + p_planes[j].point);
+					}
+				} else {
+					// Point on the line of intersection between plane i and plane j.
+					const RVO::Vector3 line_normal = RVO::cross(cross_product, p_planes[i].normal);
+					plane.point = p_planes[i].point + (((p_planes[j].point - p_planes[i].point) * p_planes[j].normal) / (line_normal * p_planes[j].normal)) * line_normal;
+				}
+
+				plane.normal = RVO::normalize(p_planes[j].normal - p_planes[i].normal);
+				proj_planes[proj_plane_count++] = plane;
+			}
+
+			const RVO::Vector3 temp_result = r_result;
+
+			if (_linear_program3(proj_planes, proj_plane_count, p_radius, p_planes[i].normal, true, r_result) < proj_plane_count) {
+				// This should in principle not happen. The result is by definition already in the feasible region of this
+				// linear program. If it fails, it is due to small floating point error, and the current result is kept.
+				r_result = temp_result;
+			}
+
+			distance = p_planes[i].normal * (p_planes[i].point - r_result);
+		}
+	}
+}
+
+void NavCrowd::_build_grid(const std::vector<RvoAgent *> &p_agents, const std::vector<RvoAgent *> &p_computed_agents) {
+	const uint32_t count = p_agents.size();
+
+	// Cells as large as the average neighbor distance, so most queries only look at the cells next to the agent.
+	float total_distance = 0.0f;
+	uint32_t searching_count = 0;
+	for (size_t i = 0; i < p_computed_agents.size(); i++) {
+		const RVO::Agent *agent = p_computed_agents[i]->get_agent();
+		if (agent->maxNeighbors_ > 0 && agent->neighborDist_ > 0.0f) {
+			total_distance += agent->neighborDist_;
+			searching_count++;
+		}
+	}
+	cell_size = searching_count > 0 ? total_distance / searching_count : 1.0f;
+	const float inv_cell_size = 1.0f / cell_size;
+
+	const uint32_t cell_count = next_power_of_2(MAX(count, 1u)) * 2;
+	cell_mask = cell_count - 1;
+	cell_start.resize(cell_count + 1);
+	memset(cell_start.ptr(), 0, sizeof(uint32_t) * (cell_count + 1));
+
+	agent_cells.resize(count);
+	for (uint32_t i = 0; i < count; i++) {
+		const RVO::Vector3 &position = p_agents[i]->get_agent()->position_;
+		const uint32_t cell = _get_cell_hash(
+				int32_t(Math::floor(position.x() * inv_cell_size)),
+				int32_t(Math::floor(position.y() * inv_cell_size)),
+				int32_t(Math::floor(position.z() * inv_cell_size)));
+		agent_cells[i] = cell;
+		cell_start[cell]++;
+	}
+
+	// Counting sort: turn the counts into the end of each cell, then fill the cells backwards.
+	for (uint32_t i = 1; i < cell_count; i++) {
+		cell_start[i] += cell_start[i - 1];
+	}
+	cell_start[cell_count] = count;
+
+	position_x.resize(count);
+	position_y.resize(count);
+	position_z.resize(count);
+	velocity_x.resize(count);
+	velocity_y.resize(count);
+	velocity_z.resize(count);
+	radius.resize(count);
+	sorted_agents.resize(count);
+
+	for (uint32_t i = count; i-- > 0;) {
+		const uint32_t index = --cell_start[agent_cells[i]];
+		const RVO::Agent *agent = p_agents[i]->get_agent();
+		position_x[index] = agent->position_.x();
+		position_y[index] = agent->position_.y();
+		position_z[index] = agent->position_.z();
+		velocity_x[index] = agent->velocity_.x();
+		velocity_y[index] = agent->velocity_.y();
+		velocity_z[index] = agent->velocity_.z();
+		radius[index] = agent->radius_;
+		sorted_agents[index] = agent;
+	}
+}
+
+uint32_t NavCrowd::_find_neighbors(const RVO::Agent *p_agent, uint32_t p_max_neighbors, uint32_t *r_neighbors, float *r_distances) const {
+	if (p_max_neighbors == 0) {
+		return 0;
+	}
+
+	const float x = p_agent->position_.x();
+	const float y = p_agent->position_.y();
+	const float z = p_agent->position_.z();
+	const float distance = p_agent->neighborDist_;
+	float range_sq = distance * distance;
+	uint32_t count = 0;
+
+	// Same as RVO2, keeps the closest neighbors sorted by distance, and shrinks the range once there are enough of them.
+	struct Inserter {
+		const RVO::Agent *agent;
+		const RVO::Agent *const *sorted_agents;
+		uint32_t max_neighbors;
+		uint32_t *neighbors;
+		float *distances;
+
+		_FORCE_INLINE_ void insert(uint32_t p_index, float p_distance_sq, float &r_range_sq, uint32_t &r_count) const {
+			if (p_distance_sq >= r_range_sq || sorted_agents[p_index] == agent) {
+				return;
+			}
+			if (r_count < max_neighbors) {
+				r_count++;
+			}
+			uint32_t i = r_count - 1;
+			while (i != 0 && p_distance_sq < distances[i - 1]) {
+				distances[i] = distances[i - 1];
+				neighbors[i] = neighbors[i - 1];
+				i--;
+			}
+			distances[i] = p_distance_sq;
+			neighbors[i] = p_index;
+			if (r_count == max_neighbors) {
+				r_range_sq = distances[r_count - 1];
+			}
+		}
+	};
+	const Inserter inserter = { p_agent, sorted_agents.ptr(), p_max_neighbors, r_neighbors, r_distances };
+
+	const float *px = position_x.ptr();
+	const float *py = position_y.ptr();
+	const float *pz = position_z.ptr();
+
+	// The squared distances are computed exactly like RVO2 does, lane by lane.
+	auto scan = [&](uint32_t p_from, uint32_t p_to) {
+		uint32_t i = p_from;
+#ifdef NAV_CROWD_SSE2
+		const __m128 vx = _mm_set1_ps(x);
+		const __m128 vy = _mm_set1_ps(y);
+		const __m128 vz = _mm_set1_ps(z);
+		for (; i + 4 <= p_to; i += 4) {
+			const __m128 dx = _mm_sub_ps(vx, _mm_loadu_ps(px + i));
+			const __m128 dy = _mm_sub_ps(vy, _mm_loadu_ps(py + i));
+			const __m128 dz = _mm_sub_ps(vz, _mm_loadu_ps(pz + i));
+			const __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+			int mask = _mm_movemask_ps(_mm_cmplt_ps(d, _mm_set1_ps(range_sq)));
+			if (mask == 0) {
+				continue;
+			}
+			float distances[4];
+			_mm_storeu_ps(distances, d);
+			for (uint32_t j = 0; j < 4; j++) {
+				if (mask & (1 << j)) {
+					inserter.insert(i + j, distances[j], range_sq, count);
+				}
+			}
+		}
+#endif
+		for (; i < p_to; i++) {
+			const float dx = x - px[i];
+			const float dy = y - py[i];
+			const float dz = z - pz[i];
+			inserter.insert(i, dx * dx + dy * dy + dz * dz, range_sq, count);
+		}
+	};
+
+	const float inv_cell_size = 1.0f / cell_size;
+	const int32_t from_x = int32_t(Math::floor((x - distance) * inv_cell_size));
+	const int32_t from_y = int32_t(Math::floor((y - distance) * inv_cell_size));
+	const int32_t from_z = int32_t(Math::floor((z - distance) * inv_cell_size));
+	const int32_t to_x = int32_t(Math::floor((x + distance) * inv_cell_size));
+	const int32_t to_y = int32_t(Math::floor((y + distance) * inv_cell_size));
+	const int32_t to_z = int32_t(Math::floor((z + distance) * inv_cell_size));
+
+	const uint64_t query_cells = uint64_t(to_x - from_x + 1) * uint64_t(to_y - from_y + 1) * uint64_t(to_z - from_z + 1);
+	if (query_cells > MAX_QUERY_CELLS || query_cells > cell_mask + 1) {
+		scan(0, sorted_agents.size());
+		return count;
+	}
+
+	// Different cells can share a hash, each hash is only scanned once.
+	uint32_t visited[MAX_QUERY_CELLS];
+	uint32_t visited_count = 0;
+	for (int32_t cz = from_z; cz <= to_z; cz++) {
+		for (int32_t cy = from_y; cy <= to_y; cy++) {
+			for (int32_t cx = from_x; cx <= to_x; cx++) {
+				const uint32_t cell = _get_cell_hash(cx, cy, cz);
+				bool is_visited = false;
+				for (uint32_t i = 0; i < visited_count; i++) {
+					if (visited[i] == cell) {
+						is_visited = true;
+						break;
+					}
+				}
+				if (is_visited) {
+					continue;
+				}
+				visited[visited_count++] = cell;
+				scan(cell_start[cell], cell_start[cell + 1]);
+			}
+		}
+	}
+
+	return count;
+}
+
+uint32_t NavCrowd::_compute_planes(const RVO::Agent *p_agent, const uint32_t *p_neighbors, uint32_t p_count, RVO::Plane *r_planes) const {
+	const float inv_time_horizon = 1.0f / p_agent->timeHorizon_;
+	const float inv_time_step = 1.0f / time_step;
+	const bool ignore_y = p_agent->ignore_y_;
+	uint32_t plane_count = 0;
+
+	// Every case of RVO2 is `w = relative_velocity - s * relative_position` with a different `s`:
+	// the inverse time step when colliding, the inverse time horizon when projecting on the cut-off circle,
+	// and the cone projection factor otherwise. All of them are evaluated, and `s` picked per neighbor.
+	uint32_t i = 0;
+#ifdef NAV_CROWD_SSE2
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 x = _mm_set1_ps(p_agent->position_.x());
+	const __m128 y = _mm_set1_ps(p_agent->position_.y());
+	const __m128 z = _mm_set1_ps(p_agent->position_.z());
+	const __m128 vx = _mm_set1_ps(p_agent->velocity_.x());
+	const __m128 vy = _mm_set1_ps(p_agent->velocity_.y());
+	const __m128 vz = _mm_set1_ps(p_agent->velocity_.z());
+	const __m128 r = _mm_set1_ps(p_agent->radius_);
+	const __m128 sign_mask = _mm_set1_ps(-0.0f);
+	const __m128 time_horizon_factor = _mm_set1_ps(inv_time_horizon);
+	const __m128 time_step_factor = _mm_set1_ps(inv_time_step);
+
+	for (; i + 4 <= p_count; i += 4) {
+		const uint32_t a = p_neighbors[i + 0];
+		const uint32_t b = p_neighbors[i + 1];
+		const uint32_t c = p_neighbors[i + 2];
+		const uint32_t d = p_neighbors[i + 3];
+
+		const __m128 rel_x = _mm_sub_ps(_mm_setr_ps(position_x[a], position_x[b], position_x[c], position_x[d]), x);
+		__m128 rel_y = _mm_sub_ps(_mm_setr_ps(position_y[a], position_y[b], position_y[c], position_y[d]), y);
+		const __m128 rel_z = _mm_sub_ps(_mm_setr_ps(position_z[a], position_z[b], position_z[c], position_z[d]), z);
+		const __m128 rel_vx = _mm_sub_ps(vx, _mm_setr_ps(velocity_x[a], velocity_x[b], velocity_x[c], velocity_x[d]));
+		__m128 rel_vy = _mm_sub_ps(vy, _mm_setr_ps(velocity_y[a], velocity_y[b], velocity_y[c], velocity_y[d]));
+		const __m128 rel_vz = _mm_sub_ps(vz, _mm_setr_ps(velocity_z[a], velocity_z[b], velocity_z[c], velocity_z[d]));
+		const __m128 combined_radius = _mm_add_ps(r, _mm_setr_ps(radius[a], radius[b], radius[c], radius[d]));
+
+		int skip_mask = 0;
+		if (ignore_y) {
+			// Agents at different heights don't avoid each other.
+			const __m128 abs_y = _mm_andnot_ps(sign_mask, rel_y);
+			skip_mask = _mm_movemask_ps(_mm_cmpgt_ps(abs_y, _mm_mul_ps(combined_radius, _mm_set1_ps(2.0f))));
+			rel_y = zero;
+			rel_vy = zero;
+		}
+
+		const __m128 dist_sq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(rel_x, rel_x), _mm_mul_ps(rel_y, rel_y)), _mm_mul_ps(rel_z, rel_z));
+		const __m128 combined_radius_sq = _mm_mul_ps(combined_radius, combined_radius);
+		const __m128 colliding = _mm_cmpngt_ps(dist_sq, combined_radius_sq);
+
+		// Cut-off circle.
+		const __m128 cw_x = _mm_sub_ps(rel_vx, _mm_mul_ps(time_horizon_factor, rel_x));
+		const __m128 cw_y = _mm_sub_ps(rel_vy, _mm_mul_ps(time_horizon_factor, rel_y));
+		const __m128 cw_z = _mm_sub_ps(rel_vz, _mm_mul_ps(time_horizon_factor, rel_z));
+		const __m128 cw_length_sq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cw_x, cw_x), _mm_mul_ps(cw_y, cw_y)), _mm_mul_ps(cw_z, cw_z));
+		const __m128 cw_dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cw_x, rel_x), _mm_mul_ps(cw_y, rel_y)), _mm_mul_ps(cw_z, rel_z));
+		const __m128 cut_off = _mm_and_ps(_mm_cmplt_ps(cw_dot, zero), _mm_cmpgt_ps(_mm_mul_ps(cw_dot, cw_dot), _mm_mul_ps(combined_radius_sq, cw_length_sq)));
+
+		// Cone.
+		const __m128 cone_b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(rel_x, rel_vx), _mm_mul_ps(rel_y, rel_vy)), _mm_mul_ps(rel_z, rel_vz));
+		const __m128 cross_x = _mm_sub_ps(_mm_mul_ps(rel_y, rel_vz), _mm_mul_ps(rel_z, rel_vy));
+		const __m128 cross_y = _mm_sub_ps(_mm_mul_ps(rel_z, rel_vx), _mm_mul_ps(rel_x, rel_vz));
+		const __m128 cross_z = _mm_sub_ps(_mm_mul_ps(rel_x, rel_vy), _mm_mul_ps(rel_y, rel_vx));
+		const __m128 cross_sq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cross_x, cross_x), _mm_mul_ps(cross_y, cross_y)), _mm_mul_ps(cross_z, cross_z));
+		const __m128 rel_v_sq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(rel_vx, rel_vx), _mm_mul_ps(rel_vy, rel_vy)), _mm_mul_ps(rel_vz, rel_vz));
+		const __m128 cone_c = _mm_sub_ps(rel_v_sq, _mm_div_ps(cross_sq, _mm_sub_ps(dist_sq, combined_radius_sq)));
+		const __m128 cone_t = _mm_div_ps(_mm_add_ps(cone_b, _mm_sqrt_ps(_mm_sub_ps(_mm_mul_ps(cone_b, cone_b), _mm_mul_ps(dist_sq, cone_c)))), dist_sq);
+
+		const __m128 factor = _mm_or_ps(_mm_and_ps(colliding, time_step_factor),
+				_mm_andnot_ps(colliding, _mm_or_ps(_mm_and_ps(cut_off, time_horizon_factor), _mm_andnot_ps(cut_off, cone_t))));
+
+		const __m128 w_x = _mm_sub_ps(rel_vx, _mm_mul_ps(factor, rel_x));
+		const __m128 w_y = _mm_sub_ps(rel_vy, _mm_mul_ps(factor, rel_y));
+		const __m128 w_z = _mm_sub_ps(rel_vz, _mm_mul_ps(factor, rel_z));
+		const __m128 w_length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(w_x, w_x), _mm_mul_ps(w_y, w_y)), _mm_mul_ps(w_z, w_z)));
+		const __m128 inv_w_length = _mm_div_ps(one, w_length);
+		const __m128 normal_x = _mm_mul_ps(w_x, inv_w_length);
+		const __m128 normal_y = _mm_mul_ps(w_y, inv_w_length);
+		const __m128 normal_z = _mm_mul_ps(w_z, inv_w_length);
+		const __m128 u_length = _mm_sub_ps(_mm_mul_ps(combined_radius, factor), w_length);
+
+		float normals[3][4];
+		float points[3][4];
+		_mm_storeu_ps(normals[0], normal_x);
+		_mm_storeu_ps(normals[1], normal_y);
+		_mm_storeu_ps(normals[2], normal_z);
+		_mm_storeu_ps(points[0], _mm_add_ps(vx, _mm_mul_ps(half, _mm_mul_ps(u_length, normal_x))));
+		_mm_storeu_ps(points[1], _mm_add_ps(vy, _mm_mul_ps(half, _mm_mul_ps(u_length, normal_y))));
+		_mm_storeu_ps(points[2], _mm_add_ps(vz, _mm_mul_ps(half, _mm_mul_ps(u_length, normal_z))));
+
+		for (uint32_t j = 0; j < 4; j++) {
+			if (skip_mask & (1 << j)) {
+				continue;
+			}
+			RVO::Plane &plane = r_planes[plane_count++];
+			plane.normal = RVO::Vector3(normals[0][j], normals[1][j], normals[2][j]);
+			plane.point = RVO::Vector3(points[0][j], points[1][j], points[2][j]);
+		}
+	}
+#endif
+
+	for (; i < p_count; i++) {
+		const uint32_t other = p_neighbors[i];
+
+		RVO::Vector3 relative_position = RVO::Vector3(position_x[other], position_y[other], position_z[other]) - p_agent->position_;
+		RVO::Vector3 relative_velocity = p_agent->velocity_ - RVO::Vector3(velocity_x[other], velocity_y[other], velocity_z[other]);
+		const float combined_radius = p_agent->radius_ + radius[other];
+
+		if (ignore_y) {
+			// Agents at different heights don't avoid each other.
+			if (ABS(relative_position[1]) > combined_radius * 2) {
+				continue;
+			}
+			relative_position[1] = 0;
+			relative_velocity[1] = 0;
+		}
+
+		const float dist_sq = RVO::absSq(relative_position);
+		const float combined_radius_sq = RVO::sqr(combined_radius);
+
+		float factor;
+		if (dist_sq > combined_radius_sq) {
+			const RVO::Vector3 w = relative_velocity - inv_time_horizon * relative_position;
+			const float w_length_sq = RVO::absSq(w);
+			const float dot_product = w * relative_position;
+
+			if (dot_product < 0.0f && RVO::sqr(dot_product) > combined_radius_sq * w_length_sq) {
+				factor = inv_time_horizon;
+			} else {
+				const float b = relative_position * relative_velocity;
+				const float c = RVO::absSq(relative_velocity) - RVO::absSq(RVO::cross(relative_position, relative_velocity)) / (dist_sq - combined_radius_sq);
+				factor = (b + std::sqrt(RVO::sqr(b) - dist_sq * c)) / dist_sq;
+			}
+		} else {
+			factor = inv_time_step;
+		}
+
+		const RVO::Vector3 w = relative_velocity - factor * relative_position;
+		const float w_length = RVO::abs(w);
+		const RVO::Vector3 unit_w = w / w_length;
+
+		RVO::Plane &plane = r_planes[plane_count++];
+		plane.normal = unit_w;
+		plane.point = p_agent->velocity_ + 0.5f * ((combined_radius * factor - w_length) * unit_w);
+	}
+
+	return plane_count;
+}
+
+void NavCrowd::_compute_agent(uint32_t p_index, void *p_userdata) {
+	RVO::Agent *agent = computed_agents[p_index]->get_agent();
+	const uint32_t offset = neighbor_offsets[p_index];
+
+	const uint32_t neighbor_count = _find_neighbors(agent, neighbor_offsets[p_index + 1] - offset, neighbors.ptr() + offset, neighbor_distances.ptr() + offset);
+	const uint32_t plane_count = _compute_planes(agent, neighbors.ptr() + offset, neighbor_count, planes.ptr() + offset);
+
+	const uint32_t plane_fail = _linear_program3(planes.ptr() + offset, plane_count, agent->maxSpeed_, agent->prefVelocity_, false, agent->newVelocity_);
+	if (plane_fail < plane_count) {
+		_linear_program4(planes.ptr() + offset, plane_count, plane_fail, agent->maxSpeed_, agent->newVelocity_);
+	}
+
+	if (agent->ignore_y_) {
+		agent->newVelocity_[1] = agent->prefVelocity_[1];
+	}
+}
+
+void NavCrowd::step(const std::vector<RvoAgent *> &p_agents, const std::vector<RvoAgent *> &p_computed_agents, float p_time_step) {
+	if (p_computed_agents.empty()) {
+		return;
+	}
+
+	_build_grid(p_agents, p_computed_agents);
+
+	// Room for the neighbors of every agent, so the agents can be computed in parallel without allocating.
+	const uint32_t count = p_computed_agents.size();
+	const uint32_t max_neighbors = MAX(uint32_t(p_agents.size()), 1u) - 1;
+	neighbor_offsets.resize(count + 1);
+	uint32_t total = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		neighbor_offsets[i] = total;
+		total += MIN(uint32_t(p_computed_agents[i]->get_agent()->maxNeighbors_), max_neighbors);
+	}
+	neighbor_offsets[count] = total;
+	neighbors.resize(total);
+	neighbor_distances.resize(total);
+	planes.resize(total);
+
+	computed_agents = p_computed_agents.data();
+	time_step = p_time_step;
+	thread_process_array(count, this, &NavCrowd::_compute_agent, (void *)nullptr);
+}
@@ -0,0 +1,91 @@
+/*************************************************************************/
+/*  nav_crowd.h                                                          */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef NAV_CROWD_H
+#define NAV_CROWD_H
+
+#include "core/templates/local_vector.h"
+
+#include <Agent.h>
+#include <vector>
+
+class RvoAgent;
+
+/// Local avoidance of all the agents of a map, with the ORCA velocity
+/// obstacles of RVO2.
+///
+/// Every step, the agents are copied into one array per attribute, sorted by
+/// the cell of a uniform grid they are in. The neighbors of an agent are
+/// searched in the cells within its neighbor distance, and the velocity
+/// obstacles of its neighbors are evaluated several at a time with SIMD.
+class NavCrowd {
+	/// The agents, sorted by cell.
+	LocalVector<float> position_x;
+	LocalVector<float> position_y;
+	LocalVector<float> position_z;
+	LocalVector<float> velocity_x;
+	LocalVector<float> velocity_y;
+	LocalVector<float> velocity_z;
+	LocalVector<float> radius;
+
+	LocalVector<const RVO::Agent *> sorted_agents;
+	LocalVector<uint32_t> agent_cells;
+
+	/// The hashed cells, the agents of a cell are in `[cell_start[cell], cell_start[cell + 1])`.
+	/// Cells with the same hash share their agents, so a query may see agents of another cell.
+	LocalVector<uint32_t> cell_start;
+	uint32_t cell_mask = 0;
+	float cell_size = 1.0;
+
+	/// The neighbors and velocity obstacles of the agent computed at each index,
+	/// each of them has room for its maximum number of neighbors from the offset.
+	LocalVector<uint32_t> neighbor_offsets;
+	LocalVector<uint32_t> neighbors;
+	LocalVector<float> neighbor_distances;
+	LocalVector<RVO::Plane> planes;
+
+	RvoAgent *const *computed_agents = nullptr;
+	float time_step = 0.0;
+
+	_FORCE_INLINE_ uint32_t _get_cell_hash(int32_t p_x, int32_t p_y, int32_t p_z) const {
+		return ((uint32_t(p_x) * 73856093u) ^ (uint32_t(p_y) * 19349663u) ^ (uint32_t(p_z) * 83492791u)) & cell_mask;
+	}
+
+	void _build_grid(const std::vector<RvoAgent *> &p_agents, const std::vector<RvoAgent *> &p_computed_agents);
+	uint32_t _find_neighbors(const RVO::Agent *p_agent, uint32_t p_max_neighbors, uint32_t *r_neighbors, float *r_distances) const;
+	uint32_t _compute_planes(const RVO::Agent *p_agent, const uint32_t *p_neighbors, uint32_t p_count, RVO::Plane *r_planes) const;
+	void _compute_agent(uint32_t p_index, void *p_userdata);
+
+public:
+	/// Computes the new velocity of `p_computed_agents`, avoiding all of `p_agents`.
+	void step(const std::vector<RvoAgent *> &p_agents, const std::vector<RvoAgent *> &p_computed_agents, float p_time_step);
+};
+
+#endif // NAV_CROWD_H
@@ -31,6 +31,7 @@
 #include "nav_map.h"
 
 #include "core/os/threaded_array_processor.h"
+#include "core/templates/dense_hash_map.h"
 #include "nav_region.h"
 #include "rvo_agent.h"
 
@@ -38,6 +39,122 @@
 
 #define THREE_POINTS_CROSS_PRODUCT(m_a, m_b, m_c) (((m_c) - (m_a)).cross((m_b) - (m_a)))
 
+// Path search buffers, kept per thread so queries can run in parallel and reuse
+// them. Navigation polys are indexed by the id of their polygon in the map, and
+// stamped with the generation of the search that reached them, so nothing needs
+// to be cleared between queries.
+struct NavMapPathSearch {
+	LocalVector<gd::NavigationPoly> navigation_polys;
+	LocalVector<uint32_t> generations;
+	LocalVector<uint32_t> open; // Binary heap of polygon ids, ordered by cost.
+	uint32_t generation = 0;
+
+	void begin(uint32_t p_polygon_count) {
+		if (navigation_polys.size() < p_polygon_count) {
+			const uint32_t old_count = generations.size();
+			navigation_polys.resize(p_polygon_count);
+			generations.resize(p_polygon_count);
+			for (uint32_t i = old_count; i < p_polygon_count; i++) {
+				generations[i] = 0;
+			}
+		}
+
+		generation++;
+		if (unlikely(generation == 0)) {
+			// Wrapped around, stale stamps could match again.
+			for (uint32_t i = 0; i < generations.size(); i++) {
+				generations[i] = 0;
+			}
+			generation = 1;
+		}
+		open.clear();
+	}
+
+	_FORCE_INLINE_ bool is_reached(uint32_t p_id) const {
+		return generations[p_id] == generation;
+	}
+
+	_FORCE_INLINE_ gd::NavigationPoly &reach(uint32_t p_id, const gd::Polygon *p_poly) {
+		generations[p_id] = generation;
+		gd::NavigationPoly &np = navigation_polys[p_id];
+		np = gd::NavigationPoly(p_poly);
+		np.self_id = p_id;
+		return np;
+	}
+
+	_FORCE_INLINE_ bool is_open_empty() const {
+		return open.is_empty();
+	}
+
+	void push(uint32_t p_id) {
+		navigation_polys[p_id].heap_index = open.size();
+		open.push_back(p_id);
+		_shift_up(open.size() - 1);
+	}
+
+	uint32_t pop() {
+		const uint32_t id = open[0];
+		navigation_polys[id].heap_index = UINT32_MAX;
+		const uint32_t last = open[open.size() - 1];
+		open.resize(open.size() - 1);
+		if (!open.is_empty()) {
+			open[0] = last;
+			navigation_polys[last].heap_index = 0;
+			_shift_down(0);
+		}
+		return id;
+	}
+
+	// Restores the heap order after the cost of an open polygon changed.
+	void update(uint32_t p_id) {
+		const uint32_t index = navigation_polys[p_id].heap_index;
+		_shift_up(index);
+		_shift_down(navigation_polys[p_id].heap_index);
+	}
+
+private:
+	void _shift_up(uint32_t p_index) {
+		const uint32_t id = open[p_index];
+		const float cost = navigation_polys[id].cost;
+		while (p_index > 0) {
+			const uint32_t parent = (p_index - 1) / 2;
+			if (navigation_polys[open[parent]].cost <= cost) {
+				break;
+			}
+			open[p_index] = open[parent];
+			navigation_polys[open[p_index]].heap_index = p_index;
+			p_index = parent;
+		}
+		open[p_index] = id;
+		navigation_polys[id].heap_index = p_index;
+	}
+
+	void _shift_down(uint32_t p_index) {
+		const uint32_t id = open[p_index];
+		const float cost = navigation_polys[id].cost;
+		const uint32_t count = open.size();
+		while (true) {
+			uint32_t child = p_index * 2 + 1;
+			if (child >= count) {
+				break;
+			}
+			if (child + 1 < count && navigation_polys[open[child + 1]].cost < navigation_polys[open[child]].cost) {
+				child++;
+			}
+			if (cost <= navigation_polys[open[child]].cost) {
+				break;
+			}
+			open[p_index] = open[child];
+			navigation_polys[open[p_index]].heap_index = p_index;
+			p_index = child;
+		}
+		open[p_index] = id;
+		navigation_polys[id].heap_index = p_index;
+	}
+};
+
+static thread_local NavMapPathSearch path_search;
+
 void NavMap::set_up(Vector3 p_up) {
 	up = p_up;
 	regenerate_polygons = true;
@@ -67,44 +184,18 @@ gd::PointKey NavMap::get_point_key(const Vector3 &p_pos) const {
 }
 
 Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p_optimize, uint32_t p_layers) const {
-	// Find the start poly and the end poly on this map.
-	const gd::Polygon *begin_poly = nullptr;
-	const gd::Polygon *end_poly = nullptr;
-	Vector3 begin_point;
-	Vector3 end_point;
-	float begin_d = 1e20;
-	float end_d = 1e20;
-	// Find the initial poly and the end poly on this map.
-	for (size_t i(0); i < polygons.size(); i++) {
-		const gd::Polygon &p = polygons[i];
-
-		// Only consider the polygon if it in a region with compatible layers.
-		if ((p_layers & p.owner->get_layers()) == 0) {
-			continue;
-		}
-
-		// For each face check the distance between the origin/destination
-		for (size_t point_id = 2; point_id < p.points.size(); point_id++) {
-			const Face3 face(p.points[0].pos, p.points[point_id - 1].pos, p.points[point_id].pos);
-
-			Vector3 point = face.get_closest_point_to(p_origin);
-			float distance_to_point = point.distance_to(p_origin);
-			if (distance_to_point < begin_d) {
-				begin_d = distance_to_point;
-				begin_poly = &p;
-				begin_point = point;
-			}
-
-			point = face.get_closest_point_to(p_destination);
-			distance_to_point = point.distance_to(p_destination);
-			if (distance_to_point < end_d) {
-				end_d = distance_to_point;
-				end_poly = &p;
-				end_point = point;
-			}
-		}
+	if (p_layers == 0) {
+		return Vector<Vector3>();
 	}
 
+	// Find the start poly and the end poly on this map.
+	const NavBVH::ClosestPoint begin = get_closest_polygon_point(p_origin, p_layers);
+	const NavBVH::ClosestPoint end = get_closest_polygon_point(p_destination, p_layers);
+	const gd::Polygon *begin_poly = begin.polygon;
+	const gd::Polygon *end_poly = end.polygon;
+	const Vector3 begin_point = begin.point;
+	Vector3 end_point = end.point;
+
 	// Check for trivial cases
 	if (!begin_poly || !end_poly) {
 		return Vector<Vector3>();
@@ -117,24 +208,21 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 		return path;
 	}
 
-	// List of all reachable navigation polys.
-	std::vector<gd::NavigationPoly> navigation_polys;
-	navigation_polys.reserve(polygons.size() * 0.75);
+	// The search buffers of this thread are reused across queries.
+	NavMapPathSearch &search = path_search;
+	search.begin(polygon_count);
+	LocalVector<gd::NavigationPoly> &navigation_polys = search.navigation_polys;
 
 	// Add the start polygon to the reachable navigation polygons.
-	gd::NavigationPoly begin_navigation_poly = gd::NavigationPoly(begin_poly);
-	begin_navigation_poly.self_id = 0;
+	const uint32_t begin_id = begin_poly->id;
+	gd::NavigationPoly &begin_navigation_poly = search.reach(begin_id, begin_poly);
 	begin_navigation_poly.entry = begin_point;
 	begin_navigation_poly.back_navigation_edge_pathway_start = begin_point;
 	begin_navigation_poly.back_navigation_edge_pathway_end = begin_point;
-	navigation_polys.push_back(begin_navigation_poly);
 
-	// List of polygon IDs to visit.
-	List<uint32_t> to_visit;
-	to_visit.push_back(0);
-
-	// This is an implementation of the A* algorithm.
-	int least_cost_id = 0;
+	// This is an implementation of the A* algorithm, the polygons to visit
+	// are kept in a binary heap ordered by their estimated cost.
+	int least_cost_id = begin_id;
 	bool found_route = false;
 
 	const gd::Polygon *reachable_end = nullptr;
@@ -161,44 +249,41 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 				const Vector3 new_entry = Geometry3D::get_closest_point_to_segment(least_cost_poly->entry, pathway);
 				const float new_distance = least_cost_poly->entry.distance_to(new_entry) + least_cost_poly->traveled_distance;
 
-				const std::vector<gd::NavigationPoly>::iterator it = std::find(
-						navigation_polys.begin(),
-						navigation_polys.end(),
-						gd::NavigationPoly(connection.polygon));
-
-				if (it != navigation_polys.end()) {
+				const uint32_t id = connection.polygon->id;
+				if (search.is_reached(id)) {
 					// Polygon already visited, check if we can reduce the travel cost.
-					if (new_distance < it->traveled_distance) {
-						it->back_navigation_poly_id = least_cost_id;
-						it->back_navigation_edge = connection.edge;
-						it->back_navigation_edge_pathway_start = connection.pathway_start;
-						it->back_navigation_edge_pathway_end = connection.pathway_end;
-						it->traveled_distance = new_distance;
-						it->entry = new_entry;
+					gd::NavigationPoly &np = navigation_polys[id];
+					if (new_distance < np.traveled_distance) {
+						np.back_navigation_poly_id = least_cost_id;
+						np.back_navigation_edge = connection.edge;
+						np.back_navigation_edge_pathway_start = connection.pathway_start;
+						np.back_navigation_edge_pathway_end = connection.pathway_end;
+						np.traveled_distance = new_distance;
+						np.entry = new_entry;
+						if (np.heap_index != UINT32_MAX) {
+							np.cost = new_distance + new_entry.distance_to(end_point);
+							search.update(id);
+						}
 					}
 				} else {
 					// Add the neighbour polygon to the reachable ones.
-					gd::NavigationPoly new_navigation_poly = gd::NavigationPoly(connection.polygon);
-					new_navigation_poly.self_id = navigation_polys.size();
-					new_navigation_poly.back_navigation_poly_id = least_cost_id;
-					new_navigation_poly.back_navigation_edge = connection.edge;
-					new_navigation_poly.back_navigation_edge_pathway_start = connection.pathway_start;
-					new_navigation_poly.back_navigation_edge_pathway_end = connection.pathway_end;
-					new_navigation_poly.traveled_distance = new_distance;
-					new_navigation_poly.entry = new_entry;
-					navigation_polys.push_back(new_navigation_poly);
+					gd::NavigationPoly &np = search.reach(id, connection.polygon);
+					np.back_navigation_poly_id = least_cost_id;
+					np.back_navigation_edge = connection.edge;
+					np.back_navigation_edge_pathway_start = connection.pathway_start;
+					np.back_navigation_edge_pathway_end = connection.pathway_end;
+					np.traveled_distance = new_distance;
+					np.entry = new_entry;
+					np.cost = new_distance + new_entry.distance_to(end_point);
 
 					// Add the neighbour polygon to the polygons to visit.
-					to_visit.push_back(navigation_polys.size() - 1);
+					search.push(id);
 				}
 			}
 		}
 
-		// Removes the least cost polygon from the list of polygons to visit so we can advance.
-		to_visit.erase(least_cost_id);
-
-		// When the list of polygons to visit is empty at this point it means the End Polygon is not reachable
-		if (to_visit.size() == 0) {
+		// When there are no polygons left to visit at this point it means the End Polygon is not reachable
+		if (search.is_open_empty()) {
 			// Thus use the further reachable polygon
 			ERR_BREAK_MSG(is_reachable == false, "It's not expect to not find the most reachable polygons");
 			is_reachable = false;
@@ -209,7 +294,7 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 
 			// Set as end point the furthest reachable point.
 			end_poly = reachable_end;
-			end_d = 1e20;
+			float end_d = 1e20;
 			for (size_t point_id = 2; point_id < end_poly->points.size(); point_id++) {
 				Face3 f(end_poly->points[0].pos, end_poly->points[point_id - 1].pos, end_poly->points[point_id].pos);
 				Vector3 spoint = f.get_closest_point_to(p_destination);
@@ -220,33 +305,19 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 				}
 			}
 
-			// Reset open and navigation_polys
-			gd::NavigationPoly np = navigation_polys[0];
-			navigation_polys.clear();
-			navigation_polys.push_back(np);
-			to_visit.clear();
-			to_visit.push_back(0);
-			least_cost_id = 0;
+			// Restart from the begin polygon, a new generation forgets the previous search.
+			gd::NavigationPoly np = navigation_polys[begin_id];
+			search.begin(polygon_count);
+			search.reach(begin_id, begin_poly) = np;
+			least_cost_id = begin_id;
 
 			reachable_end = nullptr;
 
 			continue;
 		}
 
-		// Find the polygon with the minimum cost from the list of polygons to visit.
-		least_cost_id = -1;
-		float least_cost = 1e30;
-		for (List<uint32_t>::Element *element = to_visit.front(); element != nullptr; element = element->next()) {
-			gd::NavigationPoly *np = &navigation_polys[element->get()];
-			float cost = np->traveled_distance;
-			cost += np->entry.distance_to(end_point);
-			if (cost < least_cost) {
-				least_cost_id = np->self_id;
-				least_cost = cost;
-			}
-		}
-
-		ERR_BREAK(least_cost_id == -1);
+		// Take the polygon with the minimum cost from the polygons to visit.
+		least_cost_id = search.pop();
 
 		// Stores the further reachable end polygon, in case our goal is not reachable.
 		if (is_reachable) {
@@ -367,52 +438,60 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 	return path;
 }
 
-Vector3 NavMap::get_closest_point_to_segment(const Vector3 &p_from, const Vector3 &p_to, const bool p_use_collision) const {
-	bool use_collision = p_use_collision;
-	Vector3 closest_point;
-	real_t closest_point_d = 1e20;
+struct NavMapPathBatch {
+	const NavMap *map = nullptr;
+	const Vector3 *origins = nullptr;
+	const Vector3 *destinations = nullptr;
+	Vector<Vector3> *paths = nullptr;
+	bool optimize = false;
+	uint32_t layers = 0;
 
-	for (size_t i(0); i < polygons.size(); i++) {
-		const gd::Polygon &p = polygons[i];
+	void get_path(uint32_t p_index, void *p_userdata) {
+		paths[p_index] = map->get_path(origins[p_index], destinations[p_index], optimize, layers);
+	}
+};
 
-		// For each face check the distance to the segment
-		for (size_t point_id = 2; point_id < p.points.size(); point_id += 1) {
-			const Face3 f(p.points[0].pos, p.points[point_id - 1].pos, p.points[point_id].pos);
-			Vector3 inters;
-			if (f.intersects_segment(p_from, p_to, &inters)) {
-				const real_t d = closest_point_d = p_from.distance_to(inters);
-				if (use_collision == false) {
-					closest_point = inters;
-					use_collision = true;
-					closest_point_d = d;
-				} else if (closest_point_d > d) {
-					closest_point = inters;
-					closest_point_d = d;
-				}
-			}
-		}
+Vector<Vector<Vector3>> NavMap::get_paths(const Vector<Vector3> &p_origins, const Vector<Vector3> &p_destinations, bool p_optimize, uint32_t p_layers) const {
+	ERR_FAIL_COND_V_MSG(p_origins.size() != p_destinations.size(), Vector<Vector<Vector3>>(), "There must be as many origins as destinations.");
 
-		if (use_collision == false) {
-			for (size_t point_id = 0; point_id < p.points.size(); point_id += 1) {
-				Vector3 a, b;
+	Vector<Vector<Vector3>> paths;
+	paths.resize(p_origins.size());
+	if (paths.is_empty()) {
+		return paths;
+	}
 
-				Geometry3D::get_closest_points_between_segments(
-						p_from,
-						p_to,
-						p.points[point_id].pos,
-						p.points[(point_id + 1) % p.points.size()].pos,
-						a,
-						b);
+	NavMapPathBatch batch;
+	batch.map = this;
+	batch.origins = p_origins.ptr();
+	batch.destinations = p_destinations.ptr();
+	batch.paths = paths.ptrw();
+	batch.optimize = p_optimize;
+	batch.layers = p_layers;
+	thread_process_array(paths.size(), &batch, &NavMapPathBatch::get_path, (void *)nullptr);
 
-				const real_t d = a.distance_to(b);
-				if (d < closest_point_d) {
-					closest_point_d = d;
-					closest_point = b;
-				}
-			}
+	return paths;
+}
+
+Vector3 NavMap::get_closest_point_to_segment(const Vector3 &p_from, const Vector3 &p_to, const bool p_use_collision) const {
+	Vector3 closest_point;
+	real_t closest_point_d = 1e20;
+	bool use_collision = false;
+	for (size_t r(0); r < regions.size(); r++) {
+		if (regions[r]->get_bvh().intersect_segment(regions[r]->get_polygons(), p_from, p_to, closest_point_d, closest_point)) {
+			use_collision = true;
 		}
 	}
 
+	if (use_collision || p_use_collision) {
+		return closest_point;
+	}
+
+	// Without collision fall back to the closest polygon edge.
+	real_t closest_point_ds = 1e20;
+	for (size_t r(0); r < regions.size(); r++) {
+		regions[r]->get_bvh().get_closest_point_to_segment(regions[r]->get_polygons(), p_from, p_to, closest_point_ds, closest_point);
+	}
+
 	return closest_point;
 }
 
@@ -432,39 +511,42 @@ RID NavMap::get_closest_point_owner(const Vector3 &p_point) const {
 }
 
 gd::ClosestPointQueryResult NavMap::get_closest_point_info(const Vector3 &p_point) const {
+	const NavBVH::ClosestPoint closest = get_closest_polygon_point(p_point, 0);
+
 	gd::ClosestPointQueryResult result;
-	real_t closest_point_ds = 1e20;
+	if (closest.polygon) {
+		result.point = closest.point;
+		result.normal = closest.normal;
+		result.owner = closest.polygon->owner->get_self();
+	}
+	return result;
+}
 
-	for (size_t i(0); i < polygons.size(); i++) {
-		const gd::Polygon &p = polygons[i];
-
-		// For each face check the distance to the point
-		for (size_t point_id = 2; point_id < p.points.size(); point_id += 1) {
-			const Face3 f(p.points[0].pos, p.points[point_id - 1].pos, p.points[point_id].pos);
-			const Vector3 inters = f.get_closest_point_to(p_point);
-			const real_t ds = inters.distance_squared_to(p_point);
-			if (ds < closest_point_ds) {
-				result.point = inters;
-				result.normal = f.get_plane().normal;
-				result.owner = p.owner->get_self();
-				closest_point_ds = ds;
-			}
+NavBVH::ClosestPoint NavMap::get_closest_polygon_point(const Vector3 &p_point, uint32_t p_layers) const {
+	NavBVH::ClosestPoint closest;
+	for (size_t r(0); r < regions.size(); r++) {
+		// Only consider the regions with compatible layers, when asked to.
+		if (p_layers != 0 && (p_layers & regions[r]->get_layers()) == 0) {
+			continue;
 		}
+		regions[r]->get_bvh().get_closest_point(regions[r]->get_polygons(), p_point, closest);
 	}
-
-	return result;
+	return closest;
 }
 
 void NavMap::add_region(NavRegion *p_region) {
+	// The region polygons are dirty, they get linked on sync.
 	regions.push_back(p_region);
-	regenerate_links = true;
 }
 
 void NavMap::remove_region(NavRegion *p_region) {
 	const std::vector<NavRegion *>::iterator it = std::find(regions.begin(), regions.end(), p_region);
 	if (it != regions.end()) {
+		// The regions around it can no longer link to its polygons.
+		if (!p_region->get_polygons().empty()) {
+			changed_bounds.push_back(p_region->get_bounds());
+		}
 		regions.erase(it);
-		regenerate_links = true;
 	}
 }
 
@@ -475,7 +557,6 @@ bool NavMap::has_agent(RvoAgent *agent) const {
 void NavMap::add_agent(RvoAgent *agent) {
 	if (!has_agent(agent)) {
 		agents.push_back(agent);
-		agents_dirty = true;
 	}
 }
 
@@ -484,7 +565,6 @@ void NavMap::remove_agent(RvoAgent *agent) {
 	const std::vector<RvoAgent *>::iterator it = std::find(agents.begin(), agents.end(), agent);
 	if (it != agents.end()) {
 		agents.erase(it);
-		agents_dirty = true;
 	}
 }
 
@@ -503,183 +583,345 @@ void NavMap::remove_agent_as_controlled(RvoAgent *agent) {
 	}
 }
 
-void NavMap::sync() {
-	// Check if we need to update the links.
-	if (regenerate_polygons) {
-		for (size_t r(0); r < regions.size(); r++) {
-			regions[r]->scratch_polygons();
-		}
-		regenerate_links = true;
+// Links the free edges of some regions to the edges of the regions around them.
+// Each region only writes to its own polygons, so they are linked in parallel.
+struct NavMapLinker {
+	enum {
+		// Edges covering more grid cells are not put in the grid.
+		MAX_EDGE_CELLS = 64,
+	};
+
+	struct KeyEdges {
+		gd::Edge::Connection edges[2];
+		uint32_t count = 0;
+	};
+
+	struct Candidate {
+		gd::Edge::Connection edge;
+		Vector3i cell_min;
+		Vector3i cell_max;
+	};
+
+	real_t margin = 0.0;
+	real_t cell_size = 1.0;
+
+	/// The free edges of the regions taking part, by key.
+	DenseHashMap<gd::EdgeKey, KeyEdges, gd::EdgeKeyHasher> key_edges;
+	/// The free edges without an edge of the same key, these are connected to the close edges.
+	LocalVector<Candidate> candidates;
+	/// A grid of the candidates, the larger ones are always tested.
+	DenseHashMap<uint64_t, LocalVector<uint32_t>> cells;
+	LocalVector<uint32_t> large_candidates;
+
+	static gd::EdgeKey get_edge_key(const gd::Edge::Connection &p_edge) {
+		const gd::Polygon *polygon = p_edge.polygon;
+		return gd::EdgeKey(polygon->points[p_edge.edge].key, polygon->points[(p_edge.edge + 1) % polygon->points.size()].key);
 	}
 
-	for (size_t r(0); r < regions.size(); r++) {
-		if (regions[r]->sync()) {
-			regenerate_links = true;
-		}
+	static AABB get_edge_bounds(const gd::Edge::Connection &p_edge) {
+		AABB bounds(p_edge.pathway_start, Vector3());
+		bounds.expand_to(p_edge.pathway_end);
+		return bounds;
 	}
 
-	if (regenerate_links) {
-		// Remove regions connections.
-		for (size_t r(0); r < regions.size(); r++) {
-			regions[r]->get_connections().clear();
-		}
+	static int64_t get_cell_count(const Vector3i &p_min, const Vector3i &p_max) {
+		return int64_t(p_max.x - p_min.x + 1) * int64_t(p_max.y - p_min.y + 1) * int64_t(p_max.z - p_min.z + 1);
+	}
 
-		// Resize the polygon count.
-		int count = 0;
-		for (size_t r(0); r < regions.size(); r++) {
-			count += regions[r]->get_polygons().size();
+	static uint64_t get_cell_key(const Vector3i &p_cell) {
+		gd::PointKey key;
+		key.x = p_cell.x;
+		key.y = p_cell.y;
+		key.z = p_cell.z;
+		return key.key;
+	}
+
+	Vector3i get_cell(const Vector3 &p_pos) const {
+		return Vector3i(int(Math::floor(p_pos.x / cell_size)), int(Math::floor(p_pos.y / cell_size)), int(Math::floor(p_pos.z / cell_size)));
+	}
+
+	void build(const LocalVector<NavRegion *> &p_regions) {
+		for (uint32_t r = 0; r < p_regions.size(); r++) {
+			const LocalVector<gd::Edge::Connection> &free_edges = p_regions[r]->get_free_edges();
+			for (uint32_t i = 0; i < free_edges.size(); i++) {
+				KeyEdges &edges = key_edges[get_edge_key(free_edges[i])];
+				if (edges.count < 2) {
+					edges.edges[edges.count] = free_edges[i];
+				}
+				edges.count++;
+			}
 		}
-		polygons.resize(count);
 
-		// Copy all region polygons in the map.
-		count = 0;
-		for (size_t r(0); r < regions.size(); r++) {
-			std::copy(
-					regions[r]->get_polygons().data(),
-					regions[r]->get_polygons().data() + regions[r]->get_polygons().size(),
-					polygons.begin() + count);
-			count += regions[r]->get_polygons().size();
+		real_t length = 0.0;
+		for (uint32_t r = 0; r < p_regions.size(); r++) {
+			const LocalVector<gd::Edge::Connection> &free_edges = p_regions[r]->get_free_edges();
+			for (uint32_t i = 0; i < free_edges.size(); i++) {
+				if (key_edges.get(get_edge_key(free_edges[i])).count == 1) {
+					Candidate candidate;
+					candidate.edge = free_edges[i];
+					candidates.push_back(candidate);
+					length += free_edges[i].pathway_start.distance_to(free_edges[i].pathway_end);
+				}
+			}
 		}
 
-		// Group all edges per key.
-		Map<gd::EdgeKey, Vector<gd::Edge::Connection>> connections;
-		for (size_t poly_id(0); poly_id < polygons.size(); poly_id++) {
-			gd::Polygon &poly(polygons[poly_id]);
+		if (candidates.is_empty()) {
+			return;
+		}
 
-			for (size_t p(0); p < poly.points.size(); p++) {
-				int next_point = (p + 1) % poly.points.size();
-				gd::EdgeKey ek(poly.points[p].key, poly.points[next_point].key);
+		// Cells about the size of an edge keep both the cells per edge and the edges per cell low.
+		cell_size = MAX(margin, length / candidates.size());
+		if (cell_size < CMP_EPSILON) {
+			cell_size = 1.0;
+		}
 
-				Map<gd::EdgeKey, Vector<gd::Edge::Connection>>::Element *connection = connections.find(ek);
-				if (!connection) {
-					connections[ek] = Vector<gd::Edge::Connection>();
-				}
-				if (connections[ek].size() <= 1) {
-					// Add the polygon/edge tuple to this key.
-					gd::Edge::Connection new_connection;
-					new_connection.polygon = &poly;
-					new_connection.edge = p;
-					new_connection.pathway_start = poly.points[p].pos;
-					new_connection.pathway_end = poly.points[next_point].pos;
-					connections[ek].push_back(new_connection);
-				} else {
-					// The edge is already connected with another edge, skip.
-					ERR_PRINT_ONCE("Attempted to merge a navigation mesh triangle edge with another already-merged edge. This happens when the current `cell_size` is different from the one used to generate the navigation mesh. This will cause navigation problem.");
+		for (uint32_t i = 0; i < candidates.size(); i++) {
+			Candidate &candidate = candidates[i];
+			const AABB bounds = get_edge_bounds(candidate.edge);
+			candidate.cell_min = get_cell(bounds.position);
+			candidate.cell_max = get_cell(bounds.position + bounds.size);
+			if (get_cell_count(candidate.cell_min, candidate.cell_max) > MAX_EDGE_CELLS) {
+				large_candidates.push_back(i);
+				continue;
+			}
+			for (int x = candidate.cell_min.x; x <= candidate.cell_max.x; x++) {
+				for (int y = candidate.cell_min.y; y <= candidate.cell_max.y; y++) {
+					for (int z = candidate.cell_min.z; z <= candidate.cell_max.z; z++) {
+						cells[get_cell_key(Vector3i(x, y, z))].push_back(i);
+					}
 				}
 			}
 		}
+	}
 
-		Vector<gd::Edge::Connection> free_edges;
-		for (KeyValue<gd::EdgeKey, Vector<gd::Edge::Connection>> &E : connections) {
-			if (E.value.size() == 2) {
-				// Connect edge that are shared in different polygons.
-				gd::Edge::Connection &c1 = E.value.write[0];
-				gd::Edge::Connection &c2 = E.value.write[1];
-				c1.polygon->edges[c1.edge].connections.push_back(c2);
-				c2.polygon->edges[c2.edge].connections.push_back(c1);
-				// Note: The pathway_start/end are full for those connection and do not need to be modified.
-			} else {
-				CRASH_COND_MSG(E.value.size() != 1, vformat("Number of connection != 1. Found: %d", E.value.size()));
-				free_edges.push_back(E.value[0]);
-			}
+	bool connect_edges(const gd::Edge::Connection &p_free_edge, const gd::Edge::Connection &p_other_edge, gd::Edge::Connection &r_connection) const {
+		Vector3 edge_p1 = p_free_edge.polygon->points[p_free_edge.edge].pos;
+		Vector3 edge_p2 = p_free_edge.polygon->points[(p_free_edge.edge + 1) % p_free_edge.polygon->points.size()].pos;
+
+		Vector3 other_edge_p1 = p_other_edge.polygon->points[p_other_edge.edge].pos;
+		Vector3 other_edge_p2 = p_other_edge.polygon->points[(p_other_edge.edge + 1) % p_other_edge.polygon->points.size()].pos;
+
+		// Compute the projection of the opposite edge on the current one
+		Vector3 edge_vector = edge_p2 - edge_p1;
+		float projected_p1_ratio = edge_vector.dot(other_edge_p1 - edge_p1) / (edge_vector.length_squared());
+		float projected_p2_ratio = edge_vector.dot(other_edge_p2 - edge_p1) / (edge_vector.length_squared());
+		if ((projected_p1_ratio < 0.0 && projected_p2_ratio < 0.0) || (projected_p1_ratio > 1.0 && projected_p2_ratio > 1.0)) {
+			return false;
 		}
 
-		// Find the compatible near edges.
-		//
-		// Note:
-		// Considering that the edges must be compatible (for obvious reasons)
-		// to be connected, create new polygons to remove that small gap is
-		// not really useful and would result in wasteful computation during
-		// connection, integration and path finding.
-		for (int i = 0; i < free_edges.size(); i++) {
-			const gd::Edge::Connection &free_edge = free_edges[i];
-			Vector3 edge_p1 = free_edge.polygon->points[free_edge.edge].pos;
-			Vector3 edge_p2 = free_edge.polygon->points[(free_edge.edge + 1) % free_edge.polygon->points.size()].pos;
+		// Check if the two edges are close to each other enough and compute a pathway between the two regions.
+		Vector3 self1 = edge_vector * CLAMP(projected_p1_ratio, 0.0, 1.0) + edge_p1;
+		Vector3 other1;
+		if (projected_p1_ratio >= 0.0 && projected_p1_ratio <= 1.0) {
+			other1 = other_edge_p1;
+		} else {
+			other1 = other_edge_p1.lerp(other_edge_p2, (1.0 - projected_p1_ratio) / (projected_p2_ratio - projected_p1_ratio));
+		}
+		if (other1.distance_to(self1) > margin) {
+			return false;
+		}
 
-			for (int j = 0; j < free_edges.size(); j++) {
-				const gd::Edge::Connection &other_edge = free_edges[j];
-				if (i == j || free_edge.polygon->owner == other_edge.polygon->owner) {
-					continue;
-				}
+		Vector3 self2 = edge_vector * CLAMP(projected_p2_ratio, 0.0, 1.0) + edge_p1;
+		Vector3 other2;
+		if (projected_p2_ratio >= 0.0 && projected_p2_ratio <= 1.0) {
+			other2 = other_edge_p2;
+		} else {
+			other2 = other_edge_p1.lerp(other_edge_p2, (0.0 - projected_p1_ratio) / (projected_p2_ratio - projected_p1_ratio));
+		}
+		if (other2.distance_to(self2) > margin) {
+			return false;
+		}
 
-				Vector3 other_edge_p1 = other_edge.polygon->points[other_edge.edge].pos;
-				Vector3 other_edge_p2 = other_edge.polygon->points[(other_edge.edge + 1) % other_edge.polygon->points.size()].pos;
+		// The edges can now be connected.
+		r_connection = p_other_edge;
+		r_connection.pathway_start = (self1 + other1) / 2.0;
+		r_connection.pathway_end = (self2 + other2) / 2.0;
+		return true;
+	}
 
-				// Compute the projection of the opposite edge on the current one
-				Vector3 edge_vector = edge_p2 - edge_p1;
-				float projected_p1_ratio = edge_vector.dot(other_edge_p1 - edge_p1) / (edge_vector.length_squared());
-				float projected_p2_ratio = edge_vector.dot(other_edge_p2 - edge_p1) / (edge_vector.length_squared());
-				if ((projected_p1_ratio < 0.0 && projected_p2_ratio < 0.0) || (projected_p1_ratio > 1.0 && projected_p2_ratio > 1.0)) {
-					continue;
-				}
+	void connect_candidate(const gd::Edge::Connection &p_free_edge, uint32_t p_candidate, Vector<gd::Edge::Connection> &r_edge_connections, Vector<gd::Edge::Connection> &r_region_connections) const {
+		const gd::Edge::Connection &other_edge = candidates[p_candidate].edge;
+		if (p_free_edge.polygon->owner == other_edge.polygon->owner) {
+			return;
+		}
+
+		gd::Edge::Connection new_connection;
+		if (connect_edges(p_free_edge, other_edge, new_connection)) {
+			r_edge_connections.push_back(new_connection);
+
+			// Add the connection to the region_connection map.
+			r_region_connections.push_back(new_connection);
+		}
+	}
+
+	void link_region(uint32_t p_index, NavRegion **p_regions) {
+		NavRegion *region = p_regions[p_index];
+		Vector<gd::Edge::Connection> &region_connections = region->get_connections();
+		region_connections.clear();
 
-				// Check if the two edges are close to each other enough and compute a pathway between the two regions.
-				Vector3 self1 = edge_vector * CLAMP(projected_p1_ratio, 0.0, 1.0) + edge_p1;
-				Vector3 other1;
-				if (projected_p1_ratio >= 0.0 && projected_p1_ratio <= 1.0) {
-					other1 = other_edge_p1;
+		const LocalVector<gd::Edge::Connection> &free_edges = region->get_free_edges();
+		for (uint32_t i = 0; i < free_edges.size(); i++) {
+			const gd::Edge::Connection &free_edge = free_edges[i];
+			Vector<gd::Edge::Connection> &edge_connections = free_edge.polygon->edges[free_edge.edge].connections;
+			edge_connections.clear();
+
+			const KeyEdges &edges = key_edges.get(get_edge_key(free_edge));
+			if (edges.count >= 2) {
+				// Connect edge that are shared in different polygons, beyond the first two they are skipped.
+				if (edges.edges[0].polygon == free_edge.polygon && edges.edges[0].edge == free_edge.edge) {
+					edge_connections.push_back(edges.edges[1]);
+				} else if (edges.edges[1].polygon == free_edge.polygon && edges.edges[1].edge == free_edge.edge) {
+					edge_connections.push_back(edges.edges[0]);
 				} else {
-					other1 = other_edge_p1.lerp(other_edge_p2, (1.0 - projected_p1_ratio) / (projected_p2_ratio - projected_p1_ratio));
-				}
-				if (other1.distance_to(self1) > edge_connection_margin) {
-					continue;
+					ERR_PRINT_ONCE("Attempted to merge a navigation mesh triangle edge with another already-merged edge. This happens when the current `cell_size` is different from the one used to generate the navigation mesh. This will cause navigation problem.");
 				}
+				continue;
+			}
 
-				Vector3 self2 = edge_vector * CLAMP(projected_p2_ratio, 0.0, 1.0) + edge_p1;
-				Vector3 other2;
-				if (projected_p2_ratio >= 0.0 && projected_p2_ratio <= 1.0) {
-					other2 = other_edge_p2;
-				} else {
-					other2 = other_edge_p1.lerp(other_edge_p2, (0.0 - projected_p1_ratio) / (projected_p2_ratio - projected_p1_ratio));
+			// Find the compatible near edges.
+			//
+			// Note:
+			// Considering that the edges must be compatible (for obvious reasons)
+			// to be connected, create new polygons to remove that small gap is
+			// not really useful and would result in wasteful computation during
+			// connection, integration and path finding.
+			const AABB bounds = get_edge_bounds(free_edge).grow(margin);
+			const Vector3i query_min = get_cell(bounds.position);
+			const Vector3i query_max = get_cell(bounds.position + bounds.size);
+			if (get_cell_count(query_min, query_max) > MAX_EDGE_CELLS) {
+				for (uint32_t j = 0; j < candidates.size(); j++) {
+					connect_candidate(free_edge, j, edge_connections, region_connections);
 				}
-				if (other2.distance_to(self2) > edge_connection_margin) {
-					continue;
+				continue;
+			}
+
+			for (int x = query_min.x; x <= query_max.x; x++) {
+				for (int y = query_min.y; y <= query_max.y; y++) {
+					for (int z = query_min.z; z <= query_max.z; z++) {
+						const Vector3i cell(x, y, z);
+						const LocalVector<uint32_t> *cell_candidates = cells.getptr(get_cell_key(cell));
+						if (!cell_candidates) {
+							continue;
+						}
+						for (uint32_t j = 0; j < cell_candidates->size(); j++) {
+							// A candidate spanning several cells is only tested in the first cell it shares with the query.
+							const Candidate &candidate = candidates[(*cell_candidates)[j]];
+							const Vector3i first(MAX(candidate.cell_min.x, query_min.x), MAX(candidate.cell_min.y, query_min.y), MAX(candidate.cell_min.z, query_min.z));
+							if (first != cell || cell.x > candidate.cell_max.x || cell.y > candidate.cell_max.y || cell.z > candidate.cell_max.z) {
+								continue;
+							}
+							connect_candidate(free_edge, (*cell_candidates)[j], edge_connections, region_connections);
+						}
+					}
 				}
+			}
+
+			for (uint32_t j = 0; j < large_candidates.size(); j++) {
+				connect_candidate(free_edge, large_candidates[j], edge_connections, region_connections);
+			}
+		}
+	}
+};
 
-				// The edges can now be connected.
-				gd::Edge::Connection new_connection = other_edge;
-				new_connection.pathway_start = (self1 + other1) / 2.0;
-				new_connection.pathway_end = (self2 + other2) / 2.0;
-				free_edge.polygon->edges[free_edge.edge].connections.push_back(new_connection);
+real_t NavMap::get_link_distance() const {
+	// Edges get connected when they are within the margin, or when their points share the same key.
+	return MAX(edge_connection_margin, cell_size);
+}
+
+void NavMap::link_regions(LocalVector<NavRegion *> &p_regions) {
+	NavMapLinker linker;
+	linker.margin = edge_connection_margin;
 
-				// Add the connection to the region_connection map.
-				free_edge.polygon->owner->get_connections().push_back(new_connection);
+	// Only the edges of the regions around the linked ones can be connected to them.
+	LocalVector<NavRegion *> close_regions;
+	for (size_t r(0); r < regions.size(); r++) {
+		if (regions[r]->get_free_edges().is_empty()) {
+			continue;
+		}
+		const AABB bounds = regions[r]->get_bounds().grow(get_link_distance());
+		for (uint32_t i = 0; i < p_regions.size(); i++) {
+			if (bounds.intersects_inclusive(p_regions[i]->get_bounds())) {
+				close_regions.push_back(regions[r]);
+				break;
 			}
 		}
+	}
 
-		// Update the update ID.
-		map_update_id = (map_update_id + 1) % 9999999;
+	linker.build(close_regions);
+	thread_process_array(p_regions.size(), &linker, &NavMapLinker::link_region, p_regions.ptr());
+}
+
+void NavMap::sync_region(uint32_t index, NavRegion **region) {
+	(*(region + index))->sync();
+}
+
+void NavMap::sync() {
+	// Check if we need to update the links.
+	if (regenerate_polygons) {
+		for (size_t r(0); r < regions.size(); r++) {
+			regions[r]->scratch_polygons();
+		}
+		regenerate_links = true;
+	}
+
+	// Only the changed regions rebuild their polygons, on the worker threads.
+	LocalVector<NavRegion *> dirty_regions;
+	for (size_t r(0); r < regions.size(); r++) {
+		if (regions[r]->is_dirty()) {
+			if (!regions[r]->get_polygons().empty()) {
+				changed_bounds.push_back(regions[r]->get_bounds());
+			}
+			dirty_regions.push_back(regions[r]);
+		}
+	}
+	if (!dirty_regions.is_empty()) {
+		thread_process_array(dirty_regions.size(), this, &NavMap::sync_region, dirty_regions.ptr());
+		for (uint32_t i = 0; i < dirty_regions.size(); i++) {
+			if (!dirty_regions[i]->get_polygons().empty()) {
+				changed_bounds.push_back(dirty_regions[i]->get_bounds());
+			}
+		}
 	}
 
-	// Update agents tree.
-	if (agents_dirty) {
-		std::vector<RVO::Agent *> raw_agents;
-		raw_agents.reserve(agents.size());
-		for (size_t i(0); i < agents.size(); i++) {
-			raw_agents.push_back(agents[i]->get_agent());
+	if (regenerate_links || !dirty_regions.is_empty() || !changed_bounds.is_empty()) {
+		// Give the polygons their index in the map.
+		polygon_count = 0;
+		for (size_t r(0); r < regions.size(); r++) {
+			regions[r]->set_polygon_offset(polygon_count);
+			polygon_count += regions[r]->get_polygons().size();
+		}
+
+		// Link again the regions close to where polygons changed, the others keep their links.
+		LocalVector<NavRegion *> relinked_regions;
+		for (size_t r(0); r < regions.size(); r++) {
+			if (regions[r]->get_polygons().empty()) {
+				continue;
+			}
+			bool relink = regenerate_links;
+			const AABB bounds = regions[r]->get_bounds().grow(get_link_distance());
+			for (uint32_t i = 0; i < changed_bounds.size() && !relink; i++) {
+				relink = bounds.intersects_inclusive(changed_bounds[i]);
+			}
+			if (relink) {
+				relinked_regions.push_back(regions[r]);
+			}
+		}
+		if (!relinked_regions.is_empty()) {
+			link_regions(relinked_regions);
 		}
-		rvo.buildAgentTree(raw_agents);
+		changed_bounds.clear();
+
+		// Update the update ID.
+		map_update_id = (map_update_id + 1) % 9999999;
 	}
 
 	regenerate_polygons = false;
 	regenerate_links = false;
-	agents_dirty = false;
-}
-
-void NavMap::compute_single_step(uint32_t index, RvoAgent **agent) {
-	(*(agent + index))->get_agent()->computeNeighbors(&rvo);
-	(*(agent + index))->get_agent()->computeNewVelocity(deltatime);
 }
 
 void NavMap::step(real_t p_deltatime) {
-	deltatime = p_deltatime;
-	if (controlled_agents.size() > 0) {
-		thread_process_array(
-				controlled_agents.size(),
-				this,
-				&NavMap::compute_single_step,
-				controlled_agents.data());
-	}
+	// The agents are gathered again every step, so the avoidance always sees where they are now.
+	crowd.step(agents, controlled_agents, p_deltatime);
 }
 
 void NavMap::dispatch_callbacks() {
@@ -688,7 +930,7 @@ void NavMap::dispatch_callbacks() {
 	}
 }
 
-void NavMap::clip_path(const std::vector<gd::NavigationPoly> &p_navigation_polys, Vector<Vector3> &path, const gd::NavigationPoly *from_poly, const Vector3 &p_to_point, const gd::NavigationPoly *p_to_poly) const {
+void NavMap::clip_path(const LocalVector<gd::NavigationPoly> &p_navigation_polys, Vector<Vector3> &path, const gd::NavigationPoly *from_poly, const Vector3 &p_to_point, const gd::NavigationPoly *p_to_poly) const {
 	Vector3 from = path[path.size() - 1];
 
 	if (from.is_equal_approx(p_to_point)) {
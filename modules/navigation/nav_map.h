@@ -34,11 +34,12 @@
 #include "nav_rid.h"
 
 #include "core/math/math_defs.h"
+#include "core/templates/local_vector.h"
 #include "core/templates/map.h"
+#include "nav_bvh.h"
+#include "nav_crowd.h"
 #include "nav_utils.h"
 
-#include <KdTree.h>
-
 class NavRegion;
 class RvoAgent;
 class NavRegion;
@@ -59,14 +60,14 @@ class NavMap : public NavRid {
 
 	std::vector<NavRegion *> regions;
 
-	/// Map polygons
-	std::vector<gd::Polygon> polygons;
+	/// The number of polygons of all the regions.
+	uint32_t polygon_count = 0;
 
-	/// Rvo world
-	RVO::KdTree rvo;
+	/// Where polygons changed since the last sync, the regions close to these bounds need new links.
+	LocalVector<AABB> changed_bounds;
 
-	/// Is agent array modified?
-	bool agents_dirty = false;
+	/// Local avoidance of the agents
+	NavCrowd crowd;
 
 	/// All the Agents (even the controlled one)
 	std::vector<RvoAgent *> agents;
@@ -74,9 +75,6 @@ class NavMap : public NavRid {
 	/// Controlled agents
 	std::vector<RvoAgent *> controlled_agents;
 
-	/// Physics delta time
-	real_t deltatime = 0.0;
-
 	/// Change the id each time the map is updated.
 	uint32_t map_update_id = 0;
 
@@ -101,6 +99,8 @@ public:
 	gd::PointKey get_point_key(const Vector3 &p_pos) const;
 
 	Vector<Vector3> get_path(Vector3 p_origin, Vector3 p_destination, bool p_optimize, uint32_t p_layers = 1) const;
+	/// Answers many path queries at once, spread over the worker threads.
+	Vector<Vector<Vector3>> get_paths(const Vector<Vector3> &p_origins, const Vector<Vector3> &p_destinations, bool p_optimize, uint32_t p_layers = 1) const;
 	Vector3 get_closest_point_to_segment(const Vector3 &p_from, const Vector3 &p_to, const bool p_use_collision) const;
 	Vector3 get_closest_point(const Vector3 &p_point) const;
 	Vector3 get_closest_point_normal(const Vector3 &p_point) const;
@@ -132,8 +132,11 @@ public:
 	void dispatch_callbacks();
 
 private:
-	void compute_single_step(uint32_t index, RvoAgent **agent);
-	void clip_path(const std::vector<gd::NavigationPoly> &p_navigation_polys, Vector<Vector3> &path, const gd::NavigationPoly *from_poly, const Vector3 &p_to_point, const gd::NavigationPoly *p_to_poly) const;
+	void sync_region(uint32_t index, NavRegion **region);
+	real_t get_link_distance() const;
+	void link_regions(LocalVector<NavRegion *> &p_regions);
+	NavBVH::ClosestPoint get_closest_polygon_point(const Vector3 &p_point, uint32_t p_layers) const;
+	void clip_path(const LocalVector<gd::NavigationPoly> &p_navigation_polys, Vector<Vector3> &path, const gd::NavigationPoly *from_poly, const Vector3 &p_to_point, const gd::NavigationPoly *p_to_poly) const;
 };
 
 #endif // RVO_SPACE_H
@@ -32,6 +32,8 @@
 
 #include "nav_map.h"
 
+#include "core/templates/dense_hash_map.h"
+
 void NavRegion::set_map(NavMap *p_map) {
 	map = p_map;
 	polygons_dirty = true;
@@ -77,14 +79,83 @@ Vector3 NavRegion::get_connection_pathway_end(int p_connection_id) const {
 	return connections[p_connection_id].pathway_end;
 }
 
+void NavRegion::set_polygon_offset(uint32_t p_offset) {
+	if (polygon_offset == p_offset) {
+		return;
+	}
+	polygon_offset = p_offset;
+	for (size_t i(0); i < polygons.size(); i++) {
+		polygons[i].id = p_offset + i;
+	}
+}
+
 bool NavRegion::sync() {
 	bool something_changed = polygons_dirty /* || something_dirty? */;
 
 	update_polygons();
 
+	if (something_changed) {
+		connect_polygons();
+
+		// When the polygons only moved the tree is refitted, otherwise it is built again.
+		if (bvh.get_polygon_count() != polygons.size() || !bvh.refit(polygons)) {
+			bvh.build(polygons);
+		}
+		polygon_offset = UINT32_MAX;
+	}
+
 	return something_changed;
 }
 
+void NavRegion::connect_polygons() {
+	struct EdgeConnections {
+		gd::Edge::Connection connections[2];
+		uint32_t count = 0;
+	};
+
+	connections.clear();
+	free_edges.clear();
+
+	// Group all edges per key.
+	DenseHashMap<gd::EdgeKey, EdgeConnections, gd::EdgeKeyHasher> edges;
+	edges.reserve(polygons.size() * 2);
+	for (size_t poly_id(0); poly_id < polygons.size(); poly_id++) {
+		gd::Polygon &poly(polygons[poly_id]);
+
+		for (size_t p(0); p < poly.points.size(); p++) {
+			int next_point = (p + 1) % poly.points.size();
+			gd::EdgeKey ek(poly.points[p].key, poly.points[next_point].key);
+
+			EdgeConnections &edge = edges[ek];
+			if (edge.count <= 1) {
+				// Add the polygon/edge tuple to this key.
+				gd::Edge::Connection &new_connection = edge.connections[edge.count++];
+				new_connection.polygon = &poly;
+				new_connection.edge = p;
+				new_connection.pathway_start = poly.points[p].pos;
+				new_connection.pathway_end = poly.points[next_point].pos;
+			} else {
+				// The edge is already connected with another edge, skip.
+				ERR_PRINT_ONCE("Attempted to merge a navigation mesh triangle edge with another already-merged edge. This happens when the current `cell_size` is different from the one used to generate the navigation mesh. This will cause navigation problem.");
+			}
+		}
+	}
+
+	for (KeyValue<gd::EdgeKey, EdgeConnections> &E : edges) {
+		if (E.value.count == 2) {
+			// Connect edge that are shared in different polygons.
+			gd::Edge::Connection &c1 = E.value.connections[0];
+			gd::Edge::Connection &c2 = E.value.connections[1];
+			c1.polygon->edges[c1.edge].connections.push_back(c2);
+			c2.polygon->edges[c2.edge].connections.push_back(c1);
+			// Note: The pathway_start/end are full for those connection and do not need to be modified.
+		} else {
+			// The map links it with the edges of the other regions.
+			free_edges.push_back(E.value.connections[0]);
+		}
+	}
+}
+
 void NavRegion::update_polygons() {
 	if (!polygons_dirty) {
 		return;
@@ -33,6 +33,8 @@
 
 #include "scene/resources/navigation_mesh.h"
 
+#include "core/templates/local_vector.h"
+#include "nav_bvh.h"
 #include "nav_rid.h"
 #include "nav_utils.h"
 
@@ -53,12 +55,24 @@ class NavRegion : public NavRid {
 	/// Cache
 	std::vector<gd::Polygon> polygons;
 
+	/// The polygon edges not shared with another polygon of this region, the map links them to the other regions.
+	LocalVector<gd::Edge::Connection> free_edges;
+
+	/// Polygons tree, used by the closest point queries
+	NavBVH bvh;
+
+	/// The index of the first polygon among the polygons of the map.
+	uint32_t polygon_offset = UINT32_MAX;
+
 public:
 	NavRegion() {}
 
 	void scratch_polygons() {
 		polygons_dirty = true;
 	}
+	bool is_dirty() const {
+		return polygons_dirty;
+	}
 
 	void set_map(NavMap *p_map);
 	NavMap *get_map() const {
@@ -88,11 +102,24 @@ public:
 	std::vector<gd::Polygon> const &get_polygons() const {
 		return polygons;
 	}
+	void set_polygon_offset(uint32_t p_offset);
+
+	const LocalVector<gd::Edge::Connection> &get_free_edges() const {
+		return free_edges;
+	}
+
+	const NavBVH &get_bvh() const {
+		return bvh;
+	}
+	AABB get_bounds() const {
+		return bvh.get_bounds();
+	}
 
 	bool sync();
 
 private:
 	void update_polygons();
+	void connect_polygons();
 };
 
 #endif // NAV_REGION_H
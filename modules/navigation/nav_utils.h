@@ -32,6 +32,7 @@
 #define NAV_UTILS_H
 
 #include "core/math/vector3.h"
+#include "core/templates/hashfuncs.h"
 #include "core/templates/vector.h"
 
 #include <vector>
@@ -60,6 +61,10 @@ struct EdgeKey {
 		return (a.key == p_key.a.key) ? (b.key < p_key.b.key) : (a.key < p_key.a.key);
 	}
 
+	bool operator==(const EdgeKey &p_key) const {
+		return a.key == p_key.a.key && b.key == p_key.b.key;
+	}
+
 	EdgeKey(const PointKey &p_a = PointKey(), const PointKey &p_b = PointKey()) :
 			a(p_a),
 			b(p_b) {
@@ -69,6 +74,12 @@ struct EdgeKey {
 	}
 };
 
+struct EdgeKeyHasher {
+	static _FORCE_INLINE_ uint32_t hash(const EdgeKey &p_key) {
+		return hash_djb2_one_32(hash_one_uint64(p_key.b.key), hash_one_uint64(p_key.a.key));
+	}
+};
+
 struct Point {
 	Vector3 pos;
 	PointKey key;
@@ -91,6 +102,9 @@ struct Edge {
 struct Polygon {
 	NavRegion *owner = nullptr;
 
+	/// The index of this `Polygon` among the polygons of the map.
+	uint32_t id = 0;
+
 	/// The points of this `Polygon`
 	std::vector<Point> points;
 
@@ -107,7 +121,7 @@ struct Polygon {
 struct NavigationPoly {
 	uint32_t self_id = 0;
 	/// This poly.
-	const Polygon *poly;
+	const Polygon *poly = nullptr;
 
 	/// Those 4 variables are used to travel the path backwards.
 	int back_navigation_poly_id = -1;
@@ -119,7 +133,12 @@ struct NavigationPoly {
 	Vector3 entry;
 	/// The distance to the destination.
 	float traveled_distance = 0.0;
+	/// The traveled distance plus the estimated distance left, used to order the polygons to visit.
+	float cost = 0.0;
+	/// The position in the heap of polygons to visit, `UINT32_MAX` when not in it.
+	uint32_t heap_index = UINT32_MAX;
 
+	NavigationPoly() {}
 	NavigationPoly(const Polygon *p_poly) :
 			poly(p_poly) {}
 
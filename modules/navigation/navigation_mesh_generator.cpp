@@ -34,6 +34,7 @@
 
 #include "core/math/convex_hull.h"
 #include "core/os/thread.h"
+#include "core/os/threaded_array_processor.h"
 #include "scene/3d/collision_shape_3d.h"
 #include "scene/3d/mesh_instance_3d.h"
 #include "scene/3d/multimesh_instance_3d.h"
@@ -374,14 +375,14 @@ void NavigationMeshGenerator::_parse_geometry(const Transform3D &p_navmesh_trans
 	}
 }
 
-void NavigationMeshGenerator::_convert_detail_mesh_to_native_navigation_mesh(const rcPolyMeshDetail *p_detail_mesh, Ref<NavigationMesh> p_nav_mesh) {
+void NavigationMeshGenerator::_convert_detail_mesh_to_native_navigation_mesh(const rcPolyMeshDetail *p_detail_mesh, TileMesh &r_tile_mesh) {
 	Vector<Vector3> nav_vertices;
 
 	for (int i = 0; i < p_detail_mesh->nverts; i++) {
 		const float *v = &p_detail_mesh->verts[i * 3];
 		nav_vertices.push_back(Vector3(v[0], v[1], v[2]));
 	}
-	p_nav_mesh->set_vertices(nav_vertices);
+	r_tile_mesh.vertices = nav_vertices;
 
 	for (int i = 0; i < p_detail_mesh->nmeshes; i++) {
 		const unsigned int *m = &p_detail_mesh->meshes[i * 4];
@@ -396,62 +397,63 @@ void NavigationMeshGenerator::_convert_detail_mesh_to_native_navigation_mesh(con
 			nav_indices.write[0] = ((int)(bverts + tris[j * 4 + 0]));
 			nav_indices.write[1] = ((int)(bverts + tris[j * 4 + 2]));
 			nav_indices.write[2] = ((int)(bverts + tris[j * 4 + 1]));
-			p_nav_mesh->add_polygon(nav_indices);
+			r_tile_mesh.polygons.push_back(nav_indices);
 		}
 	}
 }
 
 void NavigationMeshGenerator::_build_recast_navigation_mesh(
-		Ref<NavigationMesh> p_nav_mesh,
+		const BakeSettings &p_settings,
 #ifdef TOOLS_ENABLED
 		EditorProgress *ep,
 #endif
-		rcHeightfield *hf,
-		rcCompactHeightfield *chf,
-		rcContourSet *cset,
-		rcPolyMesh *poly_mesh,
-		rcPolyMeshDetail *detail_mesh,
-		Vector<float> &vertices,
-		Vector<int> &indices) {
+		const float *p_bmin,
+		const float *p_bmax,
+		int p_border_size,
+		const float *p_vertices,
+		int p_vertex_count,
+		const int *p_indices,
+		int p_triangle_count,
+		TileMesh &r_tile_mesh) {
 	rcContext ctx;
 
+	// Frees whatever is left when returning early.
+	struct RecastData {
+		rcHeightfield *hf = nullptr;
+		rcCompactHeightfield *chf = nullptr;
+		rcContourSet *cset = nullptr;
+		rcPolyMesh *poly_mesh = nullptr;
+		rcPolyMeshDetail *detail_mesh = nullptr;
+
+		~RecastData() {
+			rcFreeHeightField(hf);
+			rcFreeCompactHeightfield(chf);
+			rcFreeContourSet(cset);
+			rcFreePolyMesh(poly_mesh);
+			rcFreePolyMeshDetail(detail_mesh);
+		}
+	} data;
+
 #ifdef TOOLS_ENABLED
 	if (ep) {
 		ep->step(TTR("Setting up Configuration..."), 1);
 	}
 #endif
 
-	const float *verts = vertices.ptr();
-	const int nverts = vertices.size() / 3;
-	const int *tris = indices.ptr();
-	const int ntris = indices.size() / 3;
-
-	float bmin[3], bmax[3];
-	rcCalcBounds(verts, nverts, bmin, bmax);
-
-	rcConfig cfg;
-	memset(&cfg, 0, sizeof(cfg));
+	const float *verts = p_vertices;
+	const int nverts = p_vertex_count;
+	const int *tris = p_indices;
+	const int ntris = p_triangle_count;
 
-	cfg.cs = p_nav_mesh->get_cell_size();
-	cfg.ch = p_nav_mesh->get_cell_height();
-	cfg.walkableSlopeAngle = p_nav_mesh->get_agent_max_slope();
-	cfg.walkableHeight = (int)Math::ceil(p_nav_mesh->get_agent_height() / cfg.ch);
-	cfg.walkableClimb = (int)Math::floor(p_nav_mesh->get_agent_max_climb() / cfg.ch);
-	cfg.walkableRadius = (int)Math::ceil(p_nav_mesh->get_agent_radius() / cfg.cs);
-	cfg.maxEdgeLen = (int)(p_nav_mesh->get_edge_max_length() / p_nav_mesh->get_cell_size());
-	cfg.maxSimplificationError = p_nav_mesh->get_edge_max_error();
-	cfg.minRegionArea = (int)(p_nav_mesh->get_region_min_size() * p_nav_mesh->get_region_min_size());
-	cfg.mergeRegionArea = (int)(p_nav_mesh->get_region_merge_size() * p_nav_mesh->get_region_merge_size());
-	cfg.maxVertsPerPoly = (int)p_nav_mesh->get_verts_per_poly();
-	cfg.detailSampleDist = p_nav_mesh->get_detail_sample_distance() < 0.9f ? 0 : p_nav_mesh->get_cell_size() * p_nav_mesh->get_detail_sample_distance();
-	cfg.detailSampleMaxError = p_nav_mesh->get_cell_height() * p_nav_mesh->get_detail_sample_max_error();
+	rcConfig cfg = p_settings.config;
+	cfg.borderSize = p_border_size;
 
-	cfg.bmin[0] = bmin[0];
-	cfg.bmin[1] = bmin[1];
-	cfg.bmin[2] = bmin[2];
-	cfg.bmax[0] = bmax[0];
-	cfg.bmax[1] = bmax[1];
-	cfg.bmax[2] = bmax[2];
+	cfg.bmin[0] = p_bmin[0];
+	cfg.bmin[1] = p_bmin[1];
+	cfg.bmin[2] = p_bmin[2];
+	cfg.bmax[0] = p_bmax[0];
+	cfg.bmax[1] = p_bmax[1];
+	cfg.bmax[2] = p_bmax[2];
 
 #ifdef TOOLS_ENABLED
 	if (ep) {
@@ -465,10 +467,10 @@ void NavigationMeshGenerator::_build_recast_navigation_mesh(
 		ep->step(TTR("Creating heightfield..."), 3);
 	}
 #endif
-	hf = rcAllocHeightfield();
+	data.hf = rcAllocHeightfield();
 
-	ERR_FAIL_COND(!hf);
-	ERR_FAIL_COND(!rcCreateHeightfield(&ctx, *hf, cfg.width, cfg.height, cfg.bmin, cfg.bmax, cfg.cs, cfg.ch));
+	ERR_FAIL_COND(!data.hf);
+	ERR_FAIL_COND(!rcCreateHeightfield(&ctx, *data.hf, cfg.width, cfg.height, cfg.bmin, cfg.bmax, cfg.cs, cfg.ch));
 
 #ifdef TOOLS_ENABLED
 	if (ep) {
@@ -484,17 +486,17 @@ void NavigationMeshGenerator::_build_recast_navigation_mesh(
 		memset(tri_areas.ptrw(), 0, ntris * sizeof(unsigned char));
 		rcMarkWalkableTriangles(&ctx, cfg.walkableSlopeAngle, verts, nverts, tris, ntris, tri_areas.ptrw());
 
-		ERR_FAIL_COND(!rcRasterizeTriangles(&ctx, verts, nverts, tris, tri_areas.ptr(), ntris, *hf, cfg.walkableClimb));
+		ERR_FAIL_COND(!rcRasterizeTriangles(&ctx, verts, nverts, tris, tri_areas.ptr(), ntris, *data.hf, cfg.walkableClimb));
 	}
 
-	if (p_nav_mesh->get_filter_low_hanging_obstacles()) {
-		rcFilterLowHangingWalkableObstacles(&ctx, cfg.walkableClimb, *hf);
+	if (p_settings.filter_low_hanging_obstacles) {
+		rcFilterLowHangingWalkableObstacles(&ctx, cfg.walkableClimb, *data.hf);
 	}
-	if (p_nav_mesh->get_filter_ledge_spans()) {
-		rcFilterLedgeSpans(&ctx, cfg.walkableHeight, cfg.walkableClimb, *hf);
+	if (p_settings.filter_ledge_spans) {
+		rcFilterLedgeSpans(&ctx, cfg.walkableHeight, cfg.walkableClimb, *data.hf);
 	}
-	if (p_nav_mesh->get_filter_walkable_low_height_spans()) {
-		rcFilterWalkableLowHeightSpans(&ctx, cfg.walkableHeight, *hf);
+	if (p_settings.filter_walkable_low_height_spans) {
+		rcFilterWalkableLowHeightSpans(&ctx, cfg.walkableHeight, *data.hf);
 	}
 
 #ifdef TOOLS_ENABLED
@@ -503,13 +505,13 @@ void NavigationMeshGenerator::_build_recast_navigation_mesh(
 	}
 #endif
 
-	chf = rcAllocCompactHeightfield();
+	data.chf = rcAllocCompactHeightfield();
 
-	ERR_FAIL_COND(!chf);
-	ERR_FAIL_COND(!rcBuildCompactHeightfield(&ctx, cfg.walkableHeight, cfg.walkableClimb, *hf, *chf));
+	ERR_FAIL_COND(!data.chf);
+	ERR_FAIL_COND(!rcBuildCompactHeightfield(&ctx, cfg.walkableHeight, cfg.walkableClimb, *data.hf, *data.chf));
 
-	rcFreeHeightField(hf);
-	hf = nullptr;
+	rcFreeHeightField(data.hf);
+	data.hf = nullptr;
 
 #ifdef TOOLS_ENABLED
 	if (ep) {
@@ -517,7 +519,7 @@ void NavigationMeshGenerator::_build_recast_navigation_mesh(
 	}
 #endif
 
-	ERR_FAIL_COND(!rcErodeWalkableArea(&ctx, cfg.walkableRadius, *chf));
+	ERR_FAIL_COND(!rcErodeWalkableArea(&ctx, cfg.walkableRadius, *data.chf));
 
 #ifdef TOOLS_ENABLED
 	if (ep) {
@@ -525,13 +527,14 @@ void NavigationMeshGenerator::_build_recast_navigation_mesh(
 	}
 #endif
 
-	if (p_nav_mesh->get_sample_partition_type() == NavigationMesh::SAMPLE_PARTITION_WATERSHED) {
-		ERR_FAIL_COND(!rcBuildDistanceField(&ctx, *chf));
-		ERR_FAIL_COND(!rcBuildRegions(&ctx, *chf, 0, cfg.minRegionArea, cfg.mergeRegionArea));
-	} else if (p_nav_mesh->get_sample_partition_type() == NavigationMesh::SAMPLE_PARTITION_MONOTONE) {
-		ERR_FAIL_COND(!rcBuildRegionsMonotone(&ctx, *chf, 0, cfg.minRegionArea, cfg.mergeRegionArea));
+	// The border of a tile overlaps its neighbors, its regions are left out of the polygons.
+	if (p_settings.partition_type == NavigationMesh::SAMPLE_PARTITION_WATERSHED) {
+		ERR_FAIL_COND(!rcBuildDistanceField(&ctx, *data.chf));
+		ERR_FAIL_COND(!rcBuildRegions(&ctx, *data.chf, cfg.borderSize, cfg.minRegionArea, cfg.mergeRegionArea));
+	} else if (p_settings.partition_type == NavigationMesh::SAMPLE_PARTITION_MONOTONE) {
+		ERR_FAIL_COND(!rcBuildRegionsMonotone(&ctx, *data.chf, cfg.borderSize, cfg.minRegionArea, cfg.mergeRegionArea));
 	} else {
-		ERR_FAIL_COND(!rcBuildLayerRegions(&ctx, *chf, 0, cfg.minRegionArea));
+		ERR_FAIL_COND(!rcBuildLayerRegions(&ctx, *data.chf, cfg.borderSize, cfg.minRegionArea));
 	}
 
 #ifdef TOOLS_ENABLED
@@ -540,10 +543,10 @@ void NavigationMeshGenerator::_build_recast_navigation_mesh(
 	}
 #endif
 
-	cset = rcAllocContourSet();
+	data.cset = rcAllocContourSet();
 
-	ERR_FAIL_COND(!cset);
-	ERR_FAIL_COND(!rcBuildContours(&ctx, *chf, cfg.maxSimplificationError, cfg.maxEdgeLen, *cset));
+	ERR_FAIL_COND(!data.cset);
+	ERR_FAIL_COND(!rcBuildContours(&ctx, *data.chf, cfg.maxSimplificationError, cfg.maxEdgeLen, *data.cset));
 
 #ifdef TOOLS_ENABLED
 	if (ep) {
@@ -551,18 +554,18 @@ void NavigationMeshGenerator::_build_recast_navigation_mesh(
 	}
 #endif
 
-	poly_mesh = rcAllocPolyMesh();
-	ERR_FAIL_COND(!poly_mesh);
-	ERR_FAIL_COND(!rcBuildPolyMesh(&ctx, *cset, cfg.maxVertsPerPoly, *poly_mesh));
+	data.poly_mesh = rcAllocPolyMesh();
+	ERR_FAIL_COND(!data.poly_mesh);
+	ERR_FAIL_COND(!rcBuildPolyMesh(&ctx, *data.cset, cfg.maxVertsPerPoly, *data.poly_mesh));
 
-	detail_mesh = rcAllocPolyMeshDetail();
-	ERR_FAIL_COND(!detail_mesh);
-	ERR_FAIL_COND(!rcBuildPolyMeshDetail(&ctx, *poly_mesh, *chf, cfg.detailSampleDist, cfg.detailSampleMaxError, *detail_mesh));
+	data.detail_mesh = rcAllocPolyMeshDetail();
+	ERR_FAIL_COND(!data.detail_mesh);
+	ERR_FAIL_COND(!rcBuildPolyMeshDetail(&ctx, *data.poly_mesh, *data.chf, cfg.detailSampleDist, cfg.detailSampleMaxError, *data.detail_mesh));
 
-	rcFreeCompactHeightfield(chf);
-	chf = nullptr;
-	rcFreeContourSet(cset);
-	cset = nullptr;
+	rcFreeCompactHeightfield(data.chf);
+	data.chf = nullptr;
+	rcFreeContourSet(data.cset);
+	data.cset = nullptr;
 
 #ifdef TOOLS_ENABLED
 	if (ep) {
@@ -570,41 +573,292 @@ void NavigationMeshGenerator::_build_recast_navigation_mesh(
 	}
 #endif
 
-	_convert_detail_mesh_to_native_navigation_mesh(detail_mesh, p_nav_mesh);
-
-	rcFreePolyMesh(poly_mesh);
-	poly_mesh = nullptr;
-	rcFreePolyMeshDetail(detail_mesh);
-	detail_mesh = nullptr;
+	_convert_detail_mesh_to_native_navigation_mesh(data.detail_mesh, r_tile_mesh);
 }
 
-NavigationMeshGenerator *NavigationMeshGenerator::get_singleton() {
-	return singleton;
+uint32_t NavigationMeshGenerator::BakeSettings::hash() const {
+	uint32_t h = hash_djb2_one_float(config.cs);
+	h = hash_djb2_one_float(config.ch, h);
+	h = hash_djb2_one_float(config.walkableSlopeAngle, h);
+	h = hash_djb2_one_32(config.walkableHeight, h);
+	h = hash_djb2_one_32(config.walkableClimb, h);
+	h = hash_djb2_one_32(config.walkableRadius, h);
+	h = hash_djb2_one_32(config.maxEdgeLen, h);
+	h = hash_djb2_one_float(config.maxSimplificationError, h);
+	h = hash_djb2_one_32(config.minRegionArea, h);
+	h = hash_djb2_one_32(config.mergeRegionArea, h);
+	h = hash_djb2_one_32(config.maxVertsPerPoly, h);
+	h = hash_djb2_one_float(config.detailSampleDist, h);
+	h = hash_djb2_one_float(config.detailSampleMaxError, h);
+	h = hash_djb2_one_32(partition_type, h);
+	h = hash_djb2_one_32(filter_low_hanging_obstacles, h);
+	h = hash_djb2_one_32(filter_ledge_spans, h);
+	h = hash_djb2_one_32(filter_walkable_low_height_spans, h);
+	return hash_djb2_one_32(tile_size, h);
 }
 
-NavigationMeshGenerator::NavigationMeshGenerator() {
-	singleton = this;
-}
+void NavigationMeshGenerator::BakeTask::_build_tile(uint32_t p_index, void *p_userdata) {
+	Tile &tile = tiles[p_index];
 
-NavigationMeshGenerator::~NavigationMeshGenerator() {
+	if (settings.tile_size == 0) {
+		_build_recast_navigation_mesh(
+				settings,
+#ifdef TOOLS_ENABLED
+				ep,
+#endif
+				tile.bmin,
+				tile.bmax,
+				0,
+				vertices.ptr(),
+				vertices.size() / 3,
+				indices.ptr(),
+				indices.size() / 3,
+				tile.mesh);
+	} else if (tile.indices.size() > 0) {
+		_build_recast_navigation_mesh(
+				settings,
+#ifdef TOOLS_ENABLED
+				nullptr,
+#endif
+				tile.bmin,
+				tile.bmax,
+				border_size,
+				vertices.ptr(),
+				vertices.size() / 3,
+				tile.indices.ptr(),
+				tile.indices.size() / 3,
+				tile.mesh);
+	}
 }
 
-void NavigationMeshGenerator::bake(Ref<NavigationMesh> p_nav_mesh, Node *p_node) {
-	ERR_FAIL_COND_MSG(!p_nav_mesh.is_valid(), "Invalid navigation mesh.");
+struct NavigationMeshVertexHasher {
+	static _FORCE_INLINE_ uint32_t hash(const Vector3i &p_vertex) {
+		return hash_djb2_one_32(p_vertex.z, hash_djb2_one_32(p_vertex.y, hash_djb2_one_32(p_vertex.x)));
+	}
+};
 
-#ifdef TOOLS_ENABLED
-	EditorProgress *ep(nullptr);
-	if (Engine::get_singleton()->is_editor_hint()) {
-		ep = memnew(EditorProgress("bake", TTR("Navigation Mesh Generator Setup:"), 11));
+// A welded vertex on a tile border line, ordered by its cell along the line.
+struct NavigationMeshBorderVertex {
+	int position = 0;
+	int index = 0;
+
+	bool operator<(const NavigationMeshBorderVertex &p_other) const {
+		return position < p_other.position || (position == p_other.position && index < p_other.index);
+	}
+};
+
+void NavigationMeshGenerator::BakeTask::build() {
+	if (settings.tile_size > 0) {
+		// Give every tile the triangles that touch it or its border.
+		const float *verts = vertices.ptr();
+		const int *tris = indices.ptr();
+		const int ntris = indices.size() / 3;
+		const real_t border = border_size * settings.config.cs;
+
+		for (int i = 0; i < ntris; i++) {
+			const float *a = &verts[tris[i * 3 + 0] * 3];
+			const float *b = &verts[tris[i * 3 + 1] * 3];
+			const float *c = &verts[tris[i * 3 + 2] * 3];
+
+			int from_x, to_x, from_z, to_z;
+			_get_tile_range(MIN(a[0], MIN(b[0], c[0])), MAX(a[0], MAX(b[0], c[0])), border, tile_width, from_x, to_x);
+			_get_tile_range(MIN(a[2], MIN(b[2], c[2])), MAX(a[2], MAX(b[2], c[2])), border, tile_width, from_z, to_z);
+
+			for (int z = from_z; z <= to_z; z++) {
+				for (int x = from_x; x <= to_x; x++) {
+					const uint32_t *index = tile_indices.getptr(_make_tile_key(x, z));
+					if (index) {
+						LocalVector<int> &tile_tris = tiles[*index].indices;
+						tile_tris.push_back(tris[i * 3 + 0]);
+						tile_tris.push_back(tris[i * 3 + 1]);
+						tile_tris.push_back(tris[i * 3 + 2]);
+					}
+				}
+			}
+		}
 	}
 
-	if (ep) {
-		ep->step(TTR("Parsing Geometry..."), 0);
+	thread_process_array(tiles.size(), this, &BakeTask::_build_tile, (void *)nullptr);
+
+	if (settings.tile_size == 0) {
+		if (tiles.size() > 0) {
+			result_vertices = tiles[0].mesh.vertices;
+			result_polygons = tiles[0].mesh.polygons;
+		}
+		return;
 	}
-#endif
 
-	Vector<float> vertices;
-	Vector<int> indices;
+	// Neighbor tiles build the same vertices along their shared borders, weld them so their polygons get connected.
+	// Tiles are built on their own, so the same border vertex can come out of two tiles with rounding differences.
+	// Weld the vertices by their cell on the grid, but never merge two vertices of the same tile.
+	struct WeldedVertex {
+		int index = 0;
+		uint32_t mesh = 0;
+	};
+	const real_t cs = settings.config.cs;
+	const real_t ch = settings.config.ch;
+	DenseHashMap<Vector3i, WeldedVertex, NavigationMeshVertexHasher> vertex_indices;
+	LocalVector<Vector3i> cells;
+	LocalVector<int> remap;
+
+	LocalVector<const TileMesh *> meshes;
+	for (const KeyValue<uint64_t, TileMesh> &E : kept_tiles) {
+		meshes.push_back(&E.value);
+	}
+	for (uint32_t i = 0; i < tiles.size(); i++) {
+		meshes.push_back(&tiles[i].mesh);
+	}
+
+	for (uint32_t mesh_index = 0; mesh_index < meshes.size(); mesh_index++) {
+		const TileMesh *mesh = meshes[mesh_index];
+		remap.resize(mesh->vertices.size());
+		for (int i = 0; i < mesh->vertices.size(); i++) {
+			const Vector3 &vertex = mesh->vertices[i];
+			const Vector3i cell((int)Math::round(vertex.x / cs), (int)Math::round(vertex.y / ch), (int)Math::round(vertex.z / cs));
+			WeldedVertex *welded = vertex_indices.getptr(cell);
+			if (welded && welded->mesh != mesh_index) {
+				remap[i] = welded->index;
+				continue;
+			}
+			remap[i] = result_vertices.size();
+			if (!welded) {
+				vertex_indices.insert(cell, { remap[i], mesh_index });
+			}
+			result_vertices.push_back(vertex);
+			cells.push_back(cell);
+		}
+
+		for (const Vector<int> &polygon : mesh->polygons) {
+			Vector<int> welded;
+			welded.resize(polygon.size());
+			for (int i = 0; i < polygon.size(); i++) {
+				welded.write[i] = remap[polygon[i]];
+			}
+			result_polygons.push_back(welded);
+		}
+	}
+
+	if (settings.tile_size <= 0 || meshes.size() < 2) {
+		return;
+	}
+
+	// Recast places the vertices along a tile border for each tile on its own, so the polygons on both sides of a
+	// border can split it at different points and would not share any edge. Add the border vertices of the other side
+	// to every polygon edge that runs along a border, so that both sides end up with the same edges.
+	const int tile_size = settings.tile_size;
+	const int climb = MAX(settings.config.walkableClimb, 1);
+	DenseHashMap<uint64_t, LocalVector<NavigationMeshBorderVertex>> border_lines;
+	for (uint32_t i = 0; i < cells.size(); i++) {
+		const Vector3i &cell = cells[i];
+		for (int axis = 0; axis < 2; axis++) {
+			const int line = axis == 0 ? cell.x : cell.z;
+			if (line % tile_size != 0) {
+				continue;
+			}
+			const uint64_t key = (uint64_t(uint32_t(line)) << 1) | uint64_t(axis);
+			LocalVector<NavigationMeshBorderVertex> *border_line = border_lines.getptr(key);
+			if (!border_line) {
+				border_lines.insert(key, LocalVector<NavigationMeshBorderVertex>());
+				border_line = border_lines.getptr(key);
+			}
+			border_line->push_back({ axis == 0 ? cell.z : cell.x, int(i) });
+		}
+	}
+
+	if (border_lines.is_empty()) {
+		return;
+	}
+	for (KeyValue<uint64_t, LocalVector<NavigationMeshBorderVertex>> &E : border_lines) {
+		E.value.sort();
+	}
+
+	for (int p = 0; p < result_polygons.size(); p++) {
+		const Vector<int> &polygon = result_polygons[p];
+		Vector<int> split;
+		for (int i = 0; i < polygon.size(); i++) {
+			const int from = polygon[i];
+			const int to = polygon[(i + 1) % polygon.size()];
+			split.push_back(from);
+
+			const Vector3i &a = cells[from];
+			const Vector3i &b = cells[to];
+			int axis;
+			if (a.x == b.x && a.x % tile_size == 0) {
+				axis = 0;
+			} else if (a.z == b.z && a.z % tile_size == 0) {
+				axis = 1;
+			} else {
+				continue;
+			}
+			const int line = axis == 0 ? a.x : a.z;
+			const LocalVector<NavigationMeshBorderVertex> *border_line = border_lines.getptr((uint64_t(uint32_t(line)) << 1) | uint64_t(axis));
+			const int start = axis == 0 ? a.z : a.x;
+			const int end = axis == 0 ? b.z : b.x;
+			if (!border_line || start == end) {
+				continue;
+			}
+
+			// Add the vertices strictly between the edge's ends, in the edge's direction, skipping those on another floor.
+			const int count = border_line->size();
+			const int step = start < end ? 1 : -1;
+			int last = start;
+			for (int j = step > 0 ? 0 : count - 1; j >= 0 && j < count; j += step) {
+				const NavigationMeshBorderVertex &vertex = (*border_line)[j];
+				if ((vertex.position - last) * step <= 0 || (end - vertex.position) * step <= 0) {
+					continue;
+				}
+				const int height = a.y + (b.y - a.y) * (vertex.position - start) / (end - start);
+				if (ABS(cells[vertex.index].y - height) > climb) {
+					continue;
+				}
+				split.push_back(vertex.index);
+				last = vertex.position;
+			}
+		}
+		if (split.size() != polygon.size()) {
+			result_polygons.write[p] = split;
+		}
+	}
+}
+
+void NavigationMeshGenerator::BakeTask::execute() {
+	build();
+	finished.set();
+	callable_mp(NavigationMeshGenerator::get_singleton(), &NavigationMeshGenerator::_bake_finished).call_deferred(nullptr, 0);
+}
+
+void NavigationMeshGenerator::_get_tile_range(real_t p_min, real_t p_max, real_t p_border, real_t p_tile_size, int &r_from, int &r_to) {
+	r_from = (int)Math::floor((p_min - p_border) / p_tile_size);
+	r_to = (int)Math::floor((p_max + p_border) / p_tile_size);
+}
+
+NavigationMeshGenerator::BakeTask *NavigationMeshGenerator::_create_bake_task(Ref<NavigationMesh> p_nav_mesh, Node *p_node, const AABB &p_changed_aabb) {
+	BakeTask *task = memnew(BakeTask);
+	task->nav_mesh = p_nav_mesh;
+
+	BakeSettings &settings = task->settings;
+	rcConfig &cfg = settings.config;
+	memset(&cfg, 0, sizeof(cfg));
+
+	cfg.cs = p_nav_mesh->get_cell_size();
+	cfg.ch = p_nav_mesh->get_cell_height();
+	cfg.walkableSlopeAngle = p_nav_mesh->get_agent_max_slope();
+	cfg.walkableHeight = (int)Math::ceil(p_nav_mesh->get_agent_height() / cfg.ch);
+	cfg.walkableClimb = (int)Math::floor(p_nav_mesh->get_agent_max_climb() / cfg.ch);
+	cfg.walkableRadius = (int)Math::ceil(p_nav_mesh->get_agent_radius() / cfg.cs);
+	cfg.maxEdgeLen = (int)(p_nav_mesh->get_edge_max_length() / p_nav_mesh->get_cell_size());
+	cfg.maxSimplificationError = p_nav_mesh->get_edge_max_error();
+	cfg.minRegionArea = (int)(p_nav_mesh->get_region_min_size() * p_nav_mesh->get_region_min_size());
+	cfg.mergeRegionArea = (int)(p_nav_mesh->get_region_merge_size() * p_nav_mesh->get_region_merge_size());
+	cfg.maxVertsPerPoly = (int)p_nav_mesh->get_verts_per_poly();
+	cfg.detailSampleDist = p_nav_mesh->get_detail_sample_distance() < 0.9f ? 0 : p_nav_mesh->get_cell_size() * p_nav_mesh->get_detail_sample_distance();
+	cfg.detailSampleMaxError = p_nav_mesh->get_cell_height() * p_nav_mesh->get_detail_sample_max_error();
+
+	settings.partition_type = p_nav_mesh->get_sample_partition_type();
+	settings.filter_low_hanging_obstacles = p_nav_mesh->get_filter_low_hanging_obstacles();
+	settings.filter_ledge_spans = p_nav_mesh->get_filter_ledge_spans();
+	settings.filter_walkable_low_height_spans = p_nav_mesh->get_filter_walkable_low_height_spans();
+	settings.tile_size = p_nav_mesh->get_tile_size();
 
 	List<Node *> parse_nodes;
 
@@ -619,44 +873,203 @@ void NavigationMeshGenerator::bake(Ref<NavigationMesh> p_nav_mesh, Node *p_node)
 		NavigationMesh::ParsedGeometryType geometry_type = p_nav_mesh->get_parsed_geometry_type();
 		uint32_t collision_mask = p_nav_mesh->get_collision_mask();
 		bool recurse_children = p_nav_mesh->get_source_geometry_mode() != NavigationMesh::SOURCE_GEOMETRY_GROUPS_EXPLICIT;
-		_parse_geometry(navmesh_xform, E, vertices, indices, geometry_type, collision_mask, recurse_children);
+		_parse_geometry(navmesh_xform, E, task->vertices, task->indices, geometry_type, collision_mask, recurse_children);
 	}
 
-	if (vertices.size() > 0 && indices.size() > 0) {
-		rcHeightfield *hf = nullptr;
-		rcCompactHeightfield *chf = nullptr;
-		rcContourSet *cset = nullptr;
-		rcPolyMesh *poly_mesh = nullptr;
-		rcPolyMeshDetail *detail_mesh = nullptr;
+	const int nverts = task->vertices.size() / 3;
+	const int ntris = task->indices.size() / 3;
 
-		_build_recast_navigation_mesh(
-				p_nav_mesh,
-#ifdef TOOLS_ENABLED
-				ep,
-#endif
-				hf,
-				chf,
-				cset,
-				poly_mesh,
-				detail_mesh,
-				vertices,
-				indices);
+	float bmin[3], bmax[3];
+	if (nverts > 0 && ntris > 0) {
+		rcCalcBounds(task->vertices.ptr(), nverts, bmin, bmax);
+	}
+
+	if (settings.tile_size == 0) {
+		if (nverts > 0 && ntris > 0) {
+			task->tiles.push_back(Tile());
+			Tile &tile = task->tiles[0];
+			memcpy(tile.bmin, bmin, sizeof(bmin));
+			memcpy(tile.bmax, bmax, sizeof(bmax));
+		}
+		return task;
+	}
+
+	task->tile_width = settings.tile_size * cfg.cs;
+	task->border_size = cfg.walkableRadius + 3;
+	const real_t border = task->border_size * cfg.cs;
+
+	int from_x = 0, to_x = -1, from_z = 0, to_z = -1;
+	if (nverts > 0 && ntris > 0) {
+		_get_tile_range(bmin[0], bmax[0], 0.0, task->tile_width, from_x, to_x);
+		_get_tile_range(bmin[2], bmax[2], 0.0, task->tile_width, from_z, to_z);
+
+		// Snap the heights to the cells, so tiles from different bakes quantize them the same way.
+		bmin[1] = Math::floor(bmin[1] / cfg.ch) * cfg.ch;
+		bmax[1] = Math::ceil(bmax[1] / cfg.ch) * cfg.ch + cfg.ch;
+	}
 
-		rcFreeHeightField(hf);
-		hf = nullptr;
+	int changed_from_x = 0, changed_to_x = -1, changed_from_z = 0, changed_to_z = -1;
+	{
+		MutexLock lock(mutex);
+
+		const TileCache *cache = tile_caches.getptr(p_nav_mesh->get_instance_id());
+		task->partial = !p_changed_aabb.has_no_surface() && cache && cache->settings_hash == settings.hash();
+
+		if (task->partial) {
+			// Tiles only change if the AABB touches their border.
+			const Vector3 changed_end = p_changed_aabb.position + p_changed_aabb.size;
+			_get_tile_range(p_changed_aabb.position.x, changed_end.x, border, task->tile_width, changed_from_x, changed_to_x);
+			_get_tile_range(p_changed_aabb.position.z, changed_end.z, border, task->tile_width, changed_from_z, changed_to_z);
+
+			// Tiles that used to have polygons are rebaked too, in case their geometry is gone.
+			for (const KeyValue<uint64_t, TileMesh> &E : cache->tiles) {
+				const int x = int32_t(E.key >> 32);
+				const int z = int32_t(E.key & 0xFFFFFFFF);
+				if (x < changed_from_x || x > changed_to_x || z < changed_from_z || z > changed_to_z) {
+					task->kept_tiles.insert(E.key, E.value);
+				}
+			}
+		}
+	}
+
+	for (int z = from_z; z <= to_z; z++) {
+		for (int x = from_x; x <= to_x; x++) {
+			if (task->partial && (x < changed_from_x || x > changed_to_x || z < changed_from_z || z > changed_to_z)) {
+				continue;
+			}
 
-		rcFreeCompactHeightfield(chf);
-		chf = nullptr;
+			task->tiles.push_back(Tile());
+			Tile &tile = task->tiles[task->tiles.size() - 1];
+			tile.key = _make_tile_key(x, z);
+			tile.bmin[0] = x * task->tile_width - border;
+			tile.bmin[1] = bmin[1];
+			tile.bmin[2] = z * task->tile_width - border;
+			tile.bmax[0] = (x + 1) * task->tile_width + border;
+			tile.bmax[1] = bmax[1];
+			tile.bmax[2] = (z + 1) * task->tile_width + border;
+			task->tile_indices.insert(tile.key, task->tiles.size() - 1);
+		}
+	}
+
+	return task;
+}
+
+void NavigationMeshGenerator::_finish_bake_task(BakeTask *p_task) {
+	{
+		MutexLock lock(mutex);
+
+		const ObjectID id = p_task->nav_mesh->get_instance_id();
+		if (p_task->settings.tile_size > 0) {
+			TileCache &cache = tile_caches[id];
+			cache.settings_hash = p_task->settings.hash();
+			cache.tiles = p_task->kept_tiles;
+			for (uint32_t i = 0; i < p_task->tiles.size(); i++) {
+				const Tile &tile = p_task->tiles[i];
+				if (tile.mesh.polygons.size() > 0) {
+					cache.tiles.insert(tile.key, tile.mesh);
+				}
+			}
+		} else {
+			tile_caches.erase(id);
+		}
 
-		rcFreeContourSet(cset);
-		cset = nullptr;
+		// Forget the navigation meshes that have been freed since.
+		LocalVector<ObjectID> freed;
+		for (const KeyValue<ObjectID, TileCache> &E : tile_caches) {
+			if (!ObjectDB::get_instance(E.key)) {
+				freed.push_back(E.key);
+			}
+		}
+		for (uint32_t i = 0; i < freed.size(); i++) {
+			tile_caches.erase(freed[i]);
+		}
+	}
 
-		rcFreePolyMesh(poly_mesh);
-		poly_mesh = nullptr;
+	Ref<NavigationMesh> nav_mesh = p_task->nav_mesh;
+	nav_mesh->clear_polygons();
+	nav_mesh->set_vertices(p_task->result_vertices);
+	for (const Vector<int> &polygon : p_task->result_polygons) {
+		nav_mesh->add_polygon(polygon);
+	}
 
-		rcFreePolyMeshDetail(detail_mesh);
-		detail_mesh = nullptr;
+	if (!p_task->callback.is_null()) {
+		Variant nav_mesh_variant = nav_mesh;
+		const Variant *args[1] = { &nav_mesh_variant };
+		Variant result;
+		Callable::CallError ce;
+		p_task->callback.call(args, 1, result, ce);
+		if (ce.error != Callable::CallError::CALL_OK) {
+			ERR_PRINT("Error calling the navigation mesh bake callback: " + Variant::get_callable_error_text(p_task->callback, args, 1, ce));
+		}
 	}
+}
+
+void NavigationMeshGenerator::_bake_finished() {
+	LocalVector<BakeTask *> finished_tasks;
+	{
+		MutexLock lock(mutex);
+		for (uint32_t i = 0; i < tasks.size(); i++) {
+			if (tasks[i]->finished.is_set()) {
+				finished_tasks.push_back(tasks[i]);
+				tasks.remove_at_unordered(i);
+				i--;
+			}
+		}
+	}
+
+	WorkerThreadPool *pool = WorkerThreadPool::get_singleton();
+	for (uint32_t i = 0; i < finished_tasks.size(); i++) {
+		BakeTask *task = finished_tasks[i];
+		if (pool) {
+			// The job is done, but the worker may still be releasing it.
+			pool->wait(&task->group);
+		}
+		_finish_bake_task(task);
+		memdelete(task);
+	}
+}
+
+NavigationMeshGenerator *NavigationMeshGenerator::get_singleton() {
+	return singleton;
+}
+
+NavigationMeshGenerator::NavigationMeshGenerator() {
+	singleton = this;
+}
+
+NavigationMeshGenerator::~NavigationMeshGenerator() {
+	WorkerThreadPool *pool = WorkerThreadPool::get_singleton();
+	for (uint32_t i = 0; i < tasks.size(); i++) {
+		BakeTask *task = tasks[i];
+		if (pool) {
+			pool->wait(&task->group);
+		}
+		memdelete(task);
+	}
+	tasks.clear();
+}
+
+void NavigationMeshGenerator::bake(Ref<NavigationMesh> p_nav_mesh, Node *p_node) {
+	ERR_FAIL_COND_MSG(!p_nav_mesh.is_valid(), "Invalid navigation mesh.");
+
+#ifdef TOOLS_ENABLED
+	EditorProgress *ep(nullptr);
+	if (Engine::get_singleton()->is_editor_hint()) {
+		ep = memnew(EditorProgress("bake", TTR("Navigation Mesh Generator Setup:"), 11));
+	}
+
+	if (ep) {
+		ep->step(TTR("Parsing Geometry..."), 0);
+	}
+#endif
+
+	BakeTask *task = _create_bake_task(p_nav_mesh, p_node, AABB());
+#ifdef TOOLS_ENABLED
+	task->ep = ep;
+#endif
+	task->build();
+	_finish_bake_task(task);
+	memdelete(task);
 
 #ifdef TOOLS_ENABLED
 	if (ep) {
@@ -669,15 +1082,49 @@ void NavigationMeshGenerator::bake(Ref<NavigationMesh> p_nav_mesh, Node *p_node)
 #endif
 }
 
+void NavigationMeshGenerator::bake_async(Ref<NavigationMesh> p_nav_mesh, Node *p_node, const Callable &p_callback, const AABB &p_changed_aabb) {
+	ERR_FAIL_COND_MSG(!p_nav_mesh.is_valid(), "Invalid navigation mesh.");
+	ERR_FAIL_COND_MSG(is_baking(p_nav_mesh), "Unable to start another bake request. The navigation mesh is already being baked.");
+
+	BakeTask *task = _create_bake_task(p_nav_mesh, p_node, p_changed_aabb);
+	task->callback = p_callback;
+	{
+		MutexLock lock(mutex);
+		tasks.push_back(task);
+	}
+
+	WorkerThreadPool *pool = WorkerThreadPool::get_singleton();
+	if (pool) {
+		pool->submit(task, &task->group);
+	} else {
+		task->execute();
+	}
+}
+
+bool NavigationMeshGenerator::is_baking(Ref<NavigationMesh> p_nav_mesh) {
+	MutexLock lock(mutex);
+	for (uint32_t i = 0; i < tasks.size(); i++) {
+		if (tasks[i]->nav_mesh == p_nav_mesh) {
+			return true;
+		}
+	}
+	return false;
+}
+
 void NavigationMeshGenerator::clear(Ref<NavigationMesh> p_nav_mesh) {
 	if (p_nav_mesh.is_valid()) {
 		p_nav_mesh->clear_polygons();
 		p_nav_mesh->set_vertices(Vector<Vector3>());
+
+		MutexLock lock(mutex);
+		tile_caches.erase(p_nav_mesh->get_instance_id());
 	}
 }
 
 void NavigationMeshGenerator::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("bake", "nav_mesh", "root_node"), &NavigationMeshGenerator::bake);
+	ClassDB::bind_method(D_METHOD("bake_async", "nav_mesh", "root_node", "callback", "changed_aabb"), &NavigationMeshGenerator::bake_async, DEFVAL(Callable()), DEFVAL(AABB()));
+	ClassDB::bind_method(D_METHOD("is_baking", "nav_mesh"), &NavigationMeshGenerator::is_baking);
 	ClassDB::bind_method(D_METHOD("clear", "nav_mesh"), &NavigationMeshGenerator::clear);
 }
 
@@ -33,6 +33,11 @@
 
 #ifndef _3D_DISABLED
 
+#include "core/os/mutex.h"
+#include "core/templates/dense_hash_map.h"
+#include "core/templates/local_vector.h"
+#include "core/templates/safe_refcount.h"
+#include "core/templates/worker_thread_pool.h"
 #include "scene/3d/navigation_region_3d.h"
 
 #include <Recast.h>
@@ -46,6 +51,80 @@ class NavigationMeshGenerator : public Object {
 
 	static NavigationMeshGenerator *singleton;
 
+	// The Recast settings of a navigation mesh, read when the bake starts so that the tiles can be built on other threads.
+	struct BakeSettings {
+		rcConfig config;
+		NavigationMesh::SamplePartitionType partition_type = NavigationMesh::SAMPLE_PARTITION_WATERSHED;
+		bool filter_low_hanging_obstacles = false;
+		bool filter_ledge_spans = false;
+		bool filter_walkable_low_height_spans = false;
+		int tile_size = 0;
+
+		uint32_t hash() const;
+	};
+
+	struct TileMesh {
+		Vector<Vector3> vertices;
+		Vector<Vector<int>> polygons;
+	};
+
+	// The tiles last baked for a navigation mesh, kept so that a rebake only has to build the tiles that changed.
+	struct TileCache {
+		uint32_t settings_hash = 0;
+		DenseHashMap<uint64_t, TileMesh> tiles;
+	};
+
+	struct Tile {
+		uint64_t key = 0;
+		float bmin[3];
+		float bmax[3];
+		LocalVector<int> indices;
+		TileMesh mesh;
+	};
+
+	// Builds the tiles of one bake on the worker thread pool, then merges them with the tiles kept from the cache.
+	class BakeTask : public WorkerThreadPool::Job {
+	public:
+		Ref<NavigationMesh> nav_mesh;
+		Callable callback;
+		BakeSettings settings;
+		bool partial = false;
+
+#ifdef TOOLS_ENABLED
+		EditorProgress *ep = nullptr;
+#endif
+
+		Vector<float> vertices;
+		Vector<int> indices;
+		real_t tile_width = 0.0;
+		int border_size = 0;
+		LocalVector<Tile> tiles;
+		DenseHashMap<uint64_t, uint32_t> tile_indices;
+		DenseHashMap<uint64_t, TileMesh> kept_tiles;
+
+		Vector<Vector3> result_vertices;
+		Vector<Vector<int>> result_polygons;
+
+		WorkerThreadPool::JobGroup group;
+		SafeFlag finished;
+
+		void _build_tile(uint32_t p_index, void *p_userdata);
+		void build();
+
+		virtual void execute() override;
+	};
+
+	Mutex mutex;
+	DenseHashMap<ObjectID, TileCache> tile_caches;
+	LocalVector<BakeTask *> tasks;
+
+	static uint64_t _make_tile_key(int p_x, int p_z) { return (uint64_t(uint32_t(p_x)) << 32) | uint32_t(p_z); }
+	static void _get_tile_range(real_t p_min, real_t p_max, real_t p_border, real_t p_tile_size, int &r_from, int &r_to);
+
+	BakeTask *_create_bake_task(Ref<NavigationMesh> p_nav_mesh, Node *p_node, const AABB &p_changed_aabb);
+	void _finish_bake_task(BakeTask *p_task);
+	void _bake_finished();
+
 protected:
 	static void _bind_methods();
 
@@ -55,19 +134,20 @@ protected:
 	static void _add_faces(const PackedVector3Array &p_faces, const Transform3D &p_xform, Vector<float> &p_vertices, Vector<int> &p_indices);
 	static void _parse_geometry(const Transform3D &p_navmesh_transform, Node *p_node, Vector<float> &p_vertices, Vector<int> &p_indices, NavigationMesh::ParsedGeometryType p_generate_from, uint32_t p_collision_mask, bool p_recurse_children);
 
-	static void _convert_detail_mesh_to_native_navigation_mesh(const rcPolyMeshDetail *p_detail_mesh, Ref<NavigationMesh> p_nav_mesh);
+	static void _convert_detail_mesh_to_native_navigation_mesh(const rcPolyMeshDetail *p_detail_mesh, TileMesh &r_tile_mesh);
 	static void _build_recast_navigation_mesh(
-			Ref<NavigationMesh> p_nav_mesh,
+			const BakeSettings &p_settings,
 #ifdef TOOLS_ENABLED
 			EditorProgress *ep,
 #endif
-			rcHeightfield *hf,
-			rcCompactHeightfield *chf,
-			rcContourSet *cset,
-			rcPolyMesh *poly_mesh,
-			rcPolyMeshDetail *detail_mesh,
-			Vector<float> &vertices,
-			Vector<int> &indices);
+			const float *p_bmin,
+			const float *p_bmax,
+			int p_border_size,
+			const float *p_vertices,
+			int p_vertex_count,
+			const int *p_indices,
+			int p_triangle_count,
+			TileMesh &r_tile_mesh);
 
 public:
 	static NavigationMeshGenerator *get_singleton();
@@ -76,6 +156,11 @@ public:
 	~NavigationMeshGenerator();
 
 	void bake(Ref<NavigationMesh> p_nav_mesh, Node *p_node);
+	// Parses the geometry right away, but builds the navigation mesh on the worker thread pool.
+	// The result is applied and p_callback is called with the navigation mesh on the main thread.
+	// If p_changed_aabb has a size, only the tiles it touches are rebaked, the others are kept from the previous bake.
+	void bake_async(Ref<NavigationMesh> p_nav_mesh, Node *p_node, const Callable &p_callback = Callable(), const AABB &p_changed_aabb = AABB());
+	bool is_baking(Ref<NavigationMesh> p_nav_mesh);
 	void clear(Ref<NavigationMesh> p_nav_mesh);
 };
 
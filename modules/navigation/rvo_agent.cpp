@@ -66,7 +66,9 @@ void RvoAgent::dispatch_callback() {
 	}
 	Object *obj = ObjectDB::get_instance(callback.id);
 	if (obj == nullptr) {
+		// The receiver was freed, stop sending it callbacks.
 		callback.id = ObjectID();
+		return;
 	}
 
 	Callable::CallError responseCallError;
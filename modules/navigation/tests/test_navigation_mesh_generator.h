@@ -0,0 +1,180 @@
+/*************************************************************************/
+/*  test_navigation_mesh_generator.h                                     */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_NAVIGATION_MESH_GENERATOR_H
+#define TEST_NAVIGATION_MESH_GENERATOR_H
+
+#include "core/object/message_queue.h"
+#include "core/os/os.h"
+#include "modules/navigation/navigation_mesh_generator.h"
+#include "scene/3d/collision_shape_3d.h"
+#include "scene/3d/physics_body_3d.h"
+#include "scene/main/window.h"
+#include "scene/resources/box_shape_3d.h"
+#include "servers/navigation_server_3d.h"
+
+#include "tests/test_macros.h"
+
+namespace TestNavigationMeshGenerator {
+
+class BakeWatcher : public Object {
+public:
+	int finished_count = 0;
+
+	void bake_finished(Ref<NavigationMesh> p_nav_mesh) {
+		finished_count++;
+	}
+};
+
+static StaticBody3D *add_box(Node *p_parent, const Vector3 &p_position, const Vector3 &p_size) {
+	StaticBody3D *body = memnew(StaticBody3D);
+	body->set_position(p_position);
+	CollisionShape3D *collision_shape = memnew(CollisionShape3D);
+	Ref<BoxShape3D> box;
+	box.instantiate();
+	box->set_size(p_size);
+	collision_shape->set_shape(box);
+	body->add_child(collision_shape);
+	p_parent->add_child(body);
+	return body;
+}
+
+static Ref<NavigationMesh> create_nav_mesh(int p_tile_size) {
+	Ref<NavigationMesh> nav_mesh;
+	nav_mesh.instantiate();
+	nav_mesh->set_parsed_geometry_type(NavigationMesh::PARSED_GEOMETRY_STATIC_COLLIDERS);
+	nav_mesh->set_tile_size(p_tile_size);
+	return nav_mesh;
+}
+
+static real_t get_area(Ref<NavigationMesh> p_nav_mesh) {
+	const Vector<Vector3> vertices = p_nav_mesh->get_vertices();
+	real_t area = 0.0;
+	for (int i = 0; i < p_nav_mesh->get_polygon_count(); i++) {
+		const Vector<int> polygon = p_nav_mesh->get_polygon(i);
+		for (int j = 2; j < polygon.size(); j++) {
+			area += Face3(vertices[polygon[0]], vertices[polygon[j - 1]], vertices[polygon[j]]).get_area();
+		}
+	}
+	return area;
+}
+
+// Whether a polygon on each side of the tile border at x = p_border_x uses the same edge along the border.
+static bool has_shared_border_edge(Ref<NavigationMesh> p_nav_mesh, real_t p_border_x) {
+	const Vector<Vector3> vertices = p_nav_mesh->get_vertices();
+	HashMap<uint64_t, int> edge_sides;
+	for (int i = 0; i < p_nav_mesh->get_polygon_count(); i++) {
+		const Vector<int> polygon = p_nav_mesh->get_polygon(i);
+		Vector3 center;
+		for (int j = 0; j < polygon.size(); j++) {
+			center += vertices[polygon[j]];
+		}
+		const int side = center.x / polygon.size() < p_border_x ? 1 : 2;
+		for (int j = 0; j < polygon.size(); j++) {
+			const int a = polygon[j];
+			const int b = polygon[(j + 1) % polygon.size()];
+			if (!Math::is_equal_approx(vertices[a].x, p_border_x) || !Math::is_equal_approx(vertices[b].x, p_border_x)) {
+				continue;
+			}
+			const uint64_t key = (uint64_t(MIN(a, b)) << 32) | uint64_t(MAX(a, b));
+			edge_sides[key] |= side;
+			if (edge_sides[key] == 3) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+TEST_CASE("[SceneTree][NavigationMeshGenerator] Bake in tiles and rebake the changed ones") {
+	NavigationMeshGenerator *generator = NavigationMeshGenerator::get_singleton();
+	REQUIRE(generator);
+
+	NavigationRegion3D *region = memnew(NavigationRegion3D);
+	SceneTree::get_singleton()->get_root()->add_child(region);
+	add_box(region, Vector3(0, -0.5, 0), Vector3(30, 1, 30));
+
+	Ref<NavigationMesh> single = create_nav_mesh(0);
+	generator->bake(single, region);
+	REQUIRE(single->get_polygon_count() > 0);
+
+	Ref<NavigationMesh> tiled = create_nav_mesh(32);
+	generator->bake(tiled, region);
+	REQUIRE(tiled->get_polygon_count() > 0);
+	CHECK_MESSAGE(get_area(tiled) == doctest::Approx(get_area(single)).epsilon(0.01), "Tiles should cover the same area as a single bake.");
+	// Tiles start at the origin, so there is a tile border at x = 0.
+	CHECK_MESSAGE(has_shared_border_edge(tiled, 0.0), "The polygons on both sides of a tile border should share an edge.");
+
+	NavigationServer3D *server = NavigationServer3D::get_singleton_mut();
+	const RID map = server->map_create();
+	server->map_set_active(map, true);
+	server->map_set_cell_size(map, tiled->get_cell_size());
+	const RID nav_region = server->region_create();
+	server->region_set_map(nav_region, map);
+	server->region_set_navmesh(nav_region, tiled);
+	server->process(0.0);
+
+	const Vector3 destination(12, 0, 12);
+	const Vector<Vector3> path = server->map_get_path(map, Vector3(-12, 0, -12), destination, true);
+	REQUIRE(path.size() >= 2);
+	const Vector3 end = path[path.size() - 1];
+	CHECK_MESSAGE(Vector2(end.x, end.z).is_equal_approx(Vector2(destination.x, destination.z)), "A path should cross the tile borders.");
+
+	server->free(nav_region);
+	server->free(map);
+	server->process(0.0);
+
+	const real_t floor_area = get_area(tiled);
+	add_box(region, Vector3(5, 1, 5), Vector3(2, 2, 2));
+
+	BakeWatcher watcher;
+	generator->bake_async(tiled, region, callable_mp(&watcher, &BakeWatcher::bake_finished), AABB(Vector3(4, 0, 4), Vector3(2, 2, 2)));
+	CHECK(generator->is_baking(tiled));
+
+	const uint64_t start = OS::get_singleton()->get_ticks_msec();
+	while (generator->is_baking(tiled) && OS::get_singleton()->get_ticks_msec() - start < 10000) {
+		OS::get_singleton()->delay_usec(1000);
+		MessageQueue::get_singleton()->flush();
+	}
+	REQUIRE_FALSE(generator->is_baking(tiled));
+	CHECK(watcher.finished_count == 1);
+
+	Ref<NavigationMesh> rebaked = create_nav_mesh(32);
+	generator->bake(rebaked, region);
+	CHECK_MESSAGE(get_area(rebaked) < floor_area, "The obstacle should be cut out of the navigation mesh.");
+	CHECK_MESSAGE(get_area(tiled) == doctest::Approx(get_area(rebaked)), "Rebaking the changed tiles should give the same result as a full bake.");
+	CHECK(tiled->get_polygon_count() == rebaked->get_polygon_count());
+
+	memdelete(region);
+}
+
+} // namespace TestNavigationMeshGenerator
+
+#endif // TEST_NAVIGATION_MESH_GENERATOR_H
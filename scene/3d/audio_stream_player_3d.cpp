@@ -299,6 +299,7 @@ void AudioStreamPlayer3D::_notification(int p_what) {
 					} else {
 						AudioServer::get_singleton()->start_playback_stream(new_playback, bus_map, setplay.get(), actual_pitch_scale, linear_attenuation, attenuation_filter_cutoff_hz);
 					}
+					_update_playback_virtualization(new_playback);
 					stream_playbacks.push_back(new_playback);
 					setplay.set(-1);
 				}
@@ -475,13 +476,10 @@ Vector<AudioFrame> AudioStreamPlayer3D::_update_panning() {
 		}
 
 		linear_attenuation = Math::db2linear(db_att);
+		// Resonance Audio renders into the master bus, so voices routed by an area (bus override or reverb send) keep the panned path.
+		bool spatial = !area && bool(GLOBAL_GET("audio/enable_resonance_audio"));
 		for (Ref<AudioStreamPlayback> &playback : stream_playbacks) {
-			if (GLOBAL_GET("audio/enable_resonance_audio")) {
-				ResonanceAudioServer::get_singleton()->set_source_attenuation(audio_source_id, linear_attenuation);
-				AudioServer::get_singleton()->set_playback_highshelf_params(playback, linear_attenuation, attenuation_filter_cutoff_hz, audio_source_id);
-			} else {
-				AudioServer::get_singleton()->set_playback_highshelf_params(playback, linear_attenuation, attenuation_filter_cutoff_hz, AudioSourceId(-1));
-			}
+			AudioServer::get_singleton()->set_playback_highshelf_params(playback, linear_attenuation, attenuation_filter_cutoff_hz, spatial ? audio_source_id : AudioSourceId(-1));
 		}
 		//TODO: The lower the second parameter (tightness) the more the sound will "enclose" the listener (more undirected / playing from
 		//      speakers not facing the source) - this could be made distance dependent.
@@ -492,7 +490,14 @@ Vector<AudioFrame> AudioStreamPlayer3D::_update_panning() {
 		}
 
 		Map<StringName, Vector<AudioFrame>> bus_volumes;
-		if (area) {
+		if (spatial) {
+			// Spatial voices are panned by Resonance Audio, the first channel volume only carries the distance attenuation.
+			output_volume_vector.write[0] = AudioFrame(multiplier, multiplier);
+			for (unsigned int k = 1; k < 4; k++) {
+				output_volume_vector.write[k] = AudioFrame(0, 0);
+			}
+			bus_volumes[_get_actual_bus()] = output_volume_vector;
+		} else if (area) {
 			if (area->is_overriding_audio_bus()) {
 				//override audio bus
 				bus_volumes[area->get_audio_bus_name()] = output_volume_vector;
@@ -810,6 +815,34 @@ int AudioStreamPlayer3D::get_max_polyphony() const {
 	return max_polyphony;
 }
 
+void AudioStreamPlayer3D::_update_playback_virtualization(const Ref<AudioStreamPlayback> &p_playback) {
+	// Positional sounds can be virtualized while inaudible, so large amounts of emitters don't all need mixing.
+	// The audio server only virtualizes streams with a known length, which it can seek back into.
+	AudioServer::get_singleton()->set_playback_virtualization(p_playback, voice_virtualization_enabled, voice_priority, stream.is_valid() ? stream->get_length() : 0.0);
+}
+
+void AudioStreamPlayer3D::set_voice_priority(float p_priority) {
+	voice_priority = p_priority;
+	for (Ref<AudioStreamPlayback> &playback : stream_playbacks) {
+		_update_playback_virtualization(playback);
+	}
+}
+
+float AudioStreamPlayer3D::get_voice_priority() const {
+	return voice_priority;
+}
+
+void AudioStreamPlayer3D::set_voice_virtualization_enabled(bool p_enabled) {
+	voice_virtualization_enabled = p_enabled;
+	for (Ref<AudioStreamPlayback> &playback : stream_playbacks) {
+		_update_playback_virtualization(playback);
+	}
+}
+
+bool AudioStreamPlayer3D::is_voice_virtualization_enabled() const {
+	return voice_virtualization_enabled;
+}
+
 void AudioStreamPlayer3D::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_stream", "stream"), &AudioStreamPlayer3D::set_stream);
 	ClassDB::bind_method(D_METHOD("get_stream"), &AudioStreamPlayer3D::get_stream);
@@ -875,6 +908,12 @@ void AudioStreamPlayer3D::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_max_polyphony", "max_polyphony"), &AudioStreamPlayer3D::set_max_polyphony);
 	ClassDB::bind_method(D_METHOD("get_max_polyphony"), &AudioStreamPlayer3D::get_max_polyphony);
 
+	ClassDB::bind_method(D_METHOD("set_voice_priority", "priority"), &AudioStreamPlayer3D::set_voice_priority);
+	ClassDB::bind_method(D_METHOD("get_voice_priority"), &AudioStreamPlayer3D::get_voice_priority);
+
+	ClassDB::bind_method(D_METHOD("set_voice_virtualization_enabled", "enabled"), &AudioStreamPlayer3D::set_voice_virtualization_enabled);
+	ClassDB::bind_method(D_METHOD("is_voice_virtualization_enabled"), &AudioStreamPlayer3D::is_voice_virtualization_enabled);
+
 	ClassDB::bind_method(D_METHOD("get_stream_playback"), &AudioStreamPlayer3D::get_stream_playback);
 
 	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "stream", PROPERTY_HINT_RESOURCE_TYPE, "AudioStream"), "set_stream", "get_stream");
@@ -888,6 +927,8 @@ void AudioStreamPlayer3D::_bind_methods() {
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "stream_paused", PROPERTY_HINT_NONE, ""), "set_stream_paused", "get_stream_paused");
 	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "max_distance", PROPERTY_HINT_RANGE, "0,4096,0.01,or_greater"), "set_max_distance", "get_max_distance");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "max_polyphony", PROPERTY_HINT_NONE, ""), "set_max_polyphony", "get_max_polyphony");
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "voice_priority", PROPERTY_HINT_RANGE, "-100,100,0.1,or_lesser,or_greater"), "set_voice_priority", "get_voice_priority");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "voice_virtualization_enabled"), "set_voice_virtualization_enabled", "is_voice_virtualization_enabled");
 	ADD_PROPERTY(PropertyInfo(Variant::STRING_NAME, "bus", PROPERTY_HINT_ENUM, ""), "set_bus", "get_bus");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "area_mask", PROPERTY_HINT_LAYERS_2D_PHYSICS), "set_area_mask", "get_area_mask");
 	ADD_GROUP("Emission Angle", "emission_angle");
@@ -82,6 +82,8 @@ private:
 	bool autoplay = false;
 	StringName bus = SNAME("Master");
 	int max_polyphony = 1;
+	float voice_priority = 0.0;
+	bool voice_virtualization_enabled = true;
 
 	uint64_t last_mix_count = -1;
 
@@ -98,6 +100,7 @@ private:
 	Vector<AudioFrame> _update_panning();
 
 	void _bus_layout_changed();
+	void _update_playback_virtualization(const Ref<AudioStreamPlayback> &p_playback);
 
 	uint32_t area_mask = 1;
 
@@ -151,6 +154,12 @@ public:
 	void set_max_polyphony(int p_max_polyphony);
 	int get_max_polyphony() const;
 
+	void set_voice_priority(float p_priority);
+	float get_voice_priority() const;
+
+	void set_voice_virtualization_enabled(bool p_enabled);
+	bool is_voice_virtualization_enabled() const;
+
 	void set_autoplay(bool p_enable);
 	bool is_autoplay_enabled();
 
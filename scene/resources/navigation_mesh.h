@@ -107,6 +107,8 @@ protected:
 	bool filter_ledge_spans = false;
 	bool filter_walkable_low_height_spans = false;
 
+	int tile_size = 0;
+
 public:
 	// Recast settings
 	void set_sample_partition_type(SamplePartitionType p_value);
@@ -175,6 +177,9 @@ public:
 	void set_filter_walkable_low_height_spans(bool p_value);
 	bool get_filter_walkable_low_height_spans() const;
 
+	void set_tile_size(int p_value);
+	int get_tile_size() const;
+
 	void create_from_mesh(const Ref<Mesh> &p_mesh);
 
 	void set_vertices(const Vector<Vector3> &p_vertices);
@@ -33,6 +33,8 @@
 
 #include "core/math/math_funcs.h"
 
+struct AudioMixKernels;
+
 class AudioFilterSW {
 public:
 	struct Coeffs {
@@ -56,6 +58,7 @@ public:
 	};
 
 	class Processor { // simple filter processor
+		friend struct AudioMixKernels;
 
 		AudioFilterSW *filter = nullptr;
 		Coeffs coeffs;
@@ -0,0 +1,599 @@
+/*************************************************************************/
+/*  audio_mix_kernels.cpp                                                */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "audio_mix_kernels.h"
+
+#include "core/math/math_funcs.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AUDIO_MIX_KERNELS_SSE2
+#include <emmintrin.h>
+#if defined(__x86_64__) || defined(_M_X64)
+// AVX2 kernels are compiled for the target alone and only used if the CPU supports them.
+#define AUDIO_MIX_KERNELS_AVX2
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define AVX2_TARGET
+#else
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define AUDIO_MIX_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+void AudioMixKernels::StereoBiquad::load(const AudioFilterSW::Processor *p_processor_l, const AudioFilterSW::Processor *p_processor_r) {
+	const AudioFilterSW::Processor *processors[2] = { p_processor_l, p_processor_r };
+	for (int i = 0; i < 2; i++) {
+		const AudioFilterSW::Processor *p = processors[i];
+		b0[i] = p->coeffs.b0;
+		b1[i] = p->coeffs.b1;
+		b2[i] = p->coeffs.b2;
+		a1[i] = p->coeffs.a1;
+		a2[i] = p->coeffs.a2;
+		incr_b0[i] = p->incr_coeffs.b0;
+		incr_b1[i] = p->incr_coeffs.b1;
+		incr_b2[i] = p->incr_coeffs.b2;
+		incr_a1[i] = p->incr_coeffs.a1;
+		incr_a2[i] = p->incr_coeffs.a2;
+		ha1[i] = p->ha1;
+		ha2[i] = p->ha2;
+		hb1[i] = p->hb1;
+		hb2[i] = p->hb2;
+	}
+}
+
+void AudioMixKernels::StereoBiquad::store(AudioFilterSW::Processor *p_processor_l, AudioFilterSW::Processor *p_processor_r) const {
+	AudioFilterSW::Processor *processors[2] = { p_processor_l, p_processor_r };
+	for (int i = 0; i < 2; i++) {
+		AudioFilterSW::Processor *p = processors[i];
+		p->coeffs.b0 = b0[i];
+		p->coeffs.b1 = b1[i];
+		p->coeffs.b2 = b2[i];
+		p->coeffs.a1 = a1[i];
+		p->coeffs.a2 = a2[i];
+		p->ha1 = ha1[i];
+		p->ha2 = ha2[i];
+		p->hb1 = hb1[i];
+		p->hb2 = hb2[i];
+	}
+}
+
+/* Scalar */
+
+static void _mix_ramp_accumulate_scalar(AudioFrame *p_dst, const AudioFrame *p_src, AudioFrame p_vol_start, AudioFrame p_vol_final, uint32_t p_frames) {
+	const float inv_frames = 1.0f / p_frames;
+	const AudioFrame vol_delta = p_vol_final - p_vol_start;
+	for (uint32_t i = 0; i < p_frames; i++) {
+		AudioFrame vol = p_vol_start + vol_delta * (i * inv_frames);
+		p_dst[i] += vol * p_src[i];
+	}
+}
+
+static void _mix_ramp_biquad_accumulate_scalar(AudioFrame *p_dst, const AudioFrame *p_src, AudioFrame p_vol_start, AudioFrame p_vol_final, uint32_t p_frames, AudioMixKernels::StereoBiquad *p_biquad) {
+	const float inv_frames = 1.0f / p_frames;
+	const AudioFrame vol_delta = p_vol_final - p_vol_start;
+	AudioMixKernels::StereoBiquad &bq = *p_biquad;
+	for (uint32_t i = 0; i < p_frames; i++) {
+		AudioFrame vol = p_vol_start + vol_delta * (i * inv_frames);
+		AudioFrame mixed = vol * p_src[i];
+		for (int c = 0; c < 2; c++) {
+			float pre = mixed[c];
+			float post = pre * bq.b0[c] + bq.hb1[c] * bq.b1[c] + bq.hb2[c] * bq.b2[c] + bq.ha1[c] * bq.a1[c] + bq.ha2[c] * bq.a2[c];
+			bq.ha2[c] = bq.ha1[c];
+			bq.hb2[c] = bq.hb1[c];
+			bq.hb1[c] = pre;
+			bq.ha1[c] = post;
+			mixed[c] = post;
+
+			bq.b0[c] += bq.incr_b0[c];
+			bq.b1[c] += bq.incr_b1[c];
+			bq.b2[c] += bq.incr_b2[c];
+			bq.a1[c] += bq.incr_a1[c];
+			bq.a2[c] += bq.incr_a2[c];
+		}
+		p_dst[i] += mixed;
+	}
+}
+
+static AudioFrame _mix_gain_peak_scalar(AudioFrame *p_buf, float p_gain, uint32_t p_frames) {
+	AudioFrame peak = AudioFrame(0, 0);
+	for (uint32_t i = 0; i < p_frames; i++) {
+		p_buf[i] *= p_gain;
+		peak.l = MAX(peak.l, ABS(p_buf[i].l));
+		peak.r = MAX(peak.r, ABS(p_buf[i].r));
+	}
+	return peak;
+}
+
+static void _mix_accumulate_scalar(AudioFrame *p_dst, const AudioFrame *p_src, uint32_t p_frames) {
+	for (uint32_t i = 0; i < p_frames; i++) {
+		p_dst[i] += p_src[i];
+	}
+}
+
+/* SSE2 */
+
+#ifdef AUDIO_MIX_KERNELS_SSE2
+
+static _FORCE_INLINE_ __m128 _sse2_load_pair(const float *p_pair) {
+	return _mm_castpd_ps(_mm_load_sd((const double *)p_pair));
+}
+
+static _FORCE_INLINE_ void _sse2_store_pair(float *p_pair, __m128 p_value) {
+	_mm_store_sd((double *)p_pair, _mm_castps_pd(p_value));
+}
+
+static void _mix_ramp_accumulate_sse2(AudioFrame *p_dst, const AudioFrame *p_src, AudioFrame p_vol_start, AudioFrame p_vol_final, uint32_t p_frames) {
+	const float inv_frames = 1.0f / p_frames;
+	const AudioFrame vol_delta = p_vol_final - p_vol_start;
+
+	// Two stereo frames per register.
+	const __m128 vol_start = _mm_setr_ps(p_vol_start.l, p_vol_start.r, p_vol_start.l, p_vol_start.r);
+	const __m128 delta = _mm_setr_ps(vol_delta.l, vol_delta.r, vol_delta.l, vol_delta.r);
+	const __m128 inv = _mm_set1_ps(inv_frames);
+	const __m128 index_step = _mm_set1_ps(2.0f);
+	__m128 index = _mm_setr_ps(0.0f, 0.0f, 1.0f, 1.0f);
+
+	float *dst = (float *)p_dst;
+	const float *src = (const float *)p_src;
+	uint32_t i = 0;
+	for (; i + 2 <= p_frames; i += 2) {
+		__m128 vol = _mm_add_ps(vol_start, _mm_mul_ps(delta, _mm_mul_ps(index, inv)));
+		__m128 d = _mm_loadu_ps(dst + i * 2);
+		d = _mm_add_ps(d, _mm_mul_ps(vol, _mm_loadu_ps(src + i * 2)));
+		_mm_storeu_ps(dst + i * 2, d);
+		index = _mm_add_ps(index, index_step);
+	}
+	for (; i < p_frames; i++) {
+		AudioFrame vol = p_vol_start + vol_delta * (i * inv_frames);
+		p_dst[i] += vol * p_src[i];
+	}
+}
+
+static void _mix_ramp_biquad_accumulate_sse2(AudioFrame *p_dst, const AudioFrame *p_src, AudioFrame p_vol_start, AudioFrame p_vol_final, uint32_t p_frames, AudioMixKernels::StereoBiquad *p_biquad) {
+	const float inv_frames = 1.0f / p_frames;
+	const AudioFrame vol_delta = p_vol_final - p_vol_start;
+	AudioMixKernels::StereoBiquad &bq = *p_biquad;
+
+	// The filter is recursive, so only the two channels of a single frame can be processed at once.
+	__m128 b0 = _sse2_load_pair(bq.b0);
+	__m128 b1 = _sse2_load_pair(bq.b1);
+	__m128 b2 = _sse2_load_pair(bq.b2);
+	__m128 a1 = _sse2_load_pair(bq.a1);
+	__m128 a2 = _sse2_load_pair(bq.a2);
+	const __m128 incr_b0 = _sse2_load_pair(bq.incr_b0);
+	const __m128 incr_b1 = _sse2_load_pair(bq.incr_b1);
+	const __m128 incr_b2 = _sse2_load_pair(bq.incr_b2);
+	const __m128 incr_a1 = _sse2_load_pair(bq.incr_a1);
+	const __m128 incr_a2 = _sse2_load_pair(bq.incr_a2);
+	__m128 ha1 = _sse2_load_pair(bq.ha1);
+	__m128 ha2 = _sse2_load_pair(bq.ha2);
+	__m128 hb1 = _sse2_load_pair(bq.hb1);
+	__m128 hb2 = _sse2_load_pair(bq.hb2);
+
+	const __m128 vol_start = _mm_setr_ps(p_vol_start.l, p_vol_start.r, 0.0f, 0.0f);
+	const __m128 delta = _mm_setr_ps(vol_delta.l, vol_delta.r, 0.0f, 0.0f);
+
+	float *dst = (float *)p_dst;
+	const float *src = (const float *)p_src;
+	for (uint32_t i = 0; i < p_frames; i++) {
+		__m128 vol = _mm_add_ps(vol_start, _mm_mul_ps(delta, _mm_set1_ps(i * inv_frames)));
+		__m128 pre = _mm_mul_ps(vol, _sse2_load_pair(src + i * 2));
+		__m128 post = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(pre, b0), _mm_mul_ps(hb1, b1)), _mm_mul_ps(hb2, b2)), _mm_mul_ps(ha1, a1)), _mm_mul_ps(ha2, a2));
+		ha2 = ha1;
+		hb2 = hb1;
+		hb1 = pre;
+		ha1 = post;
+
+		b0 = _mm_add_ps(b0, incr_b0);
+		b1 = _mm_add_ps(b1, incr_b1);
+		b2 = _mm_add_ps(b2, incr_b2);
+		a1 = _mm_add_ps(a1, incr_a1);
+		a2 = _mm_add_ps(a2, incr_a2);
+
+		_sse2_store_pair(dst + i * 2, _mm_add_ps(_sse2_load_pair(dst + i * 2), post));
+	}
+
+	_sse2_store_pair(bq.b0, b0);
+	_sse2_store_pair(bq.b1, b1);
+	_sse2_store_pair(bq.b2, b2);
+	_sse2_store_pair(bq.a1, a1);
+	_sse2_store_pair(bq.a2, a2);
+	_sse2_store_pair(bq.ha1, ha1);
+	_sse2_store_pair(bq.ha2, ha2);
+	_sse2_store_pair(bq.hb1, hb1);
+	_sse2_store_pair(bq.hb2, hb2);
+}
+
+static AudioFrame _mix_gain_peak_sse2(AudioFrame *p_buf, float p_gain, uint32_t p_frames) {
+	const __m128 gain = _mm_set1_ps(p_gain);
+	const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	__m128 peak = _mm_setzero_ps();
+
+	float *buf = (float *)p_buf;
+	uint32_t i = 0;
+	for (; i + 2 <= p_frames; i += 2) {
+		__m128 v = _mm_mul_ps(_mm_loadu_ps(buf + i * 2), gain);
+		_mm_storeu_ps(buf + i * 2, v);
+		peak = _mm_max_ps(peak, _mm_and_ps(v, abs_mask));
+	}
+	// Fold [l0, r0, l1, r1] into [l, r].
+	peak = _mm_max_ps(peak, _mm_movehl_ps(peak, peak));
+
+	float lanes[4];
+	_mm_storeu_ps(lanes, peak);
+	AudioFrame result = AudioFrame(lanes[0], lanes[1]);
+	for (; i < p_frames; i++) {
+		p_buf[i] *= p_gain;
+		result.l = MAX(result.l, ABS(p_buf[i].l));
+		result.r = MAX(result.r, ABS(p_buf[i].r));
+	}
+	return result;
+}
+
+static void _mix_accumulate_sse2(AudioFrame *p_dst, const AudioFrame *p_src, uint32_t p_frames) {
+	float *dst = (float *)p_dst;
+	const float *src = (const float *)p_src;
+	uint32_t i = 0;
+	for (; i + 4 <= p_frames; i += 4) {
+		_mm_storeu_ps(dst + i * 2, _mm_add_ps(_mm_loadu_ps(dst + i * 2), _mm_loadu_ps(src + i * 2)));
+		_mm_storeu_ps(dst + i * 2 + 4, _mm_add_ps(_mm_loadu_ps(dst + i * 2 + 4), _mm_loadu_ps(src + i * 2 + 4)));
+	}
+	for (; i < p_frames; i++) {
+		p_dst[i] += p_src[i];
+	}
+}
+
+#endif // AUDIO_MIX_KERNELS_SSE2
+
+/* AVX2 */
+
+#ifdef AUDIO_MIX_KERNELS_AVX2
+
+AVX2_TARGET static void _mix_ramp_accumulate_avx2(AudioFrame *p_dst, const AudioFrame *p_src, AudioFrame p_vol_start, AudioFrame p_vol_final, uint32_t p_frames) {
+	const float inv_frames = 1.0f / p_frames;
+	const AudioFrame vol_delta = p_vol_final - p_vol_start;
+
+	// Four stereo frames per register.
+	const __m256 vol_start = _mm256_setr_ps(p_vol_start.l, p_vol_start.r, p_vol_start.l, p_vol_start.r, p_vol_start.l, p_vol_start.r, p_vol_start.l, p_vol_start.r);
+	const __m256 delta = _mm256_setr_ps(vol_delta.l, vol_delta.r, vol_delta.l, vol_delta.r, vol_delta.l, vol_delta.r, vol_delta.l, vol_delta.r);
+	const __m256 inv = _mm256_set1_ps(inv_frames);
+	const __m256 index_step = _mm256_set1_ps(4.0f);
+	__m256 index = _mm256_setr_ps(0.0f, 0.0f, 1.0f, 1.0f, 2.0f, 2.0f, 3.0f, 3.0f);
+
+	float *dst = (float *)p_dst;
+	const float *src = (const float *)p_src;
+	uint32_t i = 0;
+	for (; i + 4 <= p_frames; i += 4) {
+		__m256 vol = _mm256_add_ps(vol_start, _mm256_mul_ps(delta, _mm256_mul_ps(index, inv)));
+		__m256 d = _mm256_loadu_ps(dst + i * 2);
+		d = _mm256_add_ps(d, _mm256_mul_ps(vol, _mm256_loadu_ps(src + i * 2)));
+		_mm256_storeu_ps(dst + i * 2, d);
+		index = _mm256_add_ps(index, index_step);
+	}
+	for (; i < p_frames; i++) {
+		AudioFrame vol = p_vol_start + vol_delta * (i * inv_frames);
+		p_dst[i] += vol * p_src[i];
+	}
+}
+
+AVX2_TARGET static AudioFrame _mix_gain_peak_avx2(AudioFrame *p_buf, float p_gain, uint32_t p_frames) {
+	const __m256 gain = _mm256_set1_ps(p_gain);
+	const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+	__m256 peak = _mm256_setzero_ps();
+
+	float *buf = (float *)p_buf;
+	uint32_t i = 0;
+	for (; i + 4 <= p_frames; i += 4) {
+		__m256 v = _mm256_mul_ps(_mm256_loadu_ps(buf + i * 2), gain);
+		_mm256_storeu_ps(buf + i * 2, v);
+		peak = _mm256_max_ps(peak, _mm256_and_ps(v, abs_mask));
+	}
+	// Fold [l0, r0, l1, r1, l2, r2, l3, r3] into [l, r].
+	__m128 half = _mm_max_ps(_mm256_castps256_ps128(peak), _mm256_extractf128_ps(peak, 1));
+	half = _mm_max_ps(half, _mm_movehl_ps(half, half));
+
+	float lanes[4];
+	_mm_storeu_ps(lanes, half);
+	AudioFrame result = AudioFrame(lanes[0], lanes[1]);
+	for (; i < p_frames; i++) {
+		p_buf[i] *= p_gain;
+		result.l = MAX(result.l, ABS(p_buf[i].l));
+		result.r = MAX(result.r, ABS(p_buf[i].r));
+	}
+	return result;
+}
+
+AVX2_TARGET static void _mix_accumulate_avx2(AudioFrame *p_dst, const AudioFrame *p_src, uint32_t p_frames) {
+	float *dst = (float *)p_dst;
+	const float *src = (const float *)p_src;
+	uint32_t i = 0;
+	for (; i + 4 <= p_frames; i += 4) {
+		_mm256_storeu_ps(dst + i * 2, _mm256_add_ps(_mm256_loadu_ps(dst + i * 2), _mm256_loadu_ps(src + i * 2)));
+	}
+	for (; i < p_frames; i++) {
+		p_dst[i] += p_src[i];
+	}
+}
+
+static bool _cpu_supports_avx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) {
+		return false;
+	}
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx) {
+		return false;
+	}
+	// The OS must also save the YMM registers on context switches.
+	if ((_xgetbv(0) & 0x6) != 0x6) {
+		return false;
+	}
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // AUDIO_MIX_KERNELS_AVX2
+
+/* NEON */
+
+#ifdef AUDIO_MIX_KERNELS_NEON
+
+static void _mix_ramp_accumulate_neon(AudioFrame *p_dst, const AudioFrame *p_src, AudioFrame p_vol_start, AudioFrame p_vol_final, uint32_t p_frames) {
+	const float inv_frames = 1.0f / p_frames;
+	const AudioFrame vol_delta = p_vol_final - p_vol_start;
+
+	// Two stereo frames per register.
+	const float vol_start_lanes[4] = { p_vol_start.l, p_vol_start.r, p_vol_start.l, p_vol_start.r };
+	const float delta_lanes[4] = { vol_delta.l, vol_delta.r, vol_delta.l, vol_delta.r };
+	const float index_lanes[4] = { 0.0f, 0.0f, 1.0f, 1.0f };
+	const float32x4_t vol_start = vld1q_f32(vol_start_lanes);
+	const float32x4_t delta = vld1q_f32(delta_lanes);
+	const float32x4_t inv = vdupq_n_f32(inv_frames);
+	const float32x4_t index_step = vdupq_n_f32(2.0f);
+	float32x4_t index = vld1q_f32(index_lanes);
+
+	float *dst = (float *)p_dst;
+	const float *src = (const float *)p_src;
+	uint32_t i = 0;
+	for (; i + 2 <= p_frames; i += 2) {
+		float32x4_t vol = vaddq_f32(vol_start, vmulq_f32(delta, vmulq_f32(index, inv)));
+		float32x4_t d = vld1q_f32(dst + i * 2);
+		d = vaddq_f32(d, vmulq_f32(vol, vld1q_f32(src + i * 2)));
+		vst1q_f32(dst + i * 2, d);
+		index = vaddq_f32(index, index_step);
+	}
+	for (; i < p_frames; i++) {
+		AudioFrame vol = p_vol_start + vol_delta * (i * inv_frames);
+		p_dst[i] += vol * p_src[i];
+	}
+}
+
+static void _mix_ramp_biquad_accumulate_neon(AudioFrame *p_dst, const AudioFrame *p_src, AudioFrame p_vol_start, AudioFrame p_vol_final, uint32_t p_frames, AudioMixKernels::StereoBiquad *p_biquad) {
+	const float inv_frames = 1.0f / p_frames;
+	const AudioFrame vol_delta = p_vol_final - p_vol_start;
+	AudioMixKernels::StereoBiquad &bq = *p_biquad;
+
+	// The filter is recursive, so only the two channels of a single frame can be processed at once.
+	float32x2_t b0 = vld1_f32(bq.b0);
+	float32x2_t b1 = vld1_f32(bq.b1);
+	float32x2_t b2 = vld1_f32(bq.b2);
+	float32x2_t a1 = vld1_f32(bq.a1);
+	float32x2_t a2 = vld1_f32(bq.a2);
+	const float32x2_t incr_b0 = vld1_f32(bq.incr_b0);
+	const float32x2_t incr_b1 = vld1_f32(bq.incr_b1);
+	const float32x2_t incr_b2 = vld1_f32(bq.incr_b2);
+	const float32x2_t incr_a1 = vld1_f32(bq.incr_a1);
+	const float32x2_t incr_a2 = vld1_f32(bq.incr_a2);
+	float32x2_t ha1 = vld1_f32(bq.ha1);
+	float32x2_t ha2 = vld1_f32(bq.ha2);
+	float32x2_t hb1 = vld1_f32(bq.hb1);
+	float32x2_t hb2 = vld1_f32(bq.hb2);
+
+	const float vol_start_lanes[2] = { p_vol_start.l, p_vol_start.r };
+	const float delta_lanes[2] = { vol_delta.l, vol_delta.r };
+	const float32x2_t vol_start = vld1_f32(vol_start_lanes);
+	const float32x2_t delta = vld1_f32(delta_lanes);
+
+	float *dst = (float *)p_dst;
+	const float *src = (const float *)p_src;
+	for (uint32_t i = 0; i < p_frames; i++) {
+		float32x2_t vol = vadd_f32(vol_start, vmul_f32(delta, vdup_n_f32(i * inv_frames)));
+		float32x2_t pre = vmul_f32(vol, vld1_f32(src + i * 2));
+		float32x2_t post = vadd_f32(vadd_f32(vadd_f32(vadd_f32(vmul_f32(pre, b0), vmul_f32(hb1, b1)), vmul_f32(hb2, b2)), vmul_f32(ha1, a1)), vmul_f32(ha2, a2));
+		ha2 = ha1;
+		hb2 = hb1;
+		hb1 = pre;
+		ha1 = post;
+
+		b0 = vadd_f32(b0, incr_b0);
+		b1 = vadd_f32(b1, incr_b1);
+		b2 = vadd_f32(b2, incr_b2);
+		a1 = vadd_f32(a1, incr_a1);
+		a2 = vadd_f32(a2, incr_a2);
+
+		vst1_f32(dst + i * 2, vadd_f32(vld1_f32(dst + i * 2), post));
+	}
+
+	vst1_f32(bq.b0, b0);
+	vst1_f32(bq.b1, b1);
+	vst1_f32(bq.b2, b2);
+	vst1_f32(bq.a1, a1);
+	vst1_f32(bq.a2, a2);
+	vst1_f32(bq.ha1, ha1);
+	vst1_f32(bq.ha2, ha2);
+	vst1_f32(bq.hb1, hb1);
+	vst1_f32(bq.hb2, hb2);
+}
+
+static AudioFrame _mix_gain_peak_neon(AudioFrame *p_buf, float p_gain, uint32_t p_frames) {
+	const float32x4_t gain = vdupq_n_f32(p_gain);
+	float32x4_t peak = vdupq_n_f32(0.0f);
+
+	float *buf = (float *)p_buf;
+	uint32_t i = 0;
+	for (; i + 2 <= p_frames; i += 2) {
+		float32x4_t v = vmulq_f32(vld1q_f32(buf + i * 2), gain);
+		vst1q_f32(buf + i * 2, v);
+		peak = vmaxq_f32(peak, vabsq_f32(v));
+	}
+	// Fold [l0, r0, l1, r1] into [l, r].
+	float32x2_t folded = vmax_f32(vget_low_f32(peak), vget_high_f32(peak));
+
+	AudioFrame result = AudioFrame(vget_lane_f32(folded, 0), vget_lane_f32(folded, 1));
+	for (; i < p_frames; i++) {
+		p_buf[i] *= p_gain;
+		result.l = MAX(result.l, ABS(p_buf[i].l));
+		result.r = MAX(result.r, ABS(p_buf[i].r));
+	}
+	return result;
+}
+
+static void _mix_accumulate_neon(AudioFrame *p_dst, const AudioFrame *p_src, uint32_t p_frames) {
+	float *dst = (float *)p_dst;
+	const float *src = (const float *)p_src;
+	uint32_t i = 0;
+	for (; i + 2 <= p_frames; i += 2) {
+		vst1q_f32(dst + i * 2, vaddq_f32(vld1q_f32(dst + i * 2), vld1q_f32(src + i * 2)));
+	}
+	for (; i < p_frames; i++) {
+		p_dst[i] += p_src[i];
+	}
+}
+
+#endif // AUDIO_MIX_KERNELS_NEON
+
+/* Selection */
+
+static AudioMixKernels _make_scalar_kernels() {
+	AudioMixKernels k;
+	k.name = "Scalar";
+	k.level = AudioMixKernels::LEVEL_SCALAR;
+	k.mix_ramp_accumulate = _mix_ramp_accumulate_scalar;
+	k.mix_ramp_biquad_accumulate = _mix_ramp_biquad_accumulate_scalar;
+	k.mix_gain_peak = _mix_gain_peak_scalar;
+	k.mix_accumulate = _mix_accumulate_scalar;
+	return k;
+}
+
+const AudioMixKernels *AudioMixKernels::get_kernels(Level p_level) {
+	switch (p_level) {
+		case LEVEL_SCALAR: {
+			static const AudioMixKernels scalar = _make_scalar_kernels();
+			return &scalar;
+		}
+		case LEVEL_SSE2: {
+#ifdef AUDIO_MIX_KERNELS_SSE2
+			static const AudioMixKernels sse2 = []() {
+				AudioMixKernels k;
+				k.name = "SSE2";
+				k.level = LEVEL_SSE2;
+				k.mix_ramp_accumulate = _mix_ramp_accumulate_sse2;
+				k.mix_ramp_biquad_accumulate = _mix_ramp_biquad_accumulate_sse2;
+				k.mix_gain_peak = _mix_gain_peak_sse2;
+				k.mix_accumulate = _mix_accumulate_sse2;
+				return k;
+			}();
+			return &sse2;
+#else
+			return nullptr;
+#endif
+		}
+		case LEVEL_AVX2: {
+#ifdef AUDIO_MIX_KERNELS_AVX2
+			static const bool supported = _cpu_supports_avx2();
+			if (!supported) {
+				return nullptr;
+			}
+			static const AudioMixKernels avx2 = []() {
+				AudioMixKernels k;
+				k.name = "AVX2";
+				k.level = LEVEL_AVX2;
+				k.mix_ramp_accumulate = _mix_ramp_accumulate_avx2;
+				// A recursive filter over a stereo pair does not benefit from wider registers.
+				k.mix_ramp_biquad_accumulate = _mix_ramp_biquad_accumulate_sse2;
+				k.mix_gain_peak = _mix_gain_peak_avx2;
+				k.mix_accumulate = _mix_accumulate_avx2;
+				return k;
+			}();
+			return &avx2;
+#else
+			return nullptr;
+#endif
+		}
+		case LEVEL_NEON: {
+#ifdef AUDIO_MIX_KERNELS_NEON
+			static const AudioMixKernels neon = []() {
+				AudioMixKernels k;
+				k.name = "NEON";
+				k.level = LEVEL_NEON;
+				k.mix_ramp_accumulate = _mix_ramp_accumulate_neon;
+				k.mix_ramp_biquad_accumulate = _mix_ramp_biquad_accumulate_neon;
+				k.mix_gain_peak = _mix_gain_peak_neon;
+				k.mix_accumulate = _mix_accumulate_neon;
+				return k;
+			}();
+			return &neon;
+#else
+			return nullptr;
+#endif
+		}
+		case LEVEL_MAX:
+			break;
+	}
+	ERR_FAIL_V(nullptr);
+}
+
+const AudioMixKernels *AudioMixKernels::get_singleton() {
+	static const AudioMixKernels *best = []() {
+		const Level preferred[] = { LEVEL_AVX2, LEVEL_NEON, LEVEL_SSE2 };
+		for (Level level : preferred) {
+			const AudioMixKernels *kernels = get_kernels(level);
+			if (kernels) {
+				return kernels;
+			}
+		}
+		return get_kernels(LEVEL_SCALAR);
+	}();
+	return best;
+}
@@ -0,0 +1,77 @@
+/*************************************************************************/
+/*  audio_mix_kernels.h                                                  */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef AUDIO_MIX_KERNELS_H
+#define AUDIO_MIX_KERNELS_H
+
+#include "core/math/audio_frame.h"
+#include "servers/audio/audio_filter_sw.h"
+
+// Vectorized inner loops of the audio mixer.
+// Every instruction set provides the same set of kernels, the best one supported by the running CPU is picked at runtime.
+// All kernels produce the same results as the scalar versions, save for floating point rounding differences.
+struct AudioMixKernels {
+	enum Level {
+		LEVEL_SCALAR,
+		LEVEL_SSE2,
+		LEVEL_AVX2,
+		LEVEL_NEON,
+		LEVEL_MAX
+	};
+
+	// Biquad state of a stereo pair of processors, stored as [left, right] pairs so both channels can be filtered at once.
+	struct StereoBiquad {
+		float b0[2], b1[2], b2[2], a1[2], a2[2];
+		float incr_b0[2], incr_b1[2], incr_b2[2], incr_a1[2], incr_a2[2];
+		float ha1[2], ha2[2], hb1[2], hb2[2];
+
+		void load(const AudioFilterSW::Processor *p_processor_l, const AudioFilterSW::Processor *p_processor_r);
+		void store(AudioFilterSW::Processor *p_processor_l, AudioFilterSW::Processor *p_processor_r) const;
+	};
+
+	const char *name = "";
+	Level level = LEVEL_SCALAR;
+
+	// p_dst[i] += (p_vol_start + (p_vol_final - p_vol_start) * (i / p_frames)) * p_src[i]
+	void (*mix_ramp_accumulate)(AudioFrame *p_dst, const AudioFrame *p_src, AudioFrame p_vol_start, AudioFrame p_vol_final, uint32_t p_frames) = nullptr;
+	// Same as mix_ramp_accumulate, but the ramped source goes through an interpolating biquad before being accumulated.
+	void (*mix_ramp_biquad_accumulate)(AudioFrame *p_dst, const AudioFrame *p_src, AudioFrame p_vol_start, AudioFrame p_vol_final, uint32_t p_frames, StereoBiquad *p_biquad) = nullptr;
+	// p_buf[i] *= p_gain, returns the absolute peak of each channel after applying the gain.
+	AudioFrame (*mix_gain_peak)(AudioFrame *p_buf, float p_gain, uint32_t p_frames) = nullptr;
+	// p_dst[i] += p_src[i]
+	void (*mix_accumulate)(AudioFrame *p_dst, const AudioFrame *p_src, uint32_t p_frames) = nullptr;
+
+	// Returns nullptr if the level is not supported by this build or by the running CPU.
+	static const AudioMixKernels *get_kernels(Level p_level);
+	// The fastest kernels available.
+	static const AudioMixKernels *get_singleton();
+};
+
+#endif // AUDIO_MIX_KERNELS_H
@@ -39,8 +39,10 @@
 #include "core/os/os.h"
 #include "core/string/string_name.h"
 #include "core/templates/pair.h"
+#include "core/templates/sort_array.h"
 #include "scene/resources/audio_stream_sample.h"
 #include "servers/audio/audio_driver_dummy.h"
+#include "servers/audio/audio_mix_kernels.h"
 #include "servers/audio/effects/audio_effect_compressor.h"
 #include "servers/resonanceaudio/resonance_audio_wrapper.h"
 
@@ -256,15 +258,17 @@ void AudioServer::_driver_process(int p_frames, int32_t *p_buffer) {
 		init_channels_and_buffers();
 	}
 
-	ERR_FAIL_COND_MSG(buses.is_empty() && todo, "AudioServer bus count is less than 1.");
+	const MixPlan *plan = mix_plan.load();
+
+	ERR_FAIL_COND_MSG((plan == nullptr || plan->buses.is_empty()) && todo, "AudioServer bus count is less than 1.");
 	while (todo) {
 		if (to_mix == 0) {
-			_mix_step();
+			_mix_step(plan);
 		}
 
 		int to_copy = MIN(to_mix, todo);
 
-		Bus *master = buses[0];
+		Bus *master = plan->buses[0].bus;
 
 		int from = buffer_size - to_mix;
 		int from_buf = p_frames - todo;
@@ -304,131 +308,478 @@ void AudioServer::_driver_process(int p_frames, int32_t *p_buffer) {
 #endif
 }
 
-void AudioServer::_mix_step() {
-	bool solo_mode = false;
+void AudioServer::_update_mix_plan() {
+	MixPlan *plan = memnew(MixPlan);
+	plan->version = ++mix_plan_version;
+	plan->enable_resonance_audio = GLOBAL_GET("audio/enable_resonance_audio");
+	plan->channel_disable_threshold_linear = Math::db2linear(channel_disable_threshold_db);
+	plan->buses.resize(buses.size());
 
 	for (int i = 0; i < buses.size(); i++) {
 		Bus *bus = buses[i];
 		bus->index_cache = i; //might be moved around by editor, so..
-		for (int k = 0; k < bus->channels.size(); k++) {
-			bus->channels.write[k].used = false;
+		plan->bus_indices.insert(bus->name, i);
+
+		MixPlan::BusPlan &bus_plan = plan->buses[i];
+		bus_plan.bus = bus;
+		if (!bus->bypass) {
+			for (int j = 0; j < bus->effects.size(); j++) {
+				if (bus->effects[j].enabled) {
+					bus_plan.effects.push_back(j);
+					const AudioEffectCompressor *compressor = Object::cast_to<AudioEffectCompressor>(bus->effects[j].effect.ptr());
+					if (compressor) {
+						plan->compressors.push_back(compressor);
+					}
+				}
+			}
 		}
+	}
+
+	// Resolve sends, everything has a send save for master bus.
+	for (uint32_t i = 1; i < plan->buses.size(); i++) {
+		const int *send = plan->bus_indices.getptr(buses[i]->send);
+		if (!send || uint32_t(*send) >= i) { //invalid, send to master
+			plan->buses[i].send_index = 0;
+		} else {
+			plan->buses[i].send_index = *send;
+		}
+	}
 
+	// Group buses by level, a bus always ends up in a later level than anything that sends to it.
+	LocalVector<uint32_t> levels;
+	levels.resize(plan->buses.size());
+	uint32_t level_count = 0;
+	for (uint32_t i = 0; i < levels.size(); i++) {
+		levels[i] = 0;
+	}
+	for (int i = plan->buses.size() - 1; i >= 0; i--) {
+		int send = plan->buses[i].send_index;
+		if (send != -1) {
+			levels[send] = MAX(levels[send], levels[i] + 1);
+		}
+		level_count = MAX(level_count, levels[i] + 1);
+	}
+	plan->bus_levels.resize(level_count);
+	for (int i = plan->buses.size() - 1; i >= 0; i--) {
+		plan->bus_levels[levels[i]].push_back(i);
+		int send = plan->buses[i].send_index;
+		if (send != -1) {
+			plan->buses[send].senders.push_back(i);
+		}
+	}
+
+	MixPlan *old_plan = mix_plan.exchange(plan);
+	if (old_plan) {
+		mix_plan_graveyard.insert(old_plan);
+	}
+
+	// Solo chains follow the sends.
+	_update_bus_volumes();
+}
+
+void AudioServer::_update_bus_volumes() {
+	const MixPlan *plan = mix_plan.load();
+	ERR_FAIL_NULL(plan);
+
+	// A soloed bus keeps the buses it sends to audible. Sends always go to a lower index,
+	// so walking backwards reaches every bus after all the buses sending to it.
+	bool solo_mode = false;
+	for (uint32_t i = 0; i < plan->buses.size(); i++) {
+		plan->buses[i].bus->soloed = false;
+	}
+	for (int i = plan->buses.size() - 1; i >= 0; i--) {
+		Bus *bus = plan->buses[i].bus;
 		if (bus->solo) {
-			//solo chain
-			solo_mode = true;
 			bus->soloed = true;
-			do {
-				if (bus != buses[0]) {
-					//everything has a send save for master bus
-					if (!bus_map.has(bus->send)) {
-						bus = buses[0]; //send to master
-					} else {
-						int prev_index_cache = bus->index_cache;
-						bus = bus_map[bus->send];
-						if (prev_index_cache >= bus->index_cache) { //invalid, send to master
-							bus = buses[0];
-						}
-					}
+			solo_mode = true;
+		}
+		int send = plan->buses[i].send_index;
+		if (bus->soloed && send != -1) {
+			plan->buses[send].bus->soloed = true;
+		}
+	}
 
-					bus->soloed = true;
-				} else {
-					bus = nullptr;
-				}
+	for (uint32_t i = 0; i < plan->buses.size(); i++) {
+		Bus *bus = plan->buses[i].bus;
+		bool silenced = solo_mode ? !bus->soloed : bus->mute;
+		bus->volume_linear.set(silenced ? 0.0 : Math::db2linear(bus->volume_db));
+	}
+}
 
-			} while (bus);
-		} else {
-			bus->soloed = false;
+void AudioServer::_mix_step(const MixPlan *p_plan) {
+	for (uint32_t i = 0; i < p_plan->buses.size(); i++) {
+		Bus *bus = p_plan->buses[i].bus;
+		for (int k = 0; k < bus->channels.size(); k++) {
+			bus->channels.write[k].used = false;
 		}
 	}
+
 	for (CallbackItem *ci : mix_callback_list) {
 		ci->callback(ci->userdata);
 	}
 
+	if (p_plan->enable_resonance_audio) {
+		ResonanceAudioServer::get_singleton()->apply_pending_transforms();
+	}
+
+	_update_voices();
+
+	bool parallel = mix_thread_count > 0;
+
+	mix_chunk_playbacks.clear();
 	for (AudioStreamPlaybackListNode *playback : playback_list) {
 		// Paused streams are no-ops. Don't even mix audio from the stream playback.
 		if (playback->state.load() == AudioStreamPlaybackListNode::PAUSED) {
 			continue;
 		}
+		if (playback->voice_state == AudioStreamPlaybackListNode::VOICE_VIRTUAL && _mix_step_virtual_voice(playback)) {
+			_mix_step_playback_finish(playback);
+			continue;
+		}
+		if (playback->voice_state == AudioStreamPlaybackListNode::VOICE_REAL && playback->voice_wants_virtual) {
+			playback->voice_state = AudioStreamPlaybackListNode::VOICE_FADING_TO_VIRTUAL;
+		}
+		// Spatialized playbacks push to the resonance audio API, which must only be used from the audio thread.
+		bool spatial = p_plan->enable_resonance_audio && playback->source_id.get_id() != -1;
+		if (!spatial) {
+			mix_chunk_playbacks.push_back(playback);
+			continue;
+		}
+		_mix_step_playback(p_plan, playback, mix_buffer.ptrw(), nullptr);
+		_mix_step_playback_finish(playback);
+	}
 
-		bool fading_out = playback->state.load() == AudioStreamPlaybackListNode::FADE_OUT_TO_DELETION || playback->state.load() == AudioStreamPlaybackListNode::FADE_OUT_TO_PAUSE;
+	// The chunks only depend on the amount of playbacks, never on the thread count or on thread scheduling,
+	// and their sums are always added in chunk order, so mixing serially or in parallel gives the same output.
+	uint32_t chunk_count = MIN((uint32_t)MAX_MIX_CHUNKS, (mix_chunk_playbacks.size() + MIN_PLAYBACKS_PER_MIX_CHUNK - 1) / MIN_PLAYBACKS_PER_MIX_CHUNK);
+	if (chunk_count) {
+		uint32_t per_chunk = (mix_chunk_playbacks.size() + chunk_count - 1) / chunk_count;
 
-		AudioFrame *buf = mix_buffer.ptrw();
+		if (parallel) {
+			_ensure_mix_chunks(p_plan, chunk_count);
+			for (uint32_t i = 0; i < chunk_count; i++) {
+				mix_chunks[i].from = MIN(i * per_chunk, mix_chunk_playbacks.size());
+				mix_chunks[i].to = MIN((i + 1) * per_chunk, mix_chunk_playbacks.size());
+			}
 
-		// Copy the lookeahead buffer into the mix buffer.
-		for (int i = 0; i < LOOKAHEAD_BUFFER_SIZE; i++) {
-			buf[i] = playback->lookahead[i];
+			WorkerThreadPool::get_singleton()->parallel_for(chunk_count, this, &AudioServer::_mix_chunk_work, p_plan, WorkerThreadPool::PRIORITY_HIGH, mix_thread_count);
+
+			for (uint32_t i = 0; i < chunk_count; i++) {
+				_reduce_mix_chunk(mix_chunks[i]);
+			}
+		} else {
+			// One chunk at a time, reusing the same buffers.
+			_ensure_mix_chunks(p_plan, 1);
+			for (uint32_t i = 0; i < chunk_count; i++) {
+				mix_chunks[0].from = MIN(i * per_chunk, mix_chunk_playbacks.size());
+				mix_chunks[0].to = MIN((i + 1) * per_chunk, mix_chunk_playbacks.size());
+				_mix_chunk_work(0, p_plan);
+				_reduce_mix_chunk(mix_chunks[0]);
+			}
 		}
 
-		// Mix the audio stream
-		unsigned int mixed_frames = playback->stream_playback->mix(&buf[LOOKAHEAD_BUFFER_SIZE], playback->pitch_scale.get(), buffer_size);
+		for (uint32_t i = 0; i < mix_chunk_playbacks.size(); i++) {
+			_mix_step_playback_finish(mix_chunk_playbacks[i]);
+		}
+	}
 
-		if (mixed_frames != buffer_size) {
-			// We know we have at least the size of our lookahead buffer for fade-out purposes.
-
-			float fadeout_base = 0.94;
-			float fadeout_coefficient = 1;
-			static_assert(LOOKAHEAD_BUFFER_SIZE == 64, "Update fadeout_base and comment here if you change LOOKAHEAD_BUFFER_SIZE.");
-			// 0.94 ^ 64 = 0.01906. There might still be a pop but it'll be way better than if we didn't do this.
-			for (unsigned int idx = mixed_frames; idx < buffer_size; idx++) {
-				fadeout_coefficient *= fadeout_base;
-				buf[idx] *= fadeout_coefficient;
+	if (p_plan->enable_resonance_audio) {
+		_mix_step_spatial_listener();
+	}
+
+	if (parallel && !_mix_plan_uses_sidechain(p_plan)) {
+		_ensure_mix_bus_temp_buffers(p_plan);
+
+		for (uint32_t level = 0; level < p_plan->bus_levels.size(); level++) {
+			const LocalVector<int> &level_buses = p_plan->bus_levels[level];
+
+			// Sends are accumulated on this thread right before their target is processed, in descending index order
+			// like the serial path, so both give the same output.
+			for (uint32_t i = 0; i < level_buses.size(); i++) {
+				const LocalVector<int> &senders = p_plan->buses[level_buses[i]].senders;
+				for (uint32_t j = 0; j < senders.size(); j++) {
+					_mix_step_bus_send(p_plan, senders[j]);
+				}
 			}
-			AudioStreamPlaybackListNode::PlaybackState new_state;
-			new_state = AudioStreamPlaybackListNode::AWAITING_DELETION;
-			playback->state.store(new_state);
-		} else {
-			// Move the last little bit of what we just mixed into our lookahead buffer.
-			for (int i = 0; i < LOOKAHEAD_BUFFER_SIZE; i++) {
-				playback->lookahead[i] = buf[buffer_size + i];
+
+			MixLevelWork work;
+			work.plan = p_plan;
+			work.buses = &level_buses;
+			WorkerThreadPool::get_singleton()->parallel_for(level_buses.size(), this, &AudioServer::_mix_level_work, &work, WorkerThreadPool::PRIORITY_HIGH, mix_thread_count);
+		}
+	} else {
+		for (int i = p_plan->buses.size() - 1; i >= 0; i--) {
+			//go bus by bus
+			_mix_step_bus(p_plan, i, temp_buffer.ptrw());
+			_mix_step_bus_send(p_plan, i);
+		}
+	}
+
+	mix_frames += buffer_size;
+	to_mix = buffer_size;
+}
+
+void AudioServer::_update_voices() {
+	voice_candidates.clear();
+	for (AudioStreamPlaybackListNode *playback : playback_list) {
+		playback->voice_wants_virtual = false;
+		if (!playback->voice_virtualizable.is_set() || playback->state.load() != AudioStreamPlaybackListNode::PLAYING) {
+			continue;
+		}
+
+		// The loudest target volume already accounts for distance attenuation and panning.
+		const AudioStreamPlaybackBusDetails *bus_details = playback->bus_details.load();
+		float audibility = 0.0;
+		for (int idx = 0; idx < MAX_BUSES_PER_PLAYBACK; idx++) {
+			if (!bus_details->bus_active[idx]) {
+				continue;
+			}
+			for (int channel_idx = 0; channel_idx < channel_count; channel_idx++) {
+				const AudioFrame &vol = bus_details->volume[idx][channel_idx];
+				audibility = MAX(audibility, MAX(vol.l, vol.r));
+			}
+		}
+
+		if (audibility < voice_virtualize_threshold_linear) {
+			playback->voice_wants_virtual = true;
+			continue;
+		}
+
+		if (voice_max_count > 0) {
+			VoiceCandidate candidate;
+			candidate.playback = playback;
+			candidate.priority = playback->voice_priority.get();
+			// Voices that are already real get a slight edge, so voices of similar audibility don't keep trading places.
+			candidate.audibility = playback->voice_state == AudioStreamPlaybackListNode::VOICE_VIRTUAL ? audibility : audibility * 1.25;
+			voice_candidates.push_back(candidate);
+		}
+	}
+
+	if (voice_max_count > 0 && voice_candidates.size() > (uint32_t)voice_max_count) {
+		SortArray<VoiceCandidate, VoiceCandidateSort> sorter;
+		sorter.sort(voice_candidates.ptr(), voice_candidates.size());
+		for (uint32_t i = voice_max_count; i < voice_candidates.size(); i++) {
+			voice_candidates[i].playback->voice_wants_virtual = true;
+		}
+	}
+}
+
+bool AudioServer::_mix_step_virtual_voice(AudioStreamPlaybackListNode *p_playback) {
+	if (p_playback->state.load() != AudioStreamPlaybackListNode::PLAYING) {
+		// There is nothing to fade out, the state change is applied right away.
+		return true;
+	}
+
+	if (!p_playback->voice_wants_virtual) {
+		// Promote the voice, it fades in from silence at its estimated position like a newly started playback.
+		p_playback->stream_playback->seek(p_playback->voice_virtual_position.get());
+		for (int i = 0; i < LOOKAHEAD_BUFFER_SIZE; i++) {
+			p_playback->lookahead[i] = AudioFrame(0, 0);
+		}
+		memset(p_playback->prev_bus_details->volume, 0, sizeof(p_playback->prev_bus_details->volume));
+		p_playback->voice_state = AudioStreamPlaybackListNode::VOICE_REAL;
+		p_playback->voice_is_virtual.clear();
+		virtual_voice_count.decrement();
+		return false;
+	}
+
+	float position = p_playback->voice_virtual_position.get() + buffer_size * p_playback->pitch_scale.get() * playback_speed_scale / get_mix_rate();
+	float length = p_playback->voice_stream_length.get();
+	if (length > 0 && position >= length) {
+		// Only the stream knows whether it loops, so let it mix a single buffer from its end to find out.
+		p_playback->stream_playback->seek(position);
+		unsigned int mixed_frames = p_playback->stream_playback->mix(mix_buffer.ptrw(), p_playback->pitch_scale.get(), buffer_size);
+		if (mixed_frames != buffer_size) {
+			AudioStreamPlaybackListNode::PlaybackState old_state = AudioStreamPlaybackListNode::PLAYING;
+			p_playback->state.compare_exchange_strong(old_state, AudioStreamPlaybackListNode::AWAITING_DELETION);
+			return true;
+		}
+		position = p_playback->stream_playback->get_playback_position();
+	}
+	p_playback->voice_virtual_position.set(position);
+	return true;
+}
+
+void AudioServer::_ensure_mix_chunks(const MixPlan *p_plan, uint32_t p_chunk_count) {
+	uint32_t bus_buffer_count = p_plan->buses.size() * channel_count;
+
+	if (mix_chunks.size() < p_chunk_count) {
+		mix_chunks.resize(p_chunk_count);
+	}
+
+	for (uint32_t i = 0; i < p_chunk_count; i++) {
+		MixChunk &chunk = mix_chunks[i];
+		if (chunk.mix_buffer.size() != mix_buffer.size()) {
+			chunk.mix_buffer.resize(mix_buffer.size());
+		}
+		if (chunk.bus_buffers.size() != bus_buffer_count) {
+			chunk.bus_buffers.resize(bus_buffer_count);
+			chunk.bus_buffer_used.resize(bus_buffer_count);
+		}
+		for (uint32_t j = 0; j < bus_buffer_count; j++) {
+			if (chunk.bus_buffers[j].size() != (int)buffer_size) {
+				chunk.bus_buffers[j].resize(buffer_size);
 			}
+			chunk.bus_buffer_used[j] = false;
+		}
+	}
+}
+
+void AudioServer::_ensure_mix_bus_temp_buffers(const MixPlan *p_plan) {
+	uint32_t bus_buffer_count = p_plan->buses.size() * channel_count;
+
+	if (mix_bus_temp_buffers.size() != bus_buffer_count) {
+		mix_bus_temp_buffers.resize(bus_buffer_count);
+	}
+	for (uint32_t i = 0; i < bus_buffer_count; i++) {
+		if (mix_bus_temp_buffers[i].size() != (int)buffer_size) {
+			mix_bus_temp_buffers[i].resize(buffer_size);
+		}
+	}
+}
+
+void AudioServer::_reduce_mix_chunk(MixChunk &p_chunk) {
+	for (uint32_t buf_idx = 0; buf_idx < p_chunk.bus_buffer_used.size(); buf_idx++) {
+		if (!p_chunk.bus_buffer_used[buf_idx]) {
+			continue;
+		}
+		AudioFrame *target_buf = thread_get_channel_mix_buffer(buf_idx / channel_count, buf_idx % channel_count);
+		mix_kernels->mix_accumulate(target_buf, p_chunk.bus_buffers[buf_idx].ptr(), buffer_size);
+		p_chunk.bus_buffer_used[buf_idx] = false;
+	}
+}
+
+void AudioServer::_mix_chunk_work(uint32_t p_index, const MixPlan *p_plan) {
+	MixChunk *chunk = &mix_chunks[p_index];
+	for (uint32_t i = chunk->from; i < chunk->to; i++) {
+		_mix_step_playback(p_plan, mix_chunk_playbacks[i], chunk->mix_buffer.ptrw(), chunk);
+	}
+}
+
+bool AudioServer::_mix_plan_uses_sidechain(const MixPlan *p_plan) const {
+	for (uint32_t i = 0; i < p_plan->compressors.size(); i++) {
+		if (p_plan->compressors[i]->get_sidechain() != StringName()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void AudioServer::_mix_level_work(uint32_t p_index, MixLevelWork *p_work) {
+	int bus_idx = (*p_work->buses)[p_index];
+	_mix_step_bus(p_work->plan, bus_idx, &mix_bus_temp_buffers[bus_idx * channel_count]);
+}
+
+AudioFrame *AudioServer::_get_playback_target_buffer(MixChunk *p_chunk, int p_bus, int p_channel) {
+	if (!p_chunk) {
+		return thread_get_channel_mix_buffer(p_bus, p_channel);
+	}
+
+	uint32_t buf_idx = p_bus * channel_count + p_channel;
+	AudioFrame *data = p_chunk->bus_buffers[buf_idx].ptrw();
+	if (!p_chunk->bus_buffer_used[buf_idx]) {
+		p_chunk->bus_buffer_used[buf_idx] = true;
+		for (uint32_t i = 0; i < buffer_size; i++) {
+			data[i] = AudioFrame(0, 0);
 		}
+	}
+	return data;
+}
+
+void AudioServer::_mix_step_playback(const MixPlan *p_plan, AudioStreamPlaybackListNode *p_playback, AudioFrame *p_mix_buffer, MixChunk *p_chunk) {
+	bool fading_out = p_playback->state.load() == AudioStreamPlaybackListNode::FADE_OUT_TO_DELETION || p_playback->state.load() == AudioStreamPlaybackListNode::FADE_OUT_TO_PAUSE || p_playback->voice_state == AudioStreamPlaybackListNode::VOICE_FADING_TO_VIRTUAL;
+
+	AudioFrame *buf = p_mix_buffer;
+
+	// Copy the lookeahead buffer into the mix buffer.
+	for (int i = 0; i < LOOKAHEAD_BUFFER_SIZE; i++) {
+		buf[i] = p_playback->lookahead[i];
+	}
+
+	// Mix the audio stream
+	unsigned int mixed_frames = p_playback->stream_playback->mix(&buf[LOOKAHEAD_BUFFER_SIZE], p_playback->pitch_scale.get(), buffer_size);
 
-		AudioStreamPlaybackBusDetails *ptr = playback->bus_details.load();
-		ERR_FAIL_COND(ptr == nullptr);
-		// By putting null into the bus details pointers, we're taking ownership of their memory for the duration of this mix.
-		AudioStreamPlaybackBusDetails bus_details = *ptr;
+	if (mixed_frames != buffer_size) {
+		// We know we have at least the size of our lookahead buffer for fade-out purposes.
 
+		float fadeout_base = 0.94;
+		float fadeout_coefficient = 1;
+		static_assert(LOOKAHEAD_BUFFER_SIZE == 64, "Update fadeout_base and comment here if you change LOOKAHEAD_BUFFER_SIZE.");
+		// 0.94 ^ 64 = 0.01906. There might still be a pop but it'll be way better than if we didn't do this.
+		for (unsigned int idx = mixed_frames; idx < buffer_size; idx++) {
+			fadeout_coefficient *= fadeout_base;
+			buf[idx] *= fadeout_coefficient;
+		}
+		AudioStreamPlaybackListNode::PlaybackState new_state;
+		new_state = AudioStreamPlaybackListNode::AWAITING_DELETION;
+		p_playback->state.store(new_state);
+	} else {
+		// Move the last little bit of what we just mixed into our lookahead buffer.
+		for (int i = 0; i < LOOKAHEAD_BUFFER_SIZE; i++) {
+			p_playback->lookahead[i] = buf[buffer_size + i];
+		}
+	}
+
+	const AudioStreamPlaybackBusDetails *bus_details = p_playback->bus_details.load();
+	ERR_FAIL_COND(bus_details == nullptr);
+	AudioStreamPlaybackBusDetails *prev_bus_details = p_playback->prev_bus_details;
+
+	// Only resolve bus names when the plan or the bus assignment changed since the last mix.
+	if (p_playback->bus_index_cache_version != p_plan->version) {
+		for (int idx = 0; idx < MAX_BUSES_PER_PLAYBACK; idx++) {
+			p_playback->prev_bus_index_cache[idx] = prev_bus_details->bus_active[idx] ? p_plan->find_bus_index(prev_bus_details->bus[idx]) : 0;
+		}
+		p_playback->bus_index_cache_serial = 0;
+	}
+	if (p_playback->bus_index_cache_serial != bus_details->serial) {
+		for (int idx = 0; idx < MAX_BUSES_PER_PLAYBACK; idx++) {
+			p_playback->bus_index_cache[idx] = bus_details->bus_active[idx] ? p_plan->find_bus_index(bus_details->bus[idx]) : 0;
+		}
+		p_playback->bus_index_cache_serial = bus_details->serial;
+		p_playback->bus_index_cache_version = p_plan->version;
+	}
+
+	if (p_plan->enable_resonance_audio && p_playback->source_id.get_id() != -1) {
+		// Spatial voices bypass the bus effects, Resonance Audio renders them all into the listener buffer pulled into the master bus.
+		_mix_step_spatial_voice(p_plan, p_playback, buf, bus_details, prev_bus_details, fading_out);
+	} else {
 		// Mix to any active buses.
 		for (int idx = 0; idx < MAX_BUSES_PER_PLAYBACK; idx++) {
-			if (!bus_details.bus_active[idx]) {
+			if (!bus_details->bus_active[idx]) {
 				continue;
 			}
-			int bus_idx = thread_find_bus_index(bus_details.bus[idx]);
+			int bus_idx = p_playback->bus_index_cache[idx];
 			int prev_bus_idx = -1;
 			for (int search_idx = 0; search_idx < MAX_BUSES_PER_PLAYBACK; search_idx++) {
-				if (!playback->prev_bus_details->bus_active[search_idx]) {
+				if (!prev_bus_details->bus_active[search_idx]) {
 					continue;
 				}
-				if (playback->prev_bus_details->bus[search_idx].hash() == bus_details.bus[idx].hash()) {
+				if (prev_bus_details->bus[search_idx] == bus_details->bus[idx]) {
 					prev_bus_idx = search_idx;
 				}
 			}
 			for (int channel_idx = 0; channel_idx < channel_count; channel_idx++) {
-				AudioFrame *channel_buf = thread_get_channel_mix_buffer(bus_idx, channel_idx);
-				if (fading_out) {
-					bus_details.volume[idx][channel_idx] = AudioFrame(0, 0);
-				}
-				AudioFrame channel_vol = bus_details.volume[idx][channel_idx];
+				AudioFrame *channel_buf = _get_playback_target_buffer(p_chunk, bus_idx, channel_idx);
+				AudioFrame channel_vol = fading_out ? AudioFrame(0, 0) : bus_details->volume[idx][channel_idx];
 
 				AudioFrame prev_channel_vol = AudioFrame(0, 0);
 				if (prev_bus_idx != -1) {
-					prev_channel_vol = playback->prev_bus_details->volume[prev_bus_idx][channel_idx];
+					prev_channel_vol = prev_bus_details->volume[prev_bus_idx][channel_idx];
 				}
-				_mix_step_for_channel(channel_buf, buf, prev_channel_vol, channel_vol, playback->attenuation_filter_cutoff_hz.get(), playback->highshelf_gain.get(), playback->source_id, &playback->filter_process[channel_idx * 2], &playback->filter_process[channel_idx * 2 + 1]);
+				_mix_step_for_channel(p_plan, channel_buf, buf, prev_channel_vol, channel_vol, p_playback->attenuation_filter_cutoff_hz.get(), p_playback->highshelf_gain.get(), &p_playback->filter_process[channel_idx * 2], &p_playback->filter_process[channel_idx * 2 + 1]);
 			}
 		}
 
 		// Now go through and fade-out any buses that were being played to previously that we missed by going through current data.
 		for (int idx = 0; idx < MAX_BUSES_PER_PLAYBACK; idx++) {
-			if (!playback->prev_bus_details->bus_active[idx]) {
+			if (!prev_bus_details->bus_active[idx]) {
 				continue;
 			}
-			int bus_idx = thread_find_bus_index(playback->prev_bus_details->bus[idx]);
+			int bus_idx = p_playback->prev_bus_index_cache[idx];
 
 			int current_bus_idx = -1;
 			for (int search_idx = 0; search_idx < MAX_BUSES_PER_PLAYBACK; search_idx++) {
-				if (bus_details.bus[search_idx] == playback->prev_bus_details->bus[idx]) {
+				if (bus_details->bus[search_idx] == prev_bus_details->bus[idx]) {
 					current_bus_idx = search_idx;
 				}
 			}
@@ -438,200 +789,204 @@ void AudioServer::_mix_step() {
 			}
 
 			for (int channel_idx = 0; channel_idx < channel_count; channel_idx++) {
-				AudioFrame *channel_buf = thread_get_channel_mix_buffer(bus_idx, channel_idx);
-				AudioFrame prev_channel_vol = playback->prev_bus_details->volume[idx][channel_idx];
+				AudioFrame *channel_buf = _get_playback_target_buffer(p_chunk, bus_idx, channel_idx);
+				AudioFrame prev_channel_vol = prev_bus_details->volume[idx][channel_idx];
 				// Fade out to silence
-				_mix_step_for_channel(channel_buf, buf, prev_channel_vol, AudioFrame(0, 0), playback->attenuation_filter_cutoff_hz.get(), playback->highshelf_gain.get(), playback->source_id, &playback->filter_process[channel_idx * 2], &playback->filter_process[channel_idx * 2 + 1]);
+				_mix_step_for_channel(p_plan, channel_buf, buf, prev_channel_vol, AudioFrame(0, 0), p_playback->attenuation_filter_cutoff_hz.get(), p_playback->highshelf_gain.get(), &p_playback->filter_process[channel_idx * 2], &p_playback->filter_process[channel_idx * 2 + 1]);
 			}
 		}
+	}
 
-		// Copy the bus details we mixed with to the previous bus details to maintain volume ramps.
-		std::copy(std::begin(bus_details.bus_active), std::end(bus_details.bus_active), std::begin(playback->prev_bus_details->bus_active));
-		std::copy(std::begin(bus_details.bus), std::end(bus_details.bus), std::begin(playback->prev_bus_details->bus));
-		for (int bus_idx = 0; bus_idx < MAX_BUSES_PER_PLAYBACK; bus_idx++) {
-			std::copy(std::begin(bus_details.volume[bus_idx]), std::end(bus_details.volume[bus_idx]), std::begin(playback->prev_bus_details->volume[bus_idx]));
+	// Copy the bus details we mixed with to the previous bus details to maintain volume ramps.
+	for (int idx = 0; idx < MAX_BUSES_PER_PLAYBACK; idx++) {
+		prev_bus_details->bus_active[idx] = bus_details->bus_active[idx];
+		if (prev_bus_details->bus[idx] != bus_details->bus[idx]) {
+			prev_bus_details->bus[idx] = bus_details->bus[idx];
 		}
-
-		switch (playback->state.load()) {
-			case AudioStreamPlaybackListNode::AWAITING_DELETION:
-			case AudioStreamPlaybackListNode::FADE_OUT_TO_DELETION:
-				playback_list.erase(playback, [](AudioStreamPlaybackListNode *p) {
-					if (p->prev_bus_details) {
-						delete p->prev_bus_details;
-					}
-					if (p->bus_details) {
-						delete p->bus_details;
-					}
-					p->stream_playback.unref();
-					delete p;
-				});
-				break;
-			case AudioStreamPlaybackListNode::FADE_OUT_TO_PAUSE: {
-				// Pause the stream.
-				AudioStreamPlaybackListNode::PlaybackState old_state, new_state;
-				do {
-					old_state = playback->state.load();
-					new_state = AudioStreamPlaybackListNode::PAUSED;
-				} while (!playback->state.compare_exchange_strong(/* expected= */ old_state, new_state));
-			} break;
-			case AudioStreamPlaybackListNode::PLAYING:
-			case AudioStreamPlaybackListNode::PAUSED:
-				// No-op!
-				break;
+		for (int channel_idx = 0; channel_idx < MAX_CHANNELS_PER_BUS; channel_idx++) {
+			prev_bus_details->volume[idx][channel_idx] = fading_out ? AudioFrame(0, 0) : bus_details->volume[idx][channel_idx];
 		}
+		p_playback->prev_bus_index_cache[idx] = p_playback->bus_index_cache[idx];
 	}
-	for (int i = buses.size() - 1; i >= 0; i--) {
-		//go bus by bus
-		Bus *bus = buses[i];
-
-		for (int k = 0; k < bus->channels.size(); k++) {
-			if (bus->channels[k].active && !bus->channels[k].used) {
-				//buffer was not used, but it's still active, so it must be cleaned
-				AudioFrame *buf = bus->channels.write[k].buffer.ptrw();
+}
 
-				for (uint32_t j = 0; j < buffer_size; j++) {
-					buf[j] = AudioFrame(0, 0);
-				}
+void AudioServer::_mix_step_spatial_voice(const MixPlan *p_plan, AudioStreamPlaybackListNode *p_playback, AudioFrame *p_source_buf, const AudioStreamPlaybackBusDetails *p_bus_details, const AudioStreamPlaybackBusDetails *p_prev_bus_details, bool p_fading_out) {
+	// Resonance Audio pans and attenuates the voice by itself, so only the dry signal is submitted,
+	// using the first channel volume of the first active bus as gain.
+	AudioFrame vol_final = AudioFrame(0, 0);
+	AudioFrame vol_start = AudioFrame(0, 0);
+	int bus_idx = 0;
+	for (int idx = 0; idx < MAX_BUSES_PER_PLAYBACK; idx++) {
+		if (!p_bus_details->bus_active[idx]) {
+			continue;
+		}
+		if (!p_fading_out) {
+			vol_final = p_bus_details->volume[idx][0];
+		}
+		for (int search_idx = 0; search_idx < MAX_BUSES_PER_PLAYBACK; search_idx++) {
+			if (p_prev_bus_details->bus_active[search_idx] && p_prev_bus_details->bus[search_idx] == p_bus_details->bus[idx]) {
+				vol_start = p_prev_bus_details->volume[search_idx][0];
 			}
 		}
+		bus_idx = p_playback->bus_index_cache[idx];
+		break;
+	}
 
-		//process effects
-		if (!bus->bypass) {
-			for (int j = 0; j < bus->effects.size(); j++) {
-				if (!bus->effects[j].enabled) {
-					continue;
-				}
+	// The listener buffer is mixed into the master bus, so apply the volume, mute and solo of every bus
+	// the voice would have been sent through on its way there. Effects on those buses are not applied.
+	float bus_gain = 1.0;
+	for (; bus_idx > 0; bus_idx = p_plan->buses[bus_idx].send_index) {
+		bus_gain *= p_plan->buses[bus_idx].bus->volume_linear.get();
+	}
 
-#ifdef DEBUG_ENABLED
-				uint64_t ticks = OS::get_singleton()->get_ticks_usec();
-#endif
+	AudioFrame *dry_buf = spatial_source_buffer.ptrw();
+	for (uint32_t i = 0; i < buffer_size; i++) {
+		dry_buf[i] = AudioFrame(0, 0);
+	}
+	_mix_step_for_channel(p_plan, dry_buf, p_source_buf, vol_start * bus_gain, vol_final * bus_gain, p_playback->attenuation_filter_cutoff_hz.get(), p_playback->highshelf_gain.get(), &p_playback->filter_process[0], &p_playback->filter_process[1]);
+	ResonanceAudioServer::get_singleton()->push_source_buffer(p_playback->source_id, buffer_size, dry_buf);
+}
 
-				for (int k = 0; k < bus->channels.size(); k++) {
-					if (!(bus->channels[k].active || bus->channels[k].effect_instances[j]->process_silence())) {
-						continue;
-					}
-					bus->channels.write[k].effect_instances.write[j]->process(bus->channels[k].buffer.ptr(), temp_buffer.write[k].ptrw(), buffer_size);
-				}
+void AudioServer::_mix_step_spatial_listener() {
+	// Pulled once per mix step after every spatial voice was pushed, and before the master bus effects run.
+	if (!ResonanceAudioServer::get_singleton()->pull_listener_buffer(buffer_size, spatial_pull_buffer.ptrw())) {
+		return;
+	}
+	AudioFrame *master_buf = thread_get_channel_mix_buffer(0, 0);
+	ERR_FAIL_NULL(master_buf);
+	mix_kernels->mix_accumulate(master_buf, spatial_pull_buffer.ptr(), buffer_size);
+}
 
-				//swap buffers, so internal buffer always has the right data
-				for (int k = 0; k < bus->channels.size(); k++) {
-					if (!(buses[i]->channels[k].active || bus->channels[k].effect_instances[j]->process_silence())) {
-						continue;
-					}
-					SWAP(bus->channels.write[k].buffer, temp_buffer.write[k]);
+void AudioServer::_mix_step_playback_finish(AudioStreamPlaybackListNode *p_playback) {
+	if (p_playback->voice_state == AudioStreamPlaybackListNode::VOICE_FADING_TO_VIRTUAL) {
+		p_playback->voice_virtual_position.set(p_playback->stream_playback->get_playback_position());
+		p_playback->voice_state = AudioStreamPlaybackListNode::VOICE_VIRTUAL;
+		p_playback->voice_is_virtual.set();
+		virtual_voice_count.increment();
+	}
+
+	switch (p_playback->state.load()) {
+		case AudioStreamPlaybackListNode::AWAITING_DELETION:
+		case AudioStreamPlaybackListNode::FADE_OUT_TO_DELETION:
+			if (p_playback->voice_state == AudioStreamPlaybackListNode::VOICE_VIRTUAL) {
+				virtual_voice_count.decrement();
+			}
+			playback_list.erase(p_playback, [](AudioStreamPlaybackListNode *p) {
+				if (p->prev_bus_details) {
+					delete p->prev_bus_details;
 				}
+				if (p->bus_details) {
+					delete p->bus_details;
+				}
+				p->stream_playback.unref();
+				delete p;
+			});
+			break;
+		case AudioStreamPlaybackListNode::FADE_OUT_TO_PAUSE: {
+			// Pause the stream.
+			AudioStreamPlaybackListNode::PlaybackState old_state, new_state;
+			do {
+				old_state = p_playback->state.load();
+				new_state = AudioStreamPlaybackListNode::PAUSED;
+			} while (!p_playback->state.compare_exchange_strong(/* expected= */ old_state, new_state));
+		} break;
+		case AudioStreamPlaybackListNode::PLAYING:
+		case AudioStreamPlaybackListNode::PAUSED:
+			// No-op!
+			break;
+	}
+}
 
-#ifdef DEBUG_ENABLED
-				bus->effects.write[j].prof_time += OS::get_singleton()->get_ticks_usec() - ticks;
-#endif
+void AudioServer::_mix_step_bus(const MixPlan *p_plan, int p_bus, Vector<AudioFrame> *p_temp_buffers) {
+	const MixPlan::BusPlan &bus_plan = p_plan->buses[p_bus];
+	Bus *bus = bus_plan.bus;
+
+	for (int k = 0; k < bus->channels.size(); k++) {
+		if (bus->channels[k].active && !bus->channels[k].used) {
+			//buffer was not used, but it's still active, so it must be cleaned
+			AudioFrame *buf = bus->channels.write[k].buffer.ptrw();
+
+			for (uint32_t j = 0; j < buffer_size; j++) {
+				buf[j] = AudioFrame(0, 0);
 			}
 		}
+	}
 
-		//process send
+	//process effects
+	for (uint32_t e = 0; e < bus_plan.effects.size(); e++) {
+		int j = bus_plan.effects[e];
 
-		Bus *send = nullptr;
+#ifdef DEBUG_ENABLED
+		uint64_t ticks = OS::get_singleton()->get_ticks_usec();
+#endif
 
-		if (i > 0) {
-			//everything has a send save for master bus
-			if (!bus_map.has(bus->send)) {
-				send = buses[0];
-			} else {
-				send = bus_map[bus->send];
-				if (send->index_cache >= bus->index_cache) { //invalid, send to master
-					send = buses[0];
-				}
+		for (int k = 0; k < bus->channels.size(); k++) {
+			if (!(bus->channels[k].active || bus->channels[k].effect_instances[j]->process_silence())) {
+				continue;
 			}
+			bus->channels.write[k].effect_instances.write[j]->process(bus->channels[k].buffer.ptr(), p_temp_buffers[k].ptrw(), buffer_size);
 		}
 
+		//swap buffers, so internal buffer always has the right data
 		for (int k = 0; k < bus->channels.size(); k++) {
-			if (!bus->channels[k].active) {
-				bus->channels.write[k].peak_volume = AudioFrame(AUDIO_MIN_PEAK_DB, AUDIO_MIN_PEAK_DB);
+			if (!(bus->channels[k].active || bus->channels[k].effect_instances[j]->process_silence())) {
 				continue;
 			}
+			SWAP(bus->channels.write[k].buffer, p_temp_buffers[k]);
+		}
 
-			AudioFrame *buf = bus->channels.write[k].buffer.ptrw();
+#ifdef DEBUG_ENABLED
+		bus->effects.write[j].prof_time += OS::get_singleton()->get_ticks_usec() - ticks;
+#endif
+	}
 
-			AudioFrame peak = AudioFrame(0, 0);
+	for (int k = 0; k < bus->channels.size(); k++) {
+		if (!bus->channels[k].active) {
+			bus->channels.write[k].peak_volume = AudioFrame(AUDIO_MIN_PEAK_DB, AUDIO_MIN_PEAK_DB);
+			continue;
+		}
 
-			float volume = Math::db2linear(bus->volume_db);
+		AudioFrame *buf = bus->channels.write[k].buffer.ptrw();
 
-			if (solo_mode) {
-				if (!bus->soloed) {
-					volume = 0.0;
-				}
-			} else {
-				if (bus->mute) {
-					volume = 0.0;
-				}
-			}
+		//apply volume and compute peak
+		AudioFrame peak = mix_kernels->mix_gain_peak(buf, bus->volume_linear.get(), buffer_size);
 
-			//apply volume and compute peak
-			for (uint32_t j = 0; j < buffer_size; j++) {
-				buf[j] *= volume;
+		bus->channels.write[k].peak_volume = AudioFrame(Math::linear2db(peak.l + AUDIO_PEAK_OFFSET), Math::linear2db(peak.r + AUDIO_PEAK_OFFSET));
 
-				float l = ABS(buf[j].l);
-				if (l > peak.l) {
-					peak.l = l;
-				}
-				float r = ABS(buf[j].r);
-				if (r > peak.r) {
-					peak.r = r;
-				}
-			}
+		if (!bus->channels[k].used) {
+			//see if any audio is contained, because channel was not used
 
-			bus->channels.write[k].peak_volume = AudioFrame(Math::linear2db(peak.l + AUDIO_PEAK_OFFSET), Math::linear2db(peak.r + AUDIO_PEAK_OFFSET));
+			if (MAX(peak.r, peak.l) > p_plan->channel_disable_threshold_linear) {
+				bus->channels.write[k].last_mix_with_audio = mix_frames;
+			} else if (mix_frames - bus->channels[k].last_mix_with_audio > channel_disable_frames) {
+				bus->channels.write[k].active = false; //went inactive, don't send.
+			}
+		}
+	}
+}
 
-			if (!bus->channels[k].used) {
-				//see if any audio is contained, because channel was not used
+void AudioServer::_mix_step_bus_send(const MixPlan *p_plan, int p_bus) {
+	const MixPlan::BusPlan &bus_plan = p_plan->buses[p_bus];
+	Bus *bus = bus_plan.bus;
 
-				if (MAX(peak.r, peak.l) > Math::db2linear(channel_disable_threshold_db)) {
-					bus->channels.write[k].last_mix_with_audio = mix_frames;
-				} else if (mix_frames - bus->channels[k].last_mix_with_audio > channel_disable_frames) {
-					bus->channels.write[k].active = false;
-					continue; //went inactive, don't mix.
-				}
-			}
+	for (int k = 0; k < bus->channels.size(); k++) {
+		if (!bus->channels[k].active) {
+			continue;
+		}
 
-			if (send) {
-				//if not master bus, send
-				AudioFrame *target_buf = thread_get_channel_mix_buffer(send->index_cache, k);
+		AudioFrame *buf = bus->channels.write[k].buffer.ptrw();
 
-				for (uint32_t j = 0; j < buffer_size; j++) {
-					target_buf[j] += buf[j];
-				}
-			} else {
-				if (GLOBAL_GET("audio/enable_resonance_audio")) {
-					AudioFrame *master_buf = thread_get_channel_mix_buffer(0, 0);
-					bool success = false;
-					if (master_buf) {
-						for (int frame_idx = 0; frame_idx < spatial_pull_buffer.size(); frame_idx++) {
-							spatial_pull_buffer.write[frame_idx] = master_buf[frame_idx];
-						}
-						success = ResonanceAudioServer::get_singleton()->pull_listener_buffer(buffer_size, spatial_pull_buffer.ptrw());
-					}
-					if (success) {
-						for (int frame_idx = 0; frame_idx < spatial_pull_buffer.size(); frame_idx++) {
-							master_buf[frame_idx] += spatial_pull_buffer[frame_idx];
-						}
-					}
-				}
-			}
+		if (bus_plan.send_index != -1) {
+			//if not master bus, send
+			AudioFrame *target_buf = thread_get_channel_mix_buffer(bus_plan.send_index, k);
+			mix_kernels->mix_accumulate(target_buf, buf, buffer_size);
 		}
 	}
-
-	mix_frames += buffer_size;
-	to_mix = buffer_size;
 }
 
-void AudioServer::_mix_step_for_channel(AudioFrame *p_out_buf, AudioFrame *p_source_buf, AudioFrame p_vol_start, AudioFrame p_vol_final, float p_attenuation_filter_cutoff_hz, float p_highshelf_gain, AudioSourceId p_audio_source_id, AudioFilterSW::Processor *p_processor_l, AudioFilterSW::Processor *p_processor_r) {
-	if (GLOBAL_GET("audio/enable_resonance_audio") && p_audio_source_id.get_id() != -1) {
-		for (unsigned int frame_idx = 0; frame_idx < buffer_size; frame_idx++) {
-			// Make this buffer size invariant if buffer_size ever becomes a project setting.
-			float lerp_param = (float)frame_idx / buffer_size;
-			p_out_buf[frame_idx] += (p_vol_final * lerp_param + (1 - lerp_param) * p_vol_start) * p_source_buf[frame_idx];
-		}
-		ResonanceAudioServer::get_singleton()->push_source_buffer(p_audio_source_id, buffer_size, p_out_buf);
-	} else if (p_highshelf_gain != 0) {
+void AudioServer::_mix_step_for_channel(const MixPlan *p_plan, AudioFrame *p_out_buf, AudioFrame *p_source_buf, AudioFrame p_vol_start, AudioFrame p_vol_final, float p_attenuation_filter_cutoff_hz, float p_highshelf_gain, AudioFilterSW::Processor *p_processor_l, AudioFilterSW::Processor *p_processor_r) {
+	// Volume ramps span the whole buffer, make this buffer size invariant if buffer_size ever becomes a project setting.
+	if (p_highshelf_gain != 0) {
 		AudioFilterSW filter;
 		filter.set_mode(AudioFilterSW::HIGHSHELF);
 		filter.set_sampling_rate(get_mix_rate());
@@ -649,21 +1004,12 @@ void AudioServer::_mix_step_for_channel(AudioFrame *p_out_buf, AudioFrame *p_sou
 		p_processor_r->set_filter(&filter, /* clear_history= */ is_just_started);
 		p_processor_r->update_coeffs(buffer_size);
 
-		for (unsigned int frame_idx = 0; frame_idx < buffer_size; frame_idx++) {
-			// Make this buffer size invariant if buffer_size ever becomes a project setting.
-			float lerp_param = (float)frame_idx / buffer_size;
-			AudioFrame vol = p_vol_final * lerp_param + (1 - lerp_param) * p_vol_start;
-			AudioFrame mixed = vol * p_source_buf[frame_idx];
-			p_processor_l->process_one_interp(mixed.l);
-			p_processor_r->process_one_interp(mixed.r);
-			p_out_buf[frame_idx] += mixed;
-		}
+		AudioMixKernels::StereoBiquad biquad;
+		biquad.load(p_processor_l, p_processor_r);
+		mix_kernels->mix_ramp_biquad_accumulate(p_out_buf, p_source_buf, p_vol_start, p_vol_final, buffer_size, &biquad);
+		biquad.store(p_processor_l, p_processor_r);
 	} else {
-		for (unsigned int frame_idx = 0; frame_idx < buffer_size; frame_idx++) {
-			// Make this buffer size invariant if buffer_size ever becomes a project setting.
-			float lerp_param = (float)frame_idx / buffer_size;
-			p_out_buf[frame_idx] += (p_vol_final * lerp_param + (1 - lerp_param) * p_vol_start) * p_source_buf[frame_idx];
-		}
+		mix_kernels->mix_ramp_accumulate(p_out_buf, p_source_buf, p_vol_start, p_vol_final, buffer_size);
 	}
 }
 
@@ -709,11 +1055,9 @@ int AudioServer::thread_get_mix_buffer_size() const {
 }
 
 int AudioServer::thread_find_bus_index(const StringName &p_name) {
-	if (bus_map.has(p_name)) {
-		return bus_map[p_name]->index_cache;
-	} else {
-		return 0;
-	}
+	const MixPlan *plan = mix_plan.load();
+	ERR_FAIL_NULL_V(plan, 0);
+	return plan->find_bus_index(p_name);
 }
 
 void AudioServer::set_bus_count(int p_count) {
@@ -771,6 +1115,8 @@ void AudioServer::set_bus_count(int p_count) {
 		bus_map[attempt] = buses[i];
 	}
 
+	_update_mix_plan();
+
 	unlock();
 
 	emit_signal(SNAME("bus_layout_changed"));
@@ -784,8 +1130,10 @@ void AudioServer::remove_bus(int p_index) {
 
 	lock();
 	bus_map.erase(buses[p_index]->name);
-	memdelete(buses[p_index]);
+	Bus *bus = buses[p_index];
 	buses.remove_at(p_index);
+	_update_mix_plan();
+	memdelete(bus);
 	unlock();
 
 	emit_signal(SNAME("bus_layout_changed"));
@@ -842,6 +1190,8 @@ void AudioServer::add_bus(int p_at_pos) {
 		buses.insert(p_at_pos, bus);
 	}
 
+	_update_mix_plan();
+
 	emit_signal(SNAME("bus_layout_changed"));
 }
 
@@ -866,6 +1216,8 @@ void AudioServer::move_bus(int p_bus, int p_to_pos) {
 		buses.insert(p_to_pos - 1, bus);
 	}
 
+	_update_mix_plan();
+
 	emit_signal(SNAME("bus_layout_changed"));
 }
 
@@ -910,6 +1262,7 @@ void AudioServer::set_bus_name(int p_bus, const String &p_name) {
 	bus_map.erase(buses[p_bus]->name);
 	buses[p_bus]->name = attempt;
 	bus_map[attempt] = buses[p_bus];
+	_update_mix_plan();
 	unlock();
 
 	emit_signal(SNAME("bus_layout_changed"));
@@ -921,12 +1274,9 @@ String AudioServer::get_bus_name(int p_bus) const {
 }
 
 int AudioServer::get_bus_index(const StringName &p_bus_name) const {
-	for (int i = 0; i < buses.size(); ++i) {
-		if (buses[i]->name == p_bus_name) {
-			return i;
-		}
-	}
-	return -1;
+	Bus *const *bus = bus_map.getptr(p_bus_name);
+	// index_cache is refreshed by _update_mix_plan() after every change to the bus list.
+	return bus ? (*bus)->index_cache : -1;
 }
 
 void AudioServer::set_bus_volume_db(int p_bus, float p_volume_db) {
@@ -935,6 +1285,7 @@ void AudioServer::set_bus_volume_db(int p_bus, float p_volume_db) {
 	MARK_EDITED
 
 	buses[p_bus]->volume_db = p_volume_db;
+	_update_bus_volumes();
 }
 
 float AudioServer::get_bus_volume_db(int p_bus) const {
@@ -953,6 +1304,7 @@ void AudioServer::set_bus_send(int p_bus, const StringName &p_send) {
 	MARK_EDITED
 
 	buses[p_bus]->send = p_send;
+	_update_mix_plan();
 }
 
 StringName AudioServer::get_bus_send(int p_bus) const {
@@ -966,6 +1318,7 @@ void AudioServer::set_bus_solo(int p_bus, bool p_enable) {
 	MARK_EDITED
 
 	buses[p_bus]->solo = p_enable;
+	_update_bus_volumes();
 }
 
 bool AudioServer::is_bus_solo(int p_bus) const {
@@ -980,6 +1333,7 @@ void AudioServer::set_bus_mute(int p_bus, bool p_enable) {
 	MARK_EDITED
 
 	buses[p_bus]->mute = p_enable;
+	_update_bus_volumes();
 }
 
 bool AudioServer::is_bus_mute(int p_bus) const {
@@ -994,6 +1348,7 @@ void AudioServer::set_bus_bypass_effects(int p_bus, bool p_enable) {
 	MARK_EDITED
 
 	buses[p_bus]->bypass = p_enable;
+	_update_mix_plan();
 }
 
 bool AudioServer::is_bus_bypassing_effects(int p_bus) const {
@@ -1038,6 +1393,7 @@ void AudioServer::add_bus_effect(int p_bus, const Ref<AudioEffect> &p_effect, in
 	}
 
 	_update_bus_effects(p_bus);
+	_update_mix_plan();
 
 	unlock();
 }
@@ -1051,6 +1407,7 @@ void AudioServer::remove_bus_effect(int p_bus, int p_effect) {
 
 	buses[p_bus]->effects.remove_at(p_effect);
 	_update_bus_effects(p_bus);
+	_update_mix_plan();
 
 	unlock();
 }
@@ -1086,6 +1443,7 @@ void AudioServer::swap_bus_effects(int p_bus, int p_effect, int p_by_effect) {
 	lock();
 	SWAP(buses.write[p_bus]->effects.write[p_effect], buses.write[p_bus]->effects.write[p_by_effect]);
 	_update_bus_effects(p_bus);
+	_update_mix_plan();
 	unlock();
 }
 
@@ -1096,6 +1454,7 @@ void AudioServer::set_bus_effect_enabled(int p_bus, int p_effect, bool p_enabled
 	MARK_EDITED
 
 	buses.write[p_bus]->effects.write[p_effect].enabled = p_enabled;
+	_update_mix_plan();
 }
 
 bool AudioServer::is_bus_effect_enabled(int p_bus, int p_effect) const {
@@ -1152,6 +1511,7 @@ void AudioServer::start_playback_stream(Ref<AudioStreamPlayback> p_playback, Map
 	playback_node->stream_playback->start(p_start_time);
 
 	AudioStreamPlaybackBusDetails *new_bus_details = new AudioStreamPlaybackBusDetails();
+	new_bus_details->serial = bus_details_serial.increment();
 	int idx = 0;
 	for (KeyValue<StringName, Vector<AudioFrame>> pair : p_bus_volumes) {
 		if (pair.value.size() < channel_count || pair.value.size() != MAX_CHANNELS_PER_BUS) {
@@ -1219,6 +1579,7 @@ void AudioServer::set_playback_bus_volumes_linear(Ref<AudioStreamPlayback> p_pla
 		return;
 	}
 	AudioStreamPlaybackBusDetails *old_bus_details, *new_bus_details = new AudioStreamPlaybackBusDetails();
+	new_bus_details->serial = bus_details_serial.increment();
 
 	int idx = 0;
 	for (KeyValue<StringName, Vector<AudioFrame>> pair : p_bus_volumes) {
@@ -1307,6 +1668,24 @@ void AudioServer::set_playback_highshelf_params(Ref<AudioStreamPlayback> p_playb
 	playback_node->highshelf_gain.set(p_gain);
 }
 
+void AudioServer::set_playback_virtualization(Ref<AudioStreamPlayback> p_playback, bool p_enabled, float p_priority, float p_stream_length) {
+	ERR_FAIL_COND(p_playback.is_null());
+
+	AudioStreamPlaybackListNode *playback_node = _find_playback_list_node(p_playback);
+	if (!playback_node) {
+		return;
+	}
+	playback_node->voice_priority.set(p_priority);
+	playback_node->voice_stream_length.set(p_stream_length);
+	// Virtual voices are resumed by seeking to their estimated position. Streams without a known length, like generators
+	// and microphones, don't support seeking and would stop being drained, so they are always kept real.
+	playback_node->voice_virtualizable.set_to(p_enabled && p_stream_length > 0);
+}
+
+uint32_t AudioServer::get_virtual_voice_count() const {
+	return virtual_voice_count.get();
+}
+
 bool AudioServer::is_playback_active(Ref<AudioStreamPlayback> p_playback) {
 	ERR_FAIL_COND_V(p_playback.is_null(), false);
 
@@ -1326,6 +1705,9 @@ float AudioServer::get_playback_position(Ref<AudioStreamPlayback> p_playback) {
 		return 0;
 	}
 
+	if (playback_node->voice_is_virtual.is_set()) {
+		return playback_node->voice_virtual_position.get();
+	}
 	return playback_node->stream_playback->get_playback_position();
 }
 
@@ -1355,6 +1737,7 @@ void AudioServer::init_channels_and_buffers() {
 	temp_buffer.resize(channel_count);
 	mix_buffer.resize(buffer_size + LOOKAHEAD_BUFFER_SIZE);
 	spatial_pull_buffer.resize(buffer_size);
+	spatial_source_buffer.resize(buffer_size);
 
 	for (int i = 0; i < temp_buffer.size(); i++) {
 		temp_buffer.write[i].resize(buffer_size);
@@ -1377,6 +1760,20 @@ void AudioServer::init() {
 
 	init_channels_and_buffers();
 
+	voice_max_count = MAX(0, int(GLOBAL_DEF_RST("audio/voices/max_voices", 0)));
+	ProjectSettings::get_singleton()->set_custom_property_info("audio/voices/max_voices", PropertyInfo(Variant::INT, "audio/voices/max_voices", PROPERTY_HINT_RANGE, "0,1024,1,or_greater"));
+	voice_virtualize_threshold_linear = Math::db2linear(float(GLOBAL_DEF_RST("audio/voices/virtualize_below_db", -80.0)));
+	ProjectSettings::get_singleton()->set_custom_property_info("audio/voices/virtualize_below_db", PropertyInfo(Variant::FLOAT, "audio/voices/virtualize_below_db", PROPERTY_HINT_RANGE, "-200,0,0.1"));
+
+	int thread_count = GLOBAL_DEF_RST("audio/buses/mix_thread_count", 0);
+	ProjectSettings::get_singleton()->set_custom_property_info("audio/buses/mix_thread_count", PropertyInfo(Variant::INT, "audio/buses/mix_thread_count", PROPERTY_HINT_RANGE, "-1,16,1"));
+	// The audio thread takes part in the work, so it counts as one of the threads.
+	uint32_t available_threads = (WorkerThreadPool::get_singleton() ? WorkerThreadPool::get_singleton()->get_thread_count(WorkerThreadPool::PRIORITY_HIGH) : 0) + 1;
+	mix_thread_count = thread_count < 0 ? available_threads : MIN((uint32_t)thread_count, available_threads);
+	if (mix_thread_count <= 1) {
+		mix_thread_count = 0;
+	}
+
 	mix_count = 0;
 	set_bus_count(1);
 	set_bus_name(0, "Master");
@@ -1476,6 +1873,15 @@ void AudioServer::update() {
 	}
 	bus_details_graveyard.maybe_cleanup();
 	bus_details_graveyard_frame_old.maybe_cleanup();
+	for (MixPlan *plan : mix_plan_graveyard_frame_old) {
+		mix_plan_graveyard_frame_old.erase(plan, [](MixPlan *p) { memdelete(p); });
+	}
+	for (MixPlan *plan : mix_plan_graveyard) {
+		mix_plan_graveyard_frame_old.insert(plan);
+		mix_plan_graveyard.erase(plan);
+	}
+	mix_plan_graveyard.maybe_cleanup();
+	mix_plan_graveyard_frame_old.maybe_cleanup();
 }
 
 void AudioServer::load_default_bus_layout() {
@@ -1499,6 +1905,17 @@ void AudioServer::finish() {
 	}
 
 	buses.clear();
+
+	MixPlan *plan = mix_plan.exchange(nullptr);
+	if (plan) {
+		memdelete(plan);
+	}
+	for (MixPlan *old_plan : mix_plan_graveyard) {
+		mix_plan_graveyard.erase(old_plan, [](MixPlan *p) { memdelete(p); });
+	}
+	for (MixPlan *old_plan : mix_plan_graveyard_frame_old) {
+		mix_plan_graveyard_frame_old.erase(old_plan, [](MixPlan *p) { memdelete(p); });
+	}
 }
 
 /* MISC config */
@@ -1632,6 +2049,7 @@ void AudioServer::set_bus_layout(const Ref<AudioBusLayout> &p_bus_layout) {
 		}
 		_update_bus_effects(i);
 	}
+	_update_mix_plan();
 #ifdef TOOLS_ENABLED
 	set_edited(false);
 #endif
@@ -1744,6 +2162,7 @@ void AudioServer::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_time_to_next_mix"), &AudioServer::get_time_to_next_mix);
 	ClassDB::bind_method(D_METHOD("get_time_since_last_mix"), &AudioServer::get_time_since_last_mix);
 	ClassDB::bind_method(D_METHOD("get_output_latency"), &AudioServer::get_output_latency);
+	ClassDB::bind_method(D_METHOD("get_virtual_voice_count"), &AudioServer::get_virtual_voice_count);
 
 	ClassDB::bind_method(D_METHOD("capture_get_device_list"), &AudioServer::capture_get_device_list);
 	ClassDB::bind_method(D_METHOD("capture_get_device"), &AudioServer::capture_get_device);
@@ -1779,6 +2198,7 @@ AudioServer::AudioServer() {
 	mix_time = 0;
 	mix_size = 0;
 	playback_speed_scale = 1;
+	mix_kernels = AudioMixKernels::get_singleton();
 }
 
 AudioServer::~AudioServer() {
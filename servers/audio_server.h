@@ -34,8 +34,11 @@
 #include "core/math/audio_frame.h"
 #include "core/object/class_db.h"
 #include "core/os/os.h"
+#include "core/templates/dense_hash_map.h"
+#include "core/templates/local_vector.h"
 #include "core/templates/safe_list.h"
 #include "core/templates/safe_refcount.h"
+#include "core/templates/worker_thread_pool.h"
 #include "core/variant/variant.h"
 
 #include "servers/audio/audio_effect.h"
@@ -45,6 +48,8 @@
 #include <atomic>
 
 class AudioDriverDummy;
+class AudioEffectCompressor;
+struct AudioMixKernels;
 class AudioStream;
 class AudioStreamSample;
 class AudioStreamPlayback;
@@ -191,14 +196,14 @@ private:
 
 	float playback_speed_scale;
 
+	const AudioMixKernels *mix_kernels = nullptr;
+
 	struct Bus {
 		StringName name;
 		bool solo;
 		bool mute;
 		bool bypass;
 
-		bool soloed;
-
 		//Each channel is a stereo pair.
 		struct Channel {
 			bool used;
@@ -229,12 +234,19 @@ private:
 		float volume_db;
 		StringName send;
 		int index_cache;
+
+		// Gain applied by the audio thread, already accounting for mute and solo.
+		// Volume, mute and solo changes only update it, so they never need a new mix plan.
+		SafeNumeric<float> volume_linear;
+		bool soloed = false; // Only used by _update_bus_volumes().
 	};
 	struct AudioStreamPlaybackBusDetails {
 		bool bus_active[MAX_BUSES_PER_PLAYBACK] = { false, false, false, false, false, false };
 		StringName bus[MAX_BUSES_PER_PLAYBACK];
 		AudioFrame volume[MAX_BUSES_PER_PLAYBACK][MAX_CHANNELS_PER_BUS];
 		AudioSourceId audio_source_id = AudioSourceId(-1);
+		// Unique per allocation, used by the audio thread to tell whether resolved bus indices are still valid.
+		uint64_t serial = 0;
 	};
 
 	struct AudioStreamPlaybackListNode {
@@ -262,10 +274,133 @@ private:
 		AudioStreamPlaybackBusDetails *prev_bus_details = nullptr;
 		// The next few samples are stored here so we have some time to fade audio out if it ends abruptly at the beginning of the next mix.
 		AudioFrame lookahead[LOOKAHEAD_BUFFER_SIZE];
+		// Bus indices resolved against the mix plan, so bus names are only looked up when the details or the plan change.
+		// These should only be accessed on the audio thread.
+		uint64_t bus_index_cache_serial = 0;
+		uint64_t bus_index_cache_version = 0;
+		int bus_index_cache[MAX_BUSES_PER_PLAYBACK] = { 0, 0, 0, 0, 0, 0 };
+		int prev_bus_index_cache[MAX_BUSES_PER_PLAYBACK] = { 0, 0, 0, 0, 0, 0 };
+
+		enum VoiceState {
+			VOICE_REAL, // Decoded and mixed.
+			VOICE_FADING_TO_VIRTUAL, // Mixed one last time while fading out to silence.
+			VOICE_VIRTUAL, // Neither decoded nor mixed, only the playback position advances.
+		};
+		// Only playbacks with virtualization enabled and a known stream length count against the voice budget and can be virtualized.
+		SafeFlag voice_virtualizable;
+		SafeNumeric<float> voice_priority;
+		SafeNumeric<float> voice_stream_length; // Zero if unknown.
+		// Lets the main thread report the estimated position of a virtual voice.
+		SafeFlag voice_is_virtual;
+		SafeNumeric<float> voice_virtual_position;
+		// These should only be accessed on the audio thread.
+		VoiceState voice_state = VOICE_REAL;
+		bool voice_wants_virtual = false;
+	};
+
+	// Immutable, index-based snapshot of the bus layout consumed by the audio thread.
+	// It is compiled on the main thread whenever the layout changes and atomically swapped in,
+	// so the mix step never needs to resolve sends, solo chains or project settings by itself.
+	struct MixPlan {
+		struct BusPlan {
+			Bus *bus = nullptr;
+			int send_index = -1; // Already validated, -1 for the master bus.
+			LocalVector<int> senders; // Buses sending to this one, in descending index order.
+			LocalVector<int> effects; // Enabled effect indices, empty when bypassing.
+		};
+
+		uint64_t version = 0;
+		LocalVector<BusPlan> buses;
+		// Buses grouped so that every bus only sends to buses of a later level, and in descending index order within a level.
+		// Buses within the same level are independent and can be processed in parallel.
+		LocalVector<LocalVector<int>> bus_levels;
+		// Enabled compressors. Their sidechain can be changed at any time, so it's checked on every mix step.
+		LocalVector<const AudioEffectCompressor *> compressors;
+		DenseHashMap<StringName, int> bus_indices;
+		bool enable_resonance_audio = false;
+		float channel_disable_threshold_linear = 0.0;
+
+		_FORCE_INLINE_ int find_bus_index(const StringName &p_name) const {
+			const int *idx = bus_indices.getptr(p_name);
+			return idx ? *idx : 0;
+		}
+	};
+
+	std::atomic<MixPlan *> mix_plan = nullptr;
+	uint64_t mix_plan_version = 0;
+	SafeList<MixPlan *> mix_plan_graveyard;
+	SafeList<MixPlan *> mix_plan_graveyard_frame_old;
+
+	// Should only be called on the main thread. Changes that free buses must call it with the driver locked.
+	// Only needed when buses, sends or effects change.
+	void _update_mix_plan();
+	// Should only be called on the main thread, after the mix plan is up to date.
+	void _update_bus_volumes();
+
+	// Playbacks are split into chunks mixed into per-chunk bus buffers, which are then added to the buses in chunk order.
+	// The chunks only depend on the amount of playbacks, so the output is the same whether they are mixed in parallel
+	// ("audio/buses/mix_thread_count" is not zero) or one after the other on the audio thread.
+	enum {
+		MIN_PLAYBACKS_PER_MIX_CHUNK = 8,
+		MAX_MIX_CHUNKS = 16,
 	};
 
+	struct MixChunk {
+		uint32_t from = 0;
+		uint32_t to = 0;
+		Vector<AudioFrame> mix_buffer;
+		LocalVector<Vector<AudioFrame>> bus_buffers; // Indexed by bus * channel_count + channel.
+		LocalVector<bool> bus_buffer_used;
+	};
+
+	struct MixLevelWork {
+		const MixPlan *plan = nullptr;
+		const LocalVector<int> *buses = nullptr;
+	};
+
+	uint32_t mix_thread_count = 0; // Threads taking part in mixing, the audio thread included. Mix jobs run with high priority on the worker pool.
+	LocalVector<MixChunk> mix_chunks;
+	LocalVector<AudioStreamPlaybackListNode *> mix_chunk_playbacks;
+	LocalVector<Vector<AudioFrame>> mix_bus_temp_buffers; // Per bus effect swap buffers, indexed by bus * channel_count + channel.
+
+	void _mix_chunk_work(uint32_t p_index, const MixPlan *p_plan);
+	void _mix_level_work(uint32_t p_index, MixLevelWork *p_work);
+	void _ensure_mix_chunks(const MixPlan *p_plan, uint32_t p_chunk_count);
+	void _ensure_mix_bus_temp_buffers(const MixPlan *p_plan);
+	// A sidechain reads another bus from within an effect chain, so buses must then be processed serially.
+	bool _mix_plan_uses_sidechain(const MixPlan *p_plan) const;
+	// Adds the chunk's bus buffers to the buses, and marks them unused.
+	void _reduce_mix_chunk(MixChunk &p_chunk);
+
+	// Voice virtualization. Once per mix step, virtualizable playbacks that are inaudible, or that don't fit in the voice budget,
+	// stop being decoded and mixed. They fade out over one mix step, and fade back in from their estimated position when promoted.
+	struct VoiceCandidate {
+		AudioStreamPlaybackListNode *playback = nullptr;
+		float priority = 0.0;
+		float audibility = 0.0;
+	};
+
+	struct VoiceCandidateSort {
+		_FORCE_INLINE_ bool operator()(const VoiceCandidate &p_a, const VoiceCandidate &p_b) const {
+			if (p_a.priority != p_b.priority) {
+				return p_a.priority > p_b.priority;
+			}
+			return p_a.audibility > p_b.audibility;
+		}
+	};
+
+	int voice_max_count = 0; // Zero means no budget.
+	float voice_virtualize_threshold_linear = 0.0;
+	LocalVector<VoiceCandidate> voice_candidates;
+	SafeNumeric<uint32_t> virtual_voice_count;
+
+	void _update_voices();
+	// Returns true if the voice is still virtual and must not be mixed.
+	bool _mix_step_virtual_voice(AudioStreamPlaybackListNode *p_playback);
+
 	SafeList<AudioStreamPlaybackListNode *> playback_list;
 	SafeList<AudioStreamPlaybackBusDetails *> bus_details_graveyard;
+	SafeNumeric<uint64_t> bus_details_serial;
 
 	// TODO document if this is necessary.
 	SafeList<AudioStreamPlaybackBusDetails *> bus_details_graveyard_frame_old;
@@ -273,8 +408,9 @@ private:
 	Vector<Vector<AudioFrame>> temp_buffer; //temp_buffer for each level
 	Vector<AudioFrame> mix_buffer;
 	Vector<AudioFrame> spatial_pull_buffer;
+	Vector<AudioFrame> spatial_source_buffer; // Dry buffer of the spatial voice being pushed, spatial voices are always mixed on the audio thread.
 	Vector<Bus *> buses;
-	Map<StringName, Bus *> bus_map;
+	DenseHashMap<StringName, Bus *> bus_map;
 
 	void _update_bus_effects(int p_bus);
 
@@ -282,8 +418,15 @@ private:
 
 	void init_channels_and_buffers();
 
-	void _mix_step();
-	void _mix_step_for_channel(AudioFrame *p_out_buf, AudioFrame *p_source_buf, AudioFrame p_vol_start, AudioFrame p_vol_final, float p_attenuation_filter_cutoff_hz, float p_highshelf_gain, AudioSourceId p_audio_source_id, AudioFilterSW::Processor *p_processor_l, AudioFilterSW::Processor *p_processor_r);
+	void _mix_step(const MixPlan *p_plan);
+	void _mix_step_playback(const MixPlan *p_plan, AudioStreamPlaybackListNode *p_playback, AudioFrame *p_mix_buffer, MixChunk *p_chunk);
+	void _mix_step_playback_finish(AudioStreamPlaybackListNode *p_playback);
+	void _mix_step_spatial_voice(const MixPlan *p_plan, AudioStreamPlaybackListNode *p_playback, AudioFrame *p_source_buf, const AudioStreamPlaybackBusDetails *p_bus_details, const AudioStreamPlaybackBusDetails *p_prev_bus_details, bool p_fading_out);
+	void _mix_step_spatial_listener();
+	void _mix_step_bus(const MixPlan *p_plan, int p_bus, Vector<AudioFrame> *p_temp_buffers);
+	void _mix_step_bus_send(const MixPlan *p_plan, int p_bus);
+	_FORCE_INLINE_ AudioFrame *_get_playback_target_buffer(MixChunk *p_chunk, int p_bus, int p_channel);
+	void _mix_step_for_channel(const MixPlan *p_plan, AudioFrame *p_out_buf, AudioFrame *p_source_buf, AudioFrame p_vol_start, AudioFrame p_vol_final, float p_attenuation_filter_cutoff_hz, float p_highshelf_gain, AudioFilterSW::Processor *p_processor_l, AudioFilterSW::Processor *p_processor_r);
 
 	// Should only be called on the main thread.
 	AudioStreamPlaybackListNode *_find_playback_list_node(Ref<AudioStreamPlayback> p_playback);
@@ -387,6 +530,9 @@ public:
 	void set_playback_pitch_scale(Ref<AudioStreamPlayback> p_playback, float p_pitch_scale);
 	void set_playback_paused(Ref<AudioStreamPlayback> p_playback, bool p_paused);
 
+	void set_playback_virtualization(Ref<AudioStreamPlayback> p_playback, bool p_enabled, float p_priority = 0, float p_stream_length = 0);
+	uint32_t get_virtual_voice_count() const;
+
 	void set_playback_highshelf_params(Ref<AudioStreamPlayback> p_playback, float p_gain, float p_attenuation_cutoff_hz, AudioSourceId p_source_id);
 
 	bool is_playback_active(Ref<AudioStreamPlayback> p_playback);
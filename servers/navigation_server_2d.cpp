@@ -167,6 +167,7 @@ void NavigationServer2D::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("map_set_edge_connection_margin", "map", "margin"), &NavigationServer2D::map_set_edge_connection_margin);
 	ClassDB::bind_method(D_METHOD("map_get_edge_connection_margin", "map"), &NavigationServer2D::map_get_edge_connection_margin);
 	ClassDB::bind_method(D_METHOD("map_get_path", "map", "origin", "destination", "optimize", "layers"), &NavigationServer2D::map_get_path, DEFVAL(1));
+	ClassDB::bind_method(D_METHOD("map_get_paths", "map", "origins", "destinations", "optimize", "layers"), &NavigationServer2D::_map_get_paths, DEFVAL(1));
 	ClassDB::bind_method(D_METHOD("map_get_closest_point", "map", "to_point"), &NavigationServer2D::map_get_closest_point);
 	ClassDB::bind_method(D_METHOD("map_get_closest_point_owner", "map", "to_point"), &NavigationServer2D::map_get_closest_point_owner);
 
@@ -222,6 +223,37 @@ real_t FORWARD_1_C(map_get_edge_connection_margin, RID, p_map, rid_to_rid);
 
 Vector<Vector2> FORWARD_5_R_C(vector_v3_to_v2, map_get_path, RID, p_map, Vector2, p_origin, Vector2, p_destination, bool, p_optimize, uint32_t, p_layers, rid_to_rid, v2_to_v3, v2_to_v3, bool_to_bool, uint32_to_uint32);
 
+Vector<Vector<Vector2>> NavigationServer2D::map_get_paths(RID p_map, const Vector<Vector2> &p_origins, const Vector<Vector2> &p_destinations, bool p_optimize, uint32_t p_layers) const {
+	Vector<Vector3> origins;
+	origins.resize(p_origins.size());
+	for (int i = 0; i < p_origins.size(); i++) {
+		origins.write[i] = v2_to_v3(p_origins[i]);
+	}
+	Vector<Vector3> destinations;
+	destinations.resize(p_destinations.size());
+	for (int i = 0; i < p_destinations.size(); i++) {
+		destinations.write[i] = v2_to_v3(p_destinations[i]);
+	}
+
+	const Vector<Vector<Vector3>> paths = NavigationServer3D::get_singleton()->map_get_paths(p_map, origins, destinations, p_optimize, p_layers);
+	Vector<Vector<Vector2>> ret;
+	ret.resize(paths.size());
+	for (int i = 0; i < paths.size(); i++) {
+		ret.write[i] = vector_v3_to_v2(paths[i]);
+	}
+	return ret;
+}
+
+Array NavigationServer2D::_map_get_paths(RID p_map, const Vector<Vector2> &p_origins, const Vector<Vector2> &p_destinations, bool p_optimize, uint32_t p_layers) const {
+	const Vector<Vector<Vector2>> paths = map_get_paths(p_map, p_origins, p_destinations, p_optimize, p_layers);
+	Array ret;
+	ret.resize(paths.size());
+	for (int i = 0; i < paths.size(); i++) {
+		ret[i] = paths[i];
+	}
+	return ret;
+}
+
 Vector2 FORWARD_2_R_C(v3_to_v2, map_get_closest_point, RID, p_map, const Vector2 &, p_point, rid_to_rid, v2_to_v3);
 RID FORWARD_2_C(map_get_closest_point_owner, RID, p_map, const Vector2 &, p_point, rid_to_rid, v2_to_v3);
 
@@ -46,6 +46,8 @@ class NavigationServer2D : public Object {
 protected:
 	static void _bind_methods();
 
+	Array _map_get_paths(RID p_map, const Vector<Vector2> &p_origins, const Vector<Vector2> &p_destinations, bool p_optimize, uint32_t p_layers) const;
+
 public:
 	/// Thread safe, can be used across many threads.
 	static const NavigationServer2D *get_singleton() { return singleton; }
@@ -77,6 +79,9 @@ public:
 	/// Returns the navigation path to reach the destination from the origin.
 	virtual Vector<Vector2> map_get_path(RID p_map, Vector2 p_origin, Vector2 p_destination, bool p_optimize, uint32_t p_layers = 1) const;
 
+	/// Returns the navigation paths between each origin and destination pair, the queries run in parallel.
+	virtual Vector<Vector<Vector2>> map_get_paths(RID p_map, const Vector<Vector2> &p_origins, const Vector<Vector2> &p_destinations, bool p_optimize, uint32_t p_layers = 1) const;
+
 	virtual Vector2 map_get_closest_point(RID p_map, const Vector2 &p_point) const;
 	virtual RID map_get_closest_point_owner(RID p_map, const Vector2 &p_point) const;
 
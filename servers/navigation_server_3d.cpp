@@ -32,6 +32,16 @@
 
 NavigationServer3D *NavigationServer3D::singleton = nullptr;
 
+Array NavigationServer3D::_map_get_paths(RID p_map, const Vector<Vector3> &p_origins, const Vector<Vector3> &p_destinations, bool p_optimize, uint32_t p_navigable_layers) const {
+	const Vector<Vector<Vector3>> paths = map_get_paths(p_map, p_origins, p_destinations, p_optimize, p_navigable_layers);
+	Array ret;
+	ret.resize(paths.size());
+	for (int i = 0; i < paths.size(); i++) {
+		ret[i] = paths[i];
+	}
+	return ret;
+}
+
 void NavigationServer3D::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("map_create"), &NavigationServer3D::map_create);
 	ClassDB::bind_method(D_METHOD("map_set_active", "map", "active"), &NavigationServer3D::map_set_active);
@@ -43,6 +53,7 @@ void NavigationServer3D::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("map_set_edge_connection_margin", "map", "margin"), &NavigationServer3D::map_set_edge_connection_margin);
 	ClassDB::bind_method(D_METHOD("map_get_edge_connection_margin", "map"), &NavigationServer3D::map_get_edge_connection_margin);
 	ClassDB::bind_method(D_METHOD("map_get_path", "map", "origin", "destination", "optimize", "layers"), &NavigationServer3D::map_get_path, DEFVAL(1));
+	ClassDB::bind_method(D_METHOD("map_get_paths", "map", "origins", "destinations", "optimize", "layers"), &NavigationServer3D::_map_get_paths, DEFVAL(1));
 	ClassDB::bind_method(D_METHOD("map_get_closest_point_to_segment", "map", "start", "end", "use_collision"), &NavigationServer3D::map_get_closest_point_to_segment, DEFVAL(false));
 	ClassDB::bind_method(D_METHOD("map_get_closest_point", "map", "to_point"), &NavigationServer3D::map_get_closest_point);
 	ClassDB::bind_method(D_METHOD("map_get_closest_point_normal", "map", "to_point"), &NavigationServer3D::map_get_closest_point_normal);
@@ -49,6 +49,8 @@ class NavigationServer3D : public Object {
 protected:
 	static void _bind_methods();
 
+	Array _map_get_paths(RID p_map, const Vector<Vector3> &p_origins, const Vector<Vector3> &p_destinations, bool p_optimize, uint32_t p_navigable_layers) const;
+
 public:
 	/// Thread safe, can be used across many threads.
 	static const NavigationServer3D *get_singleton();
@@ -86,6 +88,9 @@ public:
 	/// Returns the navigation path to reach the destination from the origin.
 	virtual Vector<Vector3> map_get_path(RID p_map, Vector3 p_origin, Vector3 p_destination, bool p_optimize, uint32_t p_navigable_layers = 1) const = 0;
 
+	/// Returns the navigation paths between each origin and destination pair, the queries run in parallel.
+	virtual Vector<Vector<Vector3>> map_get_paths(RID p_map, const Vector<Vector3> &p_origins, const Vector<Vector3> &p_destinations, bool p_optimize, uint32_t p_navigable_layers = 1) const = 0;
+
 	virtual Vector3 map_get_closest_point_to_segment(RID p_map, const Vector3 &p_from, const Vector3 &p_to, const bool p_use_collision = false) const = 0;
 	virtual Vector3 map_get_closest_point(RID p_map, const Vector3 &p_point) const = 0;
 	virtual Vector3 map_get_closest_point_normal(RID p_map, const Vector3 &p_point) const = 0;
@@ -38,14 +38,23 @@
 
 static const int z_range = RS::CANVAS_ITEM_Z_MAX - RS::CANVAS_ITEM_Z_MIN + 1;
 
-void RendererCanvasCull::_render_canvas_item_tree(RID p_to_render_target, Canvas::ChildItem *p_child_items, int p_child_item_count, Item *p_canvas_item, const Transform2D &p_transform, const Rect2 &p_clip_rect, const Color &p_modulate, RendererCanvasRender::Light *p_lights, RendererCanvasRender::Light *p_directional_lights, RenderingServer::CanvasItemTextureFilter p_default_filter, RenderingServer::CanvasItemTextureRepeat p_default_repeat, bool p_snap_2d_vertices_to_pixel) {
+void RendererCanvasCull::_render_canvas_item_tree(RID p_to_render_target, Canvas::ChildItem *p_child_items, int p_child_item_count, ChildIndex *p_child_index, Item *p_canvas_item, const Transform2D &p_transform, const Rect2 &p_clip_rect, const Color &p_modulate, RendererCanvasRender::Light *p_lights, RendererCanvasRender::Light *p_directional_lights, RenderingServer::CanvasItemTextureFilter p_default_filter, RenderingServer::CanvasItemTextureRepeat p_default_repeat, bool p_snap_2d_vertices_to_pixel) {
 	RENDER_TIMESTAMP("Cull CanvasItem Tree");
 
 	memset(z_list, 0, z_range * sizeof(RendererCanvasRender::Item *));
 	memset(z_last_list, 0, z_range * sizeof(RendererCanvasRender::Item *));
 
-	for (int i = 0; i < p_child_item_count; i++) {
-		_cull_canvas_item(p_child_items[i].item, p_transform, p_clip_rect, Color(1, 1, 1, 1), 0, z_list, z_last_list, nullptr, nullptr, true);
+	if (p_child_index && p_transform.basis_determinant() != 0) {
+		int child_item_count = 0;
+		Item **child_items = _cull_child_index(p_child_index, p_transform, p_clip_rect, child_item_count);
+		for (int i = 0; i < child_item_count; i++) {
+			_cull_canvas_item(child_items[i], p_transform, p_clip_rect, Color(1, 1, 1, 1), 0, z_list, z_last_list, nullptr, nullptr, true);
+		}
+		cull_children_depth--;
+	} else {
+		for (int i = 0; i < p_child_item_count; i++) {
+			_cull_canvas_item(p_child_items[i].item, p_transform, p_clip_rect, Color(1, 1, 1, 1), 0, z_list, z_last_list, nullptr, nullptr, true);
+		}
 	}
 	if (p_canvas_item) {
 		_cull_canvas_item(p_canvas_item, p_transform, p_clip_rect, Color(1, 1, 1, 1), 0, z_list, z_last_list, nullptr, nullptr, true);
@@ -105,6 +114,234 @@ void _mark_ysort_dirty(RendererCanvasCull::Item *ysort_owner, RID_Owner<Renderer
 	} while (ysort_owner && ysort_owner->sort_y);
 }
 
+static _FORCE_INLINE_ AABB _rect_to_aabb(const Rect2 &p_rect) {
+	return AABB(Vector3(p_rect.position.x, p_rect.position.y, 0), Vector3(p_rect.size.x, p_rect.size.y, 0));
+}
+
+struct _ChildIndexCollect {
+	LocalVector<RendererCanvasCull::Item *> *items = nullptr;
+
+	_FORCE_INLINE_ bool operator()(void *p_data) {
+		items->push_back(static_cast<RendererCanvasCull::Item *>(p_data));
+		return false;
+	}
+};
+
+void RendererCanvasCull::_item_queue_update(Item *p_item) {
+	if (!p_item->update_item.in_list()) {
+		item_update_list.add_last(&p_item->update_item);
+	}
+}
+
+void RendererCanvasCull::_update_dirty_items() {
+	// Parents are queued again by their children, so they are processed after them.
+	while (item_update_list.first()) {
+		Item *item = item_update_list.first()->self();
+		item_update_list.remove(item_update_list.first());
+		_item_update_subtree(item);
+	}
+}
+
+void RendererCanvasCull::_item_update_subtree(Item *p_item) {
+	Item *ci = p_item;
+
+	Rect2 rect;
+	bool has_rect = false;
+	bool bounded = true;
+
+	if (ci->visible) {
+		bounded = !ci->update_when_visible && !ci->copy_back_buffer && !ci->vp_render && !ci->canvas_group;
+
+		// The rect of these commands depends on resources that can change without the item knowing.
+		for (const Item::Command *c = ci->commands; c && bounded; c = c->next) {
+			if (c->type == Item::Command::TYPE_MESH || c->type == Item::Command::TYPE_MULTIMESH || c->type == Item::Command::TYPE_PARTICLES) {
+				bounded = false;
+			}
+		}
+
+		if (bounded && (ci->commands != nullptr || ci->visibility_notifier)) {
+			rect = ci->get_rect();
+			if (ci->visibility_notifier && ci->visibility_notifier->area.size != Vector2()) {
+				rect = rect.merge(ci->visibility_notifier->area);
+			}
+			has_rect = true;
+		}
+
+		if (ci->child_index) {
+			if (!ci->child_index->unbounded_children.is_empty()) {
+				bounded = false;
+			}
+			if (bounded && !ci->child_index->bvh.is_empty()) {
+				AABB aabb = ci->child_index->bvh.get_aabb();
+				Rect2 children_rect(aabb.position.x, aabb.position.y, aabb.size.x, aabb.size.y);
+				rect = has_rect ? rect.merge(children_rect) : children_rect;
+				has_rect = true;
+			}
+		} else {
+			for (int i = 0; i < ci->child_items.size() && bounded; i++) {
+				const Item *child = ci->child_items[i];
+				if (!child->visible) {
+					continue;
+				}
+				if (!child->subtree_bounded) {
+					bounded = false;
+				} else if (child->subtree_has_rect) {
+					rect = has_rect ? rect.merge(child->parent_rect) : child->parent_rect;
+					has_rect = true;
+				}
+			}
+		}
+	}
+
+	if (!bounded) {
+		rect = Rect2();
+		has_rect = false;
+	}
+
+	// Grow by a pixel to account for the origin being floored when snapping transforms to pixels.
+	Rect2 parent_rect = has_rect ? ci->xform.xform(rect).grow(1.0) : Rect2();
+
+	if (bounded == ci->subtree_bounded && has_rect == ci->subtree_has_rect && rect == ci->subtree_rect && parent_rect == ci->parent_rect) {
+		return;
+	}
+
+	ci->subtree_rect = rect;
+	ci->subtree_has_rect = has_rect;
+	ci->subtree_bounded = bounded;
+	ci->parent_rect = parent_rect;
+
+	_item_attach_to_parent_index(ci);
+}
+
+void RendererCanvasCull::_item_attach_to_parent_index(Item *p_item) {
+	if (canvas_item_owner.owns(p_item->parent)) {
+		Item *item_owner = canvas_item_owner.get_or_null(p_item->parent);
+		if (!item_owner->child_index && item_owner->child_items.size() >= CHILD_INDEX_MIN_CHILDREN) {
+			item_owner->child_index = memnew(ChildIndex);
+			for (int i = 0; i < item_owner->child_items.size(); i++) {
+				_child_index_update(item_owner->child_index, item_owner->child_items[i]);
+			}
+		} else if (item_owner->child_index) {
+			_child_index_update(item_owner->child_index, p_item);
+		}
+		_item_queue_update(item_owner);
+
+	} else if (canvas_owner.owns(p_item->parent)) {
+		Canvas *canvas = canvas_owner.get_or_null(p_item->parent);
+		if (!canvas->child_index && canvas->child_items.size() >= CHILD_INDEX_MIN_CHILDREN) {
+			canvas->child_index = memnew(ChildIndex);
+			for (int i = 0; i < canvas->child_items.size(); i++) {
+				_child_index_update(canvas->child_index, canvas->child_items[i].item);
+			}
+		} else if (canvas->child_index) {
+			_child_index_update(canvas->child_index, p_item);
+		}
+	}
+}
+
+void RendererCanvasCull::_item_detach_from_parent(Item *p_item) {
+	if (canvas_owner.owns(p_item->parent)) {
+		Canvas *canvas = canvas_owner.get_or_null(p_item->parent);
+		canvas->erase_item(p_item);
+		if (canvas->child_index) {
+			_child_index_remove(canvas->child_index, p_item);
+			if (canvas->child_items.size() < CHILD_INDEX_MIN_CHILDREN / 2) {
+				_free_child_index(canvas->child_index);
+			}
+		}
+	} else if (canvas_item_owner.owns(p_item->parent)) {
+		Item *item_owner = canvas_item_owner.get_or_null(p_item->parent);
+		item_owner->child_items.erase(p_item);
+		if (item_owner->child_index) {
+			_child_index_remove(item_owner->child_index, p_item);
+			if (item_owner->child_items.size() < CHILD_INDEX_MIN_CHILDREN / 2) {
+				_free_child_index(item_owner->child_index);
+			}
+		}
+		_item_queue_update(item_owner);
+
+		if (item_owner->sort_y) {
+			_mark_ysort_dirty(item_owner, canvas_item_owner);
+		}
+	}
+}
+
+void RendererCanvasCull::_child_index_update(ChildIndex *p_index, Item *p_child) {
+	if (p_child->visible && p_child->subtree_bounded && p_child->subtree_has_rect) {
+		if (p_child->child_index_id.is_valid()) {
+			p_index->bvh.update(p_child->child_index_id, _rect_to_aabb(p_child->parent_rect));
+		} else {
+			p_child->child_index_id = p_index->bvh.insert(_rect_to_aabb(p_child->parent_rect), p_child);
+		}
+	} else if (p_child->child_index_id.is_valid()) {
+		p_index->bvh.remove(p_child->child_index_id);
+		p_child->child_index_id = DynamicBVH::ID();
+	}
+
+	bool unbounded = p_child->visible && !p_child->subtree_bounded;
+	if (unbounded != p_child->in_unbounded_children) {
+		if (unbounded) {
+			p_index->unbounded_children.push_back(p_child);
+		} else {
+			p_index->unbounded_children.erase(p_child);
+		}
+		p_child->in_unbounded_children = unbounded;
+	}
+}
+
+void RendererCanvasCull::_child_index_remove(ChildIndex *p_index, Item *p_child) {
+	if (p_child->child_index_id.is_valid()) {
+		p_index->bvh.remove(p_child->child_index_id);
+		p_child->child_index_id = DynamicBVH::ID();
+	}
+	if (p_child->in_unbounded_children) {
+		p_index->unbounded_children.erase(p_child);
+		p_child->in_unbounded_children = false;
+	}
+}
+
+void RendererCanvasCull::_free_child_index(ChildIndex *&r_index) {
+	LocalVector<Item *> children;
+	_ChildIndexCollect collect;
+	collect.items = &children;
+	r_index->bvh.aabb_query(r_index->bvh.get_aabb(), collect);
+
+	for (uint32_t i = 0; i < children.size(); i++) {
+		children[i]->child_index_id = DynamicBVH::ID();
+	}
+	for (uint32_t i = 0; i < r_index->unbounded_children.size(); i++) {
+		r_index->unbounded_children[i]->in_unbounded_children = false;
+	}
+
+	memdelete(r_index);
+	r_index = nullptr;
+}
+
+RendererCanvasCull::Item **RendererCanvasCull::_cull_child_index(ChildIndex *p_index, const Transform2D &p_xform, const Rect2 &p_clip_rect, int &r_count) {
+	// Every recursion level that uses an index gets its own list, so the pointer returned stays valid while the children are culled.
+	if (cull_children_depth == cull_children.size()) {
+		cull_children.push_back(LocalVector<Item *>());
+	}
+	LocalVector<Item *> &children = cull_children[cull_children_depth++];
+	children.clear();
+
+	// Items are tested against the clip rect after subtracting its position, see _cull_canvas_item().
+	Rect2 local_clip_rect = p_xform.affine_inverse().xform(Rect2(Vector2(), p_clip_rect.size));
+
+	_ChildIndexCollect collect;
+	collect.items = &children;
+	p_index->bvh.aabb_query(_rect_to_aabb(local_clip_rect), collect);
+	for (uint32_t i = 0; i < p_index->unbounded_children.size(); i++) {
+		children.push_back(p_index->unbounded_children[i]);
+	}
+
+	SortArray<Item *, ItemSlotSort> sorter;
+	sorter.sort(children.ptr(), children.size());
+
+	r_count = children.size();
+	return children.ptr();
+}
+
 void RendererCanvasCull::_attach_canvas_item_for_draw(RendererCanvasCull::Item *ci, RendererCanvasCull::Item *p_canvas_clip, RendererCanvasRender::Item **z_list, RendererCanvasRender::Item **z_last_list, const Transform2D &xform, const Rect2 &p_clip_rect, Rect2 global_rect, const Color &modulate, int p_z, RendererCanvasCull::Item *p_material_owner, bool use_canvas_group, RendererCanvasRender::Item *canvas_group_from, const Transform2D &p_xform) {
 	if (ci->copy_back_buffer) {
 		ci->copy_back_buffer->screen_rect = xform.xform(ci->copy_back_buffer->rect).intersection(p_clip_rect);
@@ -223,6 +460,9 @@ void RendererCanvasCull::_cull_canvas_item(Item *p_canvas_item, const Transform2
 
 	if (ci->children_order_dirty) {
 		ci->child_items.sort_custom<ItemIndexSort>();
+		for (int i = 0; i < ci->child_items.size(); i++) {
+			ci->child_items[i]->child_slot = i;
+		}
 		ci->children_order_dirty = false;
 	}
 
@@ -240,6 +480,13 @@ void RendererCanvasCull::_cull_canvas_item(Item *p_canvas_item, const Transform2
 	}
 	xform = p_transform * xform;
 
+	if (ci->subtree_bounded) {
+		// Nothing in this subtree can intersect the clip rect, skip it entirely.
+		if (!ci->subtree_has_rect || !Rect2(Vector2(), p_clip_rect.size).intersects(xform.xform(ci->subtree_rect), true)) {
+			return;
+		}
+	}
+
 	Rect2 global_rect = xform.xform(rect);
 	global_rect.position += p_clip_rect.position;
 
@@ -322,6 +569,11 @@ void RendererCanvasCull::_cull_canvas_item(Item *p_canvas_item, const Transform2
 			canvas_group_from = z_last_list[zidx];
 		}
 
+		bool use_child_index = ci->child_index != nullptr && xform.basis_determinant() != 0;
+		if (use_child_index) {
+			child_items = _cull_child_index(ci->child_index, xform, p_clip_rect, child_item_count);
+		}
+
 		for (int i = 0; i < child_item_count; i++) {
 			if (!child_items[i]->behind && !use_canvas_group) {
 				continue;
@@ -335,6 +587,10 @@ void RendererCanvasCull::_cull_canvas_item(Item *p_canvas_item, const Transform2
 			}
 			_cull_canvas_item(child_items[i], xform, p_clip_rect, modulate, p_z, z_list, z_last_list, (Item *)ci->final_clip_owner, p_material_owner, true);
 		}
+
+		if (use_child_index) {
+			cull_children_depth--;
+		}
 	}
 }
 
@@ -344,8 +600,13 @@ void RendererCanvasCull::render_canvas(RID p_render_target, Canvas *p_canvas, co
 	sdf_used = false;
 	snapping_2d_transforms_to_pixel = p_snap_2d_transforms_to_pixel;
 
+	_update_dirty_items();
+
 	if (p_canvas->children_order_dirty) {
 		p_canvas->child_items.sort();
+		for (int i = 0; i < p_canvas->child_items.size(); i++) {
+			p_canvas->child_items[i].item->child_slot = i;
+		}
 		p_canvas->children_order_dirty = false;
 	}
 
@@ -361,26 +622,26 @@ void RendererCanvasCull::render_canvas(RID p_render_target, Canvas *p_canvas, co
 	}
 
 	if (!has_mirror) {
-		_render_canvas_item_tree(p_render_target, ci, l, nullptr, p_transform, p_clip_rect, p_canvas->modulate, p_lights, p_directional_lights, p_default_filter, p_default_repeat, p_snap_2d_vertices_to_pixel);
+		_render_canvas_item_tree(p_render_target, ci, l, p_canvas->child_index, nullptr, p_transform, p_clip_rect, p_canvas->modulate, p_lights, p_directional_lights, p_default_filter, p_default_repeat, p_snap_2d_vertices_to_pixel);
 
 	} else {
 		//used for parallaxlayer mirroring
 		for (int i = 0; i < l; i++) {
 			const Canvas::ChildItem &ci2 = p_canvas->child_items[i];
-			_render_canvas_item_tree(p_render_target, nullptr, 0, ci2.item, p_transform, p_clip_rect, p_canvas->modulate, p_lights, p_directional_lights, p_default_filter, p_default_repeat, p_snap_2d_vertices_to_pixel);
+			_render_canvas_item_tree(p_render_target, nullptr, 0, nullptr, ci2.item, p_transform, p_clip_rect, p_canvas->modulate, p_lights, p_directional_lights, p_default_filter, p_default_repeat, p_snap_2d_vertices_to_pixel);
 
 			//mirroring (useful for scrolling backgrounds)
 			if (ci2.mirror.x != 0) {
 				Transform2D xform2 = p_transform * Transform2D(0, Vector2(ci2.mirror.x, 0));
-				_render_canvas_item_tree(p_render_target, nullptr, 0, ci2.item, xform2, p_clip_rect, p_canvas->modulate, p_lights, p_directional_lights, p_default_filter, p_default_repeat, p_snap_2d_vertices_to_pixel);
+				_render_canvas_item_tree(p_render_target, nullptr, 0, nullptr, ci2.item, xform2, p_clip_rect, p_canvas->modulate, p_lights, p_directional_lights, p_default_filter, p_default_repeat, p_snap_2d_vertices_to_pixel);
 			}
 			if (ci2.mirror.y != 0) {
 				Transform2D xform2 = p_transform * Transform2D(0, Vector2(0, ci2.mirror.y));
-				_render_canvas_item_tree(p_render_target, nullptr, 0, ci2.item, xform2, p_clip_rect, p_canvas->modulate, p_lights, p_directional_lights, p_default_filter, p_default_repeat, p_snap_2d_vertices_to_pixel);
+				_render_canvas_item_tree(p_render_target, nullptr, 0, nullptr, ci2.item, xform2, p_clip_rect, p_canvas->modulate, p_lights, p_directional_lights, p_default_filter, p_default_repeat, p_snap_2d_vertices_to_pixel);
 			}
 			if (ci2.mirror.y != 0 && ci2.mirror.x != 0) {
 				Transform2D xform2 = p_transform * Transform2D(0, ci2.mirror);
-				_render_canvas_item_tree(p_render_target, nullptr, 0, ci2.item, xform2, p_clip_rect, p_canvas->modulate, p_lights, p_directional_lights, p_default_filter, p_default_repeat, p_snap_2d_vertices_to_pixel);
+				_render_canvas_item_tree(p_render_target, nullptr, 0, nullptr, ci2.item, xform2, p_clip_rect, p_canvas->modulate, p_lights, p_directional_lights, p_default_filter, p_default_repeat, p_snap_2d_vertices_to_pixel);
 			}
 		}
 	}
@@ -433,6 +694,7 @@ RID RendererCanvasCull::canvas_item_allocate() {
 }
 void RendererCanvasCull::canvas_item_initialize(RID p_rid) {
 	canvas_item_owner.initialize_rid(p_rid);
+	_item_queue_update(canvas_item_owner.get_or_null(p_rid));
 }
 
 void RendererCanvasCull::canvas_item_set_parent(RID p_item, RID p_parent) {
@@ -440,18 +702,7 @@ void RendererCanvasCull::canvas_item_set_parent(RID p_item, RID p_parent) {
 	ERR_FAIL_COND(!canvas_item);
 
 	if (canvas_item->parent.is_valid()) {
-		if (canvas_owner.owns(canvas_item->parent)) {
-			Canvas *canvas = canvas_owner.get_or_null(canvas_item->parent);
-			canvas->erase_item(canvas_item);
-		} else if (canvas_item_owner.owns(canvas_item->parent)) {
-			Item *item_owner = canvas_item_owner.get_or_null(canvas_item->parent);
-			item_owner->child_items.erase(canvas_item);
-
-			if (item_owner->sort_y) {
-				_mark_ysort_dirty(item_owner, canvas_item_owner);
-			}
-		}
-
+		_item_detach_from_parent(canvas_item);
 		canvas_item->parent = RID();
 	}
 
@@ -477,11 +728,13 @@ void RendererCanvasCull::canvas_item_set_parent(RID p_item, RID p_parent) {
 	}
 
 	canvas_item->parent = p_parent;
+	_item_attach_to_parent_index(canvas_item);
 }
 
 void RendererCanvasCull::canvas_item_set_visible(RID p_item, bool p_visible) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_queue_update(canvas_item);
 
 	canvas_item->visible = p_visible;
 
@@ -498,6 +751,7 @@ void RendererCanvasCull::canvas_item_set_light_mask(RID p_item, int p_mask) {
 void RendererCanvasCull::canvas_item_set_transform(RID p_item, const Transform2D &p_transform) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_queue_update(canvas_item);
 
 	canvas_item->xform = p_transform;
 }
@@ -519,6 +773,7 @@ void RendererCanvasCull::canvas_item_set_distance_field_mode(RID p_item, bool p_
 void RendererCanvasCull::canvas_item_set_custom_rect(RID p_item, bool p_custom_rect, const Rect2 &p_rect) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_queue_update(canvas_item);
 
 	canvas_item->custom_rect = p_custom_rect;
 	canvas_item->rect = p_rect;
@@ -548,6 +803,7 @@ void RendererCanvasCull::canvas_item_set_draw_behind_parent(RID p_item, bool p_e
 void RendererCanvasCull::canvas_item_set_update_when_visible(RID p_item, bool p_update) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_queue_update(canvas_item);
 
 	canvas_item->update_when_visible = p_update;
 }
@@ -555,6 +811,7 @@ void RendererCanvasCull::canvas_item_set_update_when_visible(RID p_item, bool p_
 void RendererCanvasCull::canvas_item_add_line(RID p_item, const Point2 &p_from, const Point2 &p_to, const Color &p_color, float p_width, bool p_antialiased) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_queue_update(canvas_item);
 
 	Item::CommandPrimitive *line = canvas_item->alloc_command<Item::CommandPrimitive>();
 	ERR_FAIL_COND(!line);
@@ -740,6 +997,7 @@ void RendererCanvasCull::canvas_item_add_polyline(RID p_item, const Vector<Point
 	ERR_FAIL_COND(p_points.size() < 2);
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_queue_update(canvas_item);
 
 	Color color = Color(1, 1, 1, 1);
 
@@ -1040,6 +1298,7 @@ void RendererCanvasCull::canvas_item_add_multiline(RID p_item, const Vector<Poin
 	ERR_FAIL_COND(p_points.size() < 2);
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_queue_update(canvas_item);
 
 	Item::CommandPolygon *pline = canvas_item->alloc_command<Item::CommandPolygon>();
 	ERR_FAIL_COND(!pline);
@@ -1056,6 +1315,7 @@ void RendererCanvasCull::canvas_item_add_multiline(RID p_item, const Vector<Poin
 void RendererCanvasCull::canvas_item_add_rect(RID p_item, const Rect2 &p_rect, const Color &p_color) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_queue_update(canvas_item);
 
 	Item::CommandRect *rect = canvas_item->alloc_command<Item::CommandRect>();
 	ERR_FAIL_COND(!rect);
@@ -1066,6 +1326,7 @@ void RendererCanvasCull::canvas_item_add_rect(RID p_item, const Rect2 &p_rect, c
 void RendererCanvasCull::canvas_item_add_circle(RID p_item, const Point2 &p_pos, float p_radius, const Color &p_color) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_queue_update(canvas_item);
 
 	Item::CommandPolygon *circle = canvas_item->alloc_command<Item::CommandPolygon>();
 	ERR_FAIL_COND(!circle);
@@ -1102,6 +1363,7 @@ void RendererCanvasCull::canvas_item_add_circle(RID p_item, const Point2 &p_pos,
 void RendererCanvasCull::canvas_item_add_texture_rect(RID p_item, const Rect2 &p_rect, RID p_texture, bool p_tile, const Color &p_modulate, bool p_transpose) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_queue_update(canvas_item);
 
 	Item::CommandRect *rect = canvas_item->alloc_command<Item::CommandRect>();
 	ERR_FAIL_COND(!rect);
@@ -1133,6 +1395,7 @@ void RendererCanvasCull::canvas_item_add_texture_rect(RID p_item, const Rect2 &p
 void RendererCanvasCull::canvas_item_add_msdf_texture_rect_region(RID p_item, const Rect2 &p_rect, RID p_texture, const Rect2 &p_src_rect, const Color &p_modulate, int p_outline_size, float p_px_range) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_queue_update(canvas_item);
 
 	Item::CommandRect *rect = canvas_item->alloc_command<Item::CommandRect>();
 	ERR_FAIL_COND(!rect);
@@ -1167,6 +1430,7 @@ void RendererCanvasCull::canvas_item_add_msdf_texture_rect_region(RID p_item, co
 void RendererCanvasCull::canvas_item_add_texture_rect_region(RID p_item, const Rect2 &p_rect, RID p_texture, const Rect2 &p_src_rect, const Color &p_modulate, bool p_transpose, bool p_clip_uv) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_queue_update(canvas_item);
 
 	Item::CommandRect *rect = canvas_item->alloc_command<Item::CommandRect>();
 	ERR_FAIL_COND(!rect);
@@ -1208,6 +1472,7 @@ void RendererCanvasCull::canvas_item_add_texture_rect_region(RID p_item, const R
 void RendererCanvasCull::canvas_item_add_nine_patch(RID p_item, const Rect2 &p_rect, const Rect2 &p_source, RID p_texture, const Vector2 &p_topleft, const Vector2 &p_bottomright, RS::NinePatchAxisMode p_x_axis_mode, RS::NinePatchAxisMode p_y_axis_mode, bool p_draw_center, const Color &p_modulate) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_queue_update(canvas_item);
 
 	Item::CommandNinePatch *style = canvas_item->alloc_command<Item::CommandNinePatch>();
 	ERR_FAIL_COND(!style);
@@ -1232,6 +1497,7 @@ void RendererCanvasCull::canvas_item_add_primitive(RID p_item, const Vector<Poin
 
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_queue_update(canvas_item);
 
 	Item::CommandPrimitive *prim = canvas_item->alloc_command<Item::CommandPrimitive>();
 	ERR_FAIL_COND(!prim);
@@ -1258,6 +1524,7 @@ void RendererCanvasCull::canvas_item_add_primitive(RID p_item, const Vector<Poin
 void RendererCanvasCull::canvas_item_add_polygon(RID p_item, const Vector<Point2> &p_points, const Vector<Color> &p_colors, const Vector<Point2> &p_uvs, RID p_texture) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_queue_update(canvas_item);
 #ifdef DEBUG_ENABLED
 	int pointcount = p_points.size();
 	ERR_FAIL_COND(pointcount < 3);
@@ -1279,6 +1546,7 @@ void RendererCanvasCull::canvas_item_add_polygon(RID p_item, const Vector<Point2
 void RendererCanvasCull::canvas_item_add_triangle_array(RID p_item, const Vector<int> &p_indices, const Vector<Point2> &p_points, const Vector<Color> &p_colors, const Vector<Point2> &p_uvs, const Vector<int> &p_bones, const Vector<float> &p_weights, RID p_texture, int p_count) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_queue_update(canvas_item);
 
 	int vertex_count = p_points.size();
 	ERR_FAIL_COND(vertex_count == 0);
@@ -1302,6 +1570,7 @@ void RendererCanvasCull::canvas_item_add_triangle_array(RID p_item, const Vector
 void RendererCanvasCull::canvas_item_add_set_transform(RID p_item, const Transform2D &p_transform) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_queue_update(canvas_item);
 
 	Item::CommandTransform *tr = canvas_item->alloc_command<Item::CommandTransform>();
 	ERR_FAIL_COND(!tr);
@@ -1311,6 +1580,7 @@ void RendererCanvasCull::canvas_item_add_set_transform(RID p_item, const Transfo
 void RendererCanvasCull::canvas_item_add_mesh(RID p_item, const RID &p_mesh, const Transform2D &p_transform, const Color &p_modulate, RID p_texture) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_queue_update(canvas_item);
 	ERR_FAIL_COND(!p_mesh.is_valid());
 
 	Item::CommandMesh *m = canvas_item->alloc_command<Item::CommandMesh>();
@@ -1330,6 +1600,7 @@ void RendererCanvasCull::canvas_item_add_mesh(RID p_item, const RID &p_mesh, con
 void RendererCanvasCull::canvas_item_add_particles(RID p_item, RID p_particles, RID p_texture) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_queue_update(canvas_item);
 
 	Item::CommandParticles *part = canvas_item->alloc_command<Item::CommandParticles>();
 	ERR_FAIL_COND(!part);
@@ -1344,6 +1615,7 @@ void RendererCanvasCull::canvas_item_add_particles(RID p_item, RID p_particles,
 void RendererCanvasCull::canvas_item_add_multimesh(RID p_item, RID p_mesh, RID p_texture) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_queue_update(canvas_item);
 
 	Item::CommandMultiMesh *mm = canvas_item->alloc_command<Item::CommandMultiMesh>();
 	ERR_FAIL_COND(!mm);
@@ -1355,6 +1627,7 @@ void RendererCanvasCull::canvas_item_add_multimesh(RID p_item, RID p_mesh, RID p
 void RendererCanvasCull::canvas_item_add_clip_ignore(RID p_item, bool p_ignore) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_queue_update(canvas_item);
 
 	Item::CommandClipIgnore *ci = canvas_item->alloc_command<Item::CommandClipIgnore>();
 	ERR_FAIL_COND(!ci);
@@ -1364,6 +1637,7 @@ void RendererCanvasCull::canvas_item_add_clip_ignore(RID p_item, bool p_ignore)
 void RendererCanvasCull::canvas_item_add_animation_slice(RID p_item, double p_animation_length, double p_slice_begin, double p_slice_end, double p_offset) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_queue_update(canvas_item);
 
 	Item::CommandAnimationSlice *as = canvas_item->alloc_command<Item::CommandAnimationSlice>();
 	ERR_FAIL_COND(!as);
@@ -1430,6 +1704,7 @@ void RendererCanvasCull::canvas_item_attach_skeleton(RID p_item, RID p_skeleton)
 void RendererCanvasCull::canvas_item_set_copy_to_backbuffer(RID p_item, bool p_enable, const Rect2 &p_rect) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_queue_update(canvas_item);
 	if (p_enable && (canvas_item->copy_back_buffer == nullptr)) {
 		canvas_item->copy_back_buffer = memnew(RendererCanvasRender::Item::CopyBackBuffer);
 	}
@@ -1447,6 +1722,7 @@ void RendererCanvasCull::canvas_item_set_copy_to_backbuffer(RID p_item, bool p_e
 void RendererCanvasCull::canvas_item_clear(RID p_item) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_queue_update(canvas_item);
 
 	canvas_item->clear();
 }
@@ -1487,6 +1763,7 @@ void RendererCanvasCull::canvas_item_set_use_parent_material(RID p_item, bool p_
 void RendererCanvasCull::canvas_item_set_visibility_notifier(RID p_item, bool p_enable, const Rect2 &p_area, const Callable &p_enter_callable, const Callable &p_exit_callable) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_queue_update(canvas_item);
 
 	if (p_enable) {
 		if (!canvas_item->visibility_notifier) {
@@ -1507,6 +1784,7 @@ void RendererCanvasCull::canvas_item_set_visibility_notifier(RID p_item, bool p_
 void RendererCanvasCull::canvas_item_set_canvas_group_mode(RID p_item, RS::CanvasGroupMode p_mode, float p_clear_margin, bool p_fit_empty, float p_fit_margin, bool p_blur_mipmaps) {
 	Item *canvas_item = canvas_item_owner.get_or_null(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_item_queue_update(canvas_item);
 
 	if (p_mode == RS::CANVAS_GROUP_MODE_DISABLED) {
 		if (canvas_item->canvas_group != nullptr) {
@@ -1938,6 +2216,10 @@ bool RendererCanvasCull::free(RID p_rid) {
 			canvas->viewports.erase(canvas->viewports.front());
 		}
 
+		if (canvas->child_index) {
+			_free_child_index(canvas->child_index);
+		}
+
 		for (int i = 0; i < canvas->child_items.size(); i++) {
 			canvas->child_items[i].item->parent = RID();
 		}
@@ -1957,23 +2239,21 @@ bool RendererCanvasCull::free(RID p_rid) {
 		ERR_FAIL_COND_V(!canvas_item, true);
 
 		if (canvas_item->parent.is_valid()) {
-			if (canvas_owner.owns(canvas_item->parent)) {
-				Canvas *canvas = canvas_owner.get_or_null(canvas_item->parent);
-				canvas->erase_item(canvas_item);
-			} else if (canvas_item_owner.owns(canvas_item->parent)) {
-				Item *item_owner = canvas_item_owner.get_or_null(canvas_item->parent);
-				item_owner->child_items.erase(canvas_item);
-
-				if (item_owner->sort_y) {
-					_mark_ysort_dirty(item_owner, canvas_item_owner);
-				}
-			}
+			_item_detach_from_parent(canvas_item);
+		}
+
+		if (canvas_item->child_index) {
+			_free_child_index(canvas_item->child_index);
 		}
 
 		for (int i = 0; i < canvas_item->child_items.size(); i++) {
 			canvas_item->child_items[i]->parent = RID();
 		}
 
+		if (canvas_item->update_item.in_list()) {
+			item_update_list.remove(&canvas_item->update_item);
+		}
+
 		if (canvas_item->visibility_notifier != nullptr) {
 			visibility_notifier_allocator.free(canvas_item->visibility_notifier);
 		}
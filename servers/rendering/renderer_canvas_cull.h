@@ -31,12 +31,15 @@
 #ifndef RENDERING_SERVER_CANVAS_CULL_H
 #define RENDERING_SERVER_CANVAS_CULL_H
 
+#include "core/math/dynamic_bvh.h"
 #include "core/templates/paged_allocator.h"
 #include "renderer_compositor.h"
 #include "renderer_viewport.h"
 
 class RendererCanvasCull {
 public:
+	struct ChildIndex;
+
 	struct Item : public RendererCanvasRender::Item {
 		RID parent; // canvas it belongs to
 		List<Item *>::Element *E;
@@ -70,7 +73,22 @@ public:
 
 		VisibilityNotifierData *visibility_notifier = nullptr;
 
-		Item() {
+		// Bounds of this item and all its visible descendants in local space, used to skip whole
+		// subtrees outside of the clip rect. Unbounded subtrees contain items whose rect is only
+		// known while drawing, and are always visited.
+		Rect2 subtree_rect;
+		bool subtree_has_rect = false;
+		bool subtree_bounded = false;
+		Rect2 parent_rect; // subtree_rect in the space of the parent, as stored in its child index.
+		SelfList<Item> update_item;
+
+		ChildIndex *child_index = nullptr;
+		DynamicBVH::ID child_index_id;
+		bool in_unbounded_children = false;
+		uint32_t child_slot = 0; // Increases with the position in the parent's sorted child list.
+
+		Item() :
+				update_item(this) {
 			children_order_dirty = true;
 			E = nullptr;
 			z_index = 0;
@@ -103,6 +121,23 @@ public:
 		}
 	};
 
+	struct ItemSlotSort {
+		_FORCE_INLINE_ bool operator()(const Item *p_left, const Item *p_right) const {
+			return p_left->child_slot < p_right->child_slot;
+		}
+	};
+
+	// Spatial index over the children of a canvas or a canvas item, so culling only visits the
+	// children that intersect the clip rect. Only built once a parent has many children.
+	struct ChildIndex {
+		DynamicBVH bvh;
+		LocalVector<Item *> unbounded_children;
+	};
+
+	enum {
+		CHILD_INDEX_MIN_CHILDREN = 64,
+	};
+
 	struct LightOccluderPolygon {
 		bool active;
 		Rect2 aabb;
@@ -140,6 +175,7 @@ public:
 		Color modulate;
 		RID parent;
 		float parent_scale;
+		ChildIndex *child_index = nullptr;
 
 		int find_item(Item *p_item) {
 			for (int i = 0; i < child_items.size(); i++) {
@@ -177,7 +213,21 @@ public:
 	_FORCE_INLINE_ void _attach_canvas_item_for_draw(Item *ci, Item *p_canvas_clip, RendererCanvasRender::Item **z_list, RendererCanvasRender::Item **z_last_list, const Transform2D &xform, const Rect2 &p_clip_rect, Rect2 global_rect, const Color &modulate, int p_z, RendererCanvasCull::Item *p_material_owner, bool use_canvas_group, RendererCanvasRender::Item *canvas_group_from, const Transform2D &p_xform);
 
 private:
-	void _render_canvas_item_tree(RID p_to_render_target, Canvas::ChildItem *p_child_items, int p_child_item_count, Item *p_canvas_item, const Transform2D &p_transform, const Rect2 &p_clip_rect, const Color &p_modulate, RendererCanvasRender::Light *p_lights, RendererCanvasRender::Light *p_directional_lights, RS::CanvasItemTextureFilter p_default_filter, RS::CanvasItemTextureRepeat p_default_repeat, bool p_snap_2d_vertices_to_pixel);
+	SelfList<Item>::List item_update_list;
+	LocalVector<LocalVector<Item *>> cull_children;
+	uint32_t cull_children_depth = 0;
+
+	void _item_queue_update(Item *p_item);
+	void _update_dirty_items();
+	void _item_update_subtree(Item *p_item);
+	void _item_attach_to_parent_index(Item *p_item);
+	void _item_detach_from_parent(Item *p_item);
+	void _child_index_update(ChildIndex *p_index, Item *p_child);
+	void _child_index_remove(ChildIndex *p_index, Item *p_child);
+	void _free_child_index(ChildIndex *&r_index);
+	Item **_cull_child_index(ChildIndex *p_index, const Transform2D &p_xform, const Rect2 &p_clip_rect, int &r_count);
+
+	void _render_canvas_item_tree(RID p_to_render_target, Canvas::ChildItem *p_child_items, int p_child_item_count, ChildIndex *p_child_index, Item *p_canvas_item, const Transform2D &p_transform, const Rect2 &p_clip_rect, const Color &p_modulate, RendererCanvasRender::Light *p_lights, RendererCanvasRender::Light *p_directional_lights, RS::CanvasItemTextureFilter p_default_filter, RS::CanvasItemTextureRepeat p_default_repeat, bool p_snap_2d_vertices_to_pixel);
 	void _cull_canvas_item(Item *p_canvas_item, const Transform2D &p_transform, const Rect2 &p_clip_rect, const Color &p_modulate, int p_z, RendererCanvasRender::Item **z_list, RendererCanvasRender::Item **z_last_list, Item *p_canvas_clip, Item *p_material_owner, bool allow_y_sort);
 
 	RendererCanvasRender::Item **z_list;
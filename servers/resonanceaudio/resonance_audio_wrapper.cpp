@@ -38,3 +38,71 @@ ResonanceAudioBus::ResonanceAudioBus() {
 			vraudio::CreateResonanceAudioApi(
 					/* num_channels= */ 2, AudioServer::get_singleton()->thread_get_mix_buffer_size(), AudioServer::get_singleton()->get_mix_rate());
 };
+
+void ResonanceAudioServer::unregister_audio_source(AudioSourceId audio_source) {
+	ERR_FAIL_NULL(master_bus_ptr);
+	if (audio_source.get_id() == -1) {
+		return;
+	}
+	{
+		// Drop queued transforms, the id might be reused by the next source that gets created.
+		MutexLock lock(pending_transforms_mutex);
+		LocalVector<PendingSourceTransform> &queue = source_transform_queues[pending_queue];
+		uint32_t i = 0;
+		while (i < queue.size()) {
+			if (queue[i].source.get_id() == audio_source.get_id()) {
+				queue.remove_at(i);
+			} else {
+				i++;
+			}
+		}
+	}
+	master_bus_ptr->unregister_audio_source(audio_source);
+}
+
+void ResonanceAudioServer::set_source_transform(AudioSourceId audio_source, Transform3D source_transform) {
+	if (audio_source.get_id() == -1) {
+		return;
+	}
+	PendingSourceTransform pending;
+	pending.source = audio_source;
+	pending.transform = source_transform;
+
+	MutexLock lock(pending_transforms_mutex);
+	source_transform_queues[pending_queue].push_back(pending);
+}
+
+void ResonanceAudioServer::set_head_transform(Transform3D head_transform) {
+	MutexLock lock(pending_transforms_mutex);
+	pending_head_transform = head_transform;
+	pending_head_transform_dirty = true;
+}
+
+void ResonanceAudioServer::apply_pending_transforms() {
+	if (!master_bus_ptr) {
+		return;
+	}
+
+	Transform3D head_transform;
+	bool head_transform_dirty = false;
+	int applying_queue;
+	{
+		// Only swap under the lock, so the main thread is never kept waiting on the API calls.
+		MutexLock lock(pending_transforms_mutex);
+		applying_queue = pending_queue;
+		pending_queue = 1 - pending_queue;
+		head_transform = pending_head_transform;
+		head_transform_dirty = pending_head_transform_dirty;
+		pending_head_transform_dirty = false;
+	}
+
+	if (head_transform_dirty) {
+		master_bus_ptr->set_head_transform(head_transform);
+	}
+	// Applied in queue order, so a source moved several times since the last mix step ends up at its latest transform.
+	LocalVector<PendingSourceTransform> &queue = source_transform_queues[applying_queue];
+	for (uint32_t i = 0; i < queue.size(); i++) {
+		master_bus_ptr->set_source_transform(queue[i].source, queue[i].transform);
+	}
+	queue.clear();
+}
@@ -38,6 +38,7 @@
 #include "core/os/os.h"
 #include "core/os/thread.h"
 #include "core/templates/list.h"
+#include "core/templates/local_vector.h"
 #include "core/templates/rid.h"
 #include "core/templates/rid_owner.h"
 #include "core/templates/set.h"
@@ -64,8 +65,8 @@ private:
 
 public:
 	AudioSourceId register_audio_source() {
-		resonance_api->CreateSoundObjectSource(vraudio::RenderingMode::kBinauralHighQuality);
-		vraudio::ResonanceAudioApi::SourceId new_id = -1;
+		vraudio::ResonanceAudioApi::SourceId new_id = resonance_api->CreateSoundObjectSource(vraudio::RenderingMode::kBinauralHighQuality);
+		ERR_FAIL_COND_V(new_id == vraudio::ResonanceAudioApi::kInvalidSourceId, AudioSourceId(-1));
 		resonance_api->SetSourceDistanceModel(
 				new_id,
 				vraudio::DistanceRolloffModel::kNone,
@@ -132,7 +133,9 @@ public:
 	}
 
 	ResonanceAudioBus();
-	~ResonanceAudioBus(){};
+	~ResonanceAudioBus() {
+		delete resonance_api;
+	}
 };
 
 class ResonanceAudioServer : public Object {
@@ -152,6 +155,21 @@ protected:
 private:
 	RID_Owner<ResonanceAudioBus, true> bus_owner;
 	RID master_bus;
+	// Cached so calls don't have to look up the master bus every time, it lives as long as the server.
+	ResonanceAudioBus *master_bus_ptr = nullptr;
+
+	// Transforms are queued from the main thread and applied in one batch at the start of every mix step.
+	// The two queues are swapped under the lock, so neither thread waits on the other and nothing is reallocated once warmed up.
+	struct PendingSourceTransform {
+		AudioSourceId source;
+		Transform3D transform;
+	};
+
+	Mutex pending_transforms_mutex;
+	LocalVector<PendingSourceTransform> source_transform_queues[2];
+	int pending_queue = 0;
+	Transform3D pending_head_transform;
+	bool pending_head_transform_dirty = false;
 
 public:
 	RID create_bus() {
@@ -160,87 +178,61 @@ public:
 		ERR_FAIL_NULL_V(ptr, RID());
 		ptr->set_self(ret);
 		master_bus = ret;
+		master_bus_ptr = ptr;
 
 		return ret;
 	}
 
 	AudioSourceId register_audio_source() {
-		ResonanceAudioBus *ptr = bus_owner.get_or_null(master_bus);
-		if (ptr) {
-			AudioSourceId source = ptr->register_audio_source();
-			return source;
-		}
-		return AudioSourceId(-1);
-	}
-	void unregister_audio_source(AudioSourceId audio_source) {
-		ResonanceAudioBus *ptr = bus_owner.get_or_null(master_bus);
-		if (ptr) {
-			ptr->unregister_audio_source(audio_source);
-			return;
-		}
-		return;
+		ERR_FAIL_NULL_V(master_bus_ptr, AudioSourceId(-1));
+		return master_bus_ptr->register_audio_source();
 	}
+	void unregister_audio_source(AudioSourceId audio_source);
 	AudioSourceId register_stero_audio_source() {
-		ResonanceAudioBus *ptr = bus_owner.get_or_null(master_bus);
-		if (ptr) {
-			AudioSourceId source = ptr->register_stero_audio_source();
-			return source;
-		}
-		return AudioSourceId(-1);
-	}
-	void set_source_transform(AudioSourceId audio_source, Transform3D source_transform) {
-		ResonanceAudioBus *ptr = bus_owner.get_or_null(master_bus);
-		if (ptr) {
-			ptr->set_source_transform(audio_source, source_transform);
-			return;
-		}
-		return;
-	}
-	void set_head_transform(Transform3D head_transform) {
-		ResonanceAudioBus *ptr = bus_owner.get_or_null(master_bus);
-		if (ptr) {
-			ptr->set_head_transform(head_transform);
-			return;
-		}
-		return;
+		ERR_FAIL_NULL_V(master_bus_ptr, AudioSourceId(-1));
+		return master_bus_ptr->register_stero_audio_source();
 	}
+	void set_source_transform(AudioSourceId audio_source, Transform3D source_transform);
+	void set_head_transform(Transform3D head_transform);
+	// Should only be called on the audio thread, once per mix step before any source buffer is pushed.
+	void apply_pending_transforms();
+
+	// Should only be called on the audio thread.
 	void push_source_buffer(AudioSourceId source, int num_frames, AudioFrame *frames) {
-		ResonanceAudioBus *bus = bus_owner.get_or_null(master_bus);
-		if (bus) {
-			bus->push_source_buffer(source, num_frames, frames);
-			return;
+		if (master_bus_ptr && source.get_id() != -1) {
+			master_bus_ptr->push_source_buffer(source, num_frames, frames);
 		}
-		return;
 	}
+	// Should only be called on the audio thread, once per mix step after all source buffers have been pushed.
 	bool pull_listener_buffer(int num_frames, AudioFrame *frames) {
-		ResonanceAudioBus *ptr = bus_owner.get_or_null(master_bus);
-		if (ptr) {
-			return ptr->pull_listener_buffer(num_frames, frames);
+		if (master_bus_ptr) {
+			return master_bus_ptr->pull_listener_buffer(num_frames, frames);
 		}
 		return false;
 	}
 
 	void set_source_attenuation(AudioSourceId source, float attenuation_linear) {
-		ResonanceAudioBus *ptr = bus_owner.get_or_null(master_bus);
-		if (ptr) {
-			ptr->set_source_attenuation(source, attenuation_linear);
-			return;
+		if (master_bus_ptr && source.get_id() != -1) {
+			master_bus_ptr->set_source_attenuation(source, attenuation_linear);
 		}
-		return;
 	}
 
 	void set_linear_source_volume(AudioSourceId audio_source, real_t volume) {
-		ResonanceAudioBus *ptr = bus_owner.get_or_null(master_bus);
-		if (ptr) {
-			ptr->set_linear_source_volume(audio_source, volume);
-			return;
+		if (master_bus_ptr && audio_source.get_id() != -1) {
+			master_bus_ptr->set_linear_source_volume(audio_source, volume);
 		}
-		return;
 	}
 	ResonanceAudioServer() {
 		singleton = this;
 		master_bus = create_bus();
 	}
+	~ResonanceAudioServer() {
+		if (master_bus.is_valid()) {
+			bus_owner.free(master_bus);
+		}
+		master_bus_ptr = nullptr;
+		singleton = nullptr;
+	}
 };
 
 #endif
@@ -0,0 +1,158 @@
+/*************************************************************************/
+/*  test_message_queue.h                                                 */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_MESSAGE_QUEUE_H
+#define TEST_MESSAGE_QUEUE_H
+
+#include "core/object/message_queue.h"
+#include "core/os/thread.h"
+
+#include "tests/test_macros.h"
+
+#if !defined(NO_THREADS)
+
+namespace TestMessageQueue {
+
+class RecordCallable : public CallableCustom {
+	static bool compare_equal(const CallableCustom *p_a, const CallableCustom *p_b) {
+		return p_a == p_b;
+	}
+
+	static bool compare_less(const CallableCustom *p_a, const CallableCustom *p_b) {
+		return p_a < p_b;
+	}
+
+public:
+	ObjectID target;
+	LocalVector<int> *last_sequence = nullptr;
+	int *received = nullptr;
+	int *out_of_order = nullptr;
+
+	virtual uint32_t hash() const override {
+		return hash_djb2_one_64((uint64_t)this);
+	}
+	virtual String get_as_text() const override {
+		return "RecordCallable";
+	}
+	virtual CompareEqualFunc get_compare_equal_func() const override {
+		return compare_equal;
+	}
+	virtual CompareLessFunc get_compare_less_func() const override {
+		return compare_less;
+	}
+	virtual ObjectID get_object() const override {
+		return target;
+	}
+	virtual void call(const Variant **p_arguments, int p_argcount, Variant &r_return_value, Callable::CallError &r_call_error) const override {
+		int producer = *p_arguments[0];
+		int sequence = *p_arguments[1];
+		if ((*last_sequence)[producer] + 1 != sequence) {
+			(*out_of_order)++;
+		}
+		(*last_sequence)[producer] = sequence;
+		(*received)++;
+		r_call_error.error = Callable::CallError::CALL_OK;
+	}
+};
+
+struct Producer {
+	Callable callable;
+	int index = 0;
+	int count = 0;
+	Thread thread;
+
+	static void thread_function(void *p_userdata) {
+		Producer *producer = static_cast<Producer *>(p_userdata);
+		for (int i = 0; i < producer->count; i++) {
+			MessageQueue::get_singleton()->push_callable(producer->callable, producer->index, i);
+		}
+	}
+};
+
+TEST_CASE("[MessageQueue] Deferred calls from several threads") {
+	const bool own_queue = MessageQueue::get_singleton() == nullptr;
+	if (own_queue) {
+		memnew(MessageQueue);
+	}
+
+	Object *target = memnew(Object);
+	const int producer_count = 4;
+	// More than fits in the queue's initial size, which should grow instead of failing.
+	const int message_count = 100000;
+
+	LocalVector<int> last_sequence;
+	int received = 0;
+	int out_of_order = 0;
+	for (int i = 0; i <= producer_count; i++) {
+		last_sequence.push_back(-1);
+	}
+
+	RecordCallable *record = memnew(RecordCallable);
+	record->target = target->get_instance_id();
+	record->last_sequence = &last_sequence;
+	record->received = &received;
+	record->out_of_order = &out_of_order;
+	Callable callable(record);
+
+	Producer producers[producer_count];
+	for (int i = 0; i < producer_count; i++) {
+		producers[i].callable = callable;
+		producers[i].index = i;
+		producers[i].count = message_count;
+		producers[i].thread.start(&Producer::thread_function, &producers[i]);
+	}
+	// The main thread pushes at the same time.
+	for (int i = 0; i < message_count; i++) {
+		MessageQueue::get_singleton()->push_callable(callable, producer_count, i);
+	}
+	for (int i = 0; i < producer_count; i++) {
+		producers[i].thread.wait_to_finish();
+	}
+
+	MessageQueue::get_singleton()->flush();
+
+	CHECK_MESSAGE(received == (producer_count + 1) * message_count, "Every deferred call should have been made.");
+	CHECK_MESSAGE(out_of_order == 0, "Deferred calls from the same thread should be made in the order they were pushed.");
+
+	for (int i = 0; i < producer_count; i++) {
+		producers[i].callable = Callable();
+	}
+	callable = Callable();
+	memdelete(target);
+	if (own_queue) {
+		memdelete(MessageQueue::get_singleton());
+	}
+}
+
+} // namespace TestMessageQueue
+
+#endif // !defined(NO_THREADS)
+
+#endif // TEST_MESSAGE_QUEUE_H
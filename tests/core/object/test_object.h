@@ -275,6 +275,30 @@ TEST_CASE("[Object] Absent name getter") {
 			actual_value == Variant(),
 			"The returned value should equal nil variant.");
 }
+
+TEST_CASE("[Object] Signals call connected methods") {
+	Object emitter;
+	emitter.add_user_signal(MethodInfo("changed", PropertyInfo(Variant::STRING_NAME, "name"), PropertyInfo(Variant::NIL, "value")));
+	emitter.add_user_signal(MethodInfo("named", PropertyInfo(Variant::STRING_NAME, "name")));
+
+	Object target;
+	emitter.connect("changed", Callable(&target, "set_meta"));
+
+	// Arguments matching the bound types go straight to the method bind, others through a regular call.
+	emitter.emit_signal("changed", StringName("exact"), 1);
+	emitter.emit_signal("changed", String("converted"), 2);
+	CHECK_MESSAGE(int(target.get_meta("exact")) == 1, "Arguments of the exact types should reach the method.");
+	CHECK_MESSAGE(int(target.get_meta("converted")) == 2, "Arguments needing a conversion should reach the method.");
+
+	Object bound_target;
+	emitter.connect("named", Callable(&bound_target, "set_meta"), varray(3));
+	emitter.connect("named", Callable(&target, "set_meta"), varray(4), Object::CONNECT_ONESHOT);
+	emitter.emit_signal("named", StringName("bound"));
+	CHECK_MESSAGE(int(bound_target.get_meta("bound")) == 3, "Binds should be passed after the signal arguments.");
+	CHECK(int(target.get_meta("bound")) == 4);
+	CHECK_MESSAGE(!emitter.is_connected("named", Callable(&target, "set_meta")), "One shot connections should be disconnected after the emission.");
+	CHECK(emitter.is_connected("named", Callable(&bound_target, "set_meta")));
+}
 } // namespace TestObject
 
 #endif // TEST_OBJECT_H
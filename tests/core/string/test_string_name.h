@@ -0,0 +1,107 @@
+/*************************************************************************/
+/*  test_string_name.h                                                   */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_STRING_NAME_H
+#define TEST_STRING_NAME_H
+
+#include "core/os/thread.h"
+#include "core/string/string_name.h"
+
+#include "tests/test_macros.h"
+
+namespace TestStringName {
+
+TEST_CASE("[StringName] Interning") {
+	StringName a = "test_string_name_interning";
+	StringName b = String("test_string_name_interning");
+	StringName c = StringName::search("test_string_name_interning");
+
+	CHECK(a == b);
+	CHECK(a == c);
+	CHECK(a.data_unique_pointer() == b.data_unique_pointer());
+	CHECK(StringName::search("test_string_name_never_created") == StringName());
+}
+
+#if !defined(NO_THREADS)
+
+struct InternThread {
+	static const int NAME_COUNT = 256;
+	static const int ROUNDS = 64;
+
+	const void *pointers[NAME_COUNT] = {};
+	Thread thread;
+
+	static void thread_function(void *p_userdata) {
+		InternThread *data = static_cast<InternThread *>(p_userdata);
+		for (int round = 0; round < ROUNDS; round++) {
+			for (int i = 0; i < NAME_COUNT; i++) {
+				// Looked up and released over and over by every thread at once.
+				StringName name = "test_string_name_thread_" + itos(i);
+				if (round == ROUNDS - 1) {
+					data->pointers[i] = name.data_unique_pointer();
+				}
+			}
+		}
+	}
+};
+
+TEST_CASE("[StringName] Interning from several threads") {
+	// Keeping them alive on the main thread makes every thread end up with the same names.
+	LocalVector<StringName> names;
+	for (int i = 0; i < InternThread::NAME_COUNT; i++) {
+		names.push_back("test_string_name_thread_" + itos(i));
+	}
+
+	const int thread_count = 4;
+	InternThread threads[thread_count];
+	for (int i = 0; i < thread_count; i++) {
+		threads[i].thread.start(&InternThread::thread_function, &threads[i]);
+	}
+	for (int i = 0; i < thread_count; i++) {
+		threads[i].thread.wait_to_finish();
+	}
+
+	int mismatches = 0;
+	for (int i = 0; i < thread_count; i++) {
+		for (int j = 0; j < InternThread::NAME_COUNT; j++) {
+			if (threads[i].pointers[j] != names[j].data_unique_pointer()) {
+				mismatches++;
+			}
+		}
+	}
+	CHECK_MESSAGE(mismatches == 0, "The same name should always be interned once.");
+	CHECK(StringName::get_contended_lock_count() <= StringName::get_lock_count());
+}
+
+#endif // !defined(NO_THREADS)
+
+} // namespace TestStringName
+
+#endif // TEST_STRING_NAME_H
@@ -424,6 +424,96 @@ TEST_CASE("[Stress][CommandQueue] Stress test command queue") {
 	ProjectSettings::get_singleton()->set_setting(COMMAND_QUEUE_SETTING,
 			ProjectSettings::get_singleton()->property_get_revert(COMMAND_QUEUE_SETTING));
 }
+
+class MultiProducerState {
+public:
+	static const int PRODUCER_COUNT = 4;
+	static const int MESSAGES_PER_PRODUCER = 20000;
+	static const int BATCH_SIZE = 100;
+
+	struct Producer {
+		MultiProducerState *state = nullptr;
+		int index = 0;
+		int returned_wrong = 0;
+		Thread thread;
+	};
+
+	CommandQueueMT command_queue = CommandQueueMT(false);
+	Producer producers[PRODUCER_COUNT];
+	int last_sequence[PRODUCER_COUNT];
+	int received = 0;
+	int out_of_order = 0;
+
+	void receive(int p_producer, int p_sequence) {
+		if (last_sequence[p_producer] + 1 != p_sequence) {
+			out_of_order++;
+		}
+		last_sequence[p_producer] = p_sequence;
+		received++;
+	}
+
+	int double_value(int p_value) {
+		return p_value * 2;
+	}
+
+	static void producer_thread_loop(void *p_userdata) {
+		Producer *producer = static_cast<Producer *>(p_userdata);
+		CommandQueueMT &command_queue = producer->state->command_queue;
+
+		for (int i = 0; i < MESSAGES_PER_PRODUCER; i++) {
+			if (i % BATCH_SIZE == 0) {
+				command_queue.begin_batch();
+			}
+			command_queue.push(producer->state, &MultiProducerState::receive, producer->index, i);
+			if (i % 1000 == 500) {
+				// Returning messages are handed over right away, even inside a batch.
+				int ret = 0;
+				command_queue.push_and_ret(producer->state, &MultiProducerState::double_value, i, &ret);
+				if (ret != i * 2) {
+					producer->returned_wrong++;
+				}
+			}
+			if (i % BATCH_SIZE == BATCH_SIZE - 1) {
+				command_queue.end_batch();
+			}
+		}
+	}
+
+	MultiProducerState() {
+		for (int i = 0; i < PRODUCER_COUNT; i++) {
+			producers[i].state = this;
+			producers[i].index = i;
+			last_sequence[i] = -1;
+		}
+	}
+};
+
+TEST_CASE("[CommandQueue] Multiple producers keep their order") {
+	const int total = MultiProducerState::PRODUCER_COUNT * MultiProducerState::MESSAGES_PER_PRODUCER;
+	MultiProducerState state;
+	for (int i = 0; i < MultiProducerState::PRODUCER_COUNT; i++) {
+		state.producers[i].thread.start(&MultiProducerState::producer_thread_loop, &state.producers[i]);
+	}
+
+	// Returning messages block their producer until they are read, so keep reading.
+	while (state.received < total) {
+		state.command_queue.flush_all();
+	}
+
+	int returned_wrong = 0;
+	for (int i = 0; i < MultiProducerState::PRODUCER_COUNT; i++) {
+		state.producers[i].thread.wait_to_finish();
+		returned_wrong += state.producers[i].returned_wrong;
+	}
+	state.command_queue.flush_all();
+
+	CHECK_MESSAGE(state.received == total,
+			"Reader should have read every message of every producer.");
+	CHECK_MESSAGE(state.out_of_order == 0,
+			"Messages of a single producer should be read in the order they were pushed.");
+	CHECK_MESSAGE(returned_wrong == 0,
+			"Returning messages should get their result back.");
+}
 } // namespace TestCommandQueue
 
 #endif // !defined(NO_THREADS)
@@ -0,0 +1,298 @@
+/*************************************************************************/
+/*  test_dense_hash_map.h                                                */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_DENSE_HASH_MAP_H
+#define TEST_DENSE_HASH_MAP_H
+
+#include "core/math/random_pcg.h"
+#include "core/os/os.h"
+#include "core/templates/dense_hash_map.h"
+#include "core/templates/hash_map.h"
+#include "core/templates/map.h"
+#include "core/templates/oa_hash_map.h"
+#include "core/templates/ordered_hash_map.h"
+
+#include "tests/test_macros.h"
+
+namespace TestDenseHashMap {
+
+TEST_CASE("[DenseHashMap] Insert and lookup") {
+	DenseHashMap<int, int> map;
+	map.insert(42, 84);
+	map[7] = 14;
+
+	CHECK(map.size() == 2);
+	CHECK(map.has(42));
+	CHECK(map.has(7));
+	CHECK(!map.has(1));
+	CHECK(map.get(42) == 84);
+	CHECK(*map.getptr(7) == 14);
+	CHECK(map.getptr(1) == nullptr);
+	CHECK(map.find(1) == map.end());
+	CHECK(map.find(42)->value == 84);
+}
+
+TEST_CASE("[DenseHashMap] Overwrite element") {
+	DenseHashMap<int, int> map;
+	map.insert(42, 84);
+	map.insert(42, 1234);
+
+	CHECK(map.size() == 1);
+	CHECK(map[42] == 1234);
+}
+
+TEST_CASE("[DenseHashMap] Iteration follows insertion order") {
+	DenseHashMap<String, int> map;
+	for (int i = 0; i < 100; i++) {
+		map.insert(itos((i * 37) % 100), i);
+	}
+	// Overwriting keeps the original position.
+	map.insert(itos(0), 1000);
+
+	int expected = 0;
+	for (const KeyValue<String, int> &E : map) {
+		CHECK(E.key == itos((expected * 37) % 100));
+		CHECK(E.value == (expected == 0 ? 1000 : expected));
+		expected++;
+	}
+	CHECK(expected == 100);
+}
+
+TEST_CASE("[DenseHashMap] Erase and compaction") {
+	DenseHashMap<int, int> map;
+	for (int i = 0; i < 1000; i++) {
+		map.insert(i, i * 2);
+	}
+	for (int i = 0; i < 1000; i += 3) {
+		CHECK(map.erase(i));
+	}
+	CHECK(!map.erase(0));
+	CHECK(map.size() == 666);
+
+	// Reinserting after many erasures compacts the element array without reordering it.
+	for (int i = 1000; i < 1500; i++) {
+		map.insert(i, i * 2);
+	}
+	CHECK(map.size() == 1166);
+
+	int previous = -1;
+	for (const KeyValue<int, int> &E : map) {
+		CHECK((E.key % 3 != 0 || E.key >= 1000));
+		CHECK(E.value == E.key * 2);
+		CHECK(E.key > previous);
+		previous = E.key;
+	}
+	for (int i = 0; i < 1500; i++) {
+		CHECK(map.has(i) == (i % 3 != 0 || i >= 1000));
+	}
+}
+
+TEST_CASE("[DenseHashMap] Matches Map under random operations") {
+	DenseHashMap<uint32_t, uint32_t> map;
+	Map<uint32_t, uint32_t> reference;
+	RandomPCG rng(1234);
+
+	for (int i = 0; i < 20000; i++) {
+		uint32_t key = rng.rand() % 2000;
+		if (rng.rand() % 3 == 0) {
+			CHECK(map.erase(key) == reference.erase(key));
+		} else {
+			map[key] = i;
+			reference[key] = i;
+		}
+	}
+
+	CHECK(map.size() == (uint32_t)reference.size());
+	for (const Map<uint32_t, uint32_t>::Element *E = reference.front(); E; E = E->next()) {
+		const uint32_t *value = map.getptr(E->key());
+		REQUIRE(value);
+		CHECK(*value == E->get());
+	}
+}
+
+TEST_CASE("[DenseHashMap] Copy, clear and reset") {
+	DenseHashMap<int, String> map;
+	for (int i = 0; i < 50; i++) {
+		map.insert(i, itos(i));
+	}
+
+	DenseHashMap<int, String> copy = map;
+	map.clear();
+	CHECK(map.is_empty());
+	CHECK(!map.has(10));
+	CHECK(copy.size() == 50);
+	CHECK(copy[10] == "10");
+
+	map = copy;
+	CHECK(map.size() == 50);
+	copy.reset();
+	CHECK(copy.is_empty());
+	copy.insert(1, "one");
+	CHECK(copy[1] == "one");
+	CHECK(map[49] == "49");
+}
+
+// Prints the time taken by the common operations of DenseHashMap and the other associative containers.
+// Usage: `godot --test dense-hash-map-benchmark`.
+static void benchmark_dense_hash_map() {
+	const uint32_t count = 200000;
+	const uint32_t lookups = 2000000;
+
+	LocalVector<uint32_t> keys;
+	keys.resize(count);
+	RandomPCG rng(42);
+	for (uint32_t i = 0; i < count; i++) {
+		keys[i] = rng.rand();
+	}
+
+	const char *names[5] = { "DenseHashMap", "HashMap", "OAHashMap", "Map", "OrderedHashMap" };
+	for (int container = 0; container < 5; container++) {
+		DenseHashMap<uint32_t, uint32_t> dense;
+		HashMap<uint32_t, uint32_t> hash;
+		OAHashMap<uint32_t, uint32_t> oa;
+		Map<uint32_t, uint32_t> tree;
+		OrderedHashMap<uint32_t, uint32_t> ordered;
+		uint64_t usec[4];
+		uint64_t checksum = 0;
+
+		uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		for (uint32_t i = 0; i < count; i++) {
+			switch (container) {
+				case 0:
+					dense.insert(keys[i], i);
+					break;
+				case 1:
+					hash.set(keys[i], i);
+					break;
+				case 2:
+					oa.set(keys[i], i);
+					break;
+				case 3:
+					tree[keys[i]] = i;
+					break;
+				case 4:
+					ordered.insert(keys[i], i);
+					break;
+			}
+		}
+		usec[0] = OS::get_singleton()->get_ticks_usec() - begin;
+
+		begin = OS::get_singleton()->get_ticks_usec();
+		for (uint32_t i = 0; i < lookups; i++) {
+			const uint32_t key = keys[(i * 7919) % count];
+			const uint32_t *value = nullptr;
+			switch (container) {
+				case 0:
+					value = dense.getptr(key);
+					break;
+				case 1:
+					value = hash.getptr(key);
+					break;
+				case 2:
+					value = oa.lookup_ptr(key);
+					break;
+				case 3: {
+					const Map<uint32_t, uint32_t>::Element *E = tree.find(key);
+					value = E ? &E->get() : nullptr;
+				} break;
+				case 4: {
+					OrderedHashMap<uint32_t, uint32_t>::Element E = ordered.find(key);
+					value = E ? &E.value() : nullptr;
+				} break;
+			}
+			checksum += value ? *value : 0;
+		}
+		usec[1] = OS::get_singleton()->get_ticks_usec() - begin;
+
+		begin = OS::get_singleton()->get_ticks_usec();
+		switch (container) {
+			case 0:
+				for (const KeyValue<uint32_t, uint32_t> &E : dense) {
+					checksum += E.value;
+				}
+				break;
+			case 1:
+				for (const uint32_t *K = hash.next(nullptr); K; K = hash.next(K)) {
+					checksum += hash[*K];
+				}
+				break;
+			case 2:
+				for (OAHashMap<uint32_t, uint32_t>::Iterator it = oa.iter(); it.valid; it = oa.next_iter(it)) {
+					checksum += *it.value;
+				}
+				break;
+			case 3:
+				for (const Map<uint32_t, uint32_t>::Element *E = tree.front(); E; E = E->next()) {
+					checksum += E->get();
+				}
+				break;
+			case 4:
+				for (OrderedHashMap<uint32_t, uint32_t>::Element E = ordered.front(); E; E = E.next()) {
+					checksum += E.value();
+				}
+				break;
+		}
+		usec[2] = OS::get_singleton()->get_ticks_usec() - begin;
+
+		begin = OS::get_singleton()->get_ticks_usec();
+		for (uint32_t i = 0; i < count; i++) {
+			switch (container) {
+				case 0:
+					dense.erase(keys[i]);
+					break;
+				case 1:
+					hash.erase(keys[i]);
+					break;
+				case 2:
+					oa.remove(keys[i]);
+					break;
+				case 3:
+					tree.erase(keys[i]);
+					break;
+				case 4:
+					ordered.erase(keys[i]);
+					break;
+			}
+		}
+		usec[3] = OS::get_singleton()->get_ticks_usec() - begin;
+
+		print_line(vformat("%s (%d keys, %d lookups, checksum %d):", names[container], count, lookups, checksum));
+		print_line(vformat("    insert: %d usec", usec[0]));
+		print_line(vformat("    lookup: %d usec", usec[1]));
+		print_line(vformat("    iterate: %d usec", usec[2]));
+		print_line(vformat("    erase: %d usec", usec[3]));
+	}
+}
+
+REGISTER_TEST_COMMAND("dense-hash-map-benchmark", &benchmark_dense_hash_map);
+
+} // namespace TestDenseHashMap
+
+#endif // TEST_DENSE_HASH_MAP_H
@@ -0,0 +1,219 @@
+/*************************************************************************/
+/*  test_worker_thread_pool.h                                            */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_WORKER_THREAD_POOL_H
+#define TEST_WORKER_THREAD_POOL_H
+
+#include "core/os/os.h"
+#include "core/templates/local_vector.h"
+#include "core/templates/worker_thread_pool.h"
+#include "tests/test_macros.h"
+
+#include <atomic>
+#include <thread>
+
+namespace TestWorkerThreadPool {
+
+class Counter {
+public:
+	LocalVector<std::atomic<uint32_t>> hits;
+	WorkerThreadPool *pool = nullptr;
+	uint32_t nested_elements = 0;
+
+	void hit(uint32_t p_index, void *p_userdata) {
+		hits[p_index].fetch_add(1);
+	}
+
+	void hit_nested(uint32_t p_index, void *p_userdata) {
+		// Runs a whole parallel loop from inside a job.
+		pool->parallel_for(nested_elements, this, &Counter::hit_offset, p_index * nested_elements);
+	}
+
+	void hit_offset(uint32_t p_index, uint32_t p_offset) {
+		hits[p_offset + p_index].fetch_add(1);
+	}
+
+	bool all_hit_once() const {
+		for (uint32_t i = 0; i < hits.size(); i++) {
+			if (hits[i].load() != 1) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	Counter(uint32_t p_size) {
+		hits.resize(p_size);
+		for (uint32_t i = 0; i < p_size; i++) {
+			hits[i].store(0);
+		}
+	}
+};
+
+class RecordJob : public WorkerThreadPool::Job {
+	std::atomic<uint32_t> *order = nullptr;
+
+protected:
+	virtual void execute() override {
+		position = order->fetch_add(1);
+	}
+
+public:
+	uint32_t position = 0;
+
+	RecordJob(std::atomic<uint32_t> *p_order) :
+			order(p_order) {}
+};
+
+// Keeps the worker running it busy until released.
+class BlockingJob : public WorkerThreadPool::Job {
+protected:
+	virtual void execute() override {
+		started.store(true);
+		while (!released.load()) {
+			std::this_thread::yield();
+		}
+	}
+
+public:
+	std::atomic<bool> started = { false };
+	std::atomic<bool> released = { false };
+};
+
+TEST_CASE("[WorkerThreadPool] Parallel for processes every element once") {
+	for (int thread_count = 0; thread_count <= 4; thread_count += 2) {
+		WorkerThreadPool pool;
+		pool.init(thread_count);
+
+		Counter counter(10000);
+		pool.parallel_for(counter.hits.size(), &counter, &Counter::hit, (void *)nullptr);
+		CHECK_MESSAGE(counter.all_hit_once(), vformat("Every element should be processed exactly once, with %d worker threads.", thread_count));
+	}
+}
+
+TEST_CASE("[WorkerThreadPool] Nested parallel for") {
+	WorkerThreadPool pool;
+	pool.init(4);
+
+	Counter counter(64 * 64);
+	counter.pool = &pool;
+	counter.nested_elements = 64;
+	pool.parallel_for(64, &counter, &Counter::hit_nested, (void *)nullptr);
+	CHECK_MESSAGE(counter.all_hit_once(), "Nested loops should not deadlock nor skip elements.");
+}
+
+TEST_CASE("[WorkerThreadPool] Dependencies and groups") {
+	WorkerThreadPool pool;
+	pool.init(4);
+
+	std::atomic<uint32_t> order = { 0 };
+	RecordJob first(&order);
+	RecordJob second(&order);
+	RecordJob third(&order);
+	second.add_dependency(&first);
+	third.add_dependency(&second);
+
+	WorkerThreadPool::JobGroup group;
+	// Submitted in reverse, dependencies decide the order they run in.
+	pool.submit(&third, &group);
+	pool.submit(&second, &group);
+	pool.submit(&first, &group);
+	pool.wait(&group);
+
+	CHECK(group.is_done());
+	CHECK(first.position == 0);
+	CHECK(second.position == 1);
+	CHECK(third.position == 2);
+
+	// Jobs can be submitted again once they have finished.
+	pool.submit(&first, &group);
+	pool.wait(&group);
+	CHECK(first.position == 3);
+}
+
+TEST_CASE("[WorkerThreadPool] More jobs than the queues can hold") {
+	WorkerThreadPool pool;
+	pool.init(2);
+
+	std::atomic<uint32_t> order = { 0 };
+	LocalVector<RecordJob *> jobs;
+	WorkerThreadPool::JobGroup group;
+	for (int i = 0; i < 5000; i++) {
+		jobs.push_back(memnew(RecordJob(&order)));
+		pool.submit(jobs[i], &group);
+	}
+	pool.wait(&group);
+	CHECK_MESSAGE(order.load() == 5000, "Jobs that don't fit in the queues should run right away.");
+
+	for (uint32_t i = 0; i < jobs.size(); i++) {
+		memdelete(jobs[i]);
+	}
+}
+
+TEST_CASE("[WorkerThreadPool] Reserved workers only run high priority jobs") {
+	WorkerThreadPool pool;
+	pool.init(1, 1);
+	CHECK(pool.get_thread_count() == 1);
+	CHECK(pool.get_thread_count(WorkerThreadPool::PRIORITY_HIGH) == 2);
+
+	// Keep the only worker that takes normal priority jobs busy.
+	BlockingJob blocking;
+	WorkerThreadPool::JobGroup blocking_group;
+	pool.submit(&blocking, &blocking_group);
+	while (!blocking.started.load()) {
+		std::this_thread::yield();
+	}
+
+	std::atomic<uint32_t> order = { 0 };
+	RecordJob normal(&order);
+	WorkerThreadPool::JobGroup normal_group;
+	pool.submit(&normal, &normal_group);
+	RecordJob high(&order);
+	WorkerThreadPool::JobGroup high_group;
+	pool.submit(&high, &high_group, WorkerThreadPool::PRIORITY_HIGH);
+
+	// Don't help, the reserved worker has to pick the job up by itself.
+	uint64_t start = OS::get_singleton()->get_ticks_msec();
+	while (!high_group.is_done() && OS::get_singleton()->get_ticks_msec() - start < 5000) {
+		std::this_thread::yield();
+	}
+	CHECK_MESSAGE(high_group.is_done(), "High priority jobs should not wait for normal priority jobs to finish.");
+	CHECK_MESSAGE(!normal_group.is_done(), "Reserved workers should not take normal priority jobs.");
+
+	blocking.released.store(true);
+	pool.wait(&blocking_group);
+	pool.wait(&normal_group);
+	CHECK(high.position == 0);
+	CHECK(normal.position == 1);
+}
+
+} // namespace TestWorkerThreadPool
+
+#endif // TEST_WORKER_THREAD_POOL_H
@@ -0,0 +1,135 @@
+/*************************************************************************/
+/*  test_memory.h                                                        */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_MEMORY_H
+#define TEST_MEMORY_H
+
+#include "core/object/class_db.h"
+#include "core/os/memory.h"
+#include "core/templates/local_vector.h"
+#include "core/templates/vector.h"
+
+#include "thirdparty/doctest/doctest.h"
+
+#include <string.h>
+
+namespace TestMemory {
+
+#ifdef DEBUG_ENABLED
+static Memory::AllocationSite get_site(const char *p_file) {
+	LocalVector<Memory::AllocationSite> sites;
+	sites.resize(Memory::get_allocation_sites(nullptr, 0) + 64);
+	const uint32_t count = MIN(Memory::get_allocation_sites(sites.ptr(), sites.size()), sites.size());
+
+	Memory::AllocationSite result;
+	for (uint32_t i = 0; i < count; i++) {
+		if (strstr(sites[i].site, p_file)) {
+			result.site = sites[i].site;
+			result.live_bytes += sites[i].live_bytes;
+			result.live_count += sites[i].live_count;
+			result.total_bytes += sites[i].total_bytes;
+			result.total_count += sites[i].total_count;
+		}
+	}
+	return result;
+}
+
+TEST_CASE("[Memory] Allocation profiler attributes allocations to their site") {
+	const bool was_profiling = Memory::is_profiling();
+	Memory::set_profiling(true);
+
+	const Memory::AllocationSite before = get_site("test_memory.h");
+	uint8_t *block = (uint8_t *)memalloc(1000);
+	block = (uint8_t *)memrealloc(block, 3000);
+	LocalVector<int> *vector = memnew(LocalVector<int>);
+
+	Memory::set_profiling(false);
+	const Memory::AllocationSite during = get_site("test_memory.h");
+	CHECK(during.live_bytes - before.live_bytes == int64_t(3000 + sizeof(LocalVector<int>)));
+	CHECK(during.live_count - before.live_count == 2);
+	CHECK(during.total_count - before.total_count == 2);
+
+	memfree(block);
+	memdelete(vector);
+	const Memory::AllocationSite after = get_site("test_memory.h");
+	CHECK_MESSAGE(after.live_bytes == before.live_bytes, "Blocks allocated while profiling should be accounted for when freed later.");
+	CHECK(after.live_count == before.live_count);
+	CHECK(after.total_bytes == during.total_bytes);
+
+	Memory::set_profiling(was_profiling);
+}
+
+TEST_CASE("[Memory] Allocation profiler attributes container and class allocations to their type") {
+	const bool was_profiling = Memory::is_profiling();
+	uint8_t *early_block = (uint8_t *)memalloc(100);
+	Memory::set_profiling(true);
+
+	const Memory::AllocationSite local_vector_before = get_site(memory_type_site<LocalVector<Vector3>>());
+	const Memory::AllocationSite vector_before = get_site(memory_type_site<CowData<Vector3>>());
+	const Memory::AllocationSite object_before = get_site(memory_type_site<RefCounted>());
+	const Memory::AllocationSite file_before = get_site("test_memory.h");
+
+	LocalVector<Vector3> local_vector;
+	Vector<Vector3> vector;
+	for (int i = 0; i < 100; i++) {
+		local_vector.push_back(Vector3(i, 0, 0));
+		vector.push_back(Vector3(i, 0, 0));
+	}
+	Object *object = ClassDB::instantiate("RefCounted");
+	early_block = (uint8_t *)memrealloc(early_block, 200);
+
+	const Memory::AllocationSite local_vector_after = get_site(memory_type_site<LocalVector<Vector3>>());
+	CHECK_MESSAGE(local_vector_after.live_bytes - local_vector_before.live_bytes >= int64_t(100 * sizeof(Vector3)), "LocalVector growth should be attributed to its type.");
+	CHECK(local_vector_after.live_count - local_vector_before.live_count == 1);
+	const Memory::AllocationSite vector_after = get_site(memory_type_site<CowData<Vector3>>());
+	CHECK_MESSAGE(vector_after.live_bytes - vector_before.live_bytes >= int64_t(100 * sizeof(Vector3)), "Vector growth should be attributed to its type.");
+	CHECK(vector_after.live_count - vector_before.live_count == 1);
+	const Memory::AllocationSite object_after = get_site(memory_type_site<RefCounted>());
+	CHECK_MESSAGE(object_after.live_count - object_before.live_count == 1, "ClassDB::instantiate() should attribute the object to its class.");
+	CHECK(object_after.live_bytes - object_before.live_bytes == int64_t(sizeof(RefCounted)));
+	const Memory::AllocationSite file_after = get_site("test_memory.h");
+	CHECK_MESSAGE(file_after.live_bytes - file_before.live_bytes == 200, "Blocks allocated before profiling should be attributed once reallocated.");
+
+	memdelete(object);
+	memfree(early_block);
+	local_vector.reset();
+	vector.clear();
+	CHECK(get_site(memory_type_site<LocalVector<Vector3>>()).live_bytes == local_vector_before.live_bytes);
+	CHECK(get_site(memory_type_site<CowData<Vector3>>()).live_bytes == vector_before.live_bytes);
+	CHECK(get_site(memory_type_site<RefCounted>()).live_bytes == object_before.live_bytes);
+	CHECK(get_site("test_memory.h").live_bytes == file_before.live_bytes);
+
+	Memory::set_profiling(was_profiling);
+}
+#endif
+
+} // namespace TestMemory
+
+#endif // TEST_MEMORY_H
@@ -0,0 +1,120 @@
+/*************************************************************************/
+/*  test_small_allocator.h                                               */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_SMALL_ALLOCATOR_H
+#define TEST_SMALL_ALLOCATOR_H
+
+#include "core/os/small_allocator.h"
+#include "core/os/thread.h"
+#include "core/templates/local_vector.h"
+
+#include "thirdparty/doctest/doctest.h"
+
+#include <stdlib.h>
+
+namespace TestSmallAllocator {
+
+TEST_CASE("[SmallAllocator] Size classes") {
+	uint8_t *a = (uint8_t *)SmallAllocator::alloc(1);
+	uint8_t *b = (uint8_t *)SmallAllocator::alloc(SmallAllocator::MAX_SIZE);
+	REQUIRE(a != nullptr);
+	REQUIRE(b != nullptr);
+
+	CHECK(SmallAllocator::owns(a));
+	CHECK(SmallAllocator::owns(b));
+	CHECK(SmallAllocator::get_size(a) == SmallAllocator::SIZE_CLASS_GRANULARITY);
+	CHECK(SmallAllocator::get_size(b) == SmallAllocator::MAX_SIZE);
+	CHECK_MESSAGE((uintptr_t(a) % SmallAllocator::SIZE_CLASS_GRANULARITY) == 0, "Blocks should be aligned like malloc() ones.");
+	CHECK(SmallAllocator::alloc(SmallAllocator::MAX_SIZE + 1) == nullptr);
+
+	void *large = malloc(SmallAllocator::MAX_SIZE * 4);
+	CHECK_MESSAGE(!SmallAllocator::owns(large), "Memory from malloc() should not be mistaken for a slab block.");
+	::free(large);
+
+	SmallAllocator::free(a);
+	CHECK_MESSAGE(SmallAllocator::alloc(7) == a, "Freed blocks should be reused first on the same thread.");
+	SmallAllocator::free(a);
+	SmallAllocator::free(b);
+}
+
+static void free_blocks(void *p_userdata) {
+	LocalVector<void *> &blocks = *(LocalVector<void *> *)p_userdata;
+	for (uint32_t i = 0; i < blocks.size(); i++) {
+		SmallAllocator::free(blocks[i]);
+	}
+}
+
+TEST_CASE("[SmallAllocator] Blocks freed on another thread return to their owner") {
+	LocalVector<void *> blocks;
+	for (int i = 0; i < 1000; i++) {
+		void *block = SmallAllocator::alloc(48);
+		REQUIRE(block != nullptr);
+		blocks.push_back(block);
+	}
+
+	Thread thread;
+	thread.start(free_blocks, &blocks);
+	thread.wait_to_finish();
+
+	const uint64_t reserved = SmallAllocator::get_reserved();
+	int reused = 0;
+	LocalVector<void *> again;
+	for (int i = 0; i < 1000; i++) {
+		void *block = SmallAllocator::alloc(48);
+		reused += blocks.find(block) != -1 ? 1 : 0;
+		again.push_back(block);
+	}
+	CHECK_MESSAGE(reused == 1000, "Blocks freed remotely should be picked up again by the allocating thread.");
+	CHECK(SmallAllocator::get_reserved() == reserved);
+
+	for (uint32_t i = 0; i < again.size(); i++) {
+		SmallAllocator::free(again[i]);
+	}
+}
+
+static void add_usage(void *p_userdata) {
+	SmallAllocator::add_usage(-*(int64_t *)p_userdata);
+}
+
+TEST_CASE("[SmallAllocator] Usage is summed over threads") {
+	const uint64_t usage = SmallAllocator::get_usage();
+	int64_t bytes = 1000;
+	SmallAllocator::add_usage(bytes);
+	CHECK(SmallAllocator::get_usage() == usage + 1000);
+
+	Thread thread;
+	thread.start(add_usage, &bytes);
+	thread.wait_to_finish();
+	CHECK_MESSAGE(SmallAllocator::get_usage() == usage, "Usage released on another thread should cancel out.");
+}
+
+} // namespace TestSmallAllocator
+
+#endif // TEST_SMALL_ALLOCATOR_H
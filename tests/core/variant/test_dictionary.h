@@ -163,6 +163,75 @@ TEST_CASE("[Dictionary] keys() and values()") {
 	CHECK(int(values[0]) == 3);
 }
 
+TEST_CASE("[Dictionary] Insertion order and lookups across erasures") {
+	Dictionary map;
+	for (int i = 0; i < 100; i++) {
+		map[i] = i * 10;
+	}
+	// Reference taken before the dictionary grows further.
+	Variant &first = map[0];
+	for (int i = 100; i < 1000; i++) {
+		map[i] = i * 10;
+	}
+	CHECK_MESSAGE(int(first) == 0, "Values should not move while the dictionary grows.");
+
+	for (int i = 0; i < 1000; i++) {
+		if (i % 3 != 0) {
+			CHECK(map.erase(i));
+		}
+	}
+	CHECK_FALSE(map.erase(1));
+	CHECK(map.size() == 334);
+
+	int expected = 0;
+	for (const Variant *key = map.next(); key; key = map.next(key)) {
+		CHECK(int(*key) == expected);
+		CHECK(int(map[*key]) == expected * 10);
+		expected += 3;
+	}
+	CHECK(expected == 1002);
+	CHECK(int(map.get_key_at_index(2)) == 6);
+	CHECK(int(map.get_value_at_index(2)) == 60);
+	CHECK_FALSE(map.has(500));
+	CHECK(map.has(501));
+
+	map[1] = "re-added";
+	CHECK_MESSAGE(map.get_key_at_index(334) == Variant(1), "Re-added keys should go last.");
+}
+
+TEST_CASE("[Dictionary] Erasing keeps other entries in place until erased entries outnumber them") {
+	Dictionary map;
+	for (int i = 0; i < 100; i++) {
+		map[i] = i;
+	}
+	const Variant *last = map.getptr(99);
+	for (int i = 0; i < 50; i++) {
+		map.erase(i);
+	}
+	CHECK_MESSAGE(map.getptr(99) == last, "Entries should not move while there are as many live entries as erased ones.");
+
+	// Compacts the remaining entries.
+	map.erase(50);
+	CHECK(map.size() == 49);
+	CHECK(int(*map.getptr(99)) == 99);
+	CHECK(int(map.get_key_at_index(0)) == 51);
+}
+
+TEST_CASE("[Dictionary] StringName and String keys are the same key") {
+	Dictionary map;
+	map[StringName("name")] = 1;
+	CHECK(map.has("name"));
+	map["name"] = 2;
+	CHECK(map.size() == 1);
+	CHECK(int(map[StringName("name")]) == 2);
+	CHECK(map.keys()[0].get_type() == Variant::STRING);
+
+	map[StringName()] = 3;
+	CHECK(int(map[String()]) == 3);
+	CHECK(map.erase(StringName("name")));
+	CHECK(map.size() == 1);
+}
+
 TEST_CASE("[Dictionary] Duplicate dictionary") {
 	// d = {1: {1: 1}, {2: 2}: [2], [3]: 3}
 	Dictionary k2 = build_dictionary(2, 2);
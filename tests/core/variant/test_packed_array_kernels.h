@@ -0,0 +1,278 @@
+/*************************************************************************/
+/*  test_packed_array_kernels.h                                          */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_PACKED_ARRAY_KERNELS_H
+#define TEST_PACKED_ARRAY_KERNELS_H
+
+#include "core/math/random_number_generator.h"
+#include "core/os/os.h"
+#include "core/variant/packed_array_kernels.h"
+#include "core/variant/variant.h"
+
+#include "tests/test_macros.h"
+
+namespace TestPackedArrayKernels {
+
+// Not a multiple of any register width, so the scalar tail of the vectorized kernels is exercised too.
+const int COUNT = 1031;
+
+static PackedFloat32Array make_random(int p_count, uint64_t p_seed, float p_from = -1, float p_to = 1) {
+	Ref<RandomNumberGenerator> rng;
+	rng.instantiate();
+	rng->set_seed(p_seed);
+	PackedFloat32Array array;
+	array.resize(p_count);
+	float *w = array.ptrw();
+	for (int i = 0; i < p_count; i++) {
+		w[i] = rng->randf_range(p_from, p_to);
+	}
+	return array;
+}
+
+static bool arrays_approx_equal(const PackedFloat32Array &p_a, const PackedFloat32Array &p_b) {
+	if (p_a.size() != p_b.size()) {
+		return false;
+	}
+	for (int i = 0; i < p_a.size(); i++) {
+		if (!Math::is_equal_approx(p_a[i], p_b[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+TEST_CASE("[PackedArrayKernels] Vectorized kernels match the scalar kernels") {
+	const PackedArrayKernels *scalar = PackedArrayKernels::get_kernels(PackedArrayKernels::LEVEL_SCALAR);
+	REQUIRE(scalar != nullptr);
+	CHECK(PackedArrayKernels::get_singleton() != nullptr);
+
+	const PackedFloat32Array a = make_random(COUNT * 3, 1);
+	const PackedFloat32Array b = make_random(COUNT * 3, 2, 0.5, 2);
+	const float xform[12] = { 0.8, -0.6, 0, 0.6, 0.8, 0, 0, 0, 2, 10, -5, 3 };
+
+	for (int level = PackedArrayKernels::LEVEL_SCALAR + 1; level < PackedArrayKernels::LEVEL_MAX; level++) {
+		const PackedArrayKernels *kernels = PackedArrayKernels::get_kernels(PackedArrayKernels::Level(level));
+		if (!kernels) {
+			continue;
+		}
+		INFO(kernels->name);
+
+		PackedFloat32Array expected = a;
+		PackedFloat32Array result = a;
+
+		scalar->add(expected.ptrw(), a.ptr(), b.ptr(), COUNT);
+		kernels->add(result.ptrw(), a.ptr(), b.ptr(), COUNT);
+		CHECK_MESSAGE(arrays_approx_equal(expected, result), "Addition should match.");
+
+		scalar->subtract(expected.ptrw(), a.ptr(), b.ptr(), COUNT);
+		kernels->subtract(result.ptrw(), a.ptr(), b.ptr(), COUNT);
+		CHECK_MESSAGE(arrays_approx_equal(expected, result), "Subtraction should match.");
+
+		scalar->multiply(expected.ptrw(), a.ptr(), b.ptr(), COUNT);
+		kernels->multiply(result.ptrw(), a.ptr(), b.ptr(), COUNT);
+		CHECK_MESSAGE(arrays_approx_equal(expected, result), "Multiplication should match.");
+
+		scalar->divide(expected.ptrw(), a.ptr(), b.ptr(), COUNT);
+		kernels->divide(result.ptrw(), a.ptr(), b.ptr(), COUNT);
+		CHECK_MESSAGE(arrays_approx_equal(expected, result), "Division should match.");
+
+		scalar->add_scalar(expected.ptrw(), a.ptr(), 0.25, COUNT);
+		kernels->add_scalar(result.ptrw(), a.ptr(), 0.25, COUNT);
+		CHECK_MESSAGE(arrays_approx_equal(expected, result), "Scalar addition should match.");
+
+		scalar->multiply_scalar(expected.ptrw(), a.ptr(), -3, COUNT);
+		kernels->multiply_scalar(result.ptrw(), a.ptr(), -3, COUNT);
+		CHECK_MESSAGE(arrays_approx_equal(expected, result), "Scalar multiplication should match.");
+
+		scalar->clamp(expected.ptrw(), a.ptr(), -0.5, 0.25, COUNT);
+		kernels->clamp(result.ptrw(), a.ptr(), -0.5, 0.25, COUNT);
+		CHECK_MESSAGE(arrays_approx_equal(expected, result), "Clamping should match.");
+
+		scalar->lerp(expected.ptrw(), a.ptr(), b.ptr(), 0.3, COUNT);
+		kernels->lerp(result.ptrw(), a.ptr(), b.ptr(), 0.3, COUNT);
+		CHECK_MESSAGE(arrays_approx_equal(expected, result), "Interpolation should match.");
+
+		CHECK_MESSAGE(kernels->sum(a.ptr(), COUNT) == doctest::Approx(scalar->sum(a.ptr(), COUNT)), "Sums should match.");
+		CHECK_MESSAGE(kernels->dot(a.ptr(), b.ptr(), COUNT) == doctest::Approx(scalar->dot(a.ptr(), b.ptr(), COUNT)), "Dot products should match.");
+
+		scalar->xform_vector2(expected.ptrw(), a.ptr(), xform, COUNT);
+		kernels->xform_vector2(result.ptrw(), a.ptr(), xform, COUNT);
+		CHECK_MESSAGE(arrays_approx_equal(expected, result), "2D transforms should match.");
+
+		scalar->xform_vector3(expected.ptrw(), a.ptr(), xform, COUNT);
+		kernels->xform_vector3(result.ptrw(), a.ptr(), xform, COUNT);
+		CHECK_MESSAGE(arrays_approx_equal(expected, result), "3D transforms should match.");
+
+		// In place, like the bound methods use them.
+		result = a;
+		kernels->xform_vector3(result.ptrw(), result.ptr(), xform, COUNT);
+		CHECK_MESSAGE(arrays_approx_equal(expected, result), "3D transforms should work in place.");
+	}
+}
+
+TEST_CASE("[PackedArrayKernels] Bulk methods on packed float arrays") {
+	Variant array = PackedFloat32Array(Vector<float>({ 1, 2, 3, 4, 5 }));
+	const Variant other = PackedFloat32Array(Vector<float>({ 5, 4, 3, 2, 1 }));
+
+	CHECK(double(array.call("sum")) == doctest::Approx(15));
+	CHECK(double(array.call("dot", other)) == doctest::Approx(35));
+
+	array.call("add_array", other);
+	CHECK(PackedFloat32Array(array) == PackedFloat32Array(Vector<float>({ 6, 6, 6, 6, 6 })));
+	array.call("multiply_scalar", 0.5);
+	array.call("subtract_array", other);
+	CHECK(PackedFloat32Array(array) == PackedFloat32Array(Vector<float>({ -2, -1, 0, 1, 2 })));
+	array.call("clamp", -1.5, 1.5);
+	CHECK(PackedFloat32Array(array) == PackedFloat32Array(Vector<float>({ -1.5, -1, 0, 1, 1.5 })));
+	array.call("lerp", other, 0.5);
+	CHECK(PackedFloat32Array(array) == PackedFloat32Array(Vector<float>({ 1.75, 1.5, 1.5, 1.5, 1.25 })));
+
+	Variant doubles = PackedFloat64Array(Vector<double>({ 1, 2, 4 }));
+	doubles.call("add_scalar", 1);
+	doubles.call("divide_array", PackedFloat64Array(Vector<double>({ 2, 3, 5 })));
+	CHECK(PackedFloat64Array(doubles) == PackedFloat64Array(Vector<double>({ 1, 1, 1 })));
+
+	ERR_PRINT_OFF;
+	array.call("add_array", PackedFloat32Array());
+	ERR_PRINT_ON;
+	CHECK_MESSAGE(PackedFloat32Array(array).size() == 5, "Arrays of different sizes should be rejected.");
+}
+
+TEST_CASE("[PackedArrayKernels] Bulk methods on packed vector arrays") {
+	Variant points = PackedVector3Array(Vector<Vector3>({ Vector3(1, 0, 0), Vector3(0, 1, 0), Vector3(1, 2, 3) }));
+	const Transform3D xform = Transform3D(Basis(Vector3(0, 1, 0), Math_PI / 2), Vector3(10, 0, 0));
+	const PackedVector3Array expected = xform.xform(PackedVector3Array(points));
+
+	points.call("transform", xform);
+	const PackedVector3Array transformed = points;
+	for (int i = 0; i < expected.size(); i++) {
+		CHECK(transformed[i].is_equal_approx(expected[i]));
+	}
+
+	points.call("transform_basis", Basis().scaled(Vector3(2, 2, 2)));
+	CHECK(Vector3(points.call("sum")).is_equal_approx(expected[0] * 2 + expected[1] * 2 + expected[2] * 2));
+
+	Variant points_2d = PackedVector2Array(Vector<Vector2>({ Vector2(1, 2), Vector2(3, 4), Vector2(5, 6) }));
+	points_2d.call("transform", Transform2D(0, Vector2(1, 1)));
+	points_2d.call("multiply_scalar", 2);
+	points_2d.call("add_array", PackedVector2Array(Vector<Vector2>({ Vector2(1, 1), Vector2(1, 1), Vector2(1, 1) })));
+	CHECK(PackedVector2Array(points_2d) == PackedVector2Array(Vector<Vector2>({ Vector2(5, 7), Vector2(9, 11), Vector2(13, 15) })));
+
+	points_2d.call("add_scalar", -1);
+	points_2d.call("divide_array", PackedVector2Array(Vector<Vector2>({ Vector2(2, 2), Vector2(4, 2), Vector2(4, 7) })));
+	CHECK(PackedVector2Array(points_2d) == PackedVector2Array(Vector<Vector2>({ Vector2(2, 3), Vector2(2, 5), Vector2(3, 2) })));
+	CHECK(double(points_2d.call("dot", points_2d)) == doctest::Approx(4 + 9 + 4 + 25 + 9 + 4));
+	points_2d.call("clamp", 2.5, 4);
+	CHECK(PackedVector2Array(points_2d) == PackedVector2Array(Vector<Vector2>({ Vector2(2.5, 3), Vector2(2.5, 4), Vector2(3, 2.5) })));
+
+	Variant directions = PackedVector3Array(Vector<Vector3>({ Vector3(1, 2, 3), Vector3(-4, 5, -6) }));
+	const PackedVector3Array ones = PackedVector3Array(Vector<Vector3>({ Vector3(1, 1, 1), Vector3(1, 1, 1) }));
+	CHECK(double(directions.call("dot", ones)) == doctest::Approx(1.0));
+	directions.call("clamp", -1, 1);
+	CHECK(PackedVector3Array(directions) == PackedVector3Array(Vector<Vector3>({ Vector3(1, 1, 1), Vector3(-1, 1, -1) })));
+	ERR_PRINT_OFF;
+	const double rejected = directions.call("dot", PackedVector3Array());
+	ERR_PRINT_ON;
+	CHECK_MESSAGE(rejected == 0.0, "Arrays of different sizes should be rejected.");
+}
+
+// Compares a scripted per-element loop through Variant::evaluate with the bulk methods and every kernel level.
+// The per-element loops are too slow for the full iteration count, so they run a tenth of it and get scaled up.
+// Usage: `godot --test packed-array-kernels-benchmark`.
+static void benchmark_packed_array_kernels() {
+	const int count = 1 << 16; // Points of a large procedural mesh.
+	const int iterations = 200;
+
+	const PackedFloat32Array source = make_random(count * 3, 1);
+	const Transform3D xform = Transform3D(Basis(Vector3(0, 1, 0), 0.1), Vector3(1, 2, 3));
+	PackedVector3Array points;
+	points.resize(count);
+	for (int i = 0; i < count; i++) {
+		points.write[i] = Vector3(source[i * 3 + 0], source[i * 3 + 1], source[i * 3 + 2]);
+	}
+
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	Variant total = 0.0;
+	for (int i = 0; i < iterations / 10; i++) {
+		for (int j = 0; j < count; j++) {
+			total = Variant::evaluate(Variant::OP_ADD, total, source[j]);
+		}
+	}
+	const uint64_t variant_usec = (OS::get_singleton()->get_ticks_usec() - begin) * 10;
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	Variant array = source;
+	for (int i = 0; i < iterations; i++) {
+		total = array.call("sum");
+	}
+	const uint64_t bulk_usec = OS::get_singleton()->get_ticks_usec() - begin;
+	print_line(vformat("Sum of %d floats (%d iterations): Variant::evaluate %d usec, bulk method %d usec (%.2fx)", count, iterations, variant_usec, bulk_usec, double(variant_usec) / MAX(bulk_usec, (uint64_t)1)));
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < iterations / 10; i++) {
+		Vector3 *w = points.ptrw();
+		for (int j = 0; j < count; j++) {
+			w[j] = Variant::evaluate(Variant::OP_MULTIPLY, xform, w[j]);
+		}
+	}
+	const uint64_t variant_xform_usec = (OS::get_singleton()->get_ticks_usec() - begin) * 10;
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	Variant point_array = points;
+	for (int i = 0; i < iterations; i++) {
+		point_array.call("transform", xform);
+	}
+	const uint64_t bulk_xform_usec = OS::get_singleton()->get_ticks_usec() - begin;
+	print_line(vformat("Transform of %d points (%d iterations): Variant::evaluate %d usec, bulk method %d usec (%.2fx)", count, iterations, variant_xform_usec, bulk_xform_usec, double(variant_xform_usec) / MAX(bulk_xform_usec, (uint64_t)1)));
+
+	PackedFloat32Array target = source;
+	const float matrix[12] = { 1, 0, 0, 0, 1, 0, 0, 0, 1, 0.5, 0.5, 0.5 };
+	for (int level = PackedArrayKernels::LEVEL_SCALAR; level < PackedArrayKernels::LEVEL_MAX; level++) {
+		const PackedArrayKernels *kernels = PackedArrayKernels::get_kernels(PackedArrayKernels::Level(level));
+		if (!kernels) {
+			continue;
+		}
+
+		begin = OS::get_singleton()->get_ticks_usec();
+		double checksum = 0;
+		for (int i = 0; i < iterations; i++) {
+			kernels->lerp(target.ptrw(), target.ptr(), source.ptr(), 0.5, count * 3);
+			kernels->xform_vector3(target.ptrw(), target.ptr(), matrix, count);
+			checksum += kernels->dot(target.ptr(), source.ptr(), count * 3);
+		}
+		print_line(vformat("    %s kernels, lerp + transform + dot: %d usec (checksum %f)", kernels->name, OS::get_singleton()->get_ticks_usec() - begin, checksum));
+	}
+}
+
+REGISTER_TEST_COMMAND("packed-array-kernels-benchmark", &benchmark_packed_array_kernels);
+
+} // namespace TestPackedArrayKernels
+
+#endif // TEST_PACKED_ARRAY_KERNELS_H
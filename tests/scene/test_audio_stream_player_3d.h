@@ -0,0 +1,133 @@
+/*************************************************************************/
+/*  test_audio_stream_player_3d.h                                        */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_AUDIO_STREAM_PLAYER_3D_H
+#define TEST_AUDIO_STREAM_PLAYER_3D_H
+
+#include "scene/3d/area_3d.h"
+#include "scene/3d/audio_stream_player_3d.h"
+#include "scene/3d/camera_3d.h"
+#include "scene/3d/collision_shape_3d.h"
+#include "scene/main/window.h"
+#include "scene/resources/box_shape_3d.h"
+
+#include "tests/servers/test_audio_server.h"
+#include "tests/test_macros.h"
+
+namespace TestAudioStreamPlayer3D {
+
+class ConstantStream : public AudioStream {
+public:
+	virtual Ref<AudioStreamPlayback> instance_playback() override {
+		Ref<TestAudioServer::ConstantStreamPlayback> playback;
+		playback.instantiate();
+		playback->value = 0.5;
+		return playback;
+	}
+	virtual String get_stream_name() const override { return "Constant"; }
+	virtual float get_length() const override { return 0; }
+	virtual bool is_monophonic() const override { return false; }
+};
+
+// Runs the player's panning update, then mixes what it produced.
+static void step() {
+	SceneTree::get_singleton()->physics_process(1.0 / 60.0);
+	TestAudioServer::mix();
+}
+
+static bool is_silent(const PackedVector2Array &p_frames) {
+	for (int i = 0; i < p_frames.size(); i++) {
+		if (p_frames[i] != Vector2()) {
+			return false;
+		}
+	}
+	return true;
+}
+
+TEST_CASE("[SceneTree][AudioStreamPlayer3D] Areas override the bus of spatial players") {
+	AudioServer *server = TestAudioServer::create_server(0, true);
+	ResonanceAudioServer *resonance = memnew(ResonanceAudioServer);
+	server->add_bus();
+	server->set_bus_name(1, "Area");
+	Ref<AudioEffectCapture> capture;
+	capture.instantiate();
+	server->add_bus_effect(1, capture);
+
+	Window *root = SceneTree::get_singleton()->get_root();
+	Camera3D *camera = memnew(Camera3D);
+	root->add_child(camera);
+	camera->make_current();
+
+	Area3D *area = memnew(Area3D);
+	CollisionShape3D *collision_shape = memnew(CollisionShape3D);
+	Ref<BoxShape3D> box;
+	box.instantiate();
+	box->set_size(Vector3(4, 4, 4));
+	collision_shape->set_shape(box);
+	area->add_child(collision_shape);
+	area->set_audio_bus_override(true);
+	area->set_audio_bus_name("Area");
+	area->set_position(Vector3(0, 0, -10));
+	root->add_child(area);
+
+	Ref<ConstantStream> stream;
+	stream.instantiate();
+	AudioStreamPlayer3D *player = memnew(AudioStreamPlayer3D);
+	player->set_stream(stream);
+	player->set_position(Vector3(0, 0, -2));
+	root->add_child(player);
+	player->play();
+
+	SUBCASE("Players outside of the area are rendered by Resonance Audio") {
+		for (int i = 0; i < 4; i++) {
+			step();
+		}
+		CHECK(is_silent(capture->get_buffer(capture->get_frames_available())));
+	}
+
+	SUBCASE("Players inside of the area play on the area bus") {
+		player->set_position(Vector3(0, 0, -10));
+		for (int i = 0; i < 4; i++) {
+			step();
+		}
+		CHECK_FALSE(is_silent(capture->get_buffer(capture->get_frames_available())));
+	}
+
+	memdelete(player);
+	memdelete(area);
+	memdelete(camera);
+	TestAudioServer::mix();
+	memdelete(resonance);
+	TestAudioServer::destroy_server(server);
+}
+
+} // namespace TestAudioStreamPlayer3D
+
+#endif // TEST_AUDIO_STREAM_PLAYER_3D_H
@@ -0,0 +1,208 @@
+/*************************************************************************/
+/*  test_audio_mix_kernels.h                                             */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_AUDIO_MIX_KERNELS_H
+#define TEST_AUDIO_MIX_KERNELS_H
+
+#include "core/math/random_number_generator.h"
+#include "core/os/os.h"
+#include "core/templates/local_vector.h"
+#include "servers/audio/audio_mix_kernels.h"
+
+#include "tests/test_macros.h"
+
+namespace TestAudioMixKernels {
+
+// Odd on purpose, so the scalar tail of the vectorized kernels is exercised too.
+const uint32_t FRAMES = 515;
+
+static void fill_random(LocalVector<AudioFrame> &r_frames, uint32_t p_count, uint64_t p_seed) {
+	Ref<RandomNumberGenerator> rng;
+	rng.instantiate();
+	rng->set_seed(p_seed);
+	r_frames.resize(p_count);
+	for (uint32_t i = 0; i < p_count; i++) {
+		r_frames[i] = AudioFrame(rng->randf_range(-1, 1), rng->randf_range(-1, 1));
+	}
+}
+
+static bool frames_approx_equal(const LocalVector<AudioFrame> &p_a, const LocalVector<AudioFrame> &p_b) {
+	for (uint32_t i = 0; i < p_a.size(); i++) {
+		if (!Math::is_equal_approx(p_a[i].l, p_b[i].l) || !Math::is_equal_approx(p_a[i].r, p_b[i].r)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static AudioMixKernels::StereoBiquad make_biquad() {
+	AudioMixKernels::StereoBiquad biquad;
+	memset(&biquad, 0, sizeof(biquad));
+	for (int c = 0; c < 2; c++) {
+		biquad.b0[c] = 0.5;
+		biquad.b1[c] = 0.2;
+		biquad.b2[c] = 0.1;
+		biquad.a1[c] = 0.3;
+		biquad.a2[c] = -0.1;
+		biquad.incr_b0[c] = 0.0001;
+		biquad.incr_a1[c] = -0.0001;
+	}
+	return biquad;
+}
+
+TEST_CASE("[AudioMixKernels] Vectorized kernels match the scalar kernels") {
+	const AudioMixKernels *scalar = AudioMixKernels::get_kernels(AudioMixKernels::LEVEL_SCALAR);
+	REQUIRE(scalar != nullptr);
+	CHECK(AudioMixKernels::get_singleton() != nullptr);
+
+	LocalVector<AudioFrame> source;
+	fill_random(source, FRAMES, 1);
+	LocalVector<AudioFrame> initial;
+	fill_random(initial, FRAMES, 2);
+
+	for (int level = AudioMixKernels::LEVEL_SCALAR + 1; level < AudioMixKernels::LEVEL_MAX; level++) {
+		const AudioMixKernels *kernels = AudioMixKernels::get_kernels(AudioMixKernels::Level(level));
+		if (!kernels) {
+			continue;
+		}
+		INFO(kernels->name);
+
+		LocalVector<AudioFrame> expected = initial;
+		LocalVector<AudioFrame> result = initial;
+		scalar->mix_ramp_accumulate(expected.ptr(), source.ptr(), AudioFrame(0.2, 0.3), AudioFrame(0.9, 0.1), FRAMES);
+		kernels->mix_ramp_accumulate(result.ptr(), source.ptr(), AudioFrame(0.2, 0.3), AudioFrame(0.9, 0.1), FRAMES);
+		CHECK_MESSAGE(frames_approx_equal(expected, result), "Ramped accumulation should match.");
+
+		AudioMixKernels::StereoBiquad expected_biquad = make_biquad();
+		AudioMixKernels::StereoBiquad result_biquad = make_biquad();
+		scalar->mix_ramp_biquad_accumulate(expected.ptr(), source.ptr(), AudioFrame(1, 0.5), AudioFrame(0, 0.5), FRAMES, &expected_biquad);
+		kernels->mix_ramp_biquad_accumulate(result.ptr(), source.ptr(), AudioFrame(1, 0.5), AudioFrame(0, 0.5), FRAMES, &result_biquad);
+		CHECK_MESSAGE(frames_approx_equal(expected, result), "Filtered ramped accumulation should match.");
+		CHECK_MESSAGE(Math::is_equal_approx(expected_biquad.ha1[0], result_biquad.ha1[0]), "Filter history should match.");
+		CHECK_MESSAGE(Math::is_equal_approx(expected_biquad.b0[1], result_biquad.b0[1]), "Interpolated coefficients should match.");
+
+		AudioFrame expected_peak = scalar->mix_gain_peak(expected.ptr(), 0.7, FRAMES);
+		AudioFrame result_peak = kernels->mix_gain_peak(result.ptr(), 0.7, FRAMES);
+		CHECK_MESSAGE(frames_approx_equal(expected, result), "Applying gain should match.");
+		CHECK_MESSAGE(Math::is_equal_approx(expected_peak.l, result_peak.l), "Left peak should match.");
+		CHECK_MESSAGE(Math::is_equal_approx(expected_peak.r, result_peak.r), "Right peak should match.");
+
+		scalar->mix_accumulate(expected.ptr(), source.ptr(), FRAMES);
+		kernels->mix_accumulate(result.ptr(), source.ptr(), FRAMES);
+		CHECK_MESSAGE(frames_approx_equal(expected, result), "Accumulation should match.");
+	}
+}
+
+TEST_CASE("[AudioMixKernels] Peak is absolute") {
+	LocalVector<AudioFrame> frames;
+	frames.resize(FRAMES);
+	for (uint32_t i = 0; i < FRAMES; i++) {
+		frames[i] = AudioFrame(0.1, -0.1);
+	}
+	frames[FRAMES - 1] = AudioFrame(-0.8, 0.2); // In the scalar tail.
+	frames[7] = AudioFrame(0.3, -0.9);
+
+	for (int level = AudioMixKernels::LEVEL_SCALAR; level < AudioMixKernels::LEVEL_MAX; level++) {
+		const AudioMixKernels *kernels = AudioMixKernels::get_kernels(AudioMixKernels::Level(level));
+		if (!kernels) {
+			continue;
+		}
+		INFO(kernels->name);
+
+		LocalVector<AudioFrame> buffer = frames;
+		AudioFrame peak = kernels->mix_gain_peak(buffer.ptr(), 0.5, FRAMES);
+		CHECK(peak.l == doctest::Approx(0.4));
+		CHECK(peak.r == doctest::Approx(0.45));
+	}
+}
+
+// Prints the time taken by every kernel for every supported instruction set.
+// Usage: `godot --test audio-mix-kernels-benchmark`.
+static void benchmark_audio_mix_kernels() {
+	const uint32_t frames = 512; // AudioServer buffer size.
+	const uint32_t iterations = 20000;
+
+	LocalVector<AudioFrame> source;
+	fill_random(source, frames, 1);
+	LocalVector<AudioFrame> target;
+	fill_random(target, frames, 2);
+
+	uint64_t scalar_usec[4] = {};
+	for (int level = AudioMixKernels::LEVEL_SCALAR; level < AudioMixKernels::LEVEL_MAX; level++) {
+		const AudioMixKernels *kernels = AudioMixKernels::get_kernels(AudioMixKernels::Level(level));
+		if (!kernels) {
+			continue;
+		}
+
+		uint64_t usec[4];
+		uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		for (uint32_t i = 0; i < iterations; i++) {
+			kernels->mix_ramp_accumulate(target.ptr(), source.ptr(), AudioFrame(0.5, 0.5), AudioFrame(0.25, 0.75), frames);
+		}
+		usec[0] = OS::get_singleton()->get_ticks_usec() - begin;
+
+		begin = OS::get_singleton()->get_ticks_usec();
+		AudioMixKernels::StereoBiquad biquad = make_biquad();
+		for (uint32_t i = 0; i < iterations; i++) {
+			kernels->mix_ramp_biquad_accumulate(target.ptr(), source.ptr(), AudioFrame(0.5, 0.5), AudioFrame(0.25, 0.75), frames, &biquad);
+		}
+		usec[1] = OS::get_singleton()->get_ticks_usec() - begin;
+
+		begin = OS::get_singleton()->get_ticks_usec();
+		float peak = 0;
+		for (uint32_t i = 0; i < iterations; i++) {
+			peak += kernels->mix_gain_peak(target.ptr(), 0.999, frames).l;
+		}
+		usec[2] = OS::get_singleton()->get_ticks_usec() - begin;
+
+		begin = OS::get_singleton()->get_ticks_usec();
+		for (uint32_t i = 0; i < iterations; i++) {
+			kernels->mix_accumulate(target.ptr(), source.ptr(), frames);
+		}
+		usec[3] = OS::get_singleton()->get_ticks_usec() - begin;
+
+		const char *names[4] = { "ramp accumulate", "ramp biquad accumulate", "gain peak", "accumulate" };
+		print_line(vformat("%s (%d iterations of %d frames, peak checksum %f):", kernels->name, iterations, frames, peak));
+		for (int k = 0; k < 4; k++) {
+			if (level == AudioMixKernels::LEVEL_SCALAR) {
+				scalar_usec[k] = usec[k];
+				print_line(vformat("    %s: %d usec", names[k], usec[k]));
+			} else {
+				print_line(vformat("    %s: %d usec (%.2fx)", names[k], usec[k], double(scalar_usec[k]) / MAX(usec[k], (uint64_t)1)));
+			}
+		}
+	}
+}
+
+REGISTER_TEST_COMMAND("audio-mix-kernels-benchmark", &benchmark_audio_mix_kernels);
+
+} // namespace TestAudioMixKernels
+
+#endif // TEST_AUDIO_MIX_KERNELS_H
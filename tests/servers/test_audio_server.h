@@ -0,0 +1,472 @@
+/*************************************************************************/
+/*  test_audio_server.h                                                  */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_AUDIO_SERVER_H
+#define TEST_AUDIO_SERVER_H
+
+#include "core/config/project_settings.h"
+#include "core/templates/worker_thread_pool.h"
+#include "servers/audio/audio_stream.h"
+#include "servers/audio/effects/audio_effect_amplify.h"
+#include "servers/audio/effects/audio_effect_capture.h"
+#include "servers/audio/effects/audio_effect_compressor.h"
+#include "servers/audio_server.h"
+#include "servers/resonanceaudio/resonance_audio_wrapper.h"
+
+#include "tests/test_macros.h"
+
+namespace TestAudioServer {
+
+// Only mixes when asked to, so the tests decide when the audio thread runs.
+class ManualAudioDriver : public AudioDriver {
+	Mutex mutex;
+
+public:
+	virtual const char *get_name() const override { return "Manual"; }
+	virtual Error init() override { return OK; }
+	virtual void start() override {}
+	virtual int get_mix_rate() const override { return 44100; }
+	virtual SpeakerMode get_speaker_mode() const override { return SPEAKER_MODE_STEREO; }
+	virtual void lock() override { mutex.lock(); }
+	virtual void unlock() override { mutex.unlock(); }
+	virtual void finish() override {}
+
+	void mix(int p_frames, int32_t *p_buffer) { audio_server_process(p_frames, p_buffer, false); }
+};
+
+class ConstantStreamPlayback : public AudioStreamPlayback {
+public:
+	float value = 0.0;
+	bool active = false;
+	float position = 0.0;
+
+	virtual void start(float p_from_pos) override {
+		active = true;
+		position = p_from_pos;
+	}
+	virtual void stop() override { active = false; }
+	virtual bool is_playing() const override { return active; }
+	virtual float get_playback_position() const override { return position; }
+	virtual void seek(float p_time) override { position = p_time; }
+	virtual int mix(AudioFrame *p_buffer, float p_rate_scale, int p_frames) override {
+		for (int i = 0; i < p_frames; i++) {
+			p_buffer[i] = AudioFrame(value, value);
+		}
+		position += p_frames * p_rate_scale / 44100.0;
+		return p_frames;
+	}
+};
+
+// Deterministic white noise, restarted from its seed every time the playback starts.
+class NoiseStreamPlayback : public ConstantStreamPlayback {
+	uint32_t state = 0;
+
+public:
+	uint32_t seed = 1;
+
+	virtual void start(float p_from_pos) override {
+		ConstantStreamPlayback::start(p_from_pos);
+		state = seed;
+	}
+	virtual int mix(AudioFrame *p_buffer, float p_rate_scale, int p_frames) override {
+		for (int i = 0; i < p_frames; i++) {
+			state = state * 1664525u + 1013904223u;
+			float noise = (state >> 8) / float(1 << 24) * 2.0 - 1.0;
+			p_buffer[i] = AudioFrame(noise, noise * 0.5);
+		}
+		position += p_frames * p_rate_scale / 44100.0;
+		return p_frames;
+	}
+};
+
+const int MIX_FRAMES = 512;
+
+static ManualAudioDriver *get_driver() {
+	static ManualAudioDriver driver;
+	return &driver;
+}
+
+static AudioServer *create_server(int p_mix_thread_count = 0, bool p_spatial = false) {
+	ProjectSettings::get_singleton()->set_setting("audio/buses/mix_thread_count", p_mix_thread_count);
+	ProjectSettings::get_singleton()->set_setting("audio/enable_resonance_audio", p_spatial);
+	get_driver()->set_singleton();
+	AudioServer *server = memnew(AudioServer);
+	server->init();
+	return server;
+}
+
+static void destroy_server(AudioServer *p_server) {
+	p_server->finish();
+	memdelete(p_server);
+}
+
+static Vector<AudioFrame> channel_volumes(float p_volume) {
+	Vector<AudioFrame> volumes;
+	for (int i = 0; i < AudioServer::MAX_CHANNELS_PER_BUS; i++) {
+		volumes.push_back(AudioFrame(p_volume, p_volume));
+	}
+	return volumes;
+}
+
+static void start(const Ref<AudioStreamPlayback> &p_playback, const StringName &p_bus, float p_volume = 1.0) {
+	AudioServer::get_singleton()->start_playback_stream(p_playback, p_bus, channel_volumes(p_volume));
+}
+
+static void set_volume(const Ref<AudioStreamPlayback> &p_playback, float p_volume) {
+	AudioServer::get_singleton()->set_playback_all_bus_volumes_linear(p_playback, channel_volumes(p_volume), AudioSourceId());
+}
+
+static Ref<ConstantStreamPlayback> play(const StringName &p_bus, float p_value) {
+	Ref<ConstantStreamPlayback> playback;
+	playback.instantiate();
+	playback->value = p_value;
+	start(playback, p_bus);
+	return playback;
+}
+
+// Mixes p_steps buffers, and returns the left channel of the last frame written to the output.
+static float mix(int p_steps = 1) {
+	int32_t output[MIX_FRAMES * 2];
+	for (int i = 0; i < p_steps; i++) {
+		get_driver()->mix(MIX_FRAMES, output);
+	}
+	return output[(MIX_FRAMES - 1) * 2] / (2048.0 * ((1 << 20) - 1));
+}
+
+static void stop(const Ref<AudioStreamPlayback> &p_playback) {
+	AudioServer::get_singleton()->stop_playback_stream(p_playback);
+}
+
+TEST_CASE("[AudioServer] Bus volume, mute and solo") {
+	AudioServer *server = create_server();
+	server->add_bus();
+	server->set_bus_name(1, "Music");
+	server->add_bus();
+	server->set_bus_name(2, "Effects");
+
+	Ref<ConstantStreamPlayback> music = play("Music", 0.5);
+	Ref<ConstantStreamPlayback> effects = play("Effects", 0.25);
+	// The first buffer fades the playbacks in.
+	CHECK(mix(2) == doctest::Approx(0.75).epsilon(0.001));
+
+	server->set_bus_volume_db(1, Math::linear2db(0.5));
+	CHECK(mix() == doctest::Approx(0.5).epsilon(0.001));
+	CHECK(server->get_bus_peak_volume_left_db(1, 0) == doctest::Approx(Math::linear2db(0.25)).epsilon(0.001));
+
+	server->set_bus_mute(2, true);
+	CHECK(mix() == doctest::Approx(0.25).epsilon(0.001));
+	server->set_bus_mute(2, false);
+	CHECK(mix() == doctest::Approx(0.5).epsilon(0.001));
+
+	// Soloing a bus keeps the master bus it sends to audible, and silences the others.
+	server->set_bus_solo(2, true);
+	CHECK(mix() == doctest::Approx(0.25).epsilon(0.001));
+	server->set_bus_solo(2, false);
+	CHECK(mix() == doctest::Approx(0.5).epsilon(0.001));
+
+	server->set_bus_solo(0, true);
+	CHECK_MESSAGE(mix() == doctest::Approx(0).epsilon(0.001), "Soloing the master bus only keeps the master bus itself.");
+	server->set_bus_solo(0, false);
+
+	stop(music);
+	stop(effects);
+	mix();
+	destroy_server(server);
+}
+
+TEST_CASE("[AudioServer] Mix plan follows bus layout changes") {
+	AudioServer *server = create_server();
+	server->add_bus();
+	server->set_bus_name(1, "A");
+	server->set_bus_volume_db(1, Math::linear2db(0.5));
+	server->add_bus();
+	server->set_bus_name(2, "B");
+	server->set_bus_send(2, "A");
+
+	Ref<ConstantStreamPlayback> playback = play("B", 0.5);
+	CHECK(mix(2) == doctest::Approx(0.25).epsilon(0.001));
+
+	server->set_bus_send(2, "Master");
+	CHECK(mix() == doctest::Approx(0.5).epsilon(0.001));
+	server->set_bus_send(2, "A");
+	CHECK(mix() == doctest::Approx(0.25).epsilon(0.001));
+
+	// Buses can only send to buses before them, B falls back to sending to the master bus.
+	server->move_bus(2, 1);
+	CHECK(server->get_bus_index("B") == 1);
+	CHECK(server->get_bus_index("A") == 2);
+	CHECK(mix() == doctest::Approx(0.5).epsilon(0.001));
+	server->move_bus(2, 1);
+	CHECK(server->get_bus_index("A") == 1);
+	CHECK(mix() == doctest::Approx(0.25).epsilon(0.001));
+
+	server->add_bus(1);
+	CHECK(server->get_bus_index("A") == 2);
+	CHECK(server->get_bus_index("B") == 3);
+	CHECK(mix() == doctest::Approx(0.25).epsilon(0.001));
+
+	// Sends to a removed bus go to the master bus.
+	server->remove_bus(server->get_bus_index("A"));
+	CHECK(server->get_bus_index("A") == -1);
+	CHECK(mix() == doctest::Approx(0.5).epsilon(0.001));
+
+	// Playbacks on a removed bus go to the master bus.
+	server->set_bus_volume_db(server->get_bus_index("B"), Math::linear2db(0.5));
+	CHECK(mix() == doctest::Approx(0.25).epsilon(0.001));
+	server->remove_bus(server->get_bus_index("B"));
+	CHECK(mix() == doctest::Approx(0.5).epsilon(0.001));
+
+	stop(playback);
+	mix();
+	destroy_server(server);
+}
+
+TEST_CASE("[AudioServer] Spatial voices follow the volume of their bus") {
+	AudioServer *server = create_server(0, true);
+	// Needs the audio server to know the mix rate and buffer size.
+	ResonanceAudioServer *resonance = memnew(ResonanceAudioServer);
+	server->add_bus();
+	server->set_bus_name(1, "Music");
+
+	AudioSourceId source = resonance->register_audio_source();
+	REQUIRE(source.get_id() != -1);
+	resonance->set_source_transform(source, Transform3D(Basis(), Vector3(0, 0, -2)));
+	Ref<ConstantStreamPlayback> playback = play("Music", 0.5);
+	server->set_playback_highshelf_params(playback, 1.0, 5000, source);
+
+	// Give the binaural filters time to settle on the constant input.
+	const float full = mix(8);
+	CHECK(full != doctest::Approx(0));
+
+	server->set_bus_volume_db(1, Math::linear2db(0.5));
+	CHECK(mix(8) == doctest::Approx(full * 0.5).epsilon(0.01));
+
+	server->set_bus_mute(1, true);
+	CHECK(mix(8) == doctest::Approx(0));
+
+	server->set_bus_mute(1, false);
+	server->set_bus_volume_db(1, 0);
+	server->add_bus();
+	server->set_bus_name(2, "Ambience");
+	server->set_bus_send(1, "Ambience");
+	server->set_bus_volume_db(2, Math::linear2db(0.25));
+	CHECK_MESSAGE(mix(8) == doctest::Approx(full * 0.25).epsilon(0.01), "The volume of the buses the voice is sent through should apply too.");
+
+	stop(playback);
+	mix();
+	resonance->unregister_audio_source(source);
+	memdelete(resonance);
+	destroy_server(server);
+}
+
+TEST_CASE("[AudioServer] Inaudible voices are virtualized") {
+	AudioServer *server = create_server();
+	const float step = float(MIX_FRAMES) / 44100.0;
+	Ref<ConstantStreamPlayback> playback = play("Master", 0.5);
+	server->set_playback_virtualization(playback, true, 0, 10.0);
+	mix();
+	CHECK(server->get_virtual_voice_count() == 0);
+
+	SUBCASE("Virtual voices advance without being mixed, and resume where they would be") {
+		set_volume(playback, 0);
+		// Mixed one last time while fading out.
+		mix();
+		CHECK(server->get_virtual_voice_count() == 1);
+		const float position = playback->position;
+		CHECK(server->get_playback_position(playback) == doctest::Approx(position));
+
+		mix(4);
+		CHECK_MESSAGE(playback->position == position, "Virtual voices should not be mixed.");
+		CHECK(server->get_playback_position(playback) == doctest::Approx(position + 4 * step));
+
+		set_volume(playback, 1);
+		CHECK(mix() == doctest::Approx(0.5).epsilon(0.01));
+		CHECK(server->get_virtual_voice_count() == 0);
+		CHECK_MESSAGE(playback->position == doctest::Approx(position + 5 * step), "Promoted voices should resume from their estimated position.");
+	}
+
+	SUBCASE("Streams without a known length are never virtualized") {
+		// Like generators, which can't seek and must keep being drained.
+		server->set_playback_virtualization(playback, true, 0, 0);
+		set_volume(playback, 0);
+		const float position = playback->position;
+		mix(2);
+		CHECK(server->get_virtual_voice_count() == 0);
+		CHECK(playback->position == doctest::Approx(position + 2 * step));
+	}
+
+	SUBCASE("Voices with virtualization disabled are never virtualized") {
+		server->set_playback_virtualization(playback, false, 0, 10.0);
+		set_volume(playback, 0);
+		const float position = playback->position;
+		mix(2);
+		CHECK(server->get_virtual_voice_count() == 0);
+		CHECK(playback->position == doctest::Approx(position + 2 * step));
+	}
+
+	SUBCASE("Disabling virtualization promotes virtual voices") {
+		set_volume(playback, 0);
+		mix(2);
+		CHECK(server->get_virtual_voice_count() == 1);
+		server->set_playback_virtualization(playback, false, 0, 10.0);
+		mix();
+		CHECK(server->get_virtual_voice_count() == 0);
+	}
+
+	stop(playback);
+	mix();
+	destroy_server(server);
+}
+
+// Mixes many playbacks over several buses, and returns what reached the master bus.
+static PackedVector2Array mix_scene(int p_mix_thread_count, int p_steps) {
+	AudioServer *server = create_server(p_mix_thread_count);
+	const StringName buses[] = { "Master", "A", "B", "C" };
+	for (int i = 1; i < 4; i++) {
+		server->add_bus();
+		server->set_bus_name(i, buses[i]);
+	}
+	server->set_bus_send(2, "A");
+	server->set_bus_volume_db(1, -3.3);
+	server->set_bus_volume_db(2, 1.7);
+	server->set_bus_volume_db(3, -7.1);
+
+	Ref<AudioEffectAmplify> amplify;
+	amplify.instantiate();
+	amplify->set_volume_db(2.3);
+	server->add_bus_effect(2, amplify);
+	Ref<AudioEffectCapture> capture;
+	capture.instantiate();
+	server->add_bus_effect(0, capture);
+
+	// Enough playbacks for several chunks, with an uneven last one.
+	LocalVector<Ref<NoiseStreamPlayback>> playbacks;
+	for (int i = 0; i < 101; i++) {
+		Ref<NoiseStreamPlayback> playback;
+		playback.instantiate();
+		playback->seed = i + 1;
+		start(playback, buses[i % 4], 0.01 + 0.003 * (i % 7));
+		playbacks.push_back(playback);
+	}
+
+	mix(p_steps);
+	PackedVector2Array output = capture->get_buffer(MIX_FRAMES * p_steps);
+
+	for (uint32_t i = 0; i < playbacks.size(); i++) {
+		stop(playbacks[i]);
+	}
+	mix();
+	destroy_server(server);
+	return output;
+}
+
+TEST_CASE("[AudioServer] Parallel mixing gives the same output as serial mixing") {
+	WorkerThreadPool *pool = WorkerThreadPool::get_singleton();
+	const bool start_pool = pool->get_thread_count() == 0;
+	if (start_pool) {
+		pool->init(3);
+	}
+
+	const int steps = 3;
+	const PackedVector2Array serial = mix_scene(0, steps);
+	const PackedVector2Array parallel = mix_scene(4, steps);
+
+	if (start_pool) {
+		pool->finish();
+	}
+
+	REQUIRE(serial.size() == MIX_FRAMES * steps);
+	REQUIRE(parallel.size() == serial.size());
+
+	bool silent = true;
+	for (int i = 0; i < serial.size() && silent; i++) {
+		silent = serial[i] == Vector2();
+	}
+	CHECK_FALSE(silent);
+	CHECK_MESSAGE(memcmp(serial.ptr(), parallel.ptr(), sizeof(Vector2) * serial.size()) == 0, "Parallel mixing should give bit for bit the same output.");
+}
+
+// Plays a constant on bus A, compressed by the signal that bus C sends to bus B. Returns what A's compressor let through.
+static PackedVector2Array mix_sidechain(int p_mix_thread_count, int p_steps) {
+	AudioServer *server = create_server(p_mix_thread_count);
+	const StringName buses[] = { "Master", "A", "B", "C" };
+	for (int i = 1; i < 4; i++) {
+		server->add_bus();
+		server->set_bus_name(i, buses[i]);
+	}
+	server->set_bus_send(3, "B");
+
+	Ref<AudioEffectCompressor> compressor;
+	compressor.instantiate();
+	compressor->set_threshold(-20);
+	compressor->set_sidechain("B");
+	server->add_bus_effect(1, compressor);
+	Ref<AudioEffectCapture> capture;
+	capture.instantiate();
+	server->add_bus_effect(1, capture);
+
+	Ref<ConstantStreamPlayback> playback = play("A", 0.5);
+	Ref<ConstantStreamPlayback> sidechain = play("C", 0.5);
+
+	mix(p_steps);
+	PackedVector2Array output = capture->get_buffer(MIX_FRAMES * p_steps);
+
+	stop(playback);
+	stop(sidechain);
+	mix();
+	destroy_server(server);
+	return output;
+}
+
+TEST_CASE("[AudioServer] Sidechained compressors see the sidechain bus after it is mixed") {
+	WorkerThreadPool *pool = WorkerThreadPool::get_singleton();
+	const bool start_pool = pool->get_thread_count() == 0;
+	if (start_pool) {
+		pool->init(3);
+	}
+
+	// A (1) is processed after B (2), which is processed after C (3) sends to it, so the compressor reacts to C.
+	const int steps = 2;
+	const PackedVector2Array serial = mix_sidechain(0, steps);
+	const PackedVector2Array parallel = mix_sidechain(4, steps);
+
+	if (start_pool) {
+		pool->finish();
+	}
+
+	REQUIRE(serial.size() == MIX_FRAMES * steps);
+	REQUIRE(parallel.size() == serial.size());
+	CHECK_MESSAGE(serial[serial.size() - 1].x < 0.25, "The sidechain signal should compress bus A.");
+	CHECK_MESSAGE(memcmp(serial.ptr(), parallel.ptr(), sizeof(Vector2) * serial.size()) == 0, "Parallel mixing should give bit for bit the same output.");
+}
+
+} // namespace TestAudioServer
+
+#endif // TEST_AUDIO_SERVER_H
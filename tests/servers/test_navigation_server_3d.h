@@ -0,0 +1,274 @@
+/*************************************************************************/
+/*  test_navigation_server_3d.h                                          */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_NAVIGATION_SERVER_3D_H
+#define TEST_NAVIGATION_SERVER_3D_H
+
+#include "scene/resources/navigation_mesh.h"
+#include "servers/navigation_server_3d.h"
+
+#include "tests/test_macros.h"
+
+namespace TestNavigationServer3D {
+
+// A grid of 1x1 quads with a wall along x == p_wall_x, open only in the last row.
+static Ref<NavigationMesh> make_grid_with_wall(int p_size, int p_wall_x) {
+	Ref<NavigationMesh> mesh;
+	mesh.instantiate();
+
+	Vector<Vector3> vertices;
+	for (int z = 0; z <= p_size; z++) {
+		for (int x = 0; x <= p_size; x++) {
+			vertices.push_back(Vector3(x, 0, z));
+		}
+	}
+	mesh->set_vertices(vertices);
+
+	for (int z = 0; z < p_size; z++) {
+		for (int x = 0; x < p_size; x++) {
+			if (x == p_wall_x && z < p_size - 1) {
+				continue;
+			}
+			Vector<int> polygon;
+			polygon.push_back(z * (p_size + 1) + x);
+			polygon.push_back((z + 1) * (p_size + 1) + x);
+			polygon.push_back((z + 1) * (p_size + 1) + x + 1);
+			polygon.push_back(z * (p_size + 1) + x + 1);
+			mesh->add_polygon(polygon);
+		}
+	}
+	return mesh;
+}
+
+class _TestAvoidanceReceiver : public Object {
+	GDCLASS(_TestAvoidanceReceiver, Object);
+
+protected:
+	static void _bind_methods() {
+		ClassDB::bind_method(D_METHOD("velocity_computed", "velocity", "index"), &_TestAvoidanceReceiver::velocity_computed);
+	}
+
+public:
+	Vector3 velocities[3];
+
+	void velocity_computed(Vector3 p_velocity, int p_index) { velocities[p_index] = p_velocity; }
+};
+
+static real_t get_path_length(const Vector<Vector3> &p_path) {
+	real_t length = 0;
+	for (int i = 1; i < p_path.size(); i++) {
+		length += p_path[i - 1].distance_to(p_path[i]);
+	}
+	return length;
+}
+
+TEST_CASE("[SceneTree][NavigationServer3D] Paths go around walls") {
+	NavigationServer3D *server = NavigationServer3D::get_singleton_mut();
+	REQUIRE(server != nullptr);
+
+	const RID map = server->map_create();
+	server->map_set_active(map, true);
+	const RID region = server->region_create();
+	server->region_set_map(region, map);
+	server->region_set_navmesh(region, make_grid_with_wall(16, 8));
+	server->process(0.0); // Apply the commands and build the map.
+
+	const Vector3 origin(0.5, 0, 0.5);
+	const Vector3 destination(15.5, 0, 0.5);
+
+	const Vector<Vector3> path = server->map_get_path(map, origin, destination, true);
+	REQUIRE(path.size() >= 2);
+	CHECK(path[0].is_equal_approx(origin));
+	CHECK(path[path.size() - 1].is_equal_approx(destination));
+	// Around the wall through the gap in the last row and back.
+	CHECK(get_path_length(path) > 30);
+	CHECK(get_path_length(path) < 36);
+
+	const Vector<Vector3> unoptimized = server->map_get_path(map, origin, destination, false);
+	CHECK(get_path_length(unoptimized) >= get_path_length(path) - CMP_EPSILON);
+
+	// Batched queries should match single queries.
+	Vector<Vector3> origins;
+	Vector<Vector3> destinations;
+	for (int i = 0; i < 64; i++) {
+		origins.push_back(Vector3(0.5 + (i % 7), 0, 0.5 + (i % 13)));
+		destinations.push_back(Vector3(15.5 - (i % 5), 0, 0.5 + (i % 11)));
+	}
+
+	const Vector<Vector<Vector3>> paths = server->map_get_paths(map, origins, destinations, true);
+	REQUIRE(paths.size() == origins.size());
+	for (int i = 0; i < paths.size(); i++) {
+		CHECK(paths[i] == server->map_get_path(map, origins[i], destinations[i], true));
+	}
+
+	ERR_PRINT_OFF;
+	origins.resize(1);
+	CHECK_MESSAGE(server->map_get_paths(map, origins, destinations, true).is_empty(), "Mismatched origins and destinations should be rejected.");
+	ERR_PRINT_ON;
+
+	server->free(region);
+	server->free(map);
+	server->process(0.0);
+}
+
+TEST_CASE("[SceneTree][NavigationServer3D] Closest point queries") {
+	NavigationServer3D *server = NavigationServer3D::get_singleton_mut();
+	REQUIRE(server != nullptr);
+
+	const RID map = server->map_create();
+	server->map_set_active(map, true);
+	const RID region = server->region_create();
+	server->region_set_map(region, map);
+	server->region_set_navmesh(region, make_grid_with_wall(16, 8));
+	server->process(0.0);
+
+	CHECK(server->map_get_closest_point(map, Vector3(3.5, 2, 4.5)).is_equal_approx(Vector3(3.5, 0, 4.5)));
+	CHECK(server->map_get_closest_point(map, Vector3(-2, 0, 20)).is_equal_approx(Vector3(0, 0, 16)));
+	// The wall is not part of the navigation mesh.
+	CHECK(Math::is_equal_approx(server->map_get_closest_point(map, Vector3(8.2, 0, 3.5)).x, real_t(8)));
+	CHECK(server->map_get_closest_point_normal(map, Vector3(3.5, 2, 4.5)).is_equal_approx(Vector3(0, 1, 0)));
+	CHECK(server->map_get_closest_point_owner(map, Vector3(3.5, 2, 4.5)) == region);
+
+	CHECK(server->map_get_closest_point_to_segment(map, Vector3(2.5, 3, 2.5), Vector3(2.5, -3, 2.5)).is_equal_approx(Vector3(2.5, 0, 2.5)));
+	CHECK(server->map_get_closest_point_to_segment(map, Vector3(-3, 1, 5), Vector3(-2, 1, 7)).is_equal_approx(Vector3(0, 0, 7)));
+
+	// Moving the region keeps the polygons and only refits the tree.
+	server->region_set_transform(region, Transform3D(Basis(), Vector3(0, 1, 100)));
+	server->process(0.0);
+	CHECK(server->map_get_closest_point(map, Vector3(3.5, 5, 104.5)).is_equal_approx(Vector3(3.5, 1, 104.5)));
+	CHECK(server->map_get_path(map, Vector3(0.5, 1, 100.5), Vector3(15.5, 1, 100.5), true).size() >= 2);
+
+	server->free(region);
+	server->free(map);
+	server->process(0.0);
+}
+
+TEST_CASE("[SceneTree][NavigationServer3D] Regions are linked again when they change") {
+	NavigationServer3D *server = NavigationServer3D::get_singleton_mut();
+	REQUIRE(server != nullptr);
+
+	const RID map = server->map_create();
+	server->map_set_active(map, true);
+	server->map_set_edge_connection_margin(map, 0.5);
+	const Ref<NavigationMesh> mesh = make_grid_with_wall(4, -1);
+	const RID region_a = server->region_create();
+	server->region_set_map(region_a, map);
+	server->region_set_navmesh(region_a, mesh);
+	const RID region_b = server->region_create();
+	server->region_set_map(region_b, map);
+	server->region_set_navmesh(region_b, mesh);
+	server->region_set_transform(region_b, Transform3D(Basis(), Vector3(4, 0, 0)));
+	server->process(0.0);
+
+	const Vector3 origin(0.5, 0, 0.5);
+	// Regions sharing an edge are linked.
+	Vector<Vector3> path = server->map_get_path(map, origin, Vector3(7.5, 0, 0.5), true);
+	REQUIRE(path.size() >= 2);
+	CHECK(path[path.size() - 1].is_equal_approx(Vector3(7.5, 0, 0.5)));
+
+	// Regions too far apart are not.
+	server->region_set_transform(region_b, Transform3D(Basis(), Vector3(20, 0, 0)));
+	server->process(0.0);
+	path = server->map_get_path(map, origin, Vector3(23.5, 0, 0.5), true);
+	REQUIRE(path.size() >= 2);
+	CHECK(path[path.size() - 1].x <= 4 + CMP_EPSILON);
+
+	// Regions within the edge connection margin are linked.
+	server->region_set_transform(region_b, Transform3D(Basis(), Vector3(4.2, 0, 0)));
+	server->process(0.0);
+	path = server->map_get_path(map, origin, Vector3(7.7, 0, 0.5), true);
+	REQUIRE(path.size() >= 2);
+	CHECK(path[path.size() - 1].is_equal_approx(Vector3(7.7, 0, 0.5)));
+
+	// Removing a region unlinks it.
+	server->region_set_map(region_b, RID());
+	server->process(0.0);
+	path = server->map_get_path(map, origin, Vector3(7.7, 0, 0.5), true);
+	REQUIRE(path.size() >= 2);
+	CHECK(path[path.size() - 1].x <= 4 + CMP_EPSILON);
+
+	server->free(region_a);
+	server->free(region_b);
+	server->free(map);
+	server->process(0.0);
+}
+
+TEST_CASE("[SceneTree][NavigationServer3D] Agents avoid each other") {
+	GDREGISTER_CLASS(_TestAvoidanceReceiver);
+	NavigationServer3D *server = NavigationServer3D::get_singleton_mut();
+	REQUIRE(server != nullptr);
+
+	const RID map = server->map_create();
+	server->map_set_active(map, true);
+
+	// Two agents heading for each other, and one far away from both.
+	const Vector3 positions[3] = { Vector3(0, 0, 0), Vector3(4, 0, 0.5), Vector3(100, 0, 0) };
+	const Vector3 target_velocities[3] = { Vector3(1, 0, 0), Vector3(-1, 0, 0), Vector3(1, 0, 0) };
+
+	_TestAvoidanceReceiver *receiver = memnew(_TestAvoidanceReceiver);
+	RID agents[3];
+	for (int i = 0; i < 3; i++) {
+		agents[i] = server->agent_create();
+		server->agent_set_map(agents[i], map);
+		server->agent_set_neighbor_dist(agents[i], 10);
+		server->agent_set_max_neighbors(agents[i], 10);
+		server->agent_set_time_horizon(agents[i], 5);
+		server->agent_set_radius(agents[i], 1);
+		server->agent_set_max_speed(agents[i], 2);
+		server->agent_set_position(agents[i], positions[i]);
+		server->agent_set_velocity(agents[i], target_velocities[i]);
+		server->agent_set_target_velocity(agents[i], target_velocities[i]);
+		server->agent_set_callback(agents[i], receiver, "velocity_computed", i);
+	}
+	server->process(0.1);
+
+	CHECK_FALSE_MESSAGE(receiver->velocities[0].is_equal_approx(target_velocities[0]), "Agents on a collision course should change their velocity.");
+	CHECK_MESSAGE(receiver->velocities[0].is_equal_approx(-receiver->velocities[1]), "Both agents should take half of the avoidance.");
+	CHECK_MESSAGE(receiver->velocities[2].is_equal_approx(target_velocities[2]), "Agents without neighbors should keep their velocity.");
+
+	// Agents that moved are found at their new position.
+	server->agent_set_position(agents[2], Vector3(2, 0, 1));
+	server->process(0.1);
+	CHECK_FALSE(receiver->velocities[2].is_equal_approx(target_velocities[2]));
+
+	// Agents whose receiver was freed are still simulated, without callbacks.
+	memdelete(receiver);
+	server->process(0.1);
+
+	for (int i = 0; i < 3; i++) {
+		server->free(agents[i]);
+	}
+	server->free(map);
+	server->process(0.0);
+}
+
+} // namespace TestNavigationServer3D
+
+#endif // TEST_NAVIGATION_SERVER_3D_H
@@ -0,0 +1,304 @@
+/*************************************************************************/
+/*  test_renderer_canvas_cull.h                                          */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_RENDERER_CANVAS_CULL_H
+#define TEST_RENDERER_CANVAS_CULL_H
+
+#include "core/templates/map.h"
+#include "servers/rendering/renderer_canvas_cull.h"
+#include "servers/rendering/rendering_server_globals.h"
+#include "servers/rendering_server.h"
+
+#include "tests/test_macros.h"
+
+namespace TestRendererCanvasCull {
+
+const Rect2 CLIP_RECT = Rect2(0, 0, 100, 100);
+
+// Builds canvas item trees through the RenderingServer, and compares the items drawn by the canvas culling
+// with the ones that intersect the clip rect, found by transforming every item on its own.
+class CullTester {
+	struct ItemData {
+		RID parent; // Invalid for items parented to the canvas.
+		Transform2D xform;
+		Rect2 rect;
+		bool has_rect = false;
+		bool visible = true;
+	};
+
+	Map<RID, ItemData> items;
+	LocalVector<RID> creation_order;
+
+	Transform2D _get_global_xform(RID p_item) const {
+		const ItemData &data = items[p_item];
+		return data.parent.is_valid() ? _get_global_xform(data.parent) * data.xform : data.xform;
+	}
+
+	bool _is_visible_in_tree(RID p_item) const {
+		const ItemData &data = items[p_item];
+		return data.visible && (!data.parent.is_valid() || _is_visible_in_tree(data.parent));
+	}
+
+public:
+	RID canvas;
+
+	// Items without a rect draw nothing, and are not checked.
+	RID add_item(RID p_parent, const Vector2 &p_position, bool p_has_rect = true) {
+		RenderingServer *rs = RenderingServer::get_singleton();
+		RID item = rs->canvas_item_create();
+		rs->canvas_item_set_parent(item, p_parent.is_valid() ? p_parent : canvas);
+
+		ItemData data;
+		data.parent = p_parent;
+		data.xform = Transform2D(0, p_position);
+		items[item] = data;
+		creation_order.push_back(item);
+
+		rs->canvas_item_set_transform(item, data.xform);
+		if (p_has_rect) {
+			set_rect(item, Rect2(0, 0, 10, 10));
+		}
+		return item;
+	}
+
+	void set_rect(RID p_item, const Rect2 &p_rect) {
+		RenderingServer *rs = RenderingServer::get_singleton();
+		rs->canvas_item_clear(p_item);
+		rs->canvas_item_add_rect(p_item, p_rect, Color(1, 1, 1));
+		// Notifiers keep the last frame their item was drawn in.
+		rs->canvas_item_set_visibility_notifier(p_item, true, p_rect, Callable(), Callable());
+		items[p_item].rect = p_rect;
+		items[p_item].has_rect = true;
+	}
+
+	void set_transform(RID p_item, const Transform2D &p_xform) {
+		RenderingServer::get_singleton()->canvas_item_set_transform(p_item, p_xform);
+		items[p_item].xform = p_xform;
+	}
+
+	void set_visible(RID p_item, bool p_visible) {
+		RenderingServer::get_singleton()->canvas_item_set_visible(p_item, p_visible);
+		items[p_item].visible = p_visible;
+	}
+
+	// Only for items without children.
+	void remove_item(RID p_item) {
+		RenderingServer::get_singleton()->free(p_item);
+		items.erase(p_item);
+		creation_order.erase(p_item);
+	}
+
+	void render() {
+		RSG::rasterizer->begin_frame(0.0);
+		RendererCanvasCull::Canvas *canvas_ptr = RSG::canvas->canvas_owner.get_or_null(canvas);
+		RSG::canvas->render_canvas(RID(), canvas_ptr, Transform2D(), nullptr, nullptr, CLIP_RECT, RS::CANVAS_ITEM_TEXTURE_FILTER_LINEAR, RS::CANVAS_ITEM_TEXTURE_REPEAT_DISABLED, false, false);
+	}
+
+	bool is_drawn(RID p_item) const {
+		const RendererCanvasCull::Item *ci = RSG::canvas->canvas_item_owner.get_or_null(p_item);
+		return ci->visibility_notifier && ci->visibility_notifier->visible_in_frame == RSG::rasterizer->get_frame_number();
+	}
+
+	bool should_be_drawn(RID p_item) const {
+		return _is_visible_in_tree(p_item) && CLIP_RECT.intersects(_get_global_xform(p_item).xform(items[p_item].rect), true);
+	}
+
+	bool has_child_index(RID p_item) const {
+		return RSG::canvas->canvas_item_owner.get_or_null(p_item)->child_index != nullptr;
+	}
+
+	// Renders, and returns the amount of items whose drawn state differs from the expected one.
+	int render_and_count_mismatches() {
+		render();
+		int mismatches = 0;
+		for (const KeyValue<RID, ItemData> &E : items) {
+			if (E.value.has_rect && is_drawn(E.key) != should_be_drawn(E.key)) {
+				mismatches++;
+			}
+		}
+		return mismatches;
+	}
+
+	int count_drawn() const {
+		int drawn = 0;
+		for (const KeyValue<RID, ItemData> &E : items) {
+			if (E.value.has_rect && is_drawn(E.key)) {
+				drawn++;
+			}
+		}
+		return drawn;
+	}
+
+	CullTester() {
+		canvas = RenderingServer::get_singleton()->canvas_create();
+	}
+
+	~CullTester() {
+		// Children were always created after their parents.
+		for (int i = int(creation_order.size()) - 1; i >= 0; i--) {
+			RenderingServer::get_singleton()->free(creation_order[i]);
+		}
+		RenderingServer::get_singleton()->free(canvas);
+	}
+};
+
+TEST_CASE("[SceneTree][RendererCanvasCull] Subtrees are culled by their bounds") {
+	CullTester tester;
+	RID parent = tester.add_item(RID(), Vector2(0, 0));
+	LocalVector<RID> children;
+	for (int i = 0; i < 10; i++) {
+		children.push_back(tester.add_item(parent, Vector2(i * 40 - 150, 45)));
+	}
+	RID grandchild = tester.add_item(children[4], Vector2(0, 30));
+	RID far_parent = tester.add_item(RID(), Vector2(500, 500));
+	tester.add_item(far_parent, Vector2(10, 10));
+
+	CHECK(tester.render_and_count_mismatches() == 0);
+	CHECK(tester.is_drawn(grandchild));
+	CHECK(tester.count_drawn() > 1);
+	CHECK(tester.count_drawn() < 13);
+
+	SUBCASE("Transform changes") {
+		tester.set_transform(parent, Transform2D(0, Vector2(120, 0)));
+		CHECK(tester.render_and_count_mismatches() == 0);
+		tester.set_transform(far_parent, Transform2D(0, Vector2(-30, -30)));
+		CHECK(tester.render_and_count_mismatches() == 0);
+		tester.set_transform(children[4], Transform2D(0.5, Vector2(-60, 70)).scaled(Vector2(2, 2)));
+		CHECK(tester.render_and_count_mismatches() == 0);
+		tester.set_transform(parent, Transform2D());
+		CHECK(tester.render_and_count_mismatches() == 0);
+		CHECK(tester.count_drawn() > 1);
+	}
+
+	SUBCASE("Visibility changes") {
+		tester.set_visible(children[4], false);
+		CHECK(tester.render_and_count_mismatches() == 0);
+		CHECK_FALSE(tester.is_drawn(grandchild));
+		tester.set_visible(parent, false);
+		CHECK(tester.render_and_count_mismatches() == 0);
+		CHECK(tester.count_drawn() == 0);
+		tester.set_visible(parent, true);
+		tester.set_visible(children[4], true);
+		CHECK(tester.render_and_count_mismatches() == 0);
+		CHECK(tester.is_drawn(grandchild));
+	}
+
+	SUBCASE("Command changes") {
+		// Moves the drawing of an item that was outside into the clip rect, and the other way around.
+		tester.set_rect(children[0], Rect2(170, 10, 10, 10));
+		tester.set_rect(children[4], Rect2(500, 0, 10, 10));
+		CHECK(tester.render_and_count_mismatches() == 0);
+		CHECK(tester.is_drawn(children[0]));
+		CHECK_FALSE(tester.is_drawn(children[4]));
+	}
+
+	SUBCASE("Removed children") {
+		tester.remove_item(grandchild);
+		tester.remove_item(children[3]);
+		CHECK(tester.render_and_count_mismatches() == 0);
+	}
+}
+
+TEST_CASE("[SceneTree][RendererCanvasCull] Y-sorted and canvas group parents") {
+	CullTester tester;
+	RID ysort = tester.add_item(RID(), Vector2(0, 0), false);
+	RenderingServer::get_singleton()->canvas_item_set_sort_children_by_y(ysort, true);
+	RID nested_ysort = tester.add_item(ysort, Vector2(-100, 0), false);
+	RenderingServer::get_singleton()->canvas_item_set_sort_children_by_y(nested_ysort, true);
+	RID group = tester.add_item(RID(), Vector2(0, 0), false);
+	RenderingServer::get_singleton()->canvas_item_set_canvas_group_mode(group, RS::CANVAS_GROUP_MODE_TRANSPARENT);
+	for (int i = 0; i < 8; i++) {
+		tester.add_item(ysort, Vector2(i * 40 - 150, 100 - i * 15));
+		tester.add_item(nested_ysort, Vector2(i * 40, i * 15));
+		tester.add_item(group, Vector2(i * 40 - 150, i * 15));
+	}
+
+	CHECK(tester.render_and_count_mismatches() == 0);
+	CHECK(tester.count_drawn() > 0);
+
+	tester.set_transform(ysort, Transform2D(0, Vector2(80, 0)));
+	tester.set_transform(nested_ysort, Transform2D(0, Vector2(-200, 0)));
+	tester.set_transform(group, Transform2D(0, Vector2(100, -50)));
+	CHECK(tester.render_and_count_mismatches() == 0);
+
+	tester.set_visible(nested_ysort, false);
+	CHECK(tester.render_and_count_mismatches() == 0);
+}
+
+TEST_CASE("[SceneTree][RendererCanvasCull] Child index across its threshold") {
+	CullTester tester;
+	RID parent = tester.add_item(RID(), Vector2(0, 0), false);
+	LocalVector<RID> children;
+	for (int i = 0; i < RendererCanvasCull::CHILD_INDEX_MIN_CHILDREN - 1; i++) {
+		children.push_back(tester.add_item(parent, Vector2(i * 10 - 300, (i % 8) * 20)));
+	}
+	CHECK(tester.render_and_count_mismatches() == 0);
+	CHECK_FALSE(tester.has_child_index(parent));
+
+	for (int i = 0; i < 2; i++) {
+		children.push_back(tester.add_item(parent, Vector2(i * 20, 40)));
+	}
+	CHECK(tester.render_and_count_mismatches() == 0);
+	CHECK(tester.has_child_index(parent));
+
+	// Changes to children and to the parent must reach the index.
+	tester.set_transform(parent, Transform2D(0, Vector2(250, 0)));
+	CHECK(tester.render_and_count_mismatches() == 0);
+	tester.set_transform(children[10], Transform2D(0, Vector2(-200, 30)));
+	tester.set_visible(children[30], false);
+	tester.set_rect(children[0], Rect2(-200, 0, 10, 10));
+	CHECK(tester.render_and_count_mismatches() == 0);
+	tester.set_visible(children[30], true);
+	CHECK(tester.render_and_count_mismatches() == 0);
+
+	// Unbounded children are always visited.
+	RenderingServer::get_singleton()->canvas_item_set_update_when_visible(children[5], true);
+	CHECK(tester.render_and_count_mismatches() == 0);
+	RenderingServer::get_singleton()->canvas_item_set_update_when_visible(children[5], false);
+
+	// The index is only freed once the children drop well below the threshold.
+	while (children.size() > RendererCanvasCull::CHILD_INDEX_MIN_CHILDREN / 2) {
+		tester.remove_item(children[children.size() - 1]);
+		children.remove_at(children.size() - 1);
+		CHECK(tester.render_and_count_mismatches() == 0);
+	}
+	CHECK(tester.has_child_index(parent));
+	tester.remove_item(children[children.size() - 1]);
+	children.remove_at(children.size() - 1);
+	CHECK(tester.render_and_count_mismatches() == 0);
+	CHECK_FALSE(tester.has_child_index(parent));
+
+	tester.set_transform(parent, Transform2D(0, Vector2(300, 0)));
+	CHECK(tester.render_and_count_mismatches() == 0);
+}
+
+} // namespace TestRendererCanvasCull
+
+#endif // TEST_RENDERER_CANVAS_CULL_H
@@ -53,29 +53,41 @@
 #include "tests/core/math/test_vector3.h"
 #include "tests/core/math/test_vector3i.h"
 #include "tests/core/object/test_class_db.h"
+#include "tests/core/object/test_message_queue.h"
 #include "tests/core/object/test_method_bind.h"
 #include "tests/core/object/test_object.h"
 #include "tests/core/string/test_node_path.h"
 #include "tests/core/string/test_string.h"
+#include "tests/core/string/test_string_name.h"
 #include "tests/core/string/test_translation.h"
 #include "tests/core/templates/test_command_queue.h"
+#include "tests/core/templates/test_dense_hash_map.h"
 #include "tests/core/templates/test_list.h"
 #include "tests/core/templates/test_local_vector.h"
 #include "tests/core/templates/test_lru.h"
 #include "tests/core/templates/test_ordered_hash_map.h"
 #include "tests/core/templates/test_paged_array.h"
 #include "tests/core/templates/test_vector.h"
+#include "tests/core/templates/test_worker_thread_pool.h"
 #include "tests/core/test_crypto.h"
 #include "tests/core/test_hashing_context.h"
+#include "tests/core/test_memory.h"
+#include "tests/core/test_small_allocator.h"
 #include "tests/core/test_time.h"
 #include "tests/core/variant/test_array.h"
 #include "tests/core/variant/test_dictionary.h"
+#include "tests/core/variant/test_packed_array_kernels.h"
 #include "tests/core/variant/test_variant.h"
 #include "tests/scene/test_animation.h"
+#include "tests/scene/test_audio_stream_player_3d.h"
 #include "tests/scene/test_code_edit.h"
 #include "tests/scene/test_curve.h"
 #include "tests/scene/test_gradient.h"
 #include "tests/scene/test_path_3d.h"
+#include "tests/servers/test_audio_mix_kernels.h"
+#include "tests/servers/test_audio_server.h"
+#include "tests/servers/test_navigation_server_3d.h"
+#include "tests/servers/test_renderer_canvas_cull.h"
 #include "tests/servers/test_text_server.h"
 #include "tests/test_validate_testing.h"
 